@@ -16,8 +16,11 @@
 */
 
 #include <ignition/msgs/entity_factory.pb.h>
+#include <ignition/msgs/entity_factory_v.pb.h>
 
 #include <iostream>
+#include <string>
+#include <vector>
 
 #include <ignition/transport/Node.hh>
 
@@ -91,6 +94,55 @@ void createEntityFromStr(const std::string modelStr)
 //! [call service create sphere]
 }
 
+void createEntitiesFromStrs(const std::vector<std::string> &modelStrs)
+{
+//! [call service create multiple]
+  // All the entities are created in a single request, which the server
+  // processes in one go.
+  bool result;
+  ignition::msgs::EntityFactory_V req;
+  ignition::msgs::Boolean res;
+  for (const auto &modelStr : modelStrs)
+    req.add_data()->set_sdf(modelStr);
+
+  bool executed = node.Request("/world/empty/create_multiple",
+            req, timeout, res, result);
+  if (executed)
+  {
+    if (result)
+    {
+      std::cout << modelStrs.size() << " entities were created : ["
+                << res.data() << "]" << std::endl;
+    }
+    else
+    {
+      std::cout << "Service call failed" << std::endl;
+      return;
+    }
+  }
+  else
+    std::cerr << "Service call timed out" << std::endl;
+//! [call service create multiple]
+}
+
+//////////////////////////////////////////////////
+std::string generateBoxStr(const std::string &name, double x, double y)
+{
+  return std::string("<sdf version='1.7'>") +
+    "<model name='" + name + "'>" +
+      "<pose>" + std::to_string(x) + " " + std::to_string(y) +
+      " 0.5 0 0 0</pose>" +
+      "<link name='link'>" +
+        "<visual name='visual'>" +
+          "<geometry><box><size>0.5 0.5 0.5</size></box></geometry>" +
+        "</visual>" +
+        "<collision name='collision'>" +
+          "<geometry><box><size>0.5 0.5 0.5</size></box></geometry>" +
+        "</collision>" +
+      "</link>" +
+    "</model></sdf>";
+}
+
 //////////////////////////////////////////////////
 std::string generateLightStr(
   const std::string light_type, const std::string name,
@@ -183,4 +235,17 @@ int main(int argc, char **argv)
       0.15, 0.45, 1.0));
 
   createLight();
+
+  // Spawn a grid of boxes with a single request
+  std::vector<std::string> boxStrs;
+  for (int i = 0; i < 10; ++i)
+  {
+    for (int j = 0; j < 10; ++j)
+    {
+      boxStrs.push_back(generateBoxStr(
+          "box_" + std::to_string(i) + "_" + std::to_string(j),
+          2.0 + i, 2.0 + j));
+    }
+  }
+  createEntitiesFromStrs(boxStrs);
 }
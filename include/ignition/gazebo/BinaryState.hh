@@ -0,0 +1,274 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_BINARYSTATE_HH_
+#define IGNITION_GAZEBO_BINARYSTATE_HH_
+
+#include <cstddef>
+#include <cstdint>
+
+#include <ignition/gazebo/config.hh>
+#include <ignition/gazebo/Entity.hh>
+#include <ignition/gazebo/Export.hh>
+#include <ignition/gazebo/Types.hh>
+
+namespace ignition
+{
+  namespace gazebo
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+    /// \brief Magic bytes at the start of every binary state buffer.
+    constexpr char kBinaryStateMagic[8] =
+        {'I', 'G', 'N', 'E', 'C', 'M', 'S', '\0'};
+
+    /// \brief Current version of the binary state format.
+    constexpr uint32_t kBinaryStateVersion{1};
+
+    /// \brief Value of BinaryStateHeader::byteOrder as written by the host.
+    /// Buffers written on a host with a different byte order are rejected.
+    constexpr uint32_t kBinaryStateByteOrder{0x01020304};
+
+    /// \brief Alignment of the buffer and of every table in it.
+    constexpr std::size_t kBinaryStateAlignment{8};
+
+    /// \brief Entity flag set when the entity is marked for removal.
+    constexpr uint64_t kBinaryStateEntityRemoved{1};
+
+    /// \brief Fixed header at the start of a binary state buffer. All offsets
+    /// are in bytes from the start of the buffer, and all integers are in the
+    /// byte order of the host that wrote the buffer.
+    ///
+    /// The layout of a buffer is:
+    /// * BinaryStateHeader
+    /// * BinaryStateEntity[entityCount], all serialized entities
+    /// * BinaryStateColumn[columnCount], one per component type
+    /// * For each column, the serialized component data, followed by the
+    ///   entities that own the components (uint64_t[count]) and by the
+    ///   offsets of each component in the data (uint64_t[count + 1]).
+    ///
+    /// Tables start at multiples of kBinaryStateAlignment.
+    struct BinaryStateHeader
+    {
+      /// \brief Must be kBinaryStateMagic.
+      char magic[8];
+
+      /// \brief Format version, kBinaryStateVersion.
+      uint32_t version;
+
+      /// \brief kBinaryStateByteOrder, in the writer's byte order.
+      uint32_t byteOrder;
+
+      /// \brief Total size of the buffer.
+      uint64_t size;
+
+      /// \brief Number of entries in the entity table.
+      uint64_t entityCount;
+
+      /// \brief Offset of the entity table.
+      uint64_t entitiesOffset;
+
+      /// \brief Number of entries in the column table.
+      uint64_t columnCount;
+
+      /// \brief Offset of the column table.
+      uint64_t columnsOffset;
+    };
+
+    /// \brief Entry of the entity table.
+    struct BinaryStateEntity
+    {
+      /// \brief Entity ID.
+      uint64_t id;
+
+      /// \brief Bitmask of kBinaryStateEntity* flags.
+      uint64_t flags;
+    };
+
+    /// \brief Entry of the column table, describing all the components of a
+    /// single type.
+    struct BinaryStateColumn
+    {
+      /// \brief Component type ID.
+      uint64_t type;
+
+      /// \brief Number of components.
+      uint64_t count;
+
+      /// \brief Offset of the serialized data.
+      uint64_t dataOffset;
+
+      /// \brief Size of the serialized data.
+      uint64_t dataSize;
+
+      /// \brief Offset of the uint64_t[count] array of entities.
+      uint64_t entitiesOffset;
+
+      /// \brief Offset of the uint64_t[count + 1] array of offsets of each
+      /// component, relative to dataOffset. Component i spans
+      /// [offsets[i], offsets[i + 1]).
+      uint64_t offsetsOffset;
+    };
+
+    /// \class BinaryStateColumnView BinaryState.hh
+    /// ignition/gazebo/BinaryState.hh
+    /// \brief Read-only access to a column of a binary state buffer.
+    class BinaryStateColumnView
+    {
+      /// \brief Constructor
+      /// \param[in] _buffer Start of the buffer.
+      /// \param[in] _column Column table entry.
+      public: BinaryStateColumnView(const char *_buffer,
+                  const BinaryStateColumn &_column)
+              : column(&_column),
+                data(_buffer + _column.dataOffset),
+                entities(reinterpret_cast<const uint64_t *>(
+                    _buffer + _column.entitiesOffset)),
+                offsets(reinterpret_cast<const uint64_t *>(
+                    _buffer + _column.offsetsOffset))
+      {
+      }
+
+      /// \brief Get the component type of the column.
+      /// \return Component type ID.
+      public: ComponentTypeId TypeId() const
+      {
+        return this->column->type;
+      }
+
+      /// \brief Get the number of components in the column.
+      /// \return Component count.
+      public: std::size_t Count() const
+      {
+        return static_cast<std::size_t>(this->column->count);
+      }
+
+      /// \brief Get the entity that owns a component.
+      /// \param[in] _index Index of the component, less than Count().
+      /// \return The entity.
+      public: Entity EntityAt(std::size_t _index) const
+      {
+        return static_cast<Entity>(this->entities[_index]);
+      }
+
+      /// \brief Get the serialized data of a component.
+      /// \param[in] _index Index of the component, less than Count().
+      /// \return Pointer to the data, which is not null terminated.
+      public: const char *Data(std::size_t _index) const
+      {
+        return this->data + this->offsets[_index];
+      }
+
+      /// \brief Get the size of the serialized data of a component.
+      /// \param[in] _index Index of the component, less than Count().
+      /// \return Size in bytes.
+      public: std::size_t Size(std::size_t _index) const
+      {
+        return static_cast<std::size_t>(
+            this->offsets[_index + 1] - this->offsets[_index]);
+      }
+
+      /// \brief Column table entry.
+      private: const BinaryStateColumn *column;
+
+      /// \brief Start of the serialized data.
+      private: const char *data;
+
+      /// \brief Entities array.
+      private: const uint64_t *entities;
+
+      /// \brief Offsets array.
+      private: const uint64_t *offsets;
+    };
+
+    /// \class BinaryStateView BinaryState.hh
+    /// ignition/gazebo/BinaryState.hh
+    /// \brief Read-only access to a buffer in the binary state format, as
+    /// produced by EntityComponentManager::BinaryState. See
+    /// BinaryStateHeader for the layout.
+    ///
+    /// The view doesn't copy or own the buffer, which can be memory mapped
+    /// from a file or point into a received message. The buffer must be
+    /// aligned to kBinaryStateAlignment and must outlive the view. It is
+    /// validated once on construction, after which all accessors are
+    /// unchecked array accesses.
+    class IGNITION_GAZEBO_VISIBLE BinaryStateView
+    {
+      /// \brief Constructor of an invalid view.
+      public: BinaryStateView() = default;
+
+      /// \brief Constructor
+      /// \param[in] _data Start of the buffer.
+      /// \param[in] _size Size of the buffer in bytes.
+      public: BinaryStateView(const void *_data, std::size_t _size);
+
+      /// \brief Whether the buffer passed to the constructor is a well formed
+      /// binary state buffer. Nothing else should be called on invalid views.
+      /// \return True if valid.
+      public: bool Valid() const;
+
+      /// \brief Get the size of the buffer according to its header, which can
+      /// be smaller than the size passed to the constructor.
+      /// \return Size in bytes.
+      public: std::size_t Size() const;
+
+      /// \brief Get the number of entities in the buffer.
+      /// \return Entity count.
+      public: std::size_t EntityCount() const
+      {
+        return static_cast<std::size_t>(this->header->entityCount);
+      }
+
+      /// \brief Get an entry of the entity table.
+      /// \param[in] _index Index of the entity, less than EntityCount().
+      /// \return The entity entry.
+      public: const BinaryStateEntity &EntityAt(std::size_t _index) const
+      {
+        return this->entities[_index];
+      }
+
+      /// \brief Get the number of columns in the buffer, which is the number
+      /// of distinct component types.
+      /// \return Column count.
+      public: std::size_t ColumnCount() const
+      {
+        return static_cast<std::size_t>(this->header->columnCount);
+      }
+
+      /// \brief Get a column.
+      /// \param[in] _index Index of the column, less than ColumnCount().
+      /// \return View of the column.
+      public: BinaryStateColumnView Column(std::size_t _index) const
+      {
+        return BinaryStateColumnView(this->data, this->columns[_index]);
+      }
+
+      /// \brief Start of the buffer.
+      private: const char *data{nullptr};
+
+      /// \brief Header, or nullptr if the buffer is invalid.
+      private: const BinaryStateHeader *header{nullptr};
+
+      /// \brief Entity table.
+      private: const BinaryStateEntity *entities{nullptr};
+
+      /// \brief Column table.
+      private: const BinaryStateColumn *columns{nullptr};
+    };
+    }
+  }
+}
+#endif
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_ENTITYCOMMANDBUFFER_HH_
+#define IGNITION_GAZEBO_ENTITYCOMMANDBUFFER_HH_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+#include <ignition/gazebo/config.hh>
+#include <ignition/gazebo/Entity.hh>
+#include <ignition/gazebo/EntityComponentManager.hh>
+#include <ignition/gazebo/Export.hh>
+
+namespace ignition
+{
+  namespace gazebo
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+    // Forward declarations.
+    class EntityCommandBufferPrivate;
+
+    /// \class EntityCommandBuffer EntityCommandBuffer.hh
+    ///      ignition/gazebo/EntityCommandBuffer.hh
+    /// \brief Records structural changes to an EntityComponentManager, so
+    /// that they can be made later, at a point where no other thread is using
+    /// the manager.
+    ///
+    /// Entities, components and the entity tree can't be modified while
+    /// other threads iterate over views, for example from a parallel Each or
+    /// from systems which run concurrently. Those threads can record their
+    /// changes in a buffer instead. The changes are applied in the order in
+    /// which they were recorded.
+    ///
+    /// A buffer must only be used by one thread at a time. Use
+    /// EntityComponentManager::CommandBuffer to get a buffer for the calling
+    /// thread, which the simulation runner applies between the PreUpdate,
+    /// Update and PostUpdate phases of every iteration.
+    class IGNITION_GAZEBO_VISIBLE EntityCommandBuffer
+    {
+      /// \brief Constructor
+      /// \param[in] _ecm Entity component manager the changes are for.
+      public: explicit EntityCommandBuffer(EntityComponentManager &_ecm);
+
+      /// \brief Destructor. Changes which haven't been applied are lost.
+      public: ~EntityCommandBuffer();
+
+      /// \brief Record the creation of an entity. The entity's ID is reserved
+      /// right away, so it can be used in subsequent commands, but the entity
+      /// only exists once the buffer is applied.
+      /// \return The ID of the entity to be created.
+      public: Entity CreateEntity();
+
+      /// \brief Record the creation of a component. This will copy the
+      /// _data parameter.
+      /// \param[in] _entity The entity that will be associated with
+      /// the component.
+      /// \param[in] _data Data used to construct the component.
+      /// \tparam ComponentTypeT Component type.
+      /// \sa EntityComponentManager::CreateComponent
+      public: template<typename ComponentTypeT>
+              void CreateComponent(const Entity _entity,
+                  const ComponentTypeT &_data)
+      {
+        this->AddCommand([_entity, _data](EntityComponentManager &_ecm)
+        {
+          _ecm.CreateComponent(_entity, _data);
+        });
+      }
+
+      /// \brief Record the removal of a component.
+      /// \param[in] _entity The entity.
+      /// \tparam ComponentTypeT Component type.
+      /// \sa EntityComponentManager::RemoveComponent
+      public: template<typename ComponentTypeT>
+              void RemoveComponent(const Entity _entity)
+      {
+        this->AddCommand([_entity](EntityComponentManager &_ecm)
+        {
+          _ecm.RemoveComponent<ComponentTypeT>(_entity);
+        });
+      }
+
+      /// \brief Record a change of parent.
+      /// \param[in] _child Entity to set the parent.
+      /// \param[in] _parent Entity which should be an immediate parent of
+      /// _child entity.
+      /// \sa EntityComponentManager::SetParentEntity
+      public: void SetParentEntity(const Entity _child, const Entity _parent);
+
+      /// \brief Record an entity removal request.
+      /// \param[in] _entity Entity to be removed.
+      /// \param[in] _recursive Whether to recursively delete all child
+      /// entities.
+      /// \sa EntityComponentManager::RequestRemoveEntity
+      public: void RequestRemoveEntity(const Entity _entity,
+                  bool _recursive = true);
+
+      /// \brief Record an arbitrary change.
+      /// \param[in] _command Function which makes the change.
+      public: void AddCommand(
+                  std::function<void(EntityComponentManager &)> _command);
+
+      /// \brief Get the number of recorded commands.
+      /// \return Number of commands which haven't been applied yet.
+      public: std::size_t Size() const;
+
+      /// \brief Check whether there are no recorded commands.
+      /// \return True if there's nothing to apply.
+      public: bool Empty() const;
+
+      /// \brief Apply all the recorded commands to the entity component
+      /// manager, in order, and clear the buffer. This must not be called
+      /// while other threads use the manager.
+      public: void Apply();
+
+      /// \brief Discard all the recorded commands. The IDs of the entities
+      /// which were to be created are not reused.
+      public: void Clear();
+
+      /// \brief Pointer to private data.
+      private: std::unique_ptr<EntityCommandBufferPrivate> dataPtr;
+    };
+    }
+  }
+}
+#endif
@@ -20,11 +20,13 @@
 #include <ignition/msgs/serialized.pb.h>
 #include <ignition/msgs/serialized_map.pb.h>
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <optional>
 #include <set>
 #include <string>
+#include <tuple>
 #include <typeinfo>
 #include <type_traits>
 #include <unordered_set>
@@ -33,9 +35,12 @@
 #include <vector>
 
 #include <ignition/common/Console.hh>
+#include <ignition/math/Pose3.hh>
 #include <ignition/math/graph/Graph.hh>
+#include "ignition/gazebo/BinaryState.hh"
 #include "ignition/gazebo/Entity.hh"
 #include "ignition/gazebo/Export.hh"
+#include "ignition/gazebo/QueryFilters.hh"
 #include "ignition/gazebo/Types.hh"
 
 #include "ignition/gazebo/components/Component.hh"
@@ -48,7 +53,10 @@ namespace ignition
     // Inline bracket to help doxygen filtering.
     inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
     // Forward declarations.
+    class EntityCommandBuffer;
     class IGNITION_GAZEBO_HIDDEN EntityComponentManagerPrivate;
+    class EntityComponentManagerSnapshot;
+    class WorkStealingPool;
 
     /// \brief Type alias for the graph that holds entities.
     /// Each vertex is an entity, and the direction points from the parent to
@@ -75,6 +83,19 @@ namespace ignition
       /// \return An id for the Entity, or kNullEntity on failure.
       public: Entity CreateEntity();
 
+      /// \brief Creates several new Entities at once. This is equivalent to
+      /// calling CreateEntity _count times, but storage is reserved up front
+      /// and locks are only taken once.
+      /// \param[in] _count Number of entities to create.
+      /// \return The ids of the new Entities, in increasing order. Empty on
+      /// failure.
+      public: std::vector<Entity> CreateEntities(const std::size_t _count);
+
+      /// \brief Reserve storage for entities that will be created later, so
+      /// that creating them doesn't need to grow internal containers.
+      /// \param[in] _count Number of entities expected to be created.
+      public: void ReserveEntities(const std::size_t _count);
+
       /// \brief Clone an entity and its components. If the entity has any child
       /// entities, they will also be cloned.
       /// When cloning entities, the following rules apply:
@@ -153,6 +174,16 @@ namespace ignition
       /// \sa void PinEntity(const Entity, bool)
       public: void UnpinEntity(const Entity _entity, bool _recursive = true);
 
+      /// \brief Get the command buffer of the calling thread. Threads which
+      /// can't modify the manager directly, such as the workers of a
+      /// parallel Each, can record changes in it instead. The simulation
+      /// runner applies all command buffers after each of the PreUpdate,
+      /// Update and PostUpdate phases.
+      /// \return The calling thread's buffer. The reference is valid until
+      /// the buffers are next applied, after which the buffer is reused.
+      /// \sa EntityCommandBuffer
+      public: EntityCommandBuffer &CommandBuffer();
+
       /// \brief Allow all previously pinned entities to be removed.
       /// \sa void PinEntity(const Entity, bool)
       public: void UnpinAllEntities();
@@ -184,7 +215,8 @@ namespace ignition
       /// \param[in] _child Entity to set the parent
       /// \param[in] _parent Entity which should be an immediate parent _child
       /// entity.
-      /// \return True if successful. Will fail if entities don't exist.
+      /// \return True if successful. Will fail if entities don't exist, or if
+      /// _parent is _child or one of its descendants.
       public: bool SetParentEntity(const Entity _child, const Entity _parent);
 
       /// \brief Get whether a component type has ever been created.
@@ -255,8 +287,42 @@ namespace ignition
                   const Entity _entity,
                   const ComponentTypeT &_data);
 
+      /// \brief Create several components on an entity at once. This will
+      /// copy the _data parameters. This is equivalent to calling
+      /// CreateComponent for each of them, but the entity only moves once in
+      /// the storage and views are only updated once.
+      /// \param[in] _entity The entity that will be associated with
+      /// the components.
+      /// \param[in] _data Data used to construct each component.
+      /// \tparam ComponentTypeTs Component types.
+      /// \return True if all the components were created or updated. False
+      /// if _entity doesn't exist or if a type isn't registered.
+      public: template<typename ...ComponentTypeTs>
+              bool CreateComponents(
+                  const Entity _entity,
+                  const ComponentTypeTs &..._data);
+
+      /// \brief Create a component of the same type on several entities.
+      /// This will copy the _data parameter for each entity. This is
+      /// equivalent to calling CreateComponent for each entity, but entities
+      /// with the same components are moved together in the storage and
+      /// views are only updated once.
+      /// \param[in] _entities The entities that will be associated with
+      /// the component.
+      /// \param[in] _data Data used to construct the components.
+      /// \tparam ComponentTypeT Component type.
+      /// \return Number of entities whose component was created or updated.
+      public: template<typename ComponentTypeT>
+              std::size_t CreateComponents(
+                  const std::vector<Entity> &_entities,
+                  const ComponentTypeT &_data);
+
       /// \brief Get a component assigned to an entity based on a
       /// component type.
+      ///
+      /// Components of the same type are stored in contiguous arrays, so the
+      /// returned pointer is only valid until entities or components are
+      /// next created or removed, which may move components in memory.
       /// \param[in] _entity The entity.
       /// \return The component of the specified type assigned to specified
       /// Entity, or nullptr if the component could not be found.
@@ -264,7 +330,8 @@ namespace ignition
               const ComponentTypeT *Component(const Entity _entity) const;
 
       /// \brief Get a mutable component assigned to an entity based on a
-      /// component type.
+      /// component type. The pointer is only valid until entities or
+      /// components are next created or removed, see the const version.
       /// \param[in] _entity The entity.
       /// \return The component of the specified type assigned to specified
       /// Entity, or nullptr if the component could not be found.
@@ -317,6 +384,11 @@ namespace ignition
       /// * If the entity doesn't have that component, the component will be
       ///   created.
       /// * If the entity has the component, its data will be updated.
+      ///
+      /// A change advances the change tick, see ChangeTick, so it's seen by
+      /// value indexes, cached world poses and ChangedStateSince. It doesn't
+      /// mark the component as changed for ChangedState, which still
+      /// requires SetChanged.
       /// \param[in] _entity The entity.
       /// \param[in] _data New component data
       /// \tparam ComponentTypeT Component type
@@ -354,7 +426,8 @@ namespace ignition
       /// \details Component type must have inequality operator.
       ///
       /// \param[in] _desiredComponents All the components which must match.
-      /// \return Entity or kNullEntity if no entity has the exact components.
+      /// \return The matching entity with the lowest ID, or kNullEntity if no
+      /// entity has the exact components.
       public: template<typename ...ComponentTypeTs>
               Entity EntityByComponents(
                    const ComponentTypeTs &..._desiredComponents) const;
@@ -369,8 +442,8 @@ namespace ignition
       /// \details Component type must have inequality operator.
       ///
       /// \param[in] _desiredComponents All the components which must match.
-      /// \return All matching entities, or an empty vector if no child entity
-      /// has the exact components.
+      /// \return All matching entities sorted by ID, or an empty vector if no
+      /// entity has the exact components.
       public: template<typename ...ComponentTypeTs>
               std::vector<Entity> EntitiesByComponents(
                    const ComponentTypeTs &..._desiredComponents) const;
@@ -394,10 +467,41 @@ namespace ignition
               std::vector<Entity> ChildrenByComponents(Entity _parent,
                    const ComponentTypeTs &..._desiredComponents) const;
 
+      /// \brief Keep an index of the values of a component type, which
+      /// EntityByComponents, EntitiesByComponents and ChildrenByComponents
+      /// use to find matching entities without visiting every entity that
+      /// has the desired component types. This is worth it for components
+      /// which are often looked up by value, such as components::Name,
+      /// components::ParentEntity and components::ParentLinkName.
+      ///
+      /// The index is built when it's enabled and updated lazily, on the
+      /// next lookup, from the changes made through CreateComponent,
+      /// SetComponentData, RemoveComponent, entity removal and SetChanged.
+      /// Values modified through the pointer returned by Component aren't
+      /// seen by the index until the component is marked as changed, so
+      /// none of the lookups find such entities by their new value. Only
+      /// index types whose writers all use SetComponentData or SetChanged.
+      ///
+      /// \details The component's data type must be hashable with std::hash.
+      /// \tparam ComponentTypeT Type of component to be indexed.
+      public: template<typename ComponentTypeT>
+              void EnableValueIndex();
+
+      /// \brief Get whether the values of a component type are indexed.
+      /// \param[in] _typeId Component type.
+      /// \return True if EnableValueIndex was called for the type.
+      public: bool HasValueIndex(const ComponentTypeId _typeId) const;
+
       /// why is this required?
       private: template <typename T>
                struct identity;  // NOLINT
 
+      /// \brief Type trait that is true for std::function, so that callables
+      /// which already are a std::function are passed to the overloads that
+      /// take one.
+      private: template <typename T>
+               struct IsStdFunction;  // NOLINT
+
       /// \brief Helper function for cloning an entity and its children (this
       /// includes cloning components attached to these entities). This method
       /// should never be called directly - it is called internally from the
@@ -456,6 +560,12 @@ namespace ignition
       /// order they're listed on the template. The callback function can
       /// return false to stop subsequent calls to the callback, otherwise
       /// a true value should be returned.
+      /// The callback may add or remove components. Entities which leave the
+      /// view meanwhile aren't visited, and entities which join it are only
+      /// visited by the next call. Adding or removing components may move
+      /// other components in memory, so the pointers passed to the callback
+      /// must not be used after the callback does so. The following entities
+      /// are passed the new addresses.
       /// \tparam ComponentTypeTs All the desired component types.
       /// \warning This function should not be called outside of System's
       /// PreUpdate, Update, or PostUpdate callbacks.
@@ -481,6 +591,113 @@ namespace ignition
                   bool(const Entity &_entity,
                        ComponentTypeTs *...)>>::type _f);
 
+      /// \brief Same as the const version of Each above, but accepts any
+      /// callable, such as a lambda, and calls it directly. This avoids
+      /// building a std::function, which may allocate, on each call, and an
+      /// indirect call for each entity. This overload is picked for all
+      /// callables that aren't a std::function.
+      ///
+      /// The component types may also include the Without and Optional
+      /// filters, which are applied by the cached view instead of on every
+      /// call. Without<T> leaves out entities that have T and doesn't add a
+      /// parameter to the callable. Optional<T> passes T, or nullptr if the
+      /// entity doesn't have it. The other callable overloads, EachNew and
+      /// EachRemoved, accept the same filters.
+      /// \param[in] _f Callable with the signature
+      /// `bool(const Entity &, const ComponentTypeTs *...)`, minus the
+      /// Without filters.
+      /// \tparam ComponentTypeTs All the desired component types and filters.
+      /// \tparam Function Type of the callable, deduced from _f.
+      public: template<typename ...ComponentTypeTs, typename Function,
+                       typename = std::enable_if_t<
+                           !IsStdFunction<std::decay_t<Function>>::value>>
+              void Each(Function &&_f) const;
+
+      /// \brief Same as the mutable version of Each above, but accepts any
+      /// callable and calls it directly. See the const version.
+      /// \param[in] _f Callable with the signature
+      /// `bool(const Entity &, ComponentTypeTs *...)`.
+      /// \tparam ComponentTypeTs All the desired mutable component types.
+      /// \tparam Function Type of the callable, deduced from _f.
+      public: template<typename ...ComponentTypeTs, typename Function,
+                       typename = std::enable_if_t<
+                           !IsStdFunction<std::decay_t<Function>>::value>>
+              void Each(Function &&_f);
+
+      /// \brief Parallel version of Each. The entities that contain the given
+      /// component types are split into chunks which are processed
+      /// concurrently by a pool of worker threads owned by the entity
+      /// component manager. The calling thread also processes chunks, and
+      /// the call blocks until all the entities have been visited. Each
+      /// entity is visited exactly once, in no particular order.
+      ///
+      /// The callback may be called from several threads at once, so it must
+      /// be thread safe. While the iteration is running, only the following
+      /// is allowed inside the callback:
+      /// * Reading and writing the components passed to the callback.
+      /// * Read-only queries such as Component, ComponentData, HasEntity,
+      ///   EntityMatches and ParentEntity, as long as no other thread writes
+      ///   to the queried components.
+      ///
+      /// Anything else that modifies the entity component manager is not
+      /// allowed: creating or removing entities and components,
+      /// SetComponentData, SetChanged, and calls that build or update views,
+      /// such as Each, EachNew or EntityByComponents. Record those changes
+      /// in the CommandBuffer of the calling thread, which is applied at the
+      /// end of the current system phase, or collect them and apply them
+      /// after EachParallel returns. Changes recorded in the command buffer
+      /// are applied in the order of the entities they were recorded for,
+      /// whichever thread visited them.
+      ///
+      /// \param[in] _f Callback function to be called for each matching
+      /// entity.
+      /// \param[in] _chunkSize Number of entities per chunk. Use 0 to pick a
+      /// size based on the number of entities and threads.
+      /// \tparam ComponentTypeTs All the desired component types.
+      /// \warning This function should not be called outside of System's
+      /// PreUpdate, Update, or PostUpdate callbacks.
+      public: template<typename ...ComponentTypeTs>
+              void EachParallel(typename identity<std::function<
+                  void(const Entity &_entity,
+                       const ComponentTypeTs *...)>>::type _f,
+                  std::size_t _chunkSize = 0) const;
+
+      /// \brief Parallel version of Each, with mutable components. See the
+      /// const version for the rules that apply to the callback.
+      /// \param[in] _f Callback function to be called for each matching
+      /// entity.
+      /// \param[in] _chunkSize Number of entities per chunk. Use 0 to pick a
+      /// size based on the number of entities and threads.
+      /// \tparam ComponentTypeTs All the desired mutable component types.
+      /// \warning This function should not be called outside of System's
+      /// PreUpdate, Update, or PostUpdate callbacks.
+      public: template<typename ...ComponentTypeTs>
+              void EachParallel(typename identity<std::function<
+                  void(const Entity &_entity,
+                       ComponentTypeTs *...)>>::type _f,
+                  std::size_t _chunkSize = 0);
+
+      /// \brief Like EachParallel, but the callback is called once per chunk
+      /// with a contiguous range of entities and their components. This is
+      /// useful to set up per-chunk state, such as local accumulators, and
+      /// to keep the inner loop free of indirect calls. The same rules as
+      /// for EachParallel apply to the callback.
+      /// \param[in] _f Callback function to be called for each chunk. Its
+      /// parameters are a pointer to the first tuple of the chunk and the
+      /// number of tuples in the chunk. The first element of each tuple is
+      /// the entity, followed by its components in the order of
+      /// ComponentTypeTs.
+      /// \param[in] _chunkSize Number of entities per chunk. Use 0 to pick a
+      /// size based on the number of entities and threads.
+      /// \tparam ComponentTypeTs All the desired mutable component types.
+      /// \warning This function should not be called outside of System's
+      /// PreUpdate, Update, or PostUpdate callbacks.
+      public: template<typename ...ComponentTypeTs>
+              void ForEachChunk(typename identity<std::function<
+                  void(const std::tuple<Entity, ComponentTypeTs *...> *_chunk,
+                       std::size_t _count)>>::type _f,
+                  std::size_t _chunkSize = 0);
+
       /// \brief Call a function for each parameter in a pack.
       /// \param[in] _f Function to be called.
       /// \param[in] _components Parameters which should be passed to the
@@ -524,6 +741,28 @@ namespace ignition
                            bool(const Entity &_entity,
                                 const ComponentTypeTs *...)>>::type _f) const;
 
+      /// \brief Same as EachNew above, but accepts any callable and calls it
+      /// directly, like the Each overload which takes a callable. The same
+      /// warnings as for the std::function versions apply.
+      /// \param[in] _f Callable with the signature
+      /// `bool(const Entity &, ComponentTypeTs *...)`.
+      /// \tparam ComponentTypeTs All the desired component types.
+      /// \tparam Function Type of the callable, deduced from _f.
+      public: template<typename ...ComponentTypeTs, typename Function,
+                       typename = std::enable_if_t<
+                           !IsStdFunction<std::decay_t<Function>>::value>>
+              void EachNew(Function &&_f);
+
+      /// \brief Const version of EachNew which accepts any callable.
+      /// \param[in] _f Callable with the signature
+      /// `bool(const Entity &, const ComponentTypeTs *...)`.
+      /// \tparam ComponentTypeTs All the desired component types.
+      /// \tparam Function Type of the callable, deduced from _f.
+      public: template<typename ...ComponentTypeTs, typename Function,
+                       typename = std::enable_if_t<
+                           !IsStdFunction<std::decay_t<Function>>::value>>
+              void EachNew(Function &&_f) const;
+
       /// \brief Get all entities which contain given component types and are
       /// about to be removed, as well as the components.
       /// \param[in] _f Callback function to be called for each matching entity.
@@ -539,6 +778,17 @@ namespace ignition
                   bool(const Entity &_entity,
                        const ComponentTypeTs *...)>>::type _f) const;
 
+      /// \brief Same as EachRemoved above, but accepts any callable and calls
+      /// it directly, like the Each overload which takes a callable.
+      /// \param[in] _f Callable with the signature
+      /// `bool(const Entity &, const ComponentTypeTs *...)`.
+      /// \tparam ComponentTypeTs All the desired component types.
+      /// \tparam Function Type of the callable, deduced from _f.
+      public: template<typename ...ComponentTypeTs, typename Function,
+                       typename = std::enable_if_t<
+                           !IsStdFunction<std::decay_t<Function>>::value>>
+              void EachRemoved(Function &&_f) const;
+
       /// \brief Get a graph with all the entities. Entities are vertices and
       /// edges point from parent to children.
       /// \return Entity graph.
@@ -638,6 +888,78 @@ namespace ignition
       /// responsibility of the caller to timestamp it before use.
       public: void ChangedState(msgs::SerializedStateMap &_state) const;
 
+      /// \brief Get the current change tick. Creating or removing entities,
+      /// creating or removing components, changing their data through
+      /// SetComponentData and marking them as changed through SetChanged
+      /// advances the tick, and the entity and component remember
+      /// it. Unlike the changes reported by ChangedState, ticks aren't reset
+      /// every iteration, so any number of consumers can keep their own tick
+      /// and get the changes since then at their own rate, see
+      /// ChangedStateSince.
+      /// \return Tick of the latest change, or 0 if nothing changed yet.
+      public: uint64_t ChangeTick() const;
+
+      /// \brief Get the tick of the latest change of a component.
+      /// \param[in] _entity Entity.
+      /// \param[in] _typeId Component type.
+      /// \return Tick of the latest change, or 0 if the component never
+      /// changed.
+      public: uint64_t ComponentChangeTick(const Entity _entity,
+                  const ComponentTypeId _typeId) const;
+
+      /// \brief Get a message with the serialized state of all entities and
+      /// components that changed after a tick. The cost is proportional to
+      /// the number of entities that changed.
+      ///
+      /// This includes:
+      /// * Entities created after the tick and all of their components
+      /// * Entities removed or marked for removal after the tick
+      /// * Components created, removed or changed after the tick
+      ///
+      /// Typical usage is to start with the full state and ChangeTick(),
+      /// and then pass the tick read after every call to the next one.
+      /// \param[in] _tick Tick of the last query.
+      /// \param[out] _state The serialized state message to populate.
+      /// \return False if some entities that were removed after _tick
+      /// were forgotten because _tick is too old, in which case the caller
+      /// should get the full state instead.
+      public: bool ChangedStateSince(uint64_t _tick,
+                  msgs::SerializedStateMap &_state) const;
+
+      /// \brief Get the pose of an entity in the world frame, which is its
+      /// components::Pose composed with the poses of its ancestors through
+      /// components::ParentEntity, up to the first ancestor without a pose.
+      ///
+      /// If the cache is enabled, see EnableWorldPoseCache, world poses are
+      /// computed on demand and cached, together with those of the
+      /// ancestors, so repeated queries take constant time. Otherwise the
+      /// ancestors are walked on every call.
+      /// This function is thread safe with respect to other const functions.
+      /// \param[in] _entity Entity.
+      /// \param[out] _pose World pose.
+      /// \return False if the entity doesn't have a components::Pose.
+      public: bool CachedWorldPose(const Entity _entity,
+                  math::Pose3d &_pose) const;
+
+      /// \brief Enable or disable caching world poses in CachedWorldPose.
+      /// It's disabled by default.
+      ///
+      /// A change to the Pose or ParentEntity component of an entity
+      /// invalidates the cached poses of the entity and its descendants.
+      /// Changes are only seen if they're made through CreateComponent,
+      /// SetComponentData or RemoveComponent, or marked with SetChanged.
+      /// Only enable the cache if all the code that writes those components,
+      /// such as the loaded systems, calls SetChanged after writing through
+      /// the pointer returned by Component. Otherwise cached poses may be
+      /// stale.
+      /// \param[in] _enable True to cache world poses.
+      /// \sa ServerConfig::SetWorldPoseCache
+      public: void EnableWorldPoseCache(const bool _enable);
+
+      /// \brief Get whether CachedWorldPose caches world poses.
+      /// \return True if the cache is enabled.
+      public: bool WorldPoseCacheEnabled() const;
+
       /// \brief Set the absolute state of the ECM from a serialized message.
       /// Entities / components that are in the new state but not in the old
       /// one will be created.
@@ -648,6 +970,58 @@ namespace ignition
       /// \param[in] _stateMsg Message containing state to be set.
       public: void SetState(const msgs::SerializedStateMap &_stateMsg);
 
+      /// \brief Get the state of the given entities and components in the
+      /// binary state format. Components are grouped by type into columns,
+      /// which are written without going through protobuf or a stream per
+      /// component. Components are serialized inside a
+      /// serializers::BinarySerializationScope. See BinaryStateHeader for the
+      /// layout, and BinaryStateView to read the result.
+      /// \param[out] _buffer Buffer to write to. Its previous contents are
+      /// discarded, but its capacity is reused, so passing the same buffer
+      /// every time avoids reallocations.
+      /// \param[in] _entities Entities to be serialized. Leave empty to get
+      /// all entities.
+      /// \param[in] _types Type ID of components to be serialized. Leave empty
+      /// to get all components.
+      public: void BinaryState(
+                  std::vector<char> &_buffer,
+                  const std::unordered_set<Entity> &_entities = {},
+                  const std::unordered_set<ComponentTypeId> &_types = {})
+                  const;
+
+      /// \brief Set the absolute state of the ECM from a binary state buffer.
+      /// Entities / components that are in the new state but not in the old
+      /// one will be created, and entities that are marked as removed will be
+      /// removed, the same way as SetState does. Components are read in place
+      /// from the buffer.
+      /// \param[in] _state View of the buffer, which must be valid.
+      /// \return False if the view is invalid.
+      public: bool SetBinaryState(const BinaryStateView &_state);
+
+      /// \brief Copy all entities, components and the entity tree, so that
+      /// the manager can be brought back to this state later with Restore.
+      /// Components are cloned as they are, without serialization, so this is
+      /// much faster than State and SetState.
+      /// \return The snapshot. It doesn't depend on this manager, so it can
+      /// be restored many times, and into other managers.
+      public: std::shared_ptr<const EntityComponentManagerSnapshot> Snapshot()
+                  const;
+
+      /// \brief Bring all entities and components back to a snapshot taken
+      /// with Snapshot.
+      ///
+      /// Entities keep the IDs they had in the snapshot. Components of
+      /// entities which still exist are copied into the current instances,
+      /// so views are kept instead of rebuilt, and the components are
+      /// marked as OneTimeChange. Entities which were removed since the
+      /// snapshot are created again, and entities which were created since
+      /// the snapshot are requested to be removed, so that systems see them
+      /// through EachNew and EachRemoved. Pending removal requests are
+      /// processed first. IDs aren't reused: entities created after
+      /// restoring get IDs after all those handed out before.
+      /// \param[in] _snapshot Snapshot to restore.
+      public: void Restore(const EntityComponentManagerSnapshot &_snapshot);
+
       /// \brief Set the changed state of a component.
       /// \param[in] _entity The entity.
       /// \param[in] _type Type of the component.
@@ -690,6 +1064,44 @@ namespace ignition
       /// \brief Mark all components as not changed.
       protected: void SetAllComponentsUnchanged();
 
+      /// \brief Apply the command buffers of all threads and keep them for
+      /// reuse. Buffers requested within a CommandScope are applied in the
+      /// order of the scopes' keys, followed by those of threads outside any
+      /// scope, in the order in which they were first requested. This
+      /// function is protected to facilitate testing.
+      protected: void ApplyCommandBuffers();
+
+      /// \brief While an instance exists, the command buffer the calling
+      /// thread requests belongs to this scope, so that the order in which
+      /// buffers are applied doesn't depend on thread scheduling. The runner
+      /// opens a scope keyed by the registration order of each system it
+      /// calls. Scopes nest: the buffers of inner scopes are applied right
+      /// after their enclosing scope's, in the order of their keys.
+      protected: class IGNITION_GAZEBO_VISIBLE CommandScope
+      {
+        /// \brief Constructor
+        /// \param[in] _key Order of the scope within its enclosing scope.
+        public: explicit CommandScope(uint64_t _key);
+
+        /// \brief Destructor, restores the enclosing scope.
+        public: ~CommandScope();
+      };
+
+      /// \brief Make this manager a copy of another one, as it is now, for
+      /// systems which lag one iteration behind it.
+      ///
+      /// New entities, entities marked for removal and changed components
+      /// are the same as in the source manager. Only the entities and
+      /// components which changed since the previous call with the same
+      /// source are copied, so component values modified through the pointer
+      /// returned by Component must be followed by SetChanged, or the copy
+      /// keeps the old value. The previous iteration must have been finished
+      /// by clearing new entities, processing removals and marking
+      /// components as unchanged. Change ticks used by ChangedStateSince
+      /// aren't copied. This function is protected to facilitate testing.
+      /// \param[in] _source Manager to copy.
+      protected: void Mirror(const EntityComponentManager &_source);
+
       /// \brief Get whether an Entity exists and is new.
       ///
       /// Entities are considered new in the time between their creation and a
@@ -715,6 +1127,31 @@ namespace ignition
                    const ComponentTypeId _componentTypeId,
                    const components::BaseComponent *_data);
 
+      /// \brief Implementation of CreateComponents.
+      /// \param[in] _entity The entity that will be associated with
+      /// the components.
+      /// \param[in, out] _data Data used to construct each component. The
+      /// elements whose data doesn't need to be set externally are set to
+      /// nullptr.
+      /// \return False if no component could be created.
+      private: bool CreateComponentsImplementation(
+                   const Entity _entity,
+                   std::vector<const components::BaseComponent *> &_data);
+
+      /// \brief Implementation of CreateComponents for several entities.
+      /// The entities which don't have the component yet are added to the
+      /// storage together, and views are updated once for all of them.
+      /// \param[in] _entities The entities that will be associated with
+      /// the component.
+      /// \param[in] _data Data used to construct the components.
+      /// \param[out] _existing Entities which already had the component,
+      /// whose data needs to be set externally.
+      /// \return Number of components that were created or restored.
+      private: std::size_t CreateComponentsImplementation(
+                   const std::vector<Entity> &_entities,
+                   const components::BaseComponent *_data,
+                   std::vector<Entity> &_existing);
+
       /// \brief Get a component based on a component type.
       /// \param[in] _entity The entity.
       /// \param[in] _type Id of the component type.
@@ -733,6 +1170,56 @@ namespace ignition
                    const Entity _entity,
                    const ComponentTypeId _type);
 
+      /// \brief Function which hashes the data of a component.
+      private: using ValueHashFn = std::function<
+                   std::size_t(const components::BaseComponent &)>;
+
+      /// \brief Implementation of EnableValueIndex.
+      /// \param[in] _typeId Component type.
+      /// \param[in] _hash Function which hashes the data of components of
+      /// type _typeId.
+      private: void EnableValueIndex(const ComponentTypeId _typeId,
+                   ValueHashFn _hash);
+
+      /// \brief Record that the data of a component changed, advancing the
+      /// change tick. Used by the templates which set component data.
+      /// \param[in] _entity Entity.
+      /// \param[in] _typeId Component type.
+      private: void MarkComponentChanged(const Entity _entity,
+                   const ComponentTypeId _typeId);
+
+      /// \brief Get the candidate entities for a lookup by value from the
+      /// value indexes. The most selective index among the desired
+      /// components is used.
+      /// \param[in] _desiredComponents Components whose values are looked up.
+      /// \param[out] _candidates Entities which may match, in ascending
+      /// order. They have the same value hash as the desired component, so
+      /// they still need to be compared to it.
+      /// \return False if none of the desired component types is indexed.
+      private: bool IndexedCandidates(
+                   const std::vector<const components::BaseComponent *>
+                   &_desiredComponents,
+                   std::vector<Entity> &_candidates) const;
+
+      /// \brief Get whether an entity has components equal to all the given
+      /// components.
+      /// \param[in] _entity Entity.
+      /// \param[in] _desiredComponents All the components which must match.
+      /// \return True if all the components match.
+      private: template<typename ...ComponentTypeTs>
+               bool EntityMatchesComponents(const Entity _entity,
+                   const ComponentTypeTs &..._desiredComponents) const;
+
+      /// \brief Get the first child of an entity.
+      /// \param[in] _entity Entity.
+      /// \return The first child, or kNullEntity if there's none.
+      private: Entity FirstChild(const Entity _entity) const;
+
+      /// \brief Get the child of the same parent which follows an entity.
+      /// \param[in] _entity Entity.
+      /// \return The next sibling, or kNullEntity if there's none.
+      private: Entity NextSibling(const Entity _entity) const;
+
       /// \brief Find a View that matches the set of ComponentTypeIds. If
       /// a match is not found, then a new view is created.
       /// \tparam ComponentTypeTs All the component types that define a view.
@@ -740,6 +1227,94 @@ namespace ignition
       private: template<typename ...ComponentTypeTs>
           detail::View<ComponentTypeTs...> *FindView() const;
 
+      /// \brief Get the view data of an entity for Each. Each iterates over
+      /// the view's packed data by index. If a callback adds or removes
+      /// components, and thus changes the view, the iteration carries on
+      /// over the entities that the view had when it started, so that it
+      /// doesn't skip or revisit entities. Entities whose components moved
+      /// since are fetched again, see CurrentViewData.
+      /// \param[in] _view The view.
+      /// \param[in] _iteration The iteration started by Each.
+      /// \param[in] _index Index of the entity when Each started.
+      /// \param[out] _entry The entity's current data in the view.
+      /// \tparam ComponentTypeTs The template arguments of the view.
+      /// \tparam EntryT ComponentData or ConstComponentData of the view.
+      /// \return False if the entity has left the view since.
+      private: template<typename ...ComponentTypeTs, typename EntryT>
+          bool EachEntry(detail::View<ComponentTypeTs...> *_view,
+              const detail::ViewIteration &_iteration,
+              const std::size_t _index, EntryT &_entry) const;
+
+      /// \brief Get the current data of an entity which is part of a view.
+      /// The view's copy is used, unless the entity is marked to be updated
+      /// the next time the view is used, since its components may have moved
+      /// in the storage, see detail::BaseView::MarkEntityToUpdate. This
+      /// allows iterating over a view while callbacks add and remove
+      /// components.
+      /// \param[in] _view The view.
+      /// \param[in] _entity The entity, which must be part of the view.
+      /// \tparam ComponentTypeTs The template arguments of the view.
+      /// \return The entity followed by its components.
+      private: template<typename ...ComponentTypeTs>
+          typename detail::View<ComponentTypeTs...>::ComponentData
+          CurrentViewData(detail::View<ComponentTypeTs...> *_view,
+              const Entity _entity) const;
+
+      /// \brief Get the data that a view stores for an entity.
+      /// \param[in] _entity The entity, which must match the view.
+      /// \tparam ComponentTypeTs The template arguments of the view.
+      /// \return The entity followed by its components, see
+      /// detail::View::ComponentData.
+      private: template<typename ...ComponentTypeTs>
+          typename detail::View<ComponentTypeTs...>::ComponentData ViewData(
+              const Entity _entity) const;
+
+      /// \brief Get the data that one slot of a view stores for an entity.
+      /// \param[in] _entity The entity.
+      /// \tparam SlotT A template argument of the view.
+      /// \return The component in a tuple, or an empty tuple for Without.
+      private: template<typename SlotT>
+          typename detail::ViewSlot<SlotT>::Data ViewSlotData(
+              const Entity _entity) const;
+
+      /// \brief Check whether an entity belongs to a view, that is, whether
+      /// it has all the component types required by the view and none of
+      /// the types excluded by it.
+      /// \param[in] _entity The entity.
+      /// \param[in] _view The view.
+      /// \return True if the entity belongs to the view.
+      private: bool EntityMatchesView(const Entity _entity,
+                   const detail::BaseView &_view) const;
+
+      /// \brief Get the entities which have all the given component types
+      /// and none of the excluded ones. Matching is done once per group of
+      /// entities with the same component types, instead of once per
+      /// entity.
+      /// \param[in] _types Component types the entities must have.
+      /// \param[in] _excluded Component types the entities must not have.
+      /// \return The matching entities.
+      private: std::vector<Entity> EntitiesMatching(
+                   const std::set<ComponentTypeId> &_types,
+                   const std::set<ComponentTypeId> &_excluded) const;
+
+      /// \brief Split the range [0, _count) into chunks and call a function
+      /// for each chunk on the worker pool, blocking until all chunks are
+      /// done. The pool is created the first time this is called.
+      /// \param[in] _count Number of elements.
+      /// \param[in] _chunkSize Number of elements per chunk, or 0 to pick
+      /// one automatically.
+      /// \param[in] _fn Function called with the begin and end indices of
+      /// each chunk.
+      private: void ParallelChunks(std::size_t _count, std::size_t _chunkSize,
+                   const std::function<void(std::size_t, std::size_t)> &_fn)
+                   const;
+
+      /// \brief Set the worker pool used by parallel iteration, so that the
+      /// manager shares the threads of its owner instead of creating its own
+      /// pool. It must be called before the first parallel iteration.
+      /// \param[in] _pool Pool, which must outlive the manager's use of it.
+      private: void SetWorkerPool(WorkStealingPool *_pool);
+
       /// \brief Find a view based on the provided component type ids.
       /// \param[in] _types The component type ids that serve as a key into
       /// a map of views.
@@ -750,6 +1325,14 @@ namespace ignition
       private: std::pair<detail::BaseView *, std::mutex *> FindView(
                    const std::vector<ComponentTypeId> &_types) const;
 
+      /// \brief Get the epoch of the views. Epochs are unique across all
+      /// entity component managers, and a manager gets a new one whenever
+      /// its views are destroyed, so views found while the epoch was the
+      /// same are still valid. This can be called from any thread without
+      /// locking.
+      /// \return The epoch.
+      private: uint64_t ViewsEpoch() const;
+
       /// \brief Add a new view to the set of stored views.
       /// \param[in] _types The set of component type ids that act as the key
       /// for the view.
@@ -759,6 +1342,33 @@ namespace ignition
                    const detail::ComponentTypeKey &_types,
                    std::unique_ptr<detail::BaseView> _view) const;
 
+      /// \brief Function which adds the entities waiting to be added to a
+      /// view, see FlushView.
+      private: using ViewFlushFn = void (*)(const EntityComponentManager &,
+                   detail::BaseView &);
+
+      /// \brief Add a new view to the set of stored views, along with the
+      /// function that adds the entities waiting to be added to it.
+      /// \param[in] _types The set of component type ids that act as the key
+      /// for the view.
+      /// \param[in] _view The view to add.
+      /// \param[in] _flush Function that adds waiting entities to the view.
+      /// \return A pointer to the view.
+      private: detail::BaseView *AddView(
+                   const detail::ComponentTypeKey &_types,
+                   std::unique_ptr<detail::BaseView> _view,
+                   ViewFlushFn _flush) const;
+
+      /// \brief Add the entities waiting to be added to a view, with their
+      /// component data.
+      /// \param[in] _ecm Manager the view belongs to.
+      /// \param[in] _view The view, which must be a
+      /// View<ComponentTypeTs...>.
+      /// \tparam ComponentTypeTs Component types of the view.
+      private: template<typename ...ComponentTypeTs>
+               static void FlushView(const EntityComponentManager &_ecm,
+                   detail::BaseView &_view);
+
       /// \brief Add an entity and its components to a serialized state message.
       /// \param[out] _msg The state message.
       /// \param[in] _entity The entity to be added.
@@ -791,6 +1401,8 @@ namespace ignition
       /// added to views when the view is used, so if two systems try to access
       /// the same view in PostUpdate, we run the risk of multiple threads
       /// reading/writing from the same data).
+      /// Locking first adds the waiting entities to all views, so that a
+      /// view's data doesn't grow while another thread iterates over it.
       /// \param[in] _lock Whether the views should lock while entities are
       /// being added to them (true) or not (false).
       private: void LockAddingEntitiesToViews(bool _lock);
@@ -801,12 +1413,25 @@ namespace ignition
       /// otherwise.
       private: bool LockAddingEntitiesToViews() const;
 
+      /// \brief Reserve the ID of an entity which will be created later
+      /// through CreateReservedEntity. This is thread-safe.
+      /// \return The reserved ID, or kNullEntity if there are no IDs left.
+      private: Entity ReserveEntity();
+
+      /// \brief Create an entity whose ID was obtained from ReserveEntity.
+      /// \param[in] _entity Reserved entity ID.
+      /// \return The entity.
+      private: Entity CreateReservedEntity(const Entity _entity);
+
       // Make runners friends so that they can manage entity creation and
       // removal. This should be safe since runners are internal
       // to Gazebo.
       friend class GuiRunner;
       friend class SimulationRunner;
 
+      // Command buffers create the entities they reserved
+      friend class EntityCommandBuffer;
+
       // Make network managers friends so they have control over component
       // states. Like the runners, the managers are internal.
       friend class NetworkManagerPrimary;
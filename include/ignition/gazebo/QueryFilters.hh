@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_QUERYFILTERS_HH_
+#define IGNITION_GAZEBO_QUERYFILTERS_HH_
+
+#include <ignition/gazebo/config.hh>
+
+namespace ignition
+{
+namespace gazebo
+{
+// Inline bracket to help doxygen filtering.
+inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+  /// \brief Filter for EntityComponentManager::Each, EachNew and
+  /// EachRemoved which skips entities that have a component. It doesn't add
+  /// a parameter to the callback.
+  ///
+  /// Filtering is done by the view when components are added or removed,
+  /// not on every call, so it's cheaper than checking for the component
+  /// inside the callback.
+  ///
+  /// \code
+  /// // Iterate over all models which aren't static
+  /// _ecm.Each<components::Model, Without<components::Static>>(
+  ///     [&](const Entity &_entity, const components::Model *) -> bool
+  ///     {
+  ///       return true;
+  ///     });
+  /// \endcode
+  /// \tparam ComponentTypeT Type of component which entities must not have.
+  template <typename ComponentTypeT>
+  struct Without
+  {
+    /// \brief The component type.
+    using Type = ComponentTypeT;
+  };
+
+  /// \brief Filter for EntityComponentManager::Each, EachNew and
+  /// EachRemoved which passes a component to the callback if the entity has
+  /// it, and nullptr otherwise. Entities are visited whether or not they
+  /// have the component.
+  ///
+  /// The component is cached by the view, like the required components, so
+  /// it's cheaper than calling EntityComponentManager::Component inside the
+  /// callback.
+  ///
+  /// \code
+  /// // Iterate over all models, with their Static component if they have one
+  /// _ecm.Each<components::Model, Optional<components::Static>>(
+  ///     [&](const Entity &_entity, const components::Model *,
+  ///         const components::Static *_static) -> bool
+  ///     {
+  ///       bool isStatic = _static && _static->Data();
+  ///       return true;
+  ///     });
+  /// \endcode
+  /// \tparam ComponentTypeT Type of component which entities may have.
+  template <typename ComponentTypeT>
+  struct Optional
+  {
+    /// \brief The component type.
+    using Type = ComponentTypeT;
+  };
+}
+}
+}
+
+#endif
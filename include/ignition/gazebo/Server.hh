@@ -17,6 +17,7 @@
 #ifndef IGNITION_GAZEBO_SERVER_HH_
 #define IGNITION_GAZEBO_SERVER_HH_
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -36,6 +37,20 @@ namespace ignition
     // Forware declarations
     class ServerPrivate;
 
+    /// \brief State of a world captured by Server::Snapshot, which
+    /// Server::Restore brings the world back to.
+    struct WorldSnapshot
+    {
+      /// \brief Entities and components of the world.
+      std::shared_ptr<const EntityComponentManagerSnapshot> ecm;
+
+      /// \brief Simulation time when the snapshot was taken.
+      std::chrono::steady_clock::duration simTime{0};
+
+      /// \brief Iteration count when the snapshot was taken.
+      uint64_t iterations{0};
+    };
+
     /// \class Server Server.hh ignition/gazebo/Server.hh
     /// \brief The server instantiates and controls simulation.
     ///
@@ -281,6 +296,31 @@ namespace ignition
                                       bool _recursive = true,
                                       const unsigned int _worldIndex = 0);
 
+      /// \brief Capture the entities, components and simulation time of a
+      /// world, so that it can be brought back to this state with Restore.
+      /// This is much faster than loading the world again, which makes it
+      /// suitable for episodic resets. The server must not be running when
+      /// calling this.
+      /// \param[in] _worldIndex Index of the world.
+      /// \return The snapshot, or std::nullopt if _worldIndex is invalid or
+      /// the server is running.
+      public: std::optional<WorldSnapshot> Snapshot(
+                  const unsigned int _worldIndex = 0);
+
+      /// \brief Bring a world back to a snapshot taken with Snapshot. See
+      /// EntityComponentManager::Restore for how entities and components are
+      /// restored. Systems see the changes on the next iteration. Systems
+      /// which implement ISystemReset, such as the Physics system, are reset
+      /// before this returns. Other systems keep their internal state, for
+      /// example a controller's integrator. The server must not be running
+      /// when calling this.
+      /// \param[in] _snapshot Snapshot of the same world.
+      /// \param[in] _worldIndex Index of the world.
+      /// \return False if _worldIndex or the snapshot is invalid, or the
+      /// server is running.
+      public: bool Restore(const WorldSnapshot &_snapshot,
+                  const unsigned int _worldIndex = 0);
+
       /// \brief Private data
       private: std::unique_ptr<ServerPrivate> dataPtr;
     };
@@ -289,6 +289,81 @@ namespace ignition
       /// \param[in] _seed The seed.
       public: void SetSeed(unsigned int _seed);
 
+      /// \brief Set the number of worker threads which run PostUpdate
+      /// systems, as well as PreUpdate and Update systems that can run
+      /// concurrently. The entity component manager's parallel iteration,
+      /// such as EachParallel, uses the same threads. The simulation thread
+      /// also runs systems while it waits for the workers, so zero runs all
+      /// systems on the simulation thread.
+      /// \param[in] _count Number of worker threads.
+      /// \sa ISystemComponentAccess
+      public: void SetSystemWorkerCount(unsigned int _count);
+
+      /// \brief Get the number of worker threads which run systems.
+      /// \return The number of worker threads, or nullopt if it hasn't been
+      /// set, in which case it's one less than the number of hardware
+      /// threads.
+      public: std::optional<unsigned int> SystemWorkerCount() const;
+
+      /// \brief Set whether PostUpdate systems which tolerate lag run in
+      /// parallel with the next iteration. Such systems are given a copy of
+      /// the entity component manager as it was at the end of an iteration,
+      /// while the PreUpdate and Update systems of the following iteration
+      /// proceed on the live one. Other PostUpdate systems aren't affected.
+      /// Only changed components are copied, so systems which modify
+      /// components through the pointer returned by
+      /// EntityComponentManager::Component must call SetChanged.
+      /// \param[in] _pipelined True to pipeline PostUpdate.
+      /// \sa ISystemPostUpdateLag
+      public: void SetPipelinedPostUpdate(const bool _pipelined);
+
+      /// \brief Get whether PostUpdate systems which tolerate lag run in
+      /// parallel with the next iteration.
+      /// \return True if PostUpdate is pipelined. The default is false.
+      public: bool PipelinedPostUpdate() const;
+
+      /// \brief Set whether the server caches the world poses returned by
+      /// worldPose(), see EntityComponentManager::EnableWorldPoseCache.
+      /// Only enable it if all the loaded systems call SetChanged after
+      /// writing components::Pose and components::ParentEntity.
+      /// \param[in] _cache True to cache world poses.
+      public: void SetWorldPoseCache(const bool _cache);
+
+      /// \brief Get whether the server caches world poses.
+      /// \return True if world poses are cached. The default is false.
+      public: bool WorldPoseCache() const;
+
+      /// \brief Set whether the server indexes the values of
+      /// components::Name, components::ParentEntity and
+      /// components::ParentLinkName, which speeds up looking entities up by
+      /// them, see EntityComponentManager::EnableValueIndex. Only enable it
+      /// if all the loaded systems call SetChanged after writing those
+      /// components.
+      /// \param[in] _index True to index the component values.
+      public: void SetComponentValueIndexes(const bool _index);
+
+      /// \brief Get whether the server indexes component values.
+      /// \return True if component values are indexed. The default is false.
+      public: bool ComponentValueIndexes() const;
+
+      /// \brief Run in throughput mode, for batch jobs which step faster
+      /// than real time. In this mode, the server doesn't sleep between
+      /// unpaused iterations, ignoring the update rate, and it only
+      /// processes world control requests and publishes statistics and the
+      /// clock every _iterations iterations. Control requests received in
+      /// between are processed at the next iteration. The iterations per
+      /// second are added to the header of the statistics, and logged at
+      /// the end of each run.
+      /// \param[in] _iterations Number of iterations between statistics.
+      /// Zero is the same as one.
+      public: void SetThroughputPeriod(unsigned int _iterations);
+
+      /// \brief Get the number of iterations between statistics in
+      /// throughput mode.
+      /// \return The number of iterations, or nullopt if throughput mode is
+      /// disabled, which is the default.
+      public: std::optional<unsigned int> ThroughputPeriod() const;
+
       /// \brief Get the update period duration.
       /// \return The desired update period, or nullopt if
       /// an UpdateRate has not been set.
@@ -18,6 +18,7 @@
 #define IGNITION_GAZEBO_SYSTEM_HH_
 
 #include <memory>
+#include <set>
 
 #include <ignition/gazebo/config.hh>
 #include <ignition/gazebo/EntityComponentManager.hh>
@@ -114,12 +115,105 @@ namespace ignition
                                   EntityComponentManager &_ecm) = 0;
     };
 
+    /// \class ISystemComponentAccess ISystem.hh ignition/gazebo/System.hh
+    /// \brief Interface for a system that declares the component types which
+    /// its PreUpdate and Update read and write, so that it can run at the
+    /// same time as other systems which don't access the same types.
+    ///
+    /// Systems which don't implement this interface run alone, in the order
+    /// in which they were added. Consecutive systems which implement it run
+    /// concurrently on a pool of worker threads, except that a system which
+    /// writes a type that another one reads or writes runs after it if it
+    /// was added after it.
+    ///
+    /// While running concurrently, a system must follow the same rules as
+    /// PostUpdate systems and EachParallel callbacks:
+    ///  * It can read components of the declared types and modify components
+    ///    of the written types, through the pointers given by Component, Each
+    ///    and EachNew.
+    ///  * It can use Each, EachNew, EachRemoved and read-only queries such as
+    ///    Component, ComponentData, HasEntity and ParentEntity.
+    ///  * Anything else that modifies the entity component manager, such as
+    ///    creating or removing entities and components, SetComponentData or
+    ///    SetChanged, must be recorded in
+    ///    EntityComponentManager::CommandBuffer, which is applied at the end
+    ///    of the phase. Changes recorded by systems that ran concurrently are
+    ///    applied in no particular order relative to each other.
+    ///
+    /// Systems loaded from plugins must list this interface when they are
+    /// registered with IGNITION_ADD_PLUGIN.
+    class ISystemComponentAccess {
+      /// \brief Declare the component types accessed by PreUpdate and Update.
+      /// This is called once, when the system is added to the simulation.
+      /// \param[out] _reads Types which are only read.
+      /// \param[out] _writes Types which are modified, created or removed,
+      /// directly or through a command buffer.
+      public: virtual void ComponentAccess(
+                  std::set<ComponentTypeId> &_reads,
+                  std::set<ComponentTypeId> &_writes) const = 0;
+    };
+
     /// \class ISystemPostUpdate ISystem.hh ignition/gazebo/System.hh
     /// \brief Interface for a system that uses the PostUpdate phase
+    ///
+    /// PostUpdates run as tasks on a pool of threads shared by all systems,
+    /// so they must not block for long, for example waiting for a network
+    /// reply. A blocked PostUpdate holds its thread, leaving fewer threads
+    /// for the other systems. Work that has to wait should be handed to a
+    /// thread owned by the system instead. The Sensors system is the
+    /// exception: it waits for its rendering thread to finish the previous
+    /// frame, so that sensors are rendered from the state they were
+    /// updated at.
     class ISystemPostUpdate{
       public: virtual void PostUpdate(const UpdateInfo &_info,
                                       const EntityComponentManager &_ecm) = 0;
     };
+
+    /// \class ISystemPostUpdateLag ISystem.hh ignition/gazebo/System.hh
+    /// \brief Interface for a PostUpdate system that can run one iteration
+    /// behind the rest of the simulation, such as a sensor or a publisher.
+    ///
+    /// When ServerConfig::SetPipelinedPostUpdate is enabled, the PostUpdate
+    /// of such a system is given a copy of the entity component manager as
+    /// it was at the end of an iteration, and runs while the PreUpdate and
+    /// Update of the next iteration proceed. The copy reports the same new,
+    /// removed and changed entities and components as the original did at
+    /// the end of that iteration. Otherwise, the system runs like any other
+    /// PostUpdate system.
+    ///
+    /// A pipelined PostUpdate may run at the same time as the system's own
+    /// PreUpdate and Update, so any state shared between them must be
+    /// synchronized.
+    ///
+    /// Systems loaded from plugins must list this interface when they are
+    /// registered with IGNITION_ADD_PLUGIN.
+    class ISystemPostUpdateLag {
+      /// \brief Whether PostUpdate tolerates one iteration of lag. This is
+      /// called once, when the system is added to the simulation.
+      /// \return True to let PostUpdate be pipelined.
+      public: virtual bool PostUpdateLagTolerated() const = 0;
+    };
+
+    /// \class ISystemReset ISystem.hh ignition/gazebo/System.hh
+    /// \brief Interface for a system which keeps state outside of the
+    /// entity component manager, such as a physics engine, and can bring it
+    /// back in line with the entity component manager after the world was
+    /// restored to a snapshot with Server::Restore.
+    ///
+    /// Systems which don't implement this interface keep their internal
+    /// state across restores.
+    ///
+    /// Systems loaded from plugins must list this interface when they are
+    /// registered with IGNITION_ADD_PLUGIN.
+    class ISystemReset {
+      /// \brief Called once the world was restored, before the next
+      /// iteration runs.
+      /// \param[in] _info Simulation time the world was restored to.
+      /// \param[in] _ecm Entity component manager holding the restored
+      /// state.
+      public: virtual void Reset(const UpdateInfo &_info,
+                                 EntityComponentManager &_ecm) = 0;
+    };
   }
   }
 }
@@ -52,6 +52,14 @@ class IGNITION_GAZEBO_HIDDEN TestFixturePrivate;
 /// // Run the server
 /// fixture.Server()->Run(true, 1000, false);
 ///
+/// // To run several episodes, save the state to start each of them from
+/// fixture.SaveState();
+/// fixture.Server()->Run(true, 1000, false);
+///
+/// // Go back to the saved state and run again
+/// fixture.Reset();
+/// fixture.Server()->Run(true, 1000, false);
+///
 class IGNITION_GAZEBO_VISIBLE TestFixture
 {
   /// \brief Constructor
@@ -99,6 +107,18 @@ class IGNITION_GAZEBO_VISIBLE TestFixture
   /// The `OnConfigure` callback is called immediately on finalize.
   public: TestFixture &Finalize();
 
+  /// \brief Save the current state of the world, which Reset brings it
+  /// back to. The fixture must be finalized and the server must not be
+  /// running. Calling this again replaces the saved state.
+  /// \return Reference to self.
+  public: TestFixture &SaveState();
+
+  /// \brief Bring the world back to the state saved with SaveState,
+  /// without loading it again. This is useful to run many episodes of the
+  /// same world. The server must not be running.
+  /// \return Reference to self.
+  public: TestFixture &Reset();
+
   /// \brief Get pointer to underlying server.
   public: std::shared_ptr<gazebo::Server> Server() const;
 
@@ -35,7 +35,8 @@ namespace ignition
     // Inline bracket to help doxygen filtering.
     inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
     //
-    /// \brief Helper function to compute world pose of an entity
+    /// \brief Helper function to compute world pose of an entity. The result
+    /// is cached by the ECM, see EntityComponentManager::CachedWorldPose.
     /// \param[in] _entity Entity to get the world pose for
     /// \param[in] _ecm Immutable reference to ECM.
     /// \return World pose of entity
@@ -17,17 +17,28 @@
 #ifndef IGNITION_GAZEBO_COMPONENTS_COMPONENT_HH_
 #define IGNITION_GAZEBO_COMPONENTS_COMPONENT_HH_
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <new>
 #include <string>
 #include <sstream>
+#include <type_traits>
 #include <utility>
 
 #include <ignition/common/Console.hh>
+#include <ignition/math/Color.hh>
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Quaternion.hh>
+#include <ignition/math/Vector2.hh>
+#include <ignition/math/Vector3.hh>
+#include <ignition/math/Vector4.hh>
 
 #include <ignition/gazebo/config.hh>
 #include <ignition/gazebo/Export.hh>
 #include <ignition/gazebo/Types.hh>
+#include <ignition/gazebo/components/ComponentPool.hh>
 
 namespace ignition
 {
@@ -96,13 +107,370 @@ namespace traits
     public: static constexpr bool value =  // NOLINT
                 decltype(Test<Stream, DataType>(0))::value;
   };
+
+  /// \brief Type trait that determines if a component's data can be copied
+  /// by assignment, i.e, it checks if
+  /// `_to.Data() = std::as_const(_from).Data()` is valid.
+  template <typename ComponentTypeT>
+  class HasAssignableData
+  {
+    private: template <typename ComponentTypeArg>
+    static auto Test(int _test)
+        -> decltype(std::declval<ComponentTypeArg &>().Data() =
+                    std::declval<const ComponentTypeArg &>().Data(),
+                    std::true_type());
+
+    private: template <typename>
+    static auto Test(...) -> std::false_type;
+
+    public: static constexpr bool value =  // NOLINT
+                decltype(Test<ComponentTypeT>(0))::value;
+  };
 }
 
 namespace serializers
 {
-  /// \brief Default serializer template to call stream operators only on types
-  /// that support them. If the stream operator is not available, a warning
+  /// \brief First byte of data written by the binary serialization path. It
+  /// never starts the output of `operator<<`, so deserialization can tell
+  /// binary data from text written by older versions.
+  constexpr char kBinarySerializationMarker{'\0'};
+
+  /// \brief While an instance is alive, DefaultSerializer writes binary data
+  /// on the calling thread for the types that support it, see BinaryCodec.
+  /// Scopes can be nested.
+  ///
+  /// Binary data isn't valid UTF-8, so it must not be stored in protobuf
+  /// `string` fields such as `msgs::SerializedComponent::component`. Outside
+  /// of a scope components are serialized as text, which is what messages
+  /// and logs use. Both formats are always accepted when deserializing.
+  class IGNITION_GAZEBO_VISIBLE BinarySerializationScope
+  {
+    /// \brief Constructor. Starts writing binary data on this thread.
+    public: BinarySerializationScope();
+
+    /// \brief Destructor. Restores the previous format on this thread.
+    public: ~BinarySerializationScope();
+
+    /// \brief Scopes are tied to the thread and block that created them.
+    public: BinarySerializationScope(
+        const BinarySerializationScope &) = delete;
+
+    /// \brief Scopes are tied to the thread and block that created them.
+    public: BinarySerializationScope &operator=(
+        const BinarySerializationScope &) = delete;
+  };
+
+  /// \brief Get whether DefaultSerializer writes binary data for the types
+  /// that support it on the calling thread, which is only the case inside a
+  /// BinarySerializationScope.
+  /// \return True if binary data is written.
+  bool IGNITION_GAZEBO_VISIBLE BinarySerialization();
+
+  /// \brief Whether the host stores integers and floating point numbers in
+  /// little-endian order, which is the byte order of binary data.
+  constexpr bool kLittleEndianHost{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+      false
+#else
+      true
+#endif
+  };
+
+  /// \brief Write a scalar in little-endian order.
+  /// \param[in] _out Out stream.
+  /// \param[in] _value Value to write.
+  template <typename T>
+  void WriteLittleEndian(std::ostream &_out, const T &_value)
+  {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &_value, sizeof(T));
+    if constexpr (!kLittleEndianHost)
+      std::reverse(bytes, bytes + sizeof(T));
+    _out.write(bytes, sizeof(T));
+  }
+
+  /// \brief Read a scalar in little-endian order.
+  /// \param[in] _in In stream.
+  /// \param[out] _value Value read, only set on success.
+  /// \return True if enough bytes were available.
+  template <typename T>
+  bool ReadLittleEndian(std::istream &_in, T &_value)
+  {
+    char bytes[sizeof(T)];
+    if (!_in.read(bytes, sizeof(T)))
+      return false;
+    if constexpr (!kLittleEndianHost)
+      std::reverse(bytes, bytes + sizeof(T));
+    std::memcpy(&_value, bytes, sizeof(T));
+    return true;
+  }
+
+  /// \brief Binary encoding of a data type. `value` is true for the types
+  /// that have one:
+  /// * Arithmetic types and enums, written in little-endian order.
+  /// * Other trivially copyable types without stream operators, written as
+  ///   their raw bytes. These are only supported on little-endian hosts,
+  ///   since their fields can't be swapped one by one. Types with stream
+  ///   operators keep using them.
+  /// * ignition::math vectors, quaternions, poses and colors, through the
+  ///   specializations below.
+  ///
+  /// Specialize it to give other types a binary encoding.
+  /// \tparam T Data type.
+  template <typename T>
+  class BinaryCodec
+  {
+    /// \brief True if T is written as a single little-endian scalar.
+    public: static constexpr bool kScalar =
+        (std::is_arithmetic_v<T> && !std::is_same_v<T, long double>) ||
+        std::is_enum_v<T>;
+
+    /// \brief True if T is written as its raw bytes.
+    public: static constexpr bool kRaw = !kScalar &&
+        kLittleEndianHost &&
+        std::is_trivially_copyable_v<T> &&
+        !std::is_empty_v<T> &&
+        !std::is_pointer_v<T> &&
+        !std::is_member_pointer_v<T> &&
+        !traits::IsOutStreamable<std::ostream, T>::value &&
+        !traits::IsInStreamable<std::istream, T>::value;
+
+    /// \brief True if T has a binary encoding.
+    public: static constexpr bool value = kScalar || kRaw;  // NOLINT
+
+    /// \brief Write data.
+    /// \param[in] _out Out stream.
+    /// \param[in] _data Data to write.
+    public: static void Write(std::ostream &_out, const T &_data)
+    {
+      if constexpr (std::is_same_v<T, bool>)
+      {
+        _out.put(_data ? 1 : 0);
+      }
+      else if constexpr (kScalar)
+      {
+        WriteLittleEndian(_out, _data);
+      }
+      else
+      {
+        _out.write(reinterpret_cast<const char *>(&_data), sizeof(T));
+      }
+    }
+
+    /// \brief Read data.
+    /// \param[in] _in In stream.
+    /// \param[out] _data Data read, only set on success.
+    /// \return True if enough bytes were available.
+    public: static bool Read(std::istream &_in, T &_data)
+    {
+      if constexpr (std::is_same_v<T, bool>)
+      {
+        char c;
+        if (!_in.get(c))
+          return false;
+        _data = (c != 0);
+        return true;
+      }
+      else if constexpr (kScalar)
+      {
+        return ReadLittleEndian(_in, _data);
+      }
+      else
+      {
+        T data;
+        if (!_in.read(reinterpret_cast<char *>(&data), sizeof(T)))
+          return false;
+        _data = data;
+        return true;
+      }
+    }
+  };
+
+  /// \brief Binary encoding of math::Vector2.
+  template <typename T>
+  class BinaryCodec<math::Vector2<T>>
+  {
+    // Documentation inherited
+    public: static constexpr bool value = BinaryCodec<T>::kScalar;  // NOLINT
+
+    // Documentation inherited
+    public: static void Write(std::ostream &_out, const math::Vector2<T> &_data)
+    {
+      WriteLittleEndian(_out, _data.X());
+      WriteLittleEndian(_out, _data.Y());
+    }
+
+    // Documentation inherited
+    public: static bool Read(std::istream &_in, math::Vector2<T> &_data)
+    {
+      T x, y;
+      if (!ReadLittleEndian(_in, x) || !ReadLittleEndian(_in, y))
+        return false;
+      _data.Set(x, y);
+      return true;
+    }
+  };
+
+  /// \brief Binary encoding of math::Vector3.
+  template <typename T>
+  class BinaryCodec<math::Vector3<T>>
+  {
+    // Documentation inherited
+    public: static constexpr bool value = BinaryCodec<T>::kScalar;  // NOLINT
+
+    // Documentation inherited
+    public: static void Write(std::ostream &_out, const math::Vector3<T> &_data)
+    {
+      WriteLittleEndian(_out, _data.X());
+      WriteLittleEndian(_out, _data.Y());
+      WriteLittleEndian(_out, _data.Z());
+    }
+
+    // Documentation inherited
+    public: static bool Read(std::istream &_in, math::Vector3<T> &_data)
+    {
+      T x, y, z;
+      if (!ReadLittleEndian(_in, x) || !ReadLittleEndian(_in, y) ||
+          !ReadLittleEndian(_in, z))
+      {
+        return false;
+      }
+      _data.Set(x, y, z);
+      return true;
+    }
+  };
+
+  /// \brief Binary encoding of math::Vector4.
+  template <typename T>
+  class BinaryCodec<math::Vector4<T>>
+  {
+    // Documentation inherited
+    public: static constexpr bool value = BinaryCodec<T>::kScalar;  // NOLINT
+
+    // Documentation inherited
+    public: static void Write(std::ostream &_out, const math::Vector4<T> &_data)
+    {
+      WriteLittleEndian(_out, _data.X());
+      WriteLittleEndian(_out, _data.Y());
+      WriteLittleEndian(_out, _data.Z());
+      WriteLittleEndian(_out, _data.W());
+    }
+
+    // Documentation inherited
+    public: static bool Read(std::istream &_in, math::Vector4<T> &_data)
+    {
+      T x, y, z, w;
+      if (!ReadLittleEndian(_in, x) || !ReadLittleEndian(_in, y) ||
+          !ReadLittleEndian(_in, z) || !ReadLittleEndian(_in, w))
+      {
+        return false;
+      }
+      _data.Set(x, y, z, w);
+      return true;
+    }
+  };
+
+  /// \brief Binary encoding of math::Quaternion. The components are written
+  /// as they are, without normalization.
+  template <typename T>
+  class BinaryCodec<math::Quaternion<T>>
+  {
+    // Documentation inherited
+    public: static constexpr bool value = BinaryCodec<T>::kScalar;  // NOLINT
+
+    // Documentation inherited
+    public: static void Write(std::ostream &_out,
+                              const math::Quaternion<T> &_data)
+    {
+      WriteLittleEndian(_out, _data.W());
+      WriteLittleEndian(_out, _data.X());
+      WriteLittleEndian(_out, _data.Y());
+      WriteLittleEndian(_out, _data.Z());
+    }
+
+    // Documentation inherited
+    public: static bool Read(std::istream &_in, math::Quaternion<T> &_data)
+    {
+      T w, x, y, z;
+      if (!ReadLittleEndian(_in, w) || !ReadLittleEndian(_in, x) ||
+          !ReadLittleEndian(_in, y) || !ReadLittleEndian(_in, z))
+      {
+        return false;
+      }
+      _data.Set(w, x, y, z);
+      return true;
+    }
+  };
+
+  /// \brief Binary encoding of math::Pose3, the position followed by the
+  /// rotation.
+  template <typename T>
+  class BinaryCodec<math::Pose3<T>>
+  {
+    // Documentation inherited
+    public: static constexpr bool value = BinaryCodec<T>::kScalar;  // NOLINT
+
+    // Documentation inherited
+    public: static void Write(std::ostream &_out, const math::Pose3<T> &_data)
+    {
+      BinaryCodec<math::Vector3<T>>::Write(_out, _data.Pos());
+      BinaryCodec<math::Quaternion<T>>::Write(_out, _data.Rot());
+    }
+
+    // Documentation inherited
+    public: static bool Read(std::istream &_in, math::Pose3<T> &_data)
+    {
+      math::Vector3<T> pos;
+      math::Quaternion<T> rot;
+      if (!BinaryCodec<math::Vector3<T>>::Read(_in, pos) ||
+          !BinaryCodec<math::Quaternion<T>>::Read(_in, rot))
+      {
+        return false;
+      }
+      _data.Set(pos, rot);
+      return true;
+    }
+  };
+
+  /// \brief Binary encoding of math::Color.
+  template <>
+  class BinaryCodec<math::Color>
+  {
+    // Documentation inherited
+    public: static constexpr bool value = true;  // NOLINT
+
+    // Documentation inherited
+    public: static void Write(std::ostream &_out, const math::Color &_data)
+    {
+      WriteLittleEndian(_out, _data.R());
+      WriteLittleEndian(_out, _data.G());
+      WriteLittleEndian(_out, _data.B());
+      WriteLittleEndian(_out, _data.A());
+    }
+
+    // Documentation inherited
+    public: static bool Read(std::istream &_in, math::Color &_data)
+    {
+      float r, g, b, a;
+      if (!ReadLittleEndian(_in, r) || !ReadLittleEndian(_in, g) ||
+          !ReadLittleEndian(_in, b) || !ReadLittleEndian(_in, a))
+      {
+        return false;
+      }
+      _data.Set(r, g, b, a);
+      return true;
+    }
+  };
+
+  /// \brief Default serializer template. Types with a BinaryCodec are written
+  /// in binary, prefixed with kBinarySerializationMarker, inside a
+  /// BinarySerializationScope. Other types go through stream operators
+  /// if they support them. If the stream operator is not available, a warning
   /// message is printed.
+  ///
+  /// Deserialization accepts both binary data and text, so components
+  /// serialized as text by older versions, for example in logs, can still be
+  /// read.
   /// \tparam DataType Type on which the operator will be called.
   template <typename DataType>
   class DefaultSerializer
@@ -111,6 +479,16 @@ namespace serializers
     public: static std::ostream &Serialize(std::ostream &_out,
                                            const DataType &_data)
     {
+      if constexpr (BinaryCodec<DataType>::value)
+      {
+        if (BinarySerialization())
+        {
+          _out.put(kBinarySerializationMarker);
+          BinaryCodec<DataType>::Write(_out, _data);
+          return _out;
+        }
+      }
+
       // cppcheck-suppress syntaxError
       if constexpr (traits::IsSharedPtr<DataType>::value) // NOLINT
       {
@@ -157,6 +535,17 @@ namespace serializers
     public: static std::istream &Deserialize(std::istream &_in,
                                              DataType &_data)
     {
+      if constexpr (BinaryCodec<DataType>::value)
+      {
+        if (_in.peek() == std::istream::traits_type::to_int_type(
+            kBinarySerializationMarker))
+        {
+          _in.get();
+          BinaryCodec<DataType>::Read(_in, _data);
+          return _in;
+        }
+      }
+
       if constexpr (traits::IsSharedPtr<DataType>::value)
       {
         if constexpr (traits::IsInStreamable<std::istream,
@@ -235,6 +624,62 @@ namespace components
     /// \brief Default destructor.
     public: virtual ~BaseComponent() = default;
 
+    /// \brief Allocate components from the ComponentPool.
+    /// \param[in] _size Size of the component.
+    /// \return Pointer to the memory.
+    public: static void *operator new(std::size_t _size)
+    {
+      return ComponentPool::Allocate(_size);
+    }
+
+    /// \brief Return components to the ComponentPool.
+    /// \param[in] _ptr Pointer to the memory.
+    /// \param[in] _size Size of the component.
+    public: static void operator delete(void *_ptr, std::size_t _size) noexcept
+    {
+      ComponentPool::Deallocate(_ptr, _size);
+    }
+
+    /// \brief Components with extended alignment bypass the pool.
+    /// \param[in] _size Size of the component.
+    /// \param[in] _align Alignment of the component.
+    /// \return Pointer to the memory.
+    public: static void *operator new(std::size_t _size,
+                std::align_val_t _align)
+    {
+      return ::operator new(_size, _align);
+    }
+
+    /// \brief Components with extended alignment bypass the pool.
+    /// \param[in] _ptr Pointer to the memory.
+    /// \param[in] _size Size of the component.
+    /// \param[in] _align Alignment of the component.
+    public: static void operator delete(void *_ptr, std::size_t _size,
+                std::align_val_t _align) noexcept
+    {
+      ::operator delete(_ptr, _size, _align);
+    }
+
+    /// \brief Placement new, which would otherwise be hidden by the
+    /// allocation functions above.
+    /// \param[in] _size Size of the component.
+    /// \param[in] _ptr Memory to construct the component in.
+    /// \return _ptr
+    public: static void *operator new(std::size_t _size, void *_ptr) noexcept
+    {
+      (void)_size;
+      return _ptr;
+    }
+
+    /// \brief Placement delete, matching placement new.
+    /// \param[in] _ptr Pointer to the memory.
+    /// \param[in] _place Memory the component was constructed in.
+    public: static void operator delete(void *_ptr, void *_place) noexcept
+    {
+      (void)_ptr;
+      (void)_place;
+    }
+
     /// \brief Fills a stream with a serialized version of the component.
     /// By default, it will leave the stream empty. Derived classes should
     /// override this function to support serialization.
@@ -318,7 +763,8 @@ namespace components
   /// collision.
   /// \tparam Serializer A class that can serialize `DataType`. Defaults to a
   /// serializer that uses stream operators `<<` and `>>` on the data if they
-  /// exist.
+  /// exist, and binary data for types that have a serializers::BinaryCodec
+  /// inside a serializers::BinarySerializationScope.
   template <typename DataType, typename Identifier,
             typename Serializer = serializers::DefaultSerializer<DataType>>
   class Component : public BaseComponent
@@ -333,9 +779,28 @@ namespace components
     /// \param[in] _data Data to copy
     public: explicit Component(DataType _data);
 
+    /// \brief Copy constructor.
+    /// \param[in] _component Component to copy.
+    public: Component(const Component &_component) = default;
+
+    /// \brief Move constructor, used when the storage moves components
+    /// between its arrays.
+    /// \param[in] _component Component to move.
+    public: Component(Component &&_component) = default;
+
     /// \brief Destructor.
     public: ~Component() override = default;
 
+    /// \brief Copy assignment.
+    /// \param[in] _component Component to copy.
+    /// \return Reference to this component.
+    public: Component &operator=(const Component &_component) = default;
+
+    /// \brief Move assignment.
+    /// \param[in] _component Component to move.
+    /// \return Reference to this component.
+    public: Component &operator=(Component &&_component) = default;
+
     /// \brief Equality operator.
     /// \param[in] _component Component to compare to.
     /// \return True if equal.
@@ -436,6 +901,169 @@ namespace components
     public: inline static std::string typeName;
   };
 
+  /// \brief Function which copies the data of a component into another
+  /// component of the same type, keeping the instance copied into.
+  /// \param[in] _to Component to copy into.
+  /// \param[in] _from Component to copy from.
+  using ComponentCopyFn = void (*)(BaseComponent &_to,
+      const BaseComponent &_from);
+
+  /// \brief Register the function which copies components of a type.
+  /// Factory::Register does this for every component type. If a type is
+  /// registered more than once, the first function is kept.
+  /// \param[in] _typeId Component type.
+  /// \param[in] _copy Copy function.
+  void IGNITION_GAZEBO_VISIBLE RegisterComponentCopy(
+      ComponentTypeId _typeId, ComponentCopyFn _copy);
+
+  /// \brief Unregister the function which copies components of a type.
+  /// \param[in] _typeId Component type.
+  void IGNITION_GAZEBO_VISIBLE UnregisterComponentCopy(
+      ComponentTypeId _typeId);
+
+  /// \brief Get the function which copies components of a type. Types which
+  /// have none, such as those registered by code built against older
+  /// headers, are copied through Serialize and Deserialize.
+  /// \param[in] _typeId Component type.
+  /// \return The copy function, never null.
+  ComponentCopyFn IGNITION_GAZEBO_VISIBLE ComponentCopy(
+      ComponentTypeId _typeId);
+
+  /// \brief Copy function of component types whose data can be assigned.
+  /// \param[in] _to Component to copy into.
+  /// \param[in] _from Component to copy from.
+  /// \tparam ComponentTypeT Type of both components.
+  template <typename ComponentTypeT>
+  void CopyComponentData(BaseComponent &_to, const BaseComponent &_from)
+  {
+    static_cast<ComponentTypeT &>(_to).Data() =
+        static_cast<const ComponentTypeT &>(_from).Data();
+  }
+
+  /// \brief Describes how to construct components of a type in memory owned
+  /// by someone else, so that the storage can keep components of one type
+  /// in contiguous arrays instead of allocating each of them.
+  struct ComponentLayout
+  {
+    /// \brief Size of a component, in bytes.
+    std::size_t size;
+
+    /// \brief Alignment of a component, in bytes.
+    std::size_t align;
+
+    /// \brief Copy construct a component into uninitialized memory.
+    /// Null if the type can't be copied.
+    BaseComponent *(*copyTo)(void *_memory, const BaseComponent &_from);
+
+    /// \brief Move construct a component into uninitialized memory. The
+    /// moved-from component must still be destroyed.
+    BaseComponent *(*moveTo)(void *_memory, BaseComponent &_from);
+
+    /// \brief Move a component into a new heap allocated instance.
+    std::unique_ptr<BaseComponent> (*moveNew)(BaseComponent &_from);
+  };
+
+  /// \brief Register the layout of the components of a type.
+  /// Factory::Register does this for every movable component type. If a
+  /// type is registered more than once, the first layout is kept.
+  /// \param[in] _typeId Component type.
+  /// \param[in] _layout Layout, which must outlive the registration.
+  void IGNITION_GAZEBO_VISIBLE RegisterComponentLayout(
+      ComponentTypeId _typeId, const ComponentLayout *_layout);
+
+  /// \brief Unregister the layout of the components of a type.
+  /// \param[in] _typeId Component type.
+  void IGNITION_GAZEBO_VISIBLE UnregisterComponentLayout(
+      ComponentTypeId _typeId);
+
+  /// \brief Get the layout of the components of a type. Types which have
+  /// none, such as those registered by code built against older headers,
+  /// are stored as individually allocated instances.
+  /// \param[in] _typeId Component type.
+  /// \return The layout, or nullptr.
+  IGNITION_GAZEBO_VISIBLE const ComponentLayout *ComponentLayoutOf(
+      ComponentTypeId _typeId);
+
+  /// \brief Copy construct a component into uninitialized memory, see
+  /// ComponentLayout::copyTo.
+  /// \tparam ComponentTypeT Component type.
+  template <typename ComponentTypeT>
+  BaseComponent *CopyConstructComponent(void *_memory,
+      const BaseComponent &_from)
+  {
+    return ::new (_memory) ComponentTypeT(
+        static_cast<const ComponentTypeT &>(_from));
+  }
+
+  /// \brief Move construct a component into uninitialized memory, see
+  /// ComponentLayout::moveTo.
+  /// \tparam ComponentTypeT Component type.
+  template <typename ComponentTypeT>
+  BaseComponent *MoveConstructComponent(void *_memory, BaseComponent &_from)
+  {
+    return ::new (_memory) ComponentTypeT(
+        std::move(static_cast<ComponentTypeT &>(_from)));
+  }
+
+  /// \brief Move a component into a new heap allocated instance, see
+  /// ComponentLayout::moveNew.
+  /// \tparam ComponentTypeT Component type.
+  template <typename ComponentTypeT>
+  std::unique_ptr<BaseComponent> MoveNewComponent(BaseComponent &_from)
+  {
+    return std::make_unique<ComponentTypeT>(
+        std::move(static_cast<ComponentTypeT &>(_from)));
+  }
+
+  /// \brief Get the layout of a movable component type.
+  /// \tparam ComponentTypeT Component type.
+  /// \return The layout, which lives as long as the program.
+  template <typename ComponentTypeT>
+  const ComponentLayout *ComponentLayoutFor()
+  {
+    static const ComponentLayout layout = []()
+    {
+      ComponentLayout result{sizeof(ComponentTypeT), alignof(ComponentTypeT),
+          nullptr, MoveConstructComponent<ComponentTypeT>,
+          MoveNewComponent<ComponentTypeT>};
+      if constexpr (std::is_copy_constructible_v<ComponentTypeT>)
+        result.copyTo = CopyConstructComponent<ComponentTypeT>;
+      return result;
+    }();
+    return &layout;
+  }
+
+  /// \brief Type trait that determines if a component type is a tag, which
+  /// wraps NoData.
+  template <typename ComponentTypeT>
+  struct IsTagType : std::false_type
+  {
+  };
+
+  /// \brief Specialization of IsTagType for components that wrap NoData.
+  template <typename Identifier, typename Serializer>
+  struct IsTagType<Component<NoData, Identifier, Serializer>>
+    : std::true_type
+  {
+  };
+
+  /// \brief Register a component type as a tag. All instances of a tag type
+  /// are interchangeable, so the EntityComponentManager may share a single
+  /// instance between all entities. Factory::Register does this for every
+  /// type which wraps NoData.
+  /// \param[in] _typeId Component type.
+  void IGNITION_GAZEBO_VISIBLE RegisterTagComponent(ComponentTypeId _typeId);
+
+  /// \brief Unregister a tag component type.
+  /// \param[in] _typeId Component type.
+  void IGNITION_GAZEBO_VISIBLE UnregisterTagComponent(
+      ComponentTypeId _typeId);
+
+  /// \brief Check whether a component type was registered as a tag.
+  /// \param[in] _typeId Component type.
+  /// \return True if the type is a tag.
+  bool IGNITION_GAZEBO_VISIBLE IsTagComponent(ComponentTypeId _typeId);
+
   //////////////////////////////////////////////////
   template <typename DataType, typename Identifier, typename Serializer>
   Component<DataType, Identifier, Serializer>::Component(DataType _data)
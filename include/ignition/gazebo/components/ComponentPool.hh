@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_COMPONENTS_COMPONENTPOOL_HH_
+#define IGNITION_GAZEBO_COMPONENTS_COMPONENTPOOL_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <ignition/gazebo/config.hh>
+#include <ignition/gazebo/Export.hh>
+
+namespace ignition
+{
+namespace gazebo
+{
+// Inline bracket to help doxygen filtering.
+inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+namespace components
+{
+  /// \brief Allocation statistics of one block size of the ComponentPool.
+  struct ComponentPoolStats
+  {
+    /// \brief Size of each block, in bytes.
+    std::size_t blockSize{0};
+
+    /// \brief Number of blocks per chunk.
+    std::size_t blocksPerChunk{0};
+
+    /// \brief Number of chunks currently held.
+    std::size_t chunks{0};
+
+    /// \brief Number of blocks holding a component.
+    std::size_t usedBlocks{0};
+
+    /// \brief Number of free blocks in the chunks currently held, including
+    /// those cached by threads. A high count compared to usedBlocks means
+    /// memory is fragmented.
+    std::size_t freeBlocks{0};
+
+    /// \brief Total number of blocks allocated.
+    uint64_t allocations{0};
+
+    /// \brief Total number of blocks freed.
+    uint64_t deallocations{0};
+  };
+
+  /// \brief Memory pool that all components are allocated from.
+  ///
+  /// Components are small and are created and destroyed in large numbers
+  /// when models are spawned and removed. Instead of going to the system
+  /// allocator for each of them, the pool serves them from free lists of
+  /// fixed-size blocks. There's one list per block size, in steps of 16
+  /// bytes, so each component type always uses the same list. Blocks are
+  /// carved out of large chunks, and a chunk is given back to the system as
+  /// a whole once all of its blocks are free, for example when all the
+  /// entities of an archetype are removed.
+  ///
+  /// Components larger than kMaxBlockSize, or with extended alignment, use
+  /// the system allocator.
+  ///
+  /// All functions are thread-safe. Each thread caches a few free blocks of
+  /// each size, so that most allocations and deallocations don't contend
+  /// for the shared lists. The cache is given back when the thread exits.
+  class IGNITION_GAZEBO_VISIBLE ComponentPool
+  {
+    /// \brief Largest component size, in bytes, served by the pool.
+    public: static constexpr std::size_t kMaxBlockSize{512};
+
+    /// \brief Allocate memory for a component.
+    /// \param[in] _size Size of the component, in bytes.
+    /// \return Pointer to the memory. Throws std::bad_alloc on failure.
+    public: static void *Allocate(std::size_t _size);
+
+    /// \brief Free memory obtained from Allocate.
+    /// \param[in] _ptr Pointer returned by Allocate. May be null.
+    /// \param[in] _size The size passed to Allocate.
+    public: static void Deallocate(void *_ptr, std::size_t _size) noexcept;
+
+    /// \brief Get the statistics of each block size which has been used.
+    /// \return Statistics, ordered by block size.
+    public: static std::vector<ComponentPoolStats> Stats();
+
+    /// \brief Give the calling thread's cached blocks back, then give all
+    /// chunks without components back to the system. The pool keeps one
+    /// empty chunk per block size otherwise, to avoid allocating and freeing
+    /// chunks repeatedly.
+    /// \return Number of bytes released.
+    public: static std::size_t Trim();
+  };
+}
+}
+}
+}
+
+#endif
@@ -22,6 +22,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include <ignition/common/SingletonT.hh>
@@ -73,8 +74,8 @@ namespace components
     public: virtual std::unique_ptr<BaseComponent> Create(
                 const components::BaseComponent *_data) const override
     {
-      ComponentTypeT comp(*static_cast<const ComponentTypeT *>(_data));
-      return std::make_unique<ComponentTypeT>(comp);
+      return std::make_unique<ComponentTypeT>(
+          *static_cast<const ComponentTypeT *>(_data));
     }
   };
 
@@ -154,6 +155,20 @@ namespace components
       ComponentTypeT::typeId = typeHash;
       ComponentTypeT::typeName = _type;
 
+      if constexpr (traits::HasAssignableData<ComponentTypeT>::value)
+      {
+        RegisterComponentCopy(typeHash, CopyComponentData<ComponentTypeT>);
+      }
+      if constexpr (IsTagType<ComponentTypeT>::value)
+      {
+        RegisterTagComponent(typeHash);
+      }
+      else if constexpr (std::is_move_constructible_v<ComponentTypeT>)
+      {
+        RegisterComponentLayout(typeHash,
+            ComponentLayoutFor<ComponentTypeT>());
+      }
+
       // Check if component has already been registered by another library
       auto runtimeName = typeid(ComponentTypeT).name();
       auto runtimeNameIt = this->runtimeNamesById.find(typeHash);
@@ -238,6 +253,10 @@ namespace components
           runtimeNamesById.erase(it);
         }
       }
+
+      UnregisterComponentCopy(_typeId);
+      UnregisterTagComponent(_typeId);
+      UnregisterComponentLayout(_typeId);
     }
 
     /// \brief Create a new instance of a component.
@@ -25,6 +25,7 @@
 #include "ignition/gazebo/Entity.hh"
 #include "ignition/gazebo/Types.hh"
 #include "ignition/gazebo/config.hh"
+#include "ignition/gazebo/detail/EntityBitmap.hh"
 
 namespace ignition
 {
@@ -54,6 +55,8 @@ struct ComponentTypeHasher
   }
 };
 
+class ViewIteration;
+
 /// \brief A view is a cache to entities, and their components, that
 /// match a set of component types. A cache is used because systems will
 /// frequently, potentially every iteration, query the
@@ -105,6 +108,30 @@ class IGNITION_GAZEBO_VISIBLE BaseView
   /// otherwise
   public: bool RequiresComponent(const ComponentTypeId _typeId) const;
 
+  /// \brief See if the view excludes entities which have a particular
+  /// component type, see Without.
+  /// \param[in] _typeId The component type
+  /// \return true if entities with components of type _typeId are left out
+  /// of the view, false otherwise
+  public: bool ExcludesComponent(const ComponentTypeId _typeId) const;
+
+  /// \brief See if the view caches a particular component type when
+  /// entities have it, without requiring it, see Optional.
+  /// \param[in] _typeId The component type
+  /// \return true if _typeId is an optional component of the view, false
+  /// otherwise
+  public: bool HasOptionalComponent(const ComponentTypeId _typeId) const;
+
+  /// \brief Save an entity which is part of the view as one whose component
+  /// data must be fetched again the next time the view is used, because
+  /// one of its optional components was added or removed.
+  /// \param[in] _entity The entity
+  /// \param[in] _new Whether the entity is new to the entity component
+  /// manager.
+  /// \return True if _entity is part of the view and was marked.
+  /// \sa HasOptionalComponent
+  public: bool MarkEntityToUpdate(const Entity _entity, bool _new = false);
+
   /// \brief Update the internal data in the view because a component has been
   /// added to an entity. It is assumed that the entity is already associated
   /// with the view, and that the added component type is required by the view.
@@ -136,6 +163,16 @@ class IGNITION_GAZEBO_VISIBLE BaseView
   /// exist in the view.
   public: virtual bool RemoveEntity(const Entity _entity) = 0;
 
+  /// \brief Remove many entities from the view in a single pass over the
+  /// view's data, instead of one lookup per entity. This is faster than
+  /// calling RemoveEntity for each entity when a large part of the view is
+  /// removed.
+  /// \param[in] _entities The entities to remove. They don't need to be in
+  /// the view.
+  /// \return Number of entities that were part of the view and removed.
+  public: virtual std::size_t RemoveEntities(
+              const EntityBitmap &_entities) = 0;
+
   /// \brief Add the entity to the list of entities to be removed
   /// \param[in] _entity The entity to add.
   /// \return True if the entity was added to the list, false if the entity
@@ -151,13 +188,20 @@ class IGNITION_GAZEBO_VISIBLE BaseView
   /// \return The set of component types.
   public: const std::set<ComponentTypeId> &ComponentTypes() const;
 
+  /// \brief Get the set of component types that entities in this view must
+  /// not have.
+  /// \return The set of component types.
+  public: const std::set<ComponentTypeId> &ExcludedComponentTypes() const;
+
   /// \brief Clear all data from the view and reset it to its original, empty
   /// state.
   public: virtual void Reset() = 0;
 
-  /// \brief Get all of the entities in the view
+  /// \brief Get all of the entities in the view. The entities are in the
+  /// same order as the component data stored by the view, which is not
+  /// sorted.
   /// \return The entities in the view
-  public: const std::set<Entity> &Entities() const;
+  public: const std::vector<Entity> &Entities() const;
 
   /// \brief Get all of the entities in the view that are considered "newly
   /// created". While an entity may be new to the view, it may not be a newly
@@ -165,12 +209,12 @@ class IGNITION_GAZEBO_VISIBLE BaseView
   /// had a component added to it that now makes this entity a part of the
   /// view). An entity's "newness" is determined by the entity component
   /// manager.
-  /// \return The newly created entities that are a part of the view
-  public: const std::set<Entity> &NewEntities() const;
+  /// \return The newly created entities that are a part of the view, sorted
+  public: const std::vector<Entity> &NewEntities() const;
 
   /// \brief Get all of the entities to be removed from the view
-  /// \return The entities to be removed from the view
-  public: const std::set<Entity> &ToRemoveEntities() const;
+  /// \return The entities to be removed from the view, sorted
+  public: const std::vector<Entity> &ToRemoveEntities() const;
 
   /// \brief Get all of the entities that should be added to the view. This is
   /// useful for adding entities to the view before the view is used to ensure
@@ -187,23 +231,56 @@ class IGNITION_GAZEBO_VISIBLE BaseView
   /// \sa ToAddEntities
   public: void ClearToAddEntities();
 
-  // TODO(adlarkin) make this a std::unordered_set for better performance.
-  // We need to make sure nothing else depends on the ordered preserved by
-  // std::set first
-  /// \brief All the entities that belong to this view.
-  protected: std::set<Entity> entities;
+  /// \brief Add an entity to the packed `entities` vector.
+  /// \param[in] _entity The entity, which must not be in the view already.
+  /// \return Index of the entity in `entities`.
+  protected: std::size_t AddPackedEntity(const Entity _entity);
+
+  /// \brief Remove an entity from the packed `entities` vector by swapping
+  /// it with the last entity. Derived views must apply the same swap to
+  /// their component data.
+  /// \param[in] _entity The entity to remove.
+  /// \param[out] _index Index that the entity occupied, which now holds
+  /// the entity that was last.
+  /// \return True if the entity was in the view.
+  protected: bool RemovePackedEntity(const Entity _entity,
+                 std::size_t &_index);
+
+  /// \brief Must be called before adding, removing or reordering packed
+  /// entities. Iterations over the view by index on the calling thread, see
+  /// ViewIteration, keep a copy of the entities as they were before the
+  /// first change.
+  protected: void WillChangePacked();
+
+  /// \brief Remove entities from the lists of new entities, entities to be
+  /// removed and entities to be added. Used by RemoveEntities.
+  /// \param[in] _entities The entities to remove.
+  protected: void RemoveFromLists(const EntityBitmap &_entities);
+
+  /// \brief Insert an entity into a sorted vector, if it's not there yet.
+  /// \param[in] _vec Sorted vector.
+  /// \param[in] _entity Entity to insert.
+  protected: static void InsertSorted(std::vector<Entity> &_vec,
+                 const Entity _entity);
+
+  /// \brief Erase an entity from a sorted vector, if it's there.
+  /// \param[in] _vec Sorted vector.
+  /// \param[in] _entity Entity to erase.
+  protected: static void EraseSorted(std::vector<Entity> &_vec,
+                 const Entity _entity);
 
-  // TODO(adlarkin) make this a std::unordered_set for better performance.
-  // We need to make sure nothing else depends on the ordered preserved by
-  // std::set first
-  /// \brief List of newly created entities
-  protected: std::set<Entity> newEntities;
+  /// \brief All the entities that belong to this view, packed. Derived views
+  /// store the component data of entities[i] at index i.
+  protected: std::vector<Entity> entities;
 
-  // TODO(adlarkin) make this a std::unordered_set for better performance.
-  // We need to make sure nothing else depends on the ordered preserved by
-  // std::set first
-  /// \brief List of entities about to be removed
-  protected: std::set<Entity> toRemoveEntities;
+  /// \brief Index of each entity in `entities`.
+  protected: std::unordered_map<Entity, std::size_t> entityIndex;
+
+  /// \brief Sorted list of newly created entities
+  protected: std::vector<Entity> newEntities;
+
+  /// \brief Sorted list of entities about to be removed
+  protected: std::vector<Entity> toRemoveEntities;
 
   /// \brief List of entities to be added to the view. The value of the map
   /// indicates whether the entity is new to the entity component manager or not
@@ -211,6 +288,61 @@ class IGNITION_GAZEBO_VISIBLE BaseView
 
   /// \brief The component types in the view
   protected: std::set<ComponentTypeId> componentTypes;
+
+  /// \brief The component types which entities in the view must not have
+  protected: std::set<ComponentTypeId> excludedTypes;
+
+  /// \brief The component types which are cached when entities have them,
+  /// but aren't required
+  protected: std::set<ComponentTypeId> optionalTypes;
+};
+
+/// \brief Iteration over the packed data of a view by index on the calling
+/// thread, such as the one done by EntityComponentManager::Each. While the
+/// object is alive, the view remembers it, and keeps a copy of its entities
+/// as they were before the first change to the packed data, so that the
+/// iteration can carry on over the original entities. The copy is only made
+/// if the view changes, which callbacks rarely do.
+class IGNITION_GAZEBO_VISIBLE ViewIteration
+{
+  /// \brief Constructor. Starts the iteration.
+  /// \param[in] _view The view being iterated.
+  public: explicit ViewIteration(const BaseView *_view);
+
+  /// \brief Destructor. Ends the iteration.
+  public: ~ViewIteration();
+
+  /// \brief Iterations are tied to the thread and block that started them.
+  public: ViewIteration(const ViewIteration &) = delete;
+
+  /// \brief Iterations are tied to the thread and block that started them.
+  public: ViewIteration &operator=(const ViewIteration &) = delete;
+
+  /// \brief Get whether the packed data of the view changed since the
+  /// iteration started. Until it does, the data at an index is the data
+  /// that was there when the iteration started.
+  /// \return True if the view changed.
+  public: bool Changed() const;
+
+  /// \brief Get the entities that the view had when the iteration started.
+  /// Only valid if Changed() is true.
+  /// \return The entities, in their original order.
+  public: const std::vector<Entity> &OriginalEntities() const;
+
+  /// \brief The view being iterated.
+  private: const BaseView *view;
+
+  /// \brief The enclosing iteration on this thread, or nullptr.
+  private: ViewIteration *enclosing;
+
+  /// \brief Whether the view changed.
+  private: bool changed{false};
+
+  /// \brief Copy of the view's entities before the first change.
+  private: std::vector<Entity> entities;
+
+  /// \brief The view takes the copy.
+  friend class BaseView;
 };
 }  // namespace detail
 }  // namespace IGNITION_GAZEBO_VERSION_NAMESPACE
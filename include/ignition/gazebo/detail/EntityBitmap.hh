@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_DETAIL_ENTITYBITMAP_HH_
+#define IGNITION_GAZEBO_DETAIL_ENTITYBITMAP_HH_
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "ignition/gazebo/Entity.hh"
+#include "ignition/gazebo/config.hh"
+
+namespace ignition
+{
+namespace gazebo
+{
+// Inline bracket to help doxygen filtering.
+inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+namespace detail
+{
+/// \brief An immutable set of entities with constant time lookups, used to
+/// remove many entities from views and storage in a single pass.
+///
+/// Entities removed together usually have IDs close to each other, so they
+/// are stored as a bitmap over the range of their IDs. If the IDs are too
+/// spread out for that, for example because they were created with
+/// different offsets, a sorted vector is used instead.
+class EntityBitmap
+{
+  /// \brief Constructor
+  /// \param[in] _entities Entities in the set, in any order, without
+  /// duplicates.
+  public: explicit EntityBitmap(std::vector<Entity> _entities)
+    : count(_entities.size())
+  {
+    if (_entities.empty())
+      return;
+
+    const auto [minIt, maxIt] =
+        std::minmax_element(_entities.begin(), _entities.end());
+    const Entity range = *maxIt - *minIt + 1;
+
+    if (range <= kMaxBitsPerEntity * this->count + kMinBits)
+    {
+      this->first = *minIt;
+      this->bits.resize(range, false);
+      for (const Entity entity : _entities)
+        this->bits[entity - this->first] = true;
+    }
+    else
+    {
+      std::sort(_entities.begin(), _entities.end());
+      this->sorted = std::move(_entities);
+    }
+  }
+
+  /// \brief Check whether an entity is in the set.
+  /// \param[in] _entity Entity.
+  /// \return True if _entity is in the set.
+  public: bool Contains(const Entity _entity) const
+  {
+    if (!this->bits.empty())
+    {
+      return _entity >= this->first &&
+          _entity - this->first < this->bits.size() &&
+          this->bits[_entity - this->first];
+    }
+    return std::binary_search(this->sorted.begin(), this->sorted.end(),
+        _entity);
+  }
+
+  /// \brief Get the number of entities in the set.
+  /// \return Number of entities.
+  public: std::size_t Count() const
+  {
+    return this->count;
+  }
+
+  /// \brief Largest number of bits per entity before falling back to a
+  /// sorted vector.
+  private: static constexpr std::size_t kMaxBitsPerEntity{64};
+
+  /// \brief Number of bits that can always be used, however few entities
+  /// there are.
+  private: static constexpr std::size_t kMinBits{4096};
+
+  /// \brief Number of entities.
+  private: std::size_t count{0};
+
+  /// \brief Entity of the first bit.
+  private: Entity first{0};
+
+  /// \brief One bit per entity ID, starting at `first`.
+  private: std::vector<bool> bits;
+
+  /// \brief Sorted entities, used if `bits` is empty.
+  private: std::vector<Entity> sorted;
+};
+}  // namespace detail
+}  // namespace IGNITION_GAZEBO_VERSION_NAMESPACE
+}  // namespace gazebo
+}  // namespace ignition
+#endif
@@ -17,7 +17,9 @@
 #ifndef IGNITION_GAZEBO_DETAIL_ENTITYCOMPONENTMANAGER_HH_
 #define IGNITION_GAZEBO_DETAIL_ENTITYCOMPONENTMANAGER_HH_
 
+#include <algorithm>
 #include <cstring>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -100,10 +102,65 @@ ComponentTypeT *EntityComponentManager::CreateComponent(const Entity _entity,
       return comp;
     }
     *comp = _data;
+    this->MarkComponentChanged(_entity, ComponentTypeT::typeId);
   }
   return comp;
 }
 
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+bool EntityComponentManager::CreateComponents(const Entity _entity,
+            const ComponentTypeTs &..._data)
+{
+  std::vector<const components::BaseComponent *> data{&_data...};
+  if (!this->CreateComponentsImplementation(_entity, data))
+    return false;
+
+  // Set the data of the components which already existed
+  std::size_t index = 0;
+  bool result = true;
+  auto update = [&](const auto &_comp)
+  {
+    using ComponentTypeT = std::decay_t<decltype(_comp)>;
+    if (nullptr == data[index++])
+      return;
+
+    auto comp = this->Component<ComponentTypeT>(_entity);
+    if (!comp)
+    {
+      result = false;
+      return;
+    }
+    *comp = _comp;
+    this->MarkComponentChanged(_entity, ComponentTypeT::typeId);
+  };
+  (update(_data), ...);
+
+  return result;
+}
+
+//////////////////////////////////////////////////
+template<typename ComponentTypeT>
+std::size_t EntityComponentManager::CreateComponents(
+            const std::vector<Entity> &_entities, const ComponentTypeT &_data)
+{
+  std::vector<Entity> existing;
+  std::size_t count = this->CreateComponentsImplementation(_entities, &_data,
+      existing);
+
+  // Set the data of the components which already existed
+  for (const Entity entity : existing)
+  {
+    auto comp = this->Component<ComponentTypeT>(entity);
+    if (!comp)
+      continue;
+    *comp = _data;
+    this->MarkComponentChanged(entity, ComponentTypeT::typeId);
+    ++count;
+  }
+  return count;
+}
+
 //////////////////////////////////////////////////
 template<typename ComponentTypeT>
 const ComponentTypeT *EntityComponentManager::Component(
@@ -183,7 +240,11 @@ bool EntityComponentManager::SetComponentData(const Entity _entity,
     return true;
   }
 
-  return comp->SetData(_data, CompareData<typename ComponentTypeT::Type>);
+  if (!comp->SetData(_data, CompareData<typename ComponentTypeT::Type>))
+    return false;
+
+  this->MarkComponentChanged(_entity, ComponentTypeT::typeId);
+  return true;
 }
 
 //////////////////////////////////////////////////
@@ -204,38 +265,73 @@ ComponentTypeT *EntityComponentManager::First()
   return nullptr;
 }
 
+//////////////////////////////////////////////////
+template<typename ComponentTypeT>
+void EntityComponentManager::EnableValueIndex()
+{
+  this->EnableValueIndex(ComponentTypeT::typeId,
+      [](const components::BaseComponent &_component) -> std::size_t
+      {
+        return std::hash<typename ComponentTypeT::Type>()(
+            static_cast<const ComponentTypeT &>(_component).Data());
+      });
+}
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+bool EntityComponentManager::EntityMatchesComponents(const Entity _entity,
+    const ComponentTypeTs &..._desiredComponents) const
+{
+  // Iterate over desired components, comparing each of them to the
+  // equivalent component in the entity.
+  bool different{false};
+  ForEach([&](const auto &_desiredComponent)
+  {
+    if (different)
+      return;
+
+    auto entityComponent = this->Component<
+        std::remove_cv_t<std::remove_reference_t<
+            decltype(_desiredComponent)>>>(_entity);
+
+    if (nullptr == entityComponent || *entityComponent != _desiredComponent)
+    {
+      different = true;
+    }
+  }, _desiredComponents...);
+
+  return !different;
+}
+
 //////////////////////////////////////////////////
 template<typename ...ComponentTypeTs>
 Entity EntityComponentManager::EntityByComponents(
     const ComponentTypeTs &..._desiredComponents) const
 {
+  // Use the value indexes if any of the components is indexed
+  std::vector<Entity> candidates;
+  if (this->IndexedCandidates({&_desiredComponents...}, candidates))
+  {
+    for (const Entity entity : candidates)
+    {
+      if (this->EntityMatchesComponents(entity, _desiredComponents...))
+        return entity;
+    }
+    return kNullEntity;
+  }
+
   // Get all entities which have components of the desired types
   const auto &view = this->FindView<ComponentTypeTs...>();
 
-  // Iterate over entities
+  // The view isn't sorted, so keep the matching entity with the lowest ID,
+  // which is the first one in creation order
   Entity result{kNullEntity};
   for (const Entity entity : view->Entities())
   {
-    bool different{false};
-
-    // Iterate over desired components, comparing each of them to the
-    // equivalent component in the entity.
-    ForEach([&](const auto &_desiredComponent)
-    {
-      auto entityComponent = this->Component<
-          std::remove_cv_t<std::remove_reference_t<
-              decltype(_desiredComponent)>>>(entity);
-
-      if (*entityComponent != _desiredComponent)
-      {
-        different = true;
-      }
-    }, _desiredComponents...);
-
-    if (!different)
+    if ((kNullEntity == result || entity < result) &&
+        this->EntityMatchesComponents(entity, _desiredComponents...))
     {
       result = entity;
-      break;
     }
   }
 
@@ -247,35 +343,32 @@ template<typename ...ComponentTypeTs>
 std::vector<Entity> EntityComponentManager::EntitiesByComponents(
     const ComponentTypeTs &..._desiredComponents) const
 {
+  std::vector<Entity> result;
+
+  // Use the value indexes if any of the components is indexed
+  std::vector<Entity> candidates;
+  if (this->IndexedCandidates({&_desiredComponents...}, candidates))
+  {
+    for (const Entity entity : candidates)
+    {
+      if (this->EntityMatchesComponents(entity, _desiredComponents...))
+        result.push_back(entity);
+    }
+    return result;
+  }
+
   // Get all entities which have components of the desired types
   const auto &view = this->FindView<ComponentTypeTs...>();
 
   // Iterate over entities
-  std::vector<Entity> result;
   for (const Entity entity : view->Entities())
   {
-    bool different{false};
-
-    // Iterate over desired components, comparing each of them to the
-    // equivalent component in the entity.
-    ForEach([&](const auto &_desiredComponent)
-    {
-      auto entityComponent = this->Component<
-          std::remove_cv_t<std::remove_reference_t<
-              decltype(_desiredComponent)>>>(entity);
-
-      if (*entityComponent != _desiredComponent)
-      {
-        different = true;
-      }
-    }, _desiredComponents...);
-
-    if (!different)
-    {
+    if (this->EntityMatchesComponents(entity, _desiredComponents...))
       result.push_back(entity);
-    }
   }
 
+  // The view isn't sorted, so sort the result like the indexed candidates
+  std::sort(result.begin(), result.end());
   return result;
 }
 
@@ -284,40 +377,29 @@ template<typename ...ComponentTypeTs>
 std::vector<Entity> EntityComponentManager::ChildrenByComponents(Entity _parent,
      const ComponentTypeTs &..._desiredComponents) const
 {
-  // Get all entities which have components of the desired types
-  const auto &view = this->FindView<ComponentTypeTs...>();
-
-  // Get all entities which are immediate children of the given parent
-  auto children = this->Entities().AdjacentsFrom(_parent);
-
-  // Iterate over entities
   std::vector<Entity> result;
-  for (const Entity entity : view->Entities())
-  {
-    if (children.find(entity) == children.end())
-    {
-      continue;
-    }
 
-    // Iterate over desired components, comparing each of them to the
-    // equivalent component in the entity.
-    bool different{false};
-    ForEach([&](const auto &_desiredComponent)
+  // Use the value indexes if any of the components is indexed
+  std::vector<Entity> candidates;
+  if (this->IndexedCandidates({&_desiredComponents...}, candidates))
+  {
+    for (const Entity entity : candidates)
     {
-      auto entityComponent = this->Component<
-          std::remove_cv_t<std::remove_reference_t<
-              decltype(_desiredComponent)>>>(entity);
-
-      if (*entityComponent != _desiredComponent)
+      if (this->ParentEntity(entity) == _parent &&
+          this->EntityMatchesComponents(entity, _desiredComponents...))
       {
-        different = true;
+        result.push_back(entity);
       }
-    }, _desiredComponents...);
+    }
+    return result;
+  }
 
-    if (!different)
-    {
+  // Iterate over the immediate children of the given parent
+  for (Entity entity = this->FirstChild(_parent); entity != kNullEntity;
+       entity = this->NextSibling(entity))
+  {
+    if (this->EntityMatchesComponents(entity, _desiredComponents...))
       result.push_back(entity);
-    }
   }
 
   return result;
@@ -330,16 +412,29 @@ struct EntityComponentManager::identity  // NOLINT
   using type = T;
 };
 
+//////////////////////////////////////////////////
+template <typename T>
+struct EntityComponentManager::IsStdFunction : std::false_type  // NOLINT
+{
+};
+
+//////////////////////////////////////////////////
+template <typename T>
+struct EntityComponentManager::IsStdFunction<std::function<T>>  // NOLINT
+  : std::true_type
+{
+};
+
 //////////////////////////////////////////////////
 template<typename ...ComponentTypeTs>
 void EntityComponentManager::EachNoCache(typename identity<std::function<
     bool(const Entity &_entity, const ComponentTypeTs *...)>>::type _f) const
 {
-  for (const auto &vertex : this->Entities().Vertices())
+  // The entities are matched again before each call, since the callback may
+  // have removed components
+  const std::set<ComponentTypeId> types{ComponentTypeTs::typeId...};
+  for (const Entity entity : this->EntitiesMatching(types, {}))
   {
-    Entity entity = vertex.first;
-    auto types = std::set<ComponentTypeId>{ComponentTypeTs::typeId...};
-
     if (this->EntityMatches(entity, types))
     {
       if (!_f(entity,
@@ -356,11 +451,11 @@ template<typename ...ComponentTypeTs>
 void EntityComponentManager::EachNoCache(typename identity<std::function<
     bool(const Entity &_entity, ComponentTypeTs *...)>>::type _f)
 {
-  for (const auto &vertex : this->Entities().Vertices())
+  // The entities are matched again before each call, since the callback may
+  // have removed components
+  const std::set<ComponentTypeId> types{ComponentTypeTs::typeId...};
+  for (const Entity entity : this->EntitiesMatching(types, {}))
   {
-    Entity entity = vertex.first;
-    auto types = std::set<ComponentTypeId>{ComponentTypeTs::typeId...};
-
     if (this->EntityMatches(entity, types))
     {
       if (!_f(entity,
@@ -376,16 +471,38 @@ void EntityComponentManager::EachNoCache(typename identity<std::function<
 template<typename ...ComponentTypeTs>
 void EntityComponentManager::Each(typename identity<std::function<
     bool(const Entity &_entity, const ComponentTypeTs *...)>>::type _f) const
+{
+  this->Each<ComponentTypeTs...>(std::cref(_f));
+}
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+void EntityComponentManager::Each(typename identity<std::function<
+    bool(const Entity &_entity, ComponentTypeTs *...)>>::type _f)
+{
+  this->Each<ComponentTypeTs...>(std::cref(_f));
+}
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs, typename Function, typename>
+void EntityComponentManager::Each(Function &&_f) const
 {
   // Get the view. This will create a new view if one does not already
   // exist.
   auto view = this->FindView<ComponentTypeTs...>();
 
-  // Iterate over the entities in the view, and invoke the callback
-  // function.
-  for (const Entity entity : view->Entities())
+  // Iterate over the entities that were in the view when the iteration
+  // started, see EachEntry. The entry only gives const access to the
+  // components.
+  detail::ViewIteration iteration(view);
+  const std::size_t size = view->Data().size();
+  for (std::size_t i = 0; i < size; ++i)
   {
-    if (!std::apply(_f, view->EntityComponentConstData(entity)))
+    typename detail::View<ComponentTypeTs...>::ConstComponentData entry;
+    if (!this->EachEntry(view, iteration, i, entry))
+      continue;
+
+    if (!std::apply(_f, entry))
     {
       break;
     }
@@ -393,25 +510,123 @@ void EntityComponentManager::Each(typename identity<std::function<
 }
 
 //////////////////////////////////////////////////
-template<typename ...ComponentTypeTs>
-void EntityComponentManager::Each(typename identity<std::function<
-    bool(const Entity &_entity, ComponentTypeTs *...)>>::type _f)
+template<typename ...ComponentTypeTs, typename Function, typename>
+void EntityComponentManager::Each(Function &&_f)
 {
   // Get the view. This will create a new view if one does not already
   // exist.
   auto view = this->FindView<ComponentTypeTs...>();
 
-  // Iterate over the entities in the view, and invoke the callback
-  // function.
-  for (const Entity entity : view->Entities())
+  // Iterate over the entities that were in the view when the iteration
+  // started, see EachEntry.
+  detail::ViewIteration iteration(view);
+  const std::size_t size = view->Data().size();
+  for (std::size_t i = 0; i < size; ++i)
   {
-    if (!std::apply(_f, view->EntityComponentData(entity)))
+    typename detail::View<ComponentTypeTs...>::ComponentData entry;
+    if (!this->EachEntry(view, iteration, i, entry))
+      continue;
+
+    if (!std::apply(_f, entry))
     {
       break;
     }
   }
 }
 
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs, typename EntryT>
+bool EntityComponentManager::EachEntry(
+    detail::View<ComponentTypeTs...> *_view,
+    const detail::ViewIteration &_iteration, const std::size_t _index,
+    EntryT &_entry) const
+{
+  // Usually the callbacks don't change the view nor move components, and the
+  // entity's data is still stored at the same index
+  const bool pending = !_view->ToAddEntities().empty();
+  if (!_iteration.Changed() && !pending)
+  {
+    _entry = _view->Data()[_index];
+    return true;
+  }
+
+  // Otherwise look the original entity up. It's skipped if a callback
+  // removed it from the view.
+  const Entity entity = _iteration.Changed() ?
+      _iteration.OriginalEntities()[_index] :
+      std::get<0>(_view->Data()[_index]);
+  if (!_view->HasEntity(entity))
+    return false;
+  _entry = this->CurrentViewData(_view, entity);
+  return true;
+}
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+typename detail::View<ComponentTypeTs...>::ComponentData
+    EntityComponentManager::CurrentViewData(
+    detail::View<ComponentTypeTs...> *_view, const Entity _entity) const
+{
+  const auto &toAdd = _view->ToAddEntities();
+  if (toAdd.find(_entity) != toAdd.end())
+    return this->ViewData<ComponentTypeTs...>(_entity);
+  return _view->EntityComponentData(_entity);
+}
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+void EntityComponentManager::EachParallel(typename identity<std::function<
+    void(const Entity &_entity, const ComponentTypeTs *...)>>::type _f,
+    std::size_t _chunkSize) const
+{
+  // Get the view on the calling thread, since finding the view may modify it
+  auto view = this->FindView<ComponentTypeTs...>();
+
+  const auto &data = view->Data();
+  this->ParallelChunks(data.size(), _chunkSize,
+      [&](std::size_t _begin, std::size_t _end)
+      {
+        for (std::size_t i = _begin; i < _end; ++i)
+          std::apply(_f, data[i]);
+      });
+}
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+void EntityComponentManager::EachParallel(typename identity<std::function<
+    void(const Entity &_entity, ComponentTypeTs *...)>>::type _f,
+    std::size_t _chunkSize)
+{
+  // Get the view on the calling thread, since finding the view may modify it
+  auto view = this->FindView<ComponentTypeTs...>();
+
+  const auto &data = view->Data();
+  this->ParallelChunks(data.size(), _chunkSize,
+      [&](std::size_t _begin, std::size_t _end)
+      {
+        for (std::size_t i = _begin; i < _end; ++i)
+          std::apply(_f, data[i]);
+      });
+}
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+void EntityComponentManager::ForEachChunk(typename identity<std::function<
+    void(const std::tuple<Entity, ComponentTypeTs *...> *_chunk,
+         std::size_t _count)>>::type _f,
+    std::size_t _chunkSize)
+{
+  // Get the view on the calling thread, since finding the view may modify it
+  auto view = this->FindView<ComponentTypeTs...>();
+
+  const auto &data = view->Data();
+  this->ParallelChunks(data.size(), _chunkSize,
+      [&](std::size_t _begin, std::size_t _end)
+      {
+        _f(data.data() + _begin, _end - _begin);
+      });
+}
+
 //////////////////////////////////////////////////
 template <class Function, class... ComponentTypeTs>
 void EntityComponentManager::ForEach(Function _f,
@@ -424,6 +639,21 @@ void EntityComponentManager::ForEach(Function _f,
 template <typename... ComponentTypeTs>
 void EntityComponentManager::EachNew(typename identity<std::function<
     bool(const Entity &_entity, ComponentTypeTs *...)>>::type _f)
+{
+  this->EachNew<ComponentTypeTs...>(std::cref(_f));
+}
+
+//////////////////////////////////////////////////
+template <typename... ComponentTypeTs>
+void EntityComponentManager::EachNew(typename identity<std::function<
+    bool(const Entity &_entity, const ComponentTypeTs *...)>>::type _f) const
+{
+  this->EachNew<ComponentTypeTs...>(std::cref(_f));
+}
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs, typename Function, typename>
+void EntityComponentManager::EachNew(Function &&_f)
 {
   // Get the view. This will create a new view if one does not already
   // exist.
@@ -432,9 +662,10 @@ void EntityComponentManager::EachNew(typename identity<std::function<
   // Iterate over the entities in the view and in the newly created
   // entities list, and invoke the callback
   // function.
-  for (const Entity entity : view->NewEntities())
+  const auto &entities = view->NewEntities();
+  for (std::size_t i = 0; i < entities.size(); ++i)
   {
-    if (!std::apply(_f, view->EntityComponentData(entity)))
+    if (!std::apply(_f, this->CurrentViewData(view, entities[i])))
     {
       break;
     }
@@ -442,9 +673,8 @@ void EntityComponentManager::EachNew(typename identity<std::function<
 }
 
 //////////////////////////////////////////////////
-template <typename... ComponentTypeTs>
-void EntityComponentManager::EachNew(typename identity<std::function<
-    bool(const Entity &_entity, const ComponentTypeTs *...)>>::type _f) const
+template<typename ...ComponentTypeTs, typename Function, typename>
+void EntityComponentManager::EachNew(Function &&_f) const
 {
   // Get the view. This will create a new view if one does not already
   // exist.
@@ -453,9 +683,12 @@ void EntityComponentManager::EachNew(typename identity<std::function<
   // Iterate over the entities in the view and in the newly created
   // entities list, and invoke the callback
   // function.
-  for (const Entity entity : view->NewEntities())
+  const auto &entities = view->NewEntities();
+  for (std::size_t i = 0; i < entities.size(); ++i)
   {
-    if (!std::apply(_f, view->EntityComponentConstData(entity)))
+    typename detail::View<ComponentTypeTs...>::ConstComponentData data =
+        this->CurrentViewData(view, entities[i]);
+    if (!std::apply(_f, data))
     {
       break;
     }
@@ -466,6 +699,13 @@ void EntityComponentManager::EachNew(typename identity<std::function<
 template<typename ...ComponentTypeTs>
 void EntityComponentManager::EachRemoved(typename identity<std::function<
     bool(const Entity &_entity, const ComponentTypeTs *...)>>::type _f) const
+{
+  this->EachRemoved<ComponentTypeTs...>(std::cref(_f));
+}
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs, typename Function, typename>
+void EntityComponentManager::EachRemoved(Function &&_f) const
 {
   // Get the view. This will create a new view if one does not already
   // exist.
@@ -474,9 +714,10 @@ void EntityComponentManager::EachRemoved(typename identity<std::function<
   // Iterate over the entities in the view and in the newly created
   // entities list, and invoke the callback
   // function.
-  for (const Entity entity : view->ToRemoveEntities())
+  const auto &entities = view->ToRemoveEntities();
+  for (std::size_t i = 0; i < entities.size(); ++i)
   {
-    if (!std::apply(_f, view->EntityComponentConstData(entity)))
+    if (!std::apply(_f, view->EntityComponentConstData(entities[i])))
     {
       break;
     }
@@ -487,9 +728,30 @@ void EntityComponentManager::EachRemoved(typename identity<std::function<
 template<typename ...ComponentTypeTs>
 detail::View<ComponentTypeTs...> *EntityComponentManager::FindView() const
 {
-  auto viewKey = std::vector<ComponentTypeId>{ComponentTypeTs::typeId...};
+  // Each thread remembers the last view found for these types. It's reused
+  // without locking or hashing as long as the views of the manager it came
+  // from haven't changed, which the epoch tells.
+  static thread_local uint64_t cachedEpoch{0};
+  static thread_local std::pair<detail::BaseView *, std::mutex *> cachedView{
+      nullptr, nullptr};
+
+  const uint64_t epoch = this->ViewsEpoch();
+  std::pair<detail::BaseView *, std::mutex *> baseViewMutexPair;
+  if (cachedEpoch == epoch)
+  {
+    baseViewMutexPair = cachedView;
+  }
+  else
+  {
+    baseViewMutexPair =
+        this->FindView(detail::View<ComponentTypeTs...>::Key());
+    if (nullptr != baseViewMutexPair.first)
+    {
+      cachedEpoch = epoch;
+      cachedView = baseViewMutexPair;
+    }
+  }
 
-  auto baseViewMutexPair = this->FindView(viewKey);
   auto baseViewPtr = baseViewMutexPair.first;
   if (nullptr != baseViewPtr)
   {
@@ -513,44 +775,75 @@ detail::View<ComponentTypeTs...> *EntityComponentManager::FindView() const
     }
 
     // add any new entities to the view before using it
-    for (const auto &[entity, isNew] : view->ToAddEntities())
-    {
-      view->AddEntityWithConstComps(entity, isNew,
-          this->Component<ComponentTypeTs>(entity)...);
-      view->AddEntityWithComps(entity, isNew,
-          const_cast<EntityComponentManager*>(this)->Component<ComponentTypeTs>(
-            entity)...);
-    }
-    view->ClearToAddEntities();
+    FlushView<ComponentTypeTs...>(*this, *view);
 
     return view;
   }
 
-  // create a new view if one wasn't found
+  // create a new view if one wasn't found, with the entities that have all
+  // of the required components and none of the excluded ones
   detail::View<ComponentTypeTs...> view;
 
-  for (const auto &vertex : this->Entities().Vertices())
+  for (const Entity entity : this->EntitiesMatching(view.ComponentTypes(),
+           view.ExcludedComponentTypes()))
   {
-    Entity entity = vertex.first;
-
-    // only add entities to the view that have all of the components in viewKey
-    if (!this->EntityMatches(entity, view.ComponentTypes()))
-      continue;
-
-    view.AddEntityWithConstComps(entity, this->IsNewEntity(entity),
-        this->Component<ComponentTypeTs>(entity)...);
-    view.AddEntityWithComps(entity, this->IsNewEntity(entity),
-        const_cast<EntityComponentManager*>(this)->Component<ComponentTypeTs>(
-            entity)...);
+    view.AddEntityWithData(this->ViewData<ComponentTypeTs...>(entity),
+        this->IsNewEntity(entity));
     if (this->IsMarkedForRemoval(entity))
       view.MarkEntityToRemove(entity);
   }
 
-  baseViewPtr = this->AddView(viewKey,
-      std::make_unique<detail::View<ComponentTypeTs...>>(view));
+  baseViewPtr = this->AddView(detail::View<ComponentTypeTs...>::Key(),
+      std::make_unique<detail::View<ComponentTypeTs...>>(view),
+      &EntityComponentManager::FlushView<ComponentTypeTs...>);
   return static_cast<detail::View<ComponentTypeTs...>*>(baseViewPtr);
 }
 
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+void EntityComponentManager::FlushView(const EntityComponentManager &_ecm,
+    detail::BaseView &_view)
+{
+  auto &view = static_cast<detail::View<ComponentTypeTs...> &>(_view);
+  if (view.ToAddEntities().empty())
+    return;
+
+  for (const auto &[entity, isNew] : view.ToAddEntities())
+  {
+    view.AddEntityWithData(_ecm.ViewData<ComponentTypeTs...>(entity),
+        isNew);
+  }
+  view.ClearToAddEntities();
+}
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+typename detail::View<ComponentTypeTs...>::ComponentData
+    EntityComponentManager::ViewData(const Entity _entity) const
+{
+  return std::tuple_cat(std::make_tuple(_entity),
+      this->ViewSlotData<ComponentTypeTs>(_entity)...);
+}
+
+//////////////////////////////////////////////////
+template<typename SlotT>
+typename detail::ViewSlot<SlotT>::Data EntityComponentManager::ViewSlotData(
+    const Entity _entity) const
+{
+  using Slot = detail::ViewSlot<SlotT>;
+  if constexpr (Slot::kExcluded)
+  {
+    (void)_entity;
+    return {};
+  }
+  else
+  {
+    return typename Slot::Data(
+        const_cast<EntityComponentManager *>(this)->Component<
+            typename Slot::Type>(_entity));
+  }
+}
+
 //////////////////////////////////////////////////
 template<typename ComponentTypeT>
 bool EntityComponentManager::RemoveComponent(Entity _entity)
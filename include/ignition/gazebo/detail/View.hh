@@ -21,10 +21,12 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include <ignition/common/Console.hh>
 
 #include "ignition/gazebo/Entity.hh"
+#include "ignition/gazebo/QueryFilters.hh"
 #include "ignition/gazebo/config.hh"
 #include "ignition/gazebo/detail/BaseView.hh"
 
@@ -36,27 +38,108 @@ namespace gazebo
 inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
 namespace detail
 {
+/// \brief Describes how a template argument of a view is stored. A plain
+/// component type is required, and its component is stored in the view.
+/// \tparam T The template argument.
+template<typename T>
+struct ViewSlot
+{
+  /// \brief The component type.
+  using Type = T;
+
+  /// \brief What the slot stores in the view's tuple.
+  using Data = std::tuple<T *>;
+
+  /// \brief What the slot stores in the view's tuple, for const access.
+  using ConstData = std::tuple<const T *>;
+
+  /// \brief Whether entities must not have the component.
+  static constexpr bool kExcluded{false};
+
+  /// \brief Whether entities may lack the component.
+  static constexpr bool kOptional{false};
+};
+
+/// \brief Slot for a component type that entities must not have. Nothing is
+/// stored in the view's tuple.
+/// \tparam T The component type.
+template<typename T>
+struct ViewSlot<Without<T>>
+{
+  /// \brief The component type.
+  using Type = T;
+
+  /// \brief What the slot stores in the view's tuple.
+  using Data = std::tuple<>;
+
+  /// \brief What the slot stores in the view's tuple, for const access.
+  using ConstData = std::tuple<>;
+
+  /// \brief Whether entities must not have the component.
+  static constexpr bool kExcluded{true};
+
+  /// \brief Whether entities may lack the component.
+  static constexpr bool kOptional{false};
+};
+
+/// \brief Slot for a component type that entities may lack. The component is
+/// stored in the view's tuple, or nullptr if the entity doesn't have it.
+/// \tparam T The component type.
+template<typename T>
+struct ViewSlot<Optional<T>>
+{
+  /// \brief The component type.
+  using Type = T;
+
+  /// \brief What the slot stores in the view's tuple.
+  using Data = std::tuple<T *>;
+
+  /// \brief What the slot stores in the view's tuple, for const access.
+  using ConstData = std::tuple<const T *>;
+
+  /// \brief Whether entities must not have the component.
+  static constexpr bool kExcluded{false};
+
+  /// \brief Whether entities may lack the component.
+  static constexpr bool kOptional{true};
+};
+
 /// \brief A view that caches a particular set of component type data.
 /// \tparam ComponentTypeTs The component type(s) that are stored in this view.
+/// Besides component types, these can be Without and Optional filters, see
+/// ViewSlot.
 template<typename ...ComponentTypeTs>
 class View : public BaseView
 {
   /// \brief Alias for containers that hold and entity and its component data.
   /// The component types held in this container match the component types that
-  /// were specified when creating the view.
-  private: using ComponentData = std::tuple<Entity, ComponentTypeTs*...>;
-  private: using ConstComponentData =
-           std::tuple<Entity, const ComponentTypeTs*...>;
+  /// were specified when creating the view, minus the Without filters.
+  public: using ComponentData = decltype(std::tuple_cat(
+              std::declval<std::tuple<Entity>>(),
+              std::declval<typename ViewSlot<ComponentTypeTs>::Data>()...));
+  public: using ConstComponentData = decltype(std::tuple_cat(
+              std::declval<std::tuple<Entity>>(),
+              std::declval<typename ViewSlot<ComponentTypeTs>::ConstData>()...));
 
   /// \brief Constructor
   public: View();
 
+  /// \brief Get the key which identifies this kind of view. Views without
+  /// filters are keyed by their component types. Each filter adds a marker
+  /// followed by the component type, so that filtered views never share a
+  /// key with unfiltered ones.
+  /// \return The key.
+  public: static ComponentTypeKey Key();
+
   /// \brief Documentation inherited
   public: bool HasCachedComponentData(const Entity _entity) const override;
 
   /// \brief Documentation inherited
   public: bool RemoveEntity(const Entity _entity) override;
 
+  /// \brief Documentation inherited
+  public: std::size_t RemoveEntities(const EntityBitmap &_entities) override;
+
   /// \brief Get an entity and its component data. It is assumed that the entity
   /// being requested exists in the view.
   /// \param[_in] _entity The entity
@@ -72,8 +155,17 @@ class View : public BaseView
   /// component data are returned.
   public: ComponentData EntityComponentData(const Entity _entity);
 
-  /// \brief Add an entity with its component data to the view. It is assunmed
-  /// that the entity to be added does not already exist in the view.
+  /// \brief Get the component data of all the entities in the view, packed
+  /// in the same order as Entities(). Const and non-const iteration share
+  /// this data, since a tuple of mutable pointers converts to a tuple of
+  /// const pointers.
+  /// \return The entities and their component data.
+  public: const std::vector<ComponentData> &Data() const;
+
+  /// \brief Add an entity with its component data to the view. If the entity
+  /// already exists in the view, its component data is updated. The view
+  /// keeps a single copy of the data for const and non-const access, so this
+  /// is equivalent to AddEntityWithComps.
   /// \param[in] _entity The entity
   /// \param[in] _new Whether to add the entity to the list of new entities.
   /// The new here is to indicate whether the entity is new to the entity
@@ -83,8 +175,8 @@ class View : public BaseView
   public: void AddEntityWithConstComps(const Entity &_entity, const bool _new,
               const ComponentTypeTs*... _compPtrs);
 
-  /// \brief Add an entity with its component data to the view. It is assunmed
-  /// that the entity to be added does not already exist in the view.
+  /// \brief Add an entity with its component data to the view. If the entity
+  /// already exists in the view, its component data is updated.
   /// \param[in] _entity The entity
   /// \param[in] _new Whether to add the entity to the list of new entities.
   /// The new here is to indicate whether the entity is new to the entity
@@ -94,6 +186,14 @@ class View : public BaseView
   public: void AddEntityWithComps(const Entity &_entity, const bool _new,
               ComponentTypeTs*... _compPtrs);
 
+  /// \brief Add an entity with its component data to the view. If the entity
+  /// already exists in the view, its component data is updated. Unlike
+  /// AddEntityWithComps, this works for views with filters.
+  /// \param[in] _data The entity and its component data.
+  /// \param[in] _new Whether to add the entity to the list of new entities.
+  /// See AddEntityWithComps.
+  public: void AddEntityWithData(const ComponentData &_data, const bool _new);
+
   /// \brief Documentation inherited
   public: bool NotifyComponentAddition(const Entity _entity, bool _newEntity,
               const ComponentTypeId _typeId) override;
@@ -105,12 +205,16 @@ class View : public BaseView
   /// \brief Documentation inherited
   public: void Reset() override;
 
-  /// \brief A map of entities to their component data. Since tuples are defined
-  /// at compile time, we need seperate containers that have tuples for both
-  /// non-const and const component pointers (calls to ECM::Each can have a
-  /// method signature that uses either non-const or const pointers)
-  private: std::unordered_map<Entity, ComponentData> validData;
-  private: std::unordered_map<Entity, ConstComponentData> validConstData;
+  /// \brief Remove an entity from validData and the packed entities.
+  /// \param[in] _entity The entity
+  /// \param[out] _data The entity's component data, if not null.
+  /// \return True if the entity was in validData.
+  private: bool RemoveValid(const Entity _entity, ComponentData *_data);
+
+  /// \brief The component data of the entities in the view, packed in the
+  /// same order as `entities`. Removal swaps the last element into the
+  /// removed slot, see BaseView::RemovePackedEntity.
+  private: std::vector<ComponentData> validData;
 
   /// \brief A map of invalid entities to their component data. The difference
   /// between invalidData and validData is that the entities in invalidData were
@@ -131,7 +235,6 @@ class View : public BaseView
   ///
   /// \sa missingCompTracker
   private: std::unordered_map<Entity, ComponentData> invalidData;
-  private: std::unordered_map<Entity, ConstComponentData> invalidConstData;
 
   /// \brief A map that keeps track of which component types for entities in
   /// invalidData need to be added back to the entity in order to move the
@@ -149,7 +252,33 @@ class View : public BaseView
 template<typename ...ComponentTypeTs>
 View<ComponentTypeTs...>::View()
 {
-  this->componentTypes = {ComponentTypeTs::typeId...};
+  ([this]()
+  {
+    using Slot = ViewSlot<ComponentTypeTs>;
+    if constexpr (Slot::kExcluded)
+      this->excludedTypes.insert(Slot::Type::typeId);
+    else if constexpr (Slot::kOptional)
+      this->optionalTypes.insert(Slot::Type::typeId);
+    else
+      this->componentTypes.insert(Slot::Type::typeId);
+  }(), ...);
+}
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+ComponentTypeKey View<ComponentTypeTs...>::Key()
+{
+  ComponentTypeKey key;
+  ([&key]()
+  {
+    using Slot = ViewSlot<ComponentTypeTs>;
+    if constexpr (Slot::kExcluded)
+      key.push_back(kComponentTypeIdInvalid);
+    else if constexpr (Slot::kOptional)
+      key.push_back(kComponentTypeIdInvalid - 1);
+    key.push_back(Slot::Type::typeId);
+  }(), ...);
+  return key;
 }
 
 //////////////////////////////////////////////////
@@ -157,25 +286,8 @@ template<typename ...ComponentTypeTs>
 bool View<ComponentTypeTs...>::HasCachedComponentData(
     const Entity _entity) const
 {
-  auto cachedComps =
-    this->validData.find(_entity) != this->validData.end() ||
+  return this->HasEntity(_entity) ||
     this->invalidData.find(_entity) != this->invalidData.end();
-  auto cachedConstComps =
-    this->validConstData.find(_entity) != this->validConstData.end() ||
-    this->invalidConstData.find(_entity) != this->invalidConstData.end();
-
-  if (cachedComps && !cachedConstComps)
-  {
-    ignwarn << "Non-const component data is cached for entity " << _entity
-      << ", but const component data is not cached." << std::endl;
-  }
-  else if (cachedConstComps && !cachedComps)
-  {
-    ignwarn << "Const component data is cached for entity " << _entity
-      << ", but non-const component data is not cached." << std::endl;
-  }
-
-  return cachedComps && cachedConstComps;
 }
 
 //////////////////////////////////////////////////
@@ -183,28 +295,75 @@ template<typename ...ComponentTypeTs>
 bool View<ComponentTypeTs...>::RemoveEntity(const Entity _entity)
 {
   this->invalidData.erase(_entity);
-  this->invalidConstData.erase(_entity);
   this->missingCompTracker.erase(_entity);
 
   if (!this->HasEntity(_entity) && !this->IsEntityMarkedForAddition(_entity))
     return false;
 
-  this->entities.erase(_entity);
-  this->newEntities.erase(_entity);
-  this->toRemoveEntities.erase(_entity);
+  this->RemoveValid(_entity, nullptr);
+  this->EraseSorted(this->newEntities, _entity);
+  this->EraseSorted(this->toRemoveEntities, _entity);
   this->toAddEntities.erase(_entity);
-  this->validData.erase(_entity);
-  this->validConstData.erase(_entity);
 
   return true;
 }
 
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+std::size_t View<ComponentTypeTs...>::RemoveEntities(
+    const EntityBitmap &_entities)
+{
+  // Removed entities are replaced with the last entity, like in
+  // RemoveValid, so only the entities that move need their index updated
+  this->WillChangePacked();
+  const std::size_t oldSize = this->entities.size();
+  std::size_t size = oldSize;
+  std::size_t i = 0;
+  while (i < size)
+  {
+    const Entity entity = this->entities[i];
+    if (!_entities.Contains(entity))
+    {
+      ++i;
+      continue;
+    }
+
+    this->entityIndex.erase(entity);
+    --size;
+    if (i != size)
+    {
+      // The moved entity is checked in the next iteration
+      this->entities[i] = this->entities[size];
+      this->validData[i] = this->validData[size];
+      this->entityIndex[this->entities[i]] = i;
+    }
+  }
+  this->entities.resize(size);
+  this->validData.resize(size);
+
+  for (auto it = this->invalidData.begin(); it != this->invalidData.end();)
+  {
+    if (_entities.Contains(it->first))
+    {
+      this->missingCompTracker.erase(it->first);
+      it = this->invalidData.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  this->RemoveFromLists(_entities);
+  return oldSize - size;
+}
+
 //////////////////////////////////////////////////
 template<typename ...ComponentTypeTs>
 typename View<ComponentTypeTs...>::ConstComponentData
   View<ComponentTypeTs...>::EntityComponentConstData(const Entity _entity) const
 {
-  return this->validConstData.at(_entity);
+  return this->validData[this->entityIndex.at(_entity)];
 }
 
 //////////////////////////////////////////////////
@@ -212,7 +371,15 @@ template<typename ...ComponentTypeTs>
 typename View<ComponentTypeTs...>::ComponentData
   View<ComponentTypeTs...>::EntityComponentData(const Entity _entity)
 {
-  return this->validData.at(_entity);
+  return this->validData[this->entityIndex.at(_entity)];
+}
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+const std::vector<typename View<ComponentTypeTs...>::ComponentData>
+  &View<ComponentTypeTs...>::Data() const
+{
+  return this->validData;
 }
 
 //////////////////////////////////////////////////
@@ -220,10 +387,8 @@ template<typename ...ComponentTypeTs>
 void View<ComponentTypeTs...>::AddEntityWithConstComps(const Entity &_entity,
     const bool _new, const ComponentTypeTs*... _compPtrs)
 {
-  this->validConstData[_entity] = std::make_tuple(_entity, _compPtrs...);
-  this->entities.insert(_entity);
-  if (_new)
-    this->newEntities.insert(_entity);
+  this->AddEntityWithComps(_entity, _new,
+      const_cast<ComponentTypeTs *>(_compPtrs)...);
 }
 
 //////////////////////////////////////////////////
@@ -231,10 +396,28 @@ template<typename ...ComponentTypeTs>
 void View<ComponentTypeTs...>::AddEntityWithComps(const Entity &_entity,
     const bool _new, ComponentTypeTs*... _compPtrs)
 {
-  this->validData[_entity] = std::make_tuple(_entity, _compPtrs...);
-  this->entities.insert(_entity);
+  this->AddEntityWithData(ComponentData(_entity, _compPtrs...), _new);
+}
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+void View<ComponentTypeTs...>::AddEntityWithData(const ComponentData &_data,
+    const bool _new)
+{
+  const Entity entity = std::get<0>(_data);
+  auto it = this->entityIndex.find(entity);
+  if (it != this->entityIndex.end())
+  {
+    this->validData[it->second] = _data;
+  }
+  else
+  {
+    this->AddPackedEntity(entity);
+    this->validData.push_back(_data);
+  }
+
   if (_new)
-    this->newEntities.insert(_entity);
+    this->InsertSorted(this->newEntities, entity);
 }
 
 //////////////////////////////////////////////////
@@ -262,14 +445,17 @@ bool View<ComponentTypeTs...>::NotifyComponentAddition(const Entity _entity,
   // view, then add the entity back to the view
   if (missingCompsIter->second.empty())
   {
-    auto nh = this->invalidData.extract(_entity);
-    this->validData.insert(std::move(nh));
-    auto constCompNh = this->invalidConstData.extract(_entity);
-    this->validConstData.insert(std::move(constCompNh));
-    this->entities.insert(_entity);
+    auto invalidIter = this->invalidData.find(_entity);
+    this->AddPackedEntity(_entity);
+    this->validData.push_back(invalidIter->second);
+    this->invalidData.erase(invalidIter);
     if (_newEntity)
-      this->newEntities.insert(_entity);
+      this->InsertSorted(this->newEntities, _entity);
     this->missingCompTracker.erase(_entity);
+
+    // The cached components may have moved, and optional components may
+    // have changed, while the entity was invalid
+    this->toAddEntities[_entity] = _newEntity;
   }
 
   return true;
@@ -293,17 +479,11 @@ bool View<ComponentTypeTs...>::NotifyComponentRemoval(const Entity _entity,
   // if the component being removed is the first component that causes _entity
   // to be invalid for this view, move _entity from validData to invalidData
   // since _entity should no longer be considered a part of the view
-  auto it = this->validData.find(_entity);
-  auto constCompIt = this->validConstData.find(_entity);
-  if (it != this->validData.end() &&
-      constCompIt != this->validConstData.end())
+  ComponentData data;
+  if (this->RemoveValid(_entity, &data))
   {
-    auto nh = this->validData.extract(it);
-    this->invalidData.insert(std::move(nh));
-    auto constCompNh = this->validConstData.extract(constCompIt);
-    this->invalidConstData.insert(std::move(constCompNh));
-    this->entities.erase(_entity);
-    this->newEntities.erase(_entity);
+    this->invalidData[_entity] = data;
+    this->EraseSorted(this->newEntities, _entity);
   }
 
   this->missingCompTracker[_entity].insert(_typeId);
@@ -317,18 +497,37 @@ void View<ComponentTypeTs...>::Reset()
 {
   // reset all data structures in the BaseView except for componentTypes since
   // the view always requires the types in componentTypes
+  this->WillChangePacked();
   this->entities.clear();
+  this->entityIndex.clear();
   this->newEntities.clear();
   this->toRemoveEntities.clear();
   this->toAddEntities.clear();
 
   // reset all data structures unique to the templated view
   this->validData.clear();
-  this->validConstData.clear();
   this->invalidData.clear();
-  this->invalidConstData.clear();
   this->missingCompTracker.clear();
 }
+
+//////////////////////////////////////////////////
+template<typename ...ComponentTypeTs>
+bool View<ComponentTypeTs...>::RemoveValid(const Entity _entity,
+    ComponentData *_data)
+{
+  std::size_t index;
+  if (!this->RemovePackedEntity(_entity, index))
+    return false;
+
+  if (nullptr != _data)
+    *_data = this->validData[index];
+
+  // mirror the swap done by RemovePackedEntity
+  if (index != this->validData.size() - 1)
+    this->validData[index] = this->validData.back();
+  this->validData.pop_back();
+  return true;
+}
 }  // namespace detail
 }  // namespace IGNITION_GAZEBO_VERSION_NAMESPACE
 }  // namespace gazebo
@@ -0,0 +1,990 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "ArchetypeStorage.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include <ignition/common/Console.hh>
+#include <ignition/common/Profiler.hh>
+
+#include "ignition/gazebo/detail/EntityBitmap.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+//////////////////////////////////////////////////
+ComponentColumn::ComponentColumn(const components::ComponentLayout *_layout)
+  : layout(_layout)
+{
+  if (nullptr != this->layout)
+  {
+    this->stride = this->layout->size;
+    this->align = this->layout->align;
+  }
+  else
+  {
+    this->stride = sizeof(components::BaseComponent *);
+    this->align = alignof(components::BaseComponent *);
+  }
+}
+
+//////////////////////////////////////////////////
+ComponentColumn::ComponentColumn(ComponentColumn &&_column) noexcept
+  : layout(_column.layout), data(_column.data), size(_column.size),
+    capacity(_column.capacity), stride(_column.stride),
+    align(_column.align), baseOffset(_column.baseOffset)
+{
+  _column.data = nullptr;
+  _column.size = 0;
+  _column.capacity = 0;
+}
+
+//////////////////////////////////////////////////
+ComponentColumn &ComponentColumn::operator=(ComponentColumn &&_column)
+    noexcept
+{
+  if (this == &_column)
+    return *this;
+
+  this->Release();
+  this->layout = _column.layout;
+  this->data = _column.data;
+  this->size = _column.size;
+  this->capacity = _column.capacity;
+  this->stride = _column.stride;
+  this->align = _column.align;
+  this->baseOffset = _column.baseOffset;
+  _column.data = nullptr;
+  _column.size = 0;
+  _column.capacity = 0;
+  return *this;
+}
+
+//////////////////////////////////////////////////
+ComponentColumn::~ComponentColumn()
+{
+  this->Release();
+}
+
+//////////////////////////////////////////////////
+const components::ComponentLayout *ComponentColumn::Layout() const
+{
+  return this->layout;
+}
+
+//////////////////////////////////////////////////
+std::size_t ComponentColumn::Size() const
+{
+  return this->size;
+}
+
+//////////////////////////////////////////////////
+components::BaseComponent *ComponentColumn::At(std::size_t _row) const
+{
+  if (nullptr == this->layout)
+    return *reinterpret_cast<components::BaseComponent **>(this->Slot(_row));
+  return reinterpret_cast<components::BaseComponent *>(
+      this->Slot(_row) + this->baseOffset);
+}
+
+//////////////////////////////////////////////////
+bool ComponentColumn::EnsureCapacity(std::size_t _count)
+{
+  if (_count <= this->capacity)
+    return false;
+
+  const std::size_t newCapacity =
+      std::max<std::size_t>({_count, 2 * this->capacity, 8});
+  auto newData = static_cast<unsigned char *>(::operator new(
+      newCapacity * this->stride, std::align_val_t(this->align)));
+
+  // Pointers are copied as they are, components are moved
+  bool moved{false};
+  if (nullptr == this->layout)
+  {
+    if (this->size > 0)
+      std::memcpy(newData, this->data, this->size * this->stride);
+  }
+  else
+  {
+    for (std::size_t row = 0; row < this->size; ++row)
+    {
+      auto comp = this->At(row);
+      this->layout->moveTo(newData + row * this->stride, *comp);
+      comp->~BaseComponent();
+    }
+    moved = this->size > 0;
+  }
+
+  if (nullptr != this->data)
+    ::operator delete(this->data, std::align_val_t(this->align));
+  this->data = newData;
+  this->capacity = newCapacity;
+  return moved;
+}
+
+//////////////////////////////////////////////////
+components::BaseComponent *ComponentColumn::Push(
+    std::unique_ptr<components::BaseComponent> _component)
+{
+  this->EnsureCapacity(this->size + 1);
+  if (nullptr == this->layout)
+  {
+    auto comp = _component.release();
+    *reinterpret_cast<components::BaseComponent **>(
+        this->Slot(this->size)) = comp;
+    return this->Constructed(comp);
+  }
+
+  // The moved-from instance is destroyed with _component
+  return this->Constructed(
+      this->layout->moveTo(this->Slot(this->size), *_component));
+}
+
+//////////////////////////////////////////////////
+components::BaseComponent *ComponentColumn::PushCopy(
+    const components::BaseComponent &_component)
+{
+  if (nullptr == this->layout || nullptr == this->layout->copyTo)
+  {
+    // Clone doesn't modify the component, but isn't const
+    return this->Push(
+        const_cast<components::BaseComponent &>(_component).Clone());
+  }
+
+  this->EnsureCapacity(this->size + 1);
+  return this->Constructed(
+      this->layout->copyTo(this->Slot(this->size), _component));
+}
+
+//////////////////////////////////////////////////
+components::BaseComponent *ComponentColumn::PushFrom(
+    ComponentColumn &_column, std::size_t _row)
+{
+  if (nullptr == this->layout || nullptr == _column.layout)
+    return this->Push(_column.Take(_row));
+
+  this->EnsureCapacity(this->size + 1);
+  return this->Constructed(
+      this->layout->moveTo(this->Slot(this->size), *_column.At(_row)));
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<components::BaseComponent> ComponentColumn::Take(
+    std::size_t _row)
+{
+  if (nullptr == this->layout)
+  {
+    // The row is left with a null pointer, which SwapRemove skips
+    auto slot = reinterpret_cast<components::BaseComponent **>(
+        this->Slot(_row));
+    std::unique_ptr<components::BaseComponent> result(*slot);
+    *slot = nullptr;
+    return result;
+  }
+  return this->layout->moveNew(*this->At(_row));
+}
+
+//////////////////////////////////////////////////
+void ComponentColumn::SwapRemove(std::size_t _row)
+{
+  const std::size_t last = this->size - 1;
+  if (nullptr == this->layout)
+  {
+    auto slots = reinterpret_cast<components::BaseComponent **>(this->data);
+    delete slots[_row];
+    slots[_row] = slots[last];
+  }
+  else
+  {
+    auto comp = this->At(_row);
+    comp->~BaseComponent();
+    if (_row != last)
+    {
+      auto lastComp = this->At(last);
+      this->layout->moveTo(this->Slot(_row), *lastComp);
+      lastComp->~BaseComponent();
+    }
+  }
+  this->size = last;
+}
+
+//////////////////////////////////////////////////
+unsigned char *ComponentColumn::Slot(std::size_t _row) const
+{
+  return this->data + _row * this->stride;
+}
+
+//////////////////////////////////////////////////
+components::BaseComponent *ComponentColumn::Constructed(
+    components::BaseComponent *_component)
+{
+  if (nullptr != this->layout)
+  {
+    this->baseOffset = reinterpret_cast<unsigned char *>(_component) -
+        this->Slot(this->size);
+  }
+  ++this->size;
+  return _component;
+}
+
+//////////////////////////////////////////////////
+void ComponentColumn::Release()
+{
+  for (std::size_t row = 0; row < this->size; ++row)
+  {
+    if (nullptr == this->layout)
+      delete this->At(row);
+    else
+      this->At(row)->~BaseComponent();
+  }
+  if (nullptr != this->data)
+    ::operator delete(this->data, std::align_val_t(this->align));
+  this->data = nullptr;
+  this->size = 0;
+  this->capacity = 0;
+}
+
+//////////////////////////////////////////////////
+Archetype::Archetype(std::vector<ComponentTypeId> _types)
+  : types(std::move(_types)), tags(this->types.size())
+{
+  this->columns.reserve(this->types.size());
+  for (const auto typeId : this->types)
+    this->columns.emplace_back(components::ComponentLayoutOf(typeId));
+}
+
+//////////////////////////////////////////////////
+const std::vector<ComponentTypeId> &Archetype::Types() const
+{
+  return this->types;
+}
+
+//////////////////////////////////////////////////
+const std::vector<Entity> &Archetype::Entities() const
+{
+  return this->entities;
+}
+
+//////////////////////////////////////////////////
+int Archetype::Column(const ComponentTypeId _typeId) const
+{
+  auto it = std::lower_bound(this->types.begin(), this->types.end(), _typeId);
+  if (it == this->types.end() || *it != _typeId)
+    return -1;
+  return static_cast<int>(it - this->types.begin());
+}
+
+//////////////////////////////////////////////////
+bool Archetype::Includes(const std::set<ComponentTypeId> &_types) const
+{
+  // Both containers are sorted
+  return std::includes(this->types.begin(), this->types.end(),
+      _types.begin(), _types.end());
+}
+
+//////////////////////////////////////////////////
+components::BaseComponent *Archetype::At(std::size_t _column,
+    std::size_t _row) const
+{
+  if (nullptr != this->tags[_column])
+    return this->tags[_column].get();
+  return this->columns[_column].At(_row);
+}
+
+//////////////////////////////////////////////////
+ArchetypeStorage::ArchetypeStorage()
+{
+  this->Reset();
+}
+
+//////////////////////////////////////////////////
+void ArchetypeStorage::Reset()
+{
+  this->records.Clear();
+  this->removed.clear();
+  this->archetypes.clear();
+  this->archetypeIndex.clear();
+  this->tags.clear();
+  this->relocated.clear();
+
+  // The empty archetype always exists at index 0, it's where new entities go.
+  this->archetypes.emplace_back(std::vector<ComponentTypeId>());
+  this->archetypeIndex[{}] = 0;
+}
+
+//////////////////////////////////////////////////
+bool ArchetypeStorage::AddEntity(const Entity _entity)
+{
+  auto &empty = this->archetypes[0];
+  Record record{0, empty.entities.size()};
+  if (nullptr == this->records.Insert(_entity, record))
+    return false;
+
+  empty.entities.push_back(_entity);
+  return true;
+}
+
+//////////////////////////////////////////////////
+void ArchetypeStorage::Reserve(std::size_t _count)
+{
+  this->records.Reserve(_count);
+  this->archetypes[0].entities.reserve(_count);
+}
+
+//////////////////////////////////////////////////
+bool ArchetypeStorage::RemoveEntity(const Entity _entity)
+{
+  auto record = this->records.Find(_entity);
+  if (nullptr == record)
+    return false;
+
+  this->EraseRow(record->archetype, record->row);
+
+  this->records.Erase(_entity);
+  this->removed.erase(_entity);
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::size_t ArchetypeStorage::RemoveEntities(
+    const std::vector<Entity> &_entities)
+{
+  // Find the archetypes which hold the entities
+  std::vector<Entity> existing;
+  std::vector<std::size_t> touched;
+  existing.reserve(_entities.size());
+  for (const Entity entity : _entities)
+  {
+    auto record = this->records.Find(entity);
+    if (nullptr == record)
+      continue;
+    existing.push_back(entity);
+    touched.push_back(record->archetype);
+  }
+  if (existing.empty())
+    return 0;
+
+  std::sort(touched.begin(), touched.end());
+  touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+  detail::EntityBitmap bitmap(existing);
+
+  // Sweep each archetype once. Removed rows are filled with the last row,
+  // like in EraseRow, which is checked next.
+  for (const auto index : touched)
+  {
+    auto &archetype = this->archetypes[index];
+    std::size_t size = archetype.entities.size();
+    std::size_t row = 0;
+    while (row < size)
+    {
+      if (!bitmap.Contains(archetype.entities[row]))
+      {
+        ++row;
+        continue;
+      }
+
+      --size;
+      for (std::size_t c = 0; c < archetype.columns.size(); ++c)
+      {
+        if (nullptr == archetype.tags[c])
+          archetype.columns[c].SwapRemove(row);
+      }
+      if (row != size)
+      {
+        const auto movedEntity = archetype.entities[size];
+        archetype.entities[row] = movedEntity;
+        this->records.Find(movedEntity)->row = row;
+        if (archetype.hasData && !bitmap.Contains(movedEntity))
+          this->relocated.push_back(movedEntity);
+      }
+    }
+    archetype.entities.resize(size);
+  }
+
+  for (const Entity entity : existing)
+  {
+    this->records.Erase(entity);
+    this->removed.erase(entity);
+  }
+  return existing.size();
+}
+
+//////////////////////////////////////////////////
+bool ArchetypeStorage::HasEntity(const Entity _entity) const
+{
+  return nullptr != this->records.Find(_entity);
+}
+
+//////////////////////////////////////////////////
+std::size_t ArchetypeStorage::EntityCount() const
+{
+  return this->records.Size();
+}
+
+//////////////////////////////////////////////////
+components::BaseComponent *ArchetypeStorage::AddComponent(
+    const Entity _entity,
+    std::unique_ptr<components::BaseComponent> _component)
+{
+  if (nullptr == _component)
+    return nullptr;
+
+  auto record = this->records.Find(_entity);
+  if (nullptr == record)
+    return nullptr;
+
+  const auto typeId = _component->TypeId();
+  if (this->archetypes[record->archetype].Column(typeId) >= 0 ||
+      this->HasRemovedComponent(_entity, typeId))
+  {
+    return nullptr;
+  }
+
+  // The tag must be known before its archetypes are created
+  const bool tag = this->RegisterTag(_component);
+
+  auto to = this->Transition(record->archetype, typeId, true);
+  this->Move(_entity, *record, to, nullptr);
+
+  auto &archetype = this->archetypes[to];
+  const auto column = archetype.Column(typeId);
+  if (tag)
+    return archetype.tags[column].get();
+
+  return archetype.columns[column].Push(std::move(_component));
+}
+
+//////////////////////////////////////////////////
+components::BaseComponent *ArchetypeStorage::AddTag(const Entity _entity,
+    const ComponentTypeId _typeId)
+{
+  auto record = this->records.Find(_entity);
+  if (nullptr == record || !this->IsTag(_typeId) ||
+      this->archetypes[record->archetype].Column(_typeId) >= 0 ||
+      this->HasRemovedComponent(_entity, _typeId))
+  {
+    return nullptr;
+  }
+
+  auto to = this->Transition(record->archetype, _typeId, true);
+  this->Move(_entity, *record, to, nullptr);
+
+  auto &archetype = this->archetypes[to];
+  return archetype.tags[archetype.Column(_typeId)].get();
+}
+
+//////////////////////////////////////////////////
+bool ArchetypeStorage::IsTag(const ComponentTypeId _typeId) const
+{
+  return this->tags.find(_typeId) != this->tags.end();
+}
+
+//////////////////////////////////////////////////
+bool ArchetypeStorage::AddComponents(const Entity _entity,
+    std::vector<std::unique_ptr<components::BaseComponent>> &&_components)
+{
+  auto record = this->records.Find(_entity);
+  if (nullptr == record)
+    return false;
+
+  if (_components.empty())
+    return true;
+
+  auto types = this->archetypes[record->archetype].types;
+  for (const auto &comp : _components)
+  {
+    if (nullptr == comp)
+      return false;
+
+    const auto typeId = comp->TypeId();
+    auto it = std::lower_bound(types.begin(), types.end(), typeId);
+    if ((it != types.end() && *it == typeId) ||
+        this->HasRemovedComponent(_entity, typeId))
+    {
+      return false;
+    }
+    types.insert(it, typeId);
+  }
+
+  // Tags must be known before their archetypes are created
+  const auto firstType = _components[0]->TypeId();
+  for (auto &comp : _components)
+    this->RegisterTag(comp);
+
+  std::size_t to;
+  if (_components.size() == 1)
+  {
+    to = this->Transition(record->archetype, firstType, true);
+  }
+  else
+  {
+    to = this->FindOrAddArchetype(std::move(types));
+  }
+  this->Move(_entity, *record, to, nullptr);
+
+  // Instances of tags that were already known aren't kept
+  auto &archetype = this->archetypes[to];
+  for (auto &comp : _components)
+  {
+    if (nullptr == comp)
+      continue;
+
+    const auto column = archetype.Column(comp->TypeId());
+    if (nullptr == archetype.tags[column])
+      archetype.columns[column].Push(std::move(comp));
+    else
+      comp.reset();
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::vector<Entity> ArchetypeStorage::AddComponentToEntities(
+    const std::vector<Entity> &_entities,
+    const components::BaseComponent &_component)
+{
+  IGN_PROFILE("ArchetypeStorage::AddComponentToEntities");
+  const auto typeId = _component.TypeId();
+
+  // Mark the rows to move in each archetype, which groups the entities by
+  // archetype. An entity listed twice is only kept the first time.
+  std::vector<std::vector<bool>> marked(this->archetypes.size());
+  std::vector<std::size_t> touched;
+  std::vector<Entity> added;
+  added.reserve(_entities.size());
+  for (const Entity entity : _entities)
+  {
+    auto record = this->records.Find(entity);
+    if (nullptr == record ||
+        this->archetypes[record->archetype].Column(typeId) >= 0 ||
+        this->HasRemovedComponent(entity, typeId))
+    {
+      continue;
+    }
+
+    auto &rows = marked[record->archetype];
+    if (rows.empty())
+    {
+      rows.resize(this->archetypes[record->archetype].entities.size());
+      touched.push_back(record->archetype);
+    }
+    if (rows[record->row])
+      continue;
+    rows[record->row] = true;
+    added.push_back(entity);
+  }
+  if (added.empty())
+    return added;
+
+  // The tag must be known before its archetypes are created. Clone doesn't
+  // modify the component, but isn't const.
+  bool tag = this->IsTag(typeId);
+  if (!tag && this->dataTypes.find(typeId) == this->dataTypes.end())
+  {
+    auto instance =
+        const_cast<components::BaseComponent &>(_component).Clone();
+    tag = this->RegisterTag(instance);
+  }
+
+  std::vector<std::size_t> rows;
+  for (const auto from : touched)
+  {
+    rows.clear();
+    for (std::size_t row = 0; row < marked[from].size(); ++row)
+    {
+      if (marked[from][row])
+        rows.push_back(row);
+    }
+
+    const auto to = this->Transition(from, typeId, true);
+    this->MoveRows(from, rows, to);
+    if (!tag)
+    {
+      auto &column =
+          this->archetypes[to].columns[this->archetypes[to].Column(typeId)];
+      for (std::size_t i = 0; i < rows.size(); ++i)
+        column.PushCopy(_component);
+    }
+  }
+  return added;
+}
+
+//////////////////////////////////////////////////
+bool ArchetypeStorage::RemoveComponent(const Entity _entity,
+    const ComponentTypeId _typeId)
+{
+  auto record = this->records.Find(_entity);
+  if (nullptr == record ||
+      this->archetypes[record->archetype].Column(_typeId) < 0)
+  {
+    return false;
+  }
+
+  auto to = this->Transition(record->archetype, _typeId, false);
+  std::unique_ptr<components::BaseComponent> dropped;
+  this->Move(_entity, *record, to, &dropped);
+
+  this->removed[_entity][_typeId] = std::move(dropped);
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool ArchetypeStorage::HasRemovedComponent(const Entity _entity,
+    const ComponentTypeId _typeId) const
+{
+  auto it = this->removed.find(_entity);
+  if (it == this->removed.end())
+    return false;
+  return it->second.find(_typeId) != it->second.end();
+}
+
+//////////////////////////////////////////////////
+components::BaseComponent *ArchetypeStorage::RestoreComponent(
+    const Entity _entity, const ComponentTypeId _typeId,
+    const components::BaseComponent *_data)
+{
+  auto it = this->removed.find(_entity);
+  if (it == this->removed.end())
+    return nullptr;
+
+  auto compIt = it->second.find(_typeId);
+  if (compIt == it->second.end())
+    return nullptr;
+
+  auto comp = std::move(compIt->second);
+  it->second.erase(compIt);
+  if (it->second.empty())
+    this->removed.erase(it);
+
+  if (nullptr == comp)
+    return this->AddTag(_entity, _typeId);
+
+  // The data is copied before anything moves
+  if (nullptr != _data)
+    components::ComponentCopy(_typeId)(*comp, *_data);
+  return this->AddComponent(_entity, std::move(comp));
+}
+
+//////////////////////////////////////////////////
+components::BaseComponent *ArchetypeStorage::Component(const Entity _entity,
+    const ComponentTypeId _typeId) const
+{
+  auto record = this->records.Find(_entity);
+  if (nullptr == record)
+    return nullptr;
+
+  const auto &archetype = this->archetypes[record->archetype];
+  auto column = archetype.Column(_typeId);
+  if (column < 0)
+    return nullptr;
+
+  return archetype.At(column, record->row);
+}
+
+//////////////////////////////////////////////////
+const std::vector<ComponentTypeId> *ArchetypeStorage::ComponentTypes(
+    const Entity _entity) const
+{
+  auto record = this->records.Find(_entity);
+  if (nullptr == record)
+    return nullptr;
+
+  return &this->archetypes[record->archetype].Types();
+}
+
+//////////////////////////////////////////////////
+bool ArchetypeStorage::EntityMatches(const Entity _entity,
+    const std::set<ComponentTypeId> &_types) const
+{
+  auto record = this->records.Find(_entity);
+  if (nullptr == record)
+    return false;
+
+  return this->archetypes[record->archetype].Includes(_types);
+}
+
+//////////////////////////////////////////////////
+std::vector<Archetype> ArchetypeStorage::Snapshot() const
+{
+  IGN_PROFILE("ArchetypeStorage::Snapshot");
+  std::vector<Archetype> result;
+  for (const auto &archetype : this->archetypes)
+  {
+    if (archetype.entities.empty())
+      continue;
+
+    Archetype copy(archetype.types);
+    copy.entities = archetype.entities;
+    copy.tags = archetype.tags;
+    copy.hasData = archetype.hasData;
+    for (std::size_t c = 0; c < archetype.columns.size(); ++c)
+    {
+      const auto &from = archetype.columns[c];
+      auto &column = copy.columns[c];
+      column.EnsureCapacity(from.Size());
+      for (std::size_t row = 0; row < from.Size(); ++row)
+        column.PushCopy(*from.At(row));
+    }
+    result.push_back(std::move(copy));
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+const std::vector<Archetype> &ArchetypeStorage::Archetypes() const
+{
+  return this->archetypes;
+}
+
+//////////////////////////////////////////////////
+const std::vector<Entity> &ArchetypeStorage::Relocated() const
+{
+  return this->relocated;
+}
+
+//////////////////////////////////////////////////
+void ArchetypeStorage::ClearRelocated()
+{
+  this->relocated.clear();
+}
+
+//////////////////////////////////////////////////
+std::size_t ArchetypeStorage::Transition(std::size_t _from,
+    const ComponentTypeId _typeId, bool _add)
+{
+  {
+    auto &edges = _add ? this->archetypes[_from].addEdges :
+        this->archetypes[_from].removeEdges;
+    auto edgeIt = edges.find(_typeId);
+    if (edgeIt != edges.end())
+      return edgeIt->second;
+  }
+
+  auto types = this->archetypes[_from].types;
+  if (_add)
+    types.insert(std::lower_bound(types.begin(), types.end(), _typeId),
+        _typeId);
+  else
+    types.erase(std::lower_bound(types.begin(), types.end(), _typeId));
+
+  std::size_t to = this->FindOrAddArchetype(std::move(types));
+
+  if (_add)
+  {
+    this->archetypes[_from].addEdges[_typeId] = to;
+    this->archetypes[to].removeEdges[_typeId] = _from;
+  }
+  else
+  {
+    this->archetypes[_from].removeEdges[_typeId] = to;
+    this->archetypes[to].addEdges[_typeId] = _from;
+  }
+  return to;
+}
+
+//////////////////////////////////////////////////
+std::size_t ArchetypeStorage::FindOrAddArchetype(
+    std::vector<ComponentTypeId> _types)
+{
+  auto indexIt = this->archetypeIndex.find(_types);
+  if (indexIt != this->archetypeIndex.end())
+    return indexIt->second;
+
+  IGN_PROFILE("ArchetypeStorage::NewArchetype");
+  const std::size_t index = this->archetypes.size();
+  this->archetypeIndex[_types] = index;
+  // Note that this may invalidate references to other archetypes
+  auto &archetype = this->archetypes.emplace_back(std::move(_types));
+
+  for (std::size_t c = 0; c < archetype.types.size(); ++c)
+  {
+    auto tagIt = this->tags.find(archetype.types[c]);
+    if (tagIt != this->tags.end())
+      archetype.tags[c] = tagIt->second;
+    else
+      archetype.hasData = true;
+  }
+  return index;
+}
+
+//////////////////////////////////////////////////
+bool ArchetypeStorage::RegisterTag(
+    std::unique_ptr<components::BaseComponent> &_component)
+{
+  const auto typeId = _component->TypeId();
+  if (this->dataTypes.find(typeId) != this->dataTypes.end())
+    return false;
+
+  if (this->tags.find(typeId) == this->tags.end() &&
+      !components::IsTagComponent(typeId))
+  {
+    this->dataTypes.insert(typeId);
+    return false;
+  }
+
+  auto &tag = this->tags[typeId];
+  if (nullptr == tag)
+    tag = std::move(_component);
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::size_t ArchetypeStorage::Move(const Entity _entity, Record &_record,
+    std::size_t _to, std::unique_ptr<components::BaseComponent> *_dropped)
+{
+  this->GrowColumns(_to);
+
+  auto &src = this->archetypes[_record.archetype];
+  auto &dst = this->archetypes[_to];
+  const auto srcRow = _record.row;
+  const auto dstRow = dst.entities.size();
+  if (src.hasData)
+    this->relocated.push_back(_entity);
+
+  // Walk both sorted type lists, moving the columns they share. Columns that
+  // only exist in the destination are filled by the caller.
+  std::size_t s = 0;
+  std::size_t d = 0;
+  while (s < src.types.size() || d < dst.types.size())
+  {
+    if (d >= dst.types.size() ||
+        (s < src.types.size() && src.types[s] < dst.types[d]))
+    {
+      if (nullptr != _dropped && nullptr == src.tags[s])
+        *_dropped = src.columns[s].Take(srcRow);
+      ++s;
+    }
+    else if (s >= src.types.size() || dst.types[d] < src.types[s])
+    {
+      ++d;
+    }
+    else
+    {
+      if (nullptr == dst.tags[d])
+        dst.columns[d].PushFrom(src.columns[s], srcRow);
+      ++s;
+      ++d;
+    }
+  }
+  dst.entities.push_back(_entity);
+
+  this->EraseRow(_record.archetype, srcRow);
+
+  _record.archetype = _to;
+  _record.row = dstRow;
+  return dstRow;
+}
+
+//////////////////////////////////////////////////
+void ArchetypeStorage::MoveRows(std::size_t _from,
+    const std::vector<std::size_t> &_rows, std::size_t _to)
+{
+  this->GrowColumns(_to, _rows.size());
+
+  auto &src = this->archetypes[_from];
+  auto &dst = this->archetypes[_to];
+  const auto firstRow = dst.entities.size();
+
+  // Move the columns both archetypes share, one column at a time
+  std::size_t s = 0;
+  std::size_t d = 0;
+  while (s < src.types.size() && d < dst.types.size())
+  {
+    if (src.types[s] < dst.types[d])
+    {
+      ++s;
+    }
+    else if (dst.types[d] < src.types[s])
+    {
+      ++d;
+    }
+    else
+    {
+      if (nullptr == dst.tags[d])
+      {
+        for (const auto row : _rows)
+          dst.columns[d].PushFrom(src.columns[s], row);
+      }
+      ++s;
+      ++d;
+    }
+  }
+
+  dst.entities.reserve(firstRow + _rows.size());
+  for (std::size_t i = 0; i < _rows.size(); ++i)
+  {
+    const auto entity = src.entities[_rows[i]];
+    dst.entities.push_back(entity);
+    auto record = this->records.Find(entity);
+    record->archetype = _to;
+    record->row = firstRow + i;
+    if (src.hasData)
+      this->relocated.push_back(entity);
+  }
+
+  // Erasing from the last row means that the rows swapped in are never
+  // moved rows, and that no row is swapped if all rows moved
+  for (auto it = _rows.rbegin(); it != _rows.rend(); ++it)
+    this->EraseRow(_from, *it);
+}
+
+//////////////////////////////////////////////////
+void ArchetypeStorage::EraseRow(std::size_t _archetype, std::size_t _row)
+{
+  auto &archetype = this->archetypes[_archetype];
+  const auto last = archetype.entities.size() - 1;
+  for (std::size_t c = 0; c < archetype.columns.size(); ++c)
+  {
+    if (nullptr == archetype.tags[c])
+      archetype.columns[c].SwapRemove(_row);
+  }
+
+  if (_row != last)
+  {
+    const auto movedEntity = archetype.entities[last];
+    archetype.entities[_row] = movedEntity;
+    this->records.Find(movedEntity)->row = _row;
+    if (archetype.hasData)
+      this->relocated.push_back(movedEntity);
+  }
+  archetype.entities.pop_back();
+}
+
+//////////////////////////////////////////////////
+void ArchetypeStorage::GrowColumns(std::size_t _archetype,
+    std::size_t _rows)
+{
+  auto &archetype = this->archetypes[_archetype];
+  const std::size_t count = archetype.entities.size() + _rows;
+  bool moved{false};
+  for (std::size_t c = 0; c < archetype.columns.size(); ++c)
+  {
+    if (nullptr == archetype.tags[c])
+      moved = archetype.columns[c].EnsureCapacity(count) || moved;
+  }
+
+  if (moved)
+  {
+    this->relocated.insert(this->relocated.end(),
+        archetype.entities.begin(), archetype.entities.end());
+  }
+}
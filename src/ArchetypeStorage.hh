@@ -0,0 +1,531 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_ARCHETYPESTORAGE_HH_
+#define IGNITION_GAZEBO_ARCHETYPESTORAGE_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <ignition/gazebo/config.hh>
+#include <ignition/gazebo/Export.hh>
+
+#include "ignition/gazebo/Entity.hh"
+#include "ignition/gazebo/Types.hh"
+#include "ignition/gazebo/components/Component.hh"
+#include "EntityIndex.hh"
+
+namespace ignition
+{
+  namespace gazebo
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+    /// \class ComponentColumn ArchetypeStorage.hh
+    /// \brief Contiguous array of components of a single type. Components
+    /// are constructed in place, one after the other, through the type's
+    /// components::ComponentLayout. Types without a layout are stored as
+    /// pointers to individually allocated instances instead.
+    ///
+    /// Growing the column moves its components to a new array, and removing
+    /// a row moves the last component into it, so pointers to components
+    /// are only valid until the column changes.
+    class IGNITION_GAZEBO_VISIBLE ComponentColumn
+    {
+      /// \brief Constructor
+      /// \param[in] _layout Layout of the column's type, or nullptr to store
+      /// pointers to individually allocated components.
+      public: explicit ComponentColumn(
+                  const components::ComponentLayout *_layout = nullptr);
+
+      /// \brief Move constructor
+      /// \param[in] _column Column to move, which is left empty.
+      public: ComponentColumn(ComponentColumn &&_column) noexcept;
+
+      /// \brief Move assignment
+      /// \param[in] _column Column to move, which is left empty.
+      /// \return Reference to this column.
+      public: ComponentColumn &operator=(ComponentColumn &&_column) noexcept;
+
+      /// \brief Columns can't be copied, see PushCopy.
+      public: ComponentColumn(const ComponentColumn &) = delete;
+
+      /// \brief Columns can't be copied, see PushCopy.
+      public: ComponentColumn &operator=(const ComponentColumn &) = delete;
+
+      /// \brief Destructor, which destroys all components.
+      public: ~ComponentColumn();
+
+      /// \brief Get the layout of the column's type.
+      /// \return The layout, or nullptr if components are allocated
+      /// individually.
+      public: const components::ComponentLayout *Layout() const;
+
+      /// \brief Number of components in the column.
+      /// \return Component count.
+      public: std::size_t Size() const;
+
+      /// \brief Get a component.
+      /// \param[in] _row Row, less than Size().
+      /// \return The component.
+      public: components::BaseComponent *At(std::size_t _row) const;
+
+      /// \brief Make room for a number of components, growing the array
+      /// geometrically if needed.
+      /// \param[in] _count Number of components the column must be able to
+      /// hold.
+      /// \return True if the components already in the column were moved
+      /// to a new address.
+      public: bool EnsureCapacity(std::size_t _count);
+
+      /// \brief Add a component at the end, moving its value in.
+      /// \param[in] _component Component of the column's type.
+      /// \return The stored component.
+      public: components::BaseComponent *Push(
+                  std::unique_ptr<components::BaseComponent> _component);
+
+      /// \brief Add a copy of a component at the end.
+      /// \param[in] _component Component of the column's type.
+      /// \return The stored component.
+      public: components::BaseComponent *PushCopy(
+                  const components::BaseComponent &_component);
+
+      /// \brief Add a component at the end, moving it from a row of another
+      /// column of the same type. The other row holds a moved-from
+      /// component until it's removed with SwapRemove.
+      /// \param[in, out] _column Column to move from.
+      /// \param[in] _row Row of _column.
+      /// \return The stored component.
+      public: components::BaseComponent *PushFrom(ComponentColumn &_column,
+                  std::size_t _row);
+
+      /// \brief Move a component out of the column into a new instance. The
+      /// row holds a moved-from component until it's removed with
+      /// SwapRemove.
+      /// \param[in] _row Row.
+      /// \return The new instance.
+      public: std::unique_ptr<components::BaseComponent> Take(
+                  std::size_t _row);
+
+      /// \brief Destroy the component at a row, and move the last component
+      /// into its place.
+      /// \param[in] _row Row.
+      public: void SwapRemove(std::size_t _row);
+
+      /// \brief Get the memory of a row.
+      /// \param[in] _row Row, which may be past the last component.
+      /// \return Pointer to the memory.
+      private: unsigned char *Slot(std::size_t _row) const;
+
+      /// \brief Count a component stored at the end of the column.
+      /// \param[in] _component The component, constructed at Slot(size), or
+      /// pointed to from there if the column has no layout.
+      /// \return _component
+      private: components::BaseComponent *Constructed(
+                   components::BaseComponent *_component);
+
+      /// \brief Destroy all components and free the array.
+      private: void Release();
+
+      /// \brief Layout of the column's type, or nullptr if components are
+      /// allocated individually and `data` holds pointers to them.
+      private: const components::ComponentLayout *layout{nullptr};
+
+      /// \brief The array of components.
+      private: unsigned char *data{nullptr};
+
+      /// \brief Number of components.
+      private: std::size_t size{0};
+
+      /// \brief Number of components `data` can hold.
+      private: std::size_t capacity{0};
+
+      /// \brief Distance between two rows, in bytes.
+      private: std::size_t stride{0};
+
+      /// \brief Alignment of `data`.
+      private: std::size_t align{0};
+
+      /// \brief Offset of the BaseComponent within a component stored in
+      /// place, which is the same for all components of a type.
+      private: std::ptrdiff_t baseOffset{0};
+    };
+
+    /// \class Archetype ArchetypeStorage.hh
+    /// \brief An archetype groups all the entities that have exactly the same
+    /// set of component types. Components are stored in one column per
+    /// component type, and each entity occupies one row across all columns.
+    ///
+    /// Columns store the component values contiguously, see ComponentColumn,
+    /// so components move in memory when their entity changes archetype,
+    /// when another row of the archetype is removed, and when the archetype
+    /// grows. ArchetypeStorage::Relocated lists the entities whose
+    /// components moved, so that cached pointers can be refreshed.
+    ///
+    /// Tag components, which hold no data, have no column. All the rows of
+    /// a tag type share a single instance.
+    class IGNITION_GAZEBO_VISIBLE Archetype
+    {
+      /// \brief Constructor
+      /// \param[in] _types Component types of this archetype. Must be sorted
+      /// and unique.
+      public: explicit Archetype(std::vector<ComponentTypeId> _types);
+
+      /// \brief Get the sorted component types of this archetype.
+      /// \return The component types.
+      public: const std::vector<ComponentTypeId> &Types() const;
+
+      /// \brief Get the entities stored in this archetype, in row order.
+      /// \return The entities.
+      public: const std::vector<Entity> &Entities() const;
+
+      /// \brief Get the column index of a component type.
+      /// \param[in] _typeId Component type.
+      /// \return Column index, or -1 if the archetype doesn't have the type.
+      public: int Column(const ComponentTypeId _typeId) const;
+
+      /// \brief Check whether this archetype has all the given types.
+      /// \param[in] _types Component types to check.
+      /// \return True if all of _types are part of this archetype.
+      public: bool Includes(const std::set<ComponentTypeId> &_types) const;
+
+      /// \brief Get a component given its column and row.
+      /// \param[in] _column Column index, see Column().
+      /// \param[in] _row Row index.
+      /// \return Pointer to the component.
+      public: components::BaseComponent *At(std::size_t _column,
+                  std::size_t _row) const;
+
+      /// \brief Sorted component types.
+      private: std::vector<ComponentTypeId> types;
+
+      /// \brief One column per type in `types`, in the same order. Each
+      /// column has one element per row, except for tag columns, which are
+      /// always empty.
+      private: std::vector<ComponentColumn> columns;
+
+      /// \brief Shared instance of each tag type in `types`, in the same
+      /// order. Null for types which aren't tags.
+      private: std::vector<std::shared_ptr<components::BaseComponent>> tags;
+
+      /// \brief Entity stored in each row.
+      private: std::vector<Entity> entities;
+
+      /// \brief Whether any of `types` is stored in a column, i.e. isn't a
+      /// tag.
+      private: bool hasData{false};
+
+      /// \brief Cached archetype transitions. The key is the component type
+      /// being added (or removed), and the value is the index of the
+      /// resulting archetype.
+      private: std::unordered_map<ComponentTypeId, std::size_t> addEdges;
+
+      /// \brief See addEdges.
+      private: std::unordered_map<ComponentTypeId, std::size_t> removeEdges;
+
+      friend class ArchetypeStorage;
+    };
+
+    /// \class ArchetypeStorage ArchetypeStorage.hh
+    /// \brief Component storage used by the EntityComponentManager. Entities
+    /// are grouped by their component signature into archetypes, so that
+    /// queries such as "which entities have these components" can be
+    /// answered once per archetype instead of once per entity.
+    ///
+    /// Components that are removed from an entity are kept around, detached
+    /// from their archetype, until the entity is removed. This allows a
+    /// later re-addition of the same component type to reuse the value.
+    ///
+    /// Component pointers returned by the storage are only valid until the
+    /// next structural change, i.e. until entities or components are added
+    /// or removed. Entities whose components moved are listed by Relocated.
+    class IGNITION_GAZEBO_VISIBLE ArchetypeStorage
+    {
+      /// \brief Constructor
+      public: ArchetypeStorage();
+
+      /// \brief Remove all entities and components.
+      public: void Reset();
+
+      /// \brief Add an entity without any components.
+      /// \param[in] _entity Entity to add.
+      /// \return False if the entity already existed.
+      public: bool AddEntity(const Entity _entity);
+
+      /// \brief Reserve storage for entities that will be added later.
+      /// \param[in] _count Number of entities expected to be in the storage.
+      public: void Reserve(std::size_t _count);
+
+      /// \brief Remove an entity and destroy all of its components, including
+      /// the removed ones.
+      /// \param[in] _entity Entity to remove.
+      /// \return False if the entity didn't exist.
+      public: bool RemoveEntity(const Entity _entity);
+
+      /// \brief Remove many entities and destroy all of their components.
+      /// Each archetype holding some of the entities is swept once, instead
+      /// of looking up and moving rows one entity at a time.
+      /// \param[in] _entities Entities to remove, without duplicates.
+      /// Entities that don't exist are ignored.
+      /// \return Number of entities removed.
+      public: std::size_t RemoveEntities(const std::vector<Entity> &_entities);
+
+      /// \brief Check whether an entity is in the storage.
+      /// \param[in] _entity Entity to check.
+      /// \return True if the entity exists.
+      public: bool HasEntity(const Entity _entity) const;
+
+      /// \brief Number of entities in the storage.
+      /// \return Entity count.
+      public: std::size_t EntityCount() const;
+
+      /// \brief Add a new component to an entity, moving the entity to the
+      /// archetype that contains the component's type.
+      /// \param[in] _entity Entity which will own the component.
+      /// \param[in] _component Component instance.
+      /// \return Pointer to the stored component, or nullptr if the entity
+      /// doesn't exist, the component is null or the entity already has a
+      /// component of that type (live or removed).
+      public: components::BaseComponent *AddComponent(const Entity _entity,
+                  std::unique_ptr<components::BaseComponent> _component);
+
+      /// \brief Add a tag component to an entity, without creating an
+      /// instance for it. The type must already be known to be a tag, see
+      /// IsTag.
+      /// \param[in] _entity Entity which will own the component.
+      /// \param[in] _typeId Tag type.
+      /// \return Pointer to the shared instance of the tag, or nullptr if
+      /// the type isn't a known tag, the entity doesn't exist or it already
+      /// has the tag (live or removed).
+      public: components::BaseComponent *AddTag(const Entity _entity,
+                  const ComponentTypeId _typeId);
+
+      /// \brief Check whether a component type is stored as a tag. Types
+      /// are known to be tags once a component of that type has been added.
+      /// \param[in] _typeId Component type.
+      /// \return True if the type is a tag.
+      public: bool IsTag(const ComponentTypeId _typeId) const;
+
+      /// \brief Add several new components to an entity. The entity is moved
+      /// once, straight to the archetype that contains all the new types.
+      /// \param[in] _entity Entity which will own the components.
+      /// \param[in] _components Component instances, of distinct types.
+      /// \return False if the entity doesn't exist, a component is null, or
+      /// the entity already has a component of one of the types (live or
+      /// removed). Nothing is added in that case.
+      public: bool AddComponents(const Entity _entity,
+                  std::vector<std::unique_ptr<components::BaseComponent>>
+                  &&_components);
+
+      /// \brief Add a copy of a component to several entities. Entities are
+      /// grouped by archetype, and each group's rows are moved together to
+      /// a destination archetype which is found and grown once.
+      /// \param[in] _entities Entities which will own the copies.
+      /// \param[in] _component Component to copy.
+      /// \return The entities that received a copy, in the order they were
+      /// given. Entities that don't exist, or already have a component of
+      /// that type (live or removed), are skipped.
+      public: std::vector<Entity> AddComponentToEntities(
+                  const std::vector<Entity> &_entities,
+                  const components::BaseComponent &_component);
+
+      /// \brief Remove a component from an entity. The entity is moved to the
+      /// archetype without the component's type, and the instance is kept
+      /// until the entity is removed or the component is restored.
+      /// \param[in] _entity Entity that owns the component.
+      /// \param[in] _typeId Type of the component to remove.
+      /// \return True if the entity had a live component of that type.
+      public: bool RemoveComponent(const Entity _entity,
+                  const ComponentTypeId _typeId);
+
+      /// \brief Check if an entity has a component that has been removed
+      /// through RemoveComponent but not destroyed yet.
+      /// \param[in] _entity Entity to check.
+      /// \param[in] _typeId Component type.
+      /// \return True if the component is currently removed.
+      public: bool HasRemovedComponent(const Entity _entity,
+                  const ComponentTypeId _typeId) const;
+
+      /// \brief Bring back a component previously removed with
+      /// RemoveComponent. The removed value is reused, unless new data is
+      /// given.
+      /// \param[in] _entity Entity that owns the component.
+      /// \param[in] _typeId Component type.
+      /// \param[in] _data If not null, value to copy into the component
+      /// before it's restored. It may point to a component of this storage,
+      /// which restoring may move.
+      /// \return Pointer to the restored component, or nullptr if there was
+      /// no removed component of that type.
+      public: components::BaseComponent *RestoreComponent(
+                  const Entity _entity, const ComponentTypeId _typeId,
+                  const components::BaseComponent *_data = nullptr);
+
+      /// \brief Get a live component of an entity.
+      /// \param[in] _entity Entity.
+      /// \param[in] _typeId Component type.
+      /// \return The component, or nullptr if the entity doesn't have a live
+      /// component of that type.
+      public: components::BaseComponent *Component(const Entity _entity,
+                  const ComponentTypeId _typeId) const;
+
+      /// \brief Get the sorted types of all live components of an entity.
+      /// \param[in] _entity Entity.
+      /// \return Pointer to the component types, or nullptr if the entity
+      /// doesn't exist. The pointer is invalidated by the next structural
+      /// change.
+      public: const std::vector<ComponentTypeId> *ComponentTypes(
+                  const Entity _entity) const;
+
+      /// \brief Check whether an entity has live components of all the given
+      /// types.
+      /// \param[in] _entity Entity to check.
+      /// \param[in] _types Component types.
+      /// \return True if the entity has all of the types.
+      public: bool EntityMatches(const Entity _entity,
+                  const std::set<ComponentTypeId> &_types) const;
+
+      /// \brief Copy all entities and their live components. Each non-empty
+      /// archetype is copied with clones of its components, in row order.
+      /// Removed components aren't copied.
+      /// \return The copied archetypes, which aren't connected to this
+      /// storage.
+      public: std::vector<Archetype> Snapshot() const;
+
+      /// \brief Get all the archetypes. Archetypes are never destroyed
+      /// (except on Reset) but may be empty.
+      /// \return All archetypes.
+      public: const std::vector<Archetype> &Archetypes() const;
+
+      /// \brief Get the entities whose components moved to a different
+      /// address since the last call to ClearRelocated. These are the
+      /// entities that changed archetype, the entities moved into the rows
+      /// they, or removed entities, left, and all the entities of an
+      /// archetype that had to grow. Entities which only have tags aren't
+      /// listed, since tags never move. An entity may be listed more than
+      /// once.
+      /// \return The relocated entities.
+      public: const std::vector<Entity> &Relocated() const;
+
+      /// \brief Forget the entities listed by Relocated.
+      public: void ClearRelocated();
+
+      /// \brief Location of an entity in the storage.
+      private: struct Record
+      {
+        /// \brief Index of the entity's archetype.
+        std::size_t archetype{0};
+
+        /// \brief Row of the entity in the archetype.
+        std::size_t row{0};
+      };
+
+      /// \brief Find the archetype reached by adding or removing a type from
+      /// another archetype, creating it if needed.
+      /// \param[in] _from Index of the source archetype.
+      /// \param[in] _typeId Type being added or removed.
+      /// \param[in] _add True if _typeId is being added, false if removed.
+      /// \return Index of the resulting archetype.
+      private: std::size_t Transition(std::size_t _from,
+                   const ComponentTypeId _typeId, bool _add);
+
+      /// \brief Remember that a component's type is a tag, if it is one.
+      /// \param[in, out] _component Component being added. If it's the
+      /// first instance of a tag type, it's taken as the shared instance.
+      /// \return True if the component's type is a tag.
+      private: bool RegisterTag(
+                   std::unique_ptr<components::BaseComponent> &_component);
+
+      /// \brief Find the archetype with the given types, creating it if
+      /// needed.
+      /// \param[in] _types Sorted and unique component types.
+      /// \return Index of the archetype.
+      private: std::size_t FindOrAddArchetype(
+                   std::vector<ComponentTypeId> _types);
+
+      /// \brief Move an entity's row to another archetype. Columns that only
+      /// exist in the source archetype are moved into _dropped, if given.
+      /// Columns that only exist in the destination archetype are left one
+      /// row short, and the caller must push the new components into them.
+      /// \param[in] _entity Entity being moved.
+      /// \param[in, out] _record The entity's record, which is updated.
+      /// \param[in] _to Index of the destination archetype.
+      /// \param[out] _dropped Receives the component that doesn't exist in
+      /// the destination archetype, if any.
+      /// \return Row of the entity in the destination archetype.
+      private: std::size_t Move(const Entity _entity, Record &_record,
+                   std::size_t _to,
+                   std::unique_ptr<components::BaseComponent> *_dropped);
+
+      /// \brief Move several rows of an archetype to another archetype at
+      /// once, one column at a time. Columns that only exist in the source
+      /// archetype are destroyed, and columns that only exist in the
+      /// destination archetype are left short of the moved rows, which the
+      /// caller must push.
+      /// \param[in] _from Index of the source archetype.
+      /// \param[in] _rows Rows to move, sorted and unique.
+      /// \param[in] _to Index of the destination archetype.
+      private: void MoveRows(std::size_t _from,
+                   const std::vector<std::size_t> &_rows, std::size_t _to);
+
+      /// \brief Remove a row from an archetype by swapping it with the last
+      /// row, and update the record of the entity that was swapped in.
+      /// \param[in] _archetype Archetype index.
+      /// \param[in] _row Row to remove. Its components are destroyed.
+      private: void EraseRow(std::size_t _archetype, std::size_t _row);
+
+      /// \brief Make room for more rows in an archetype's columns, listing
+      /// its entities as relocated if the columns had to move.
+      /// \param[in] _archetype Archetype index.
+      /// \param[in] _rows Number of rows to make room for.
+      private: void GrowColumns(std::size_t _archetype,
+                   std::size_t _rows = 1);
+
+      /// \brief All archetypes. The first one has no component types.
+      private: std::vector<Archetype> archetypes;
+
+      /// \brief Index of archetypes by their sorted component types.
+      private: std::map<std::vector<ComponentTypeId>, std::size_t>
+               archetypeIndex;
+
+      /// \brief Location of each entity.
+      private: EntityIndex<Record> records;
+
+      /// \brief Components that have been removed from an entity but not
+      /// destroyed yet. Removed tags are kept as null pointers.
+      private: std::unordered_map<Entity, std::unordered_map<ComponentTypeId,
+               std::unique_ptr<components::BaseComponent>>> removed;
+
+      /// \brief Shared instance of each tag type, see Archetype::tags.
+      private: std::unordered_map<ComponentTypeId,
+               std::shared_ptr<components::BaseComponent>> tags;
+
+      /// \brief Types known to hold data, so that the tag registry isn't
+      /// looked up for each component added.
+      private: std::unordered_set<ComponentTypeId> dataTypes;
+
+      /// \brief See Relocated.
+      private: std::vector<Entity> relocated;
+    };
+    }
+  }
+}
+#endif
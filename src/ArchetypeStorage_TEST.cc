@@ -0,0 +1,541 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "ignition/gazebo/components/Factory.hh"
+#include "ArchetypeStorage.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+using IntComponent = components::Component<int, class IntComponentTag>;
+IGN_GAZEBO_REGISTER_COMPONENT("ign_gazebo_components.IntComponent",
+    IntComponent)
+
+using DoubleComponent = components::Component<double,
+    class DoubleComponentTag>;
+IGN_GAZEBO_REGISTER_COMPONENT("ign_gazebo_components.DoubleComponent",
+    DoubleComponent)
+
+using TagComponent = components::Component<components::NoData,
+    class TagComponentTag>;
+IGN_GAZEBO_REGISTER_COMPONENT("ign_gazebo_components.TagComponent",
+    TagComponent)
+
+//////////////////////////////////////////////////
+TEST(ArchetypeStorage, Entities)
+{
+  ArchetypeStorage storage;
+  EXPECT_EQ(0u, storage.EntityCount());
+  ASSERT_EQ(1u, storage.Archetypes().size());
+  EXPECT_TRUE(storage.Archetypes()[0].Types().empty());
+
+  EXPECT_TRUE(storage.AddEntity(1));
+  EXPECT_TRUE(storage.AddEntity(2));
+  EXPECT_FALSE(storage.AddEntity(1));
+  EXPECT_EQ(2u, storage.EntityCount());
+  EXPECT_TRUE(storage.HasEntity(1));
+  EXPECT_FALSE(storage.HasEntity(3));
+  EXPECT_EQ(2u, storage.Archetypes()[0].Entities().size());
+
+  EXPECT_TRUE(storage.RemoveEntity(1));
+  EXPECT_FALSE(storage.RemoveEntity(1));
+  EXPECT_FALSE(storage.HasEntity(1));
+  EXPECT_EQ(1u, storage.EntityCount());
+
+  storage.Reset();
+  EXPECT_EQ(0u, storage.EntityCount());
+  EXPECT_EQ(1u, storage.Archetypes().size());
+}
+
+//////////////////////////////////////////////////
+TEST(ArchetypeStorage, RemoveEntities)
+{
+  ArchetypeStorage storage;
+  for (Entity entity = 1; entity <= 10; ++entity)
+  {
+    storage.AddEntity(entity);
+    storage.AddComponent(entity,
+        std::make_unique<IntComponent>(static_cast<int>(entity)));
+    if (entity % 2 == 0)
+    {
+      storage.AddComponent(entity,
+          std::make_unique<DoubleComponent>(entity * 0.5));
+    }
+  }
+  storage.RemoveComponent(3, IntComponent::typeId);
+
+  // Nonexistent entities are ignored
+  EXPECT_EQ(4u, storage.RemoveEntities({1, 2, 3, 8, 42}));
+  EXPECT_EQ(6u, storage.EntityCount());
+  for (const Entity entity : {1, 2, 3, 8})
+    EXPECT_FALSE(storage.HasEntity(entity));
+  EXPECT_FALSE(storage.HasRemovedComponent(3, IntComponent::typeId));
+
+  // The remaining entities keep their components
+  for (const Entity entity : {4, 5, 6, 7, 9, 10})
+  {
+    ASSERT_TRUE(storage.HasEntity(entity));
+    auto comp = static_cast<IntComponent *>(
+        storage.Component(entity, IntComponent::typeId));
+    ASSERT_NE(nullptr, comp);
+    EXPECT_EQ(static_cast<int>(entity), comp->Data());
+    EXPECT_EQ(entity % 2 == 0,
+        nullptr != storage.Component(entity, DoubleComponent::typeId));
+  }
+
+  std::size_t rows{0};
+  for (const auto &archetype : storage.Archetypes())
+    rows += archetype.Entities().size();
+  EXPECT_EQ(6u, rows);
+
+  EXPECT_EQ(0u, storage.RemoveEntities({1, 2}));
+}
+
+//////////////////////////////////////////////////
+TEST(ArchetypeStorage, AddRemoveComponents)
+{
+  ArchetypeStorage storage;
+  EXPECT_EQ(nullptr, storage.AddComponent(1,
+      std::make_unique<IntComponent>(1)));
+
+  storage.AddEntity(1);
+  storage.AddEntity(2);
+
+  auto intComp = storage.AddComponent(1, std::make_unique<IntComponent>(10));
+  ASSERT_NE(nullptr, intComp);
+  EXPECT_NE(nullptr, storage.AddComponent(1,
+      std::make_unique<DoubleComponent>(0.5)));
+  EXPECT_NE(nullptr, storage.AddComponent(2,
+      std::make_unique<IntComponent>(20)));
+
+  // Can't add the same type twice
+  EXPECT_EQ(nullptr, storage.AddComponent(1,
+      std::make_unique<IntComponent>(11)));
+
+  // Component values are kept as entities move between archetypes
+  EXPECT_EQ(10,
+      static_cast<IntComponent *>(storage.Component(1, IntComponent::typeId))
+      ->Data());
+  EXPECT_EQ(20,
+      static_cast<IntComponent *>(storage.Component(2, IntComponent::typeId))
+      ->Data());
+  EXPECT_EQ(nullptr, storage.Component(2, DoubleComponent::typeId));
+
+  ASSERT_NE(nullptr, storage.ComponentTypes(1));
+  EXPECT_EQ(2u, storage.ComponentTypes(1)->size());
+  EXPECT_EQ(nullptr, storage.ComponentTypes(3));
+
+  EXPECT_TRUE(storage.EntityMatches(1,
+      {IntComponent::typeId, DoubleComponent::typeId}));
+  EXPECT_TRUE(storage.EntityMatches(2, {IntComponent::typeId}));
+  EXPECT_FALSE(storage.EntityMatches(2, {DoubleComponent::typeId}));
+
+  // Removed components are kept and can be restored
+  EXPECT_TRUE(storage.RemoveComponent(1, IntComponent::typeId));
+  EXPECT_FALSE(storage.RemoveComponent(1, IntComponent::typeId));
+  EXPECT_EQ(nullptr, storage.Component(1, IntComponent::typeId));
+  EXPECT_TRUE(storage.HasRemovedComponent(1, IntComponent::typeId));
+  EXPECT_FALSE(storage.EntityMatches(1, {IntComponent::typeId}));
+  EXPECT_DOUBLE_EQ(0.5, static_cast<DoubleComponent *>(
+      storage.Component(1, DoubleComponent::typeId))->Data());
+  EXPECT_EQ(nullptr, storage.AddComponent(1,
+      std::make_unique<IntComponent>(12)));
+
+  intComp = storage.RestoreComponent(1, IntComponent::typeId);
+  ASSERT_NE(nullptr, intComp);
+  EXPECT_EQ(10, static_cast<IntComponent *>(intComp)->Data());
+  EXPECT_FALSE(storage.HasRemovedComponent(1, IntComponent::typeId));
+  EXPECT_EQ(intComp, storage.Component(1, IntComponent::typeId));
+  EXPECT_EQ(nullptr, storage.RestoreComponent(1, IntComponent::typeId));
+
+  // Restoring with data, which may live in the storage itself
+  EXPECT_TRUE(storage.RemoveComponent(1, IntComponent::typeId));
+  intComp = storage.RestoreComponent(1, IntComponent::typeId,
+      storage.Component(2, IntComponent::typeId));
+  ASSERT_NE(nullptr, intComp);
+  EXPECT_EQ(20, static_cast<IntComponent *>(intComp)->Data());
+
+  // Entity 2 is still fine after entity 1 moved around
+  EXPECT_EQ(20,
+      static_cast<IntComponent *>(storage.Component(2, IntComponent::typeId))
+      ->Data());
+}
+
+//////////////////////////////////////////////////
+TEST(ArchetypeStorage, AddComponents)
+{
+  ArchetypeStorage storage;
+  storage.Reserve(2);
+  storage.AddEntity(1);
+  storage.AddEntity(2);
+
+  std::vector<std::unique_ptr<components::BaseComponent>> comps;
+  comps.push_back(std::make_unique<IntComponent>(10));
+  comps.push_back(std::make_unique<DoubleComponent>(0.5));
+  EXPECT_TRUE(storage.AddComponents(1, std::move(comps)));
+
+  // Straight to {int, double}, without going through {int}
+  EXPECT_EQ(2u, storage.Archetypes().size());
+  EXPECT_TRUE(storage.EntityMatches(1,
+      {IntComponent::typeId, DoubleComponent::typeId}));
+  EXPECT_EQ(10,
+      static_cast<IntComponent *>(storage.Component(1, IntComponent::typeId))
+      ->Data());
+  EXPECT_DOUBLE_EQ(0.5, static_cast<DoubleComponent *>(
+      storage.Component(1, DoubleComponent::typeId))->Data());
+
+  // Nothing is added if one of the types already exists
+  EXPECT_NE(nullptr, storage.AddComponent(2,
+      std::make_unique<IntComponent>(20)));
+  comps.clear();
+  comps.push_back(std::make_unique<DoubleComponent>(1.5));
+  comps.push_back(std::make_unique<IntComponent>(21));
+  EXPECT_FALSE(storage.AddComponents(2, std::move(comps)));
+  EXPECT_EQ(nullptr, storage.Component(2, DoubleComponent::typeId));
+
+  comps.clear();
+  comps.push_back(std::make_unique<IntComponent>(30));
+  EXPECT_FALSE(storage.AddComponents(3, std::move(comps)));
+}
+
+//////////////////////////////////////////////////
+TEST(ArchetypeStorage, AddComponentToEntities)
+{
+  ArchetypeStorage storage;
+  for (Entity e = 1; e <= 7; ++e)
+    storage.AddEntity(e);
+  storage.AddComponent(2, std::make_unique<IntComponent>(2));
+  storage.AddComponent(7, std::make_unique<IntComponent>(7));
+  storage.AddComponent(4, std::make_unique<IntComponent>(4));
+  storage.AddComponent(5, std::make_unique<DoubleComponent>(5.0));
+  storage.AddComponent(6, std::make_unique<DoubleComponent>(6.0));
+  storage.RemoveComponent(6, DoubleComponent::typeId);
+
+  // Entities from three archetypes, one listed twice, one missing, one which
+  // already has the type and one which had it
+  storage.ClearRelocated();
+  const DoubleComponent value(1.5);
+  EXPECT_EQ(std::vector<Entity>({4, 1, 2, 3}),
+      storage.AddComponentToEntities({4, 1, 5, 2, 9, 3, 6, 1}, value));
+
+  for (Entity e = 1; e <= 4; ++e)
+  {
+    auto comp = static_cast<DoubleComponent *>(
+        storage.Component(e, DoubleComponent::typeId));
+    ASSERT_NE(nullptr, comp);
+    EXPECT_DOUBLE_EQ(1.5, comp->Data());
+  }
+  EXPECT_DOUBLE_EQ(5.0, static_cast<DoubleComponent *>(
+      storage.Component(5, DoubleComponent::typeId))->Data());
+  EXPECT_EQ(nullptr, storage.Component(6, DoubleComponent::typeId));
+  EXPECT_EQ(2, static_cast<IntComponent *>(
+      storage.Component(2, IntComponent::typeId))->Data());
+  EXPECT_EQ(4, static_cast<IntComponent *>(
+      storage.Component(4, IntComponent::typeId))->Data());
+
+  // Entities left behind keep their data
+  EXPECT_EQ(nullptr, storage.Component(7, DoubleComponent::typeId));
+  EXPECT_EQ(7, static_cast<IntComponent *>(
+      storage.Component(7, IntComponent::typeId))->Data());
+  EXPECT_TRUE(storage.HasEntity(6));
+  EXPECT_EQ(7u, storage.EntityCount());
+  EXPECT_TRUE(storage.EntityMatches(1, {DoubleComponent::typeId}));
+  EXPECT_TRUE(storage.EntityMatches(2,
+      {IntComponent::typeId, DoubleComponent::typeId}));
+
+  // Entities which had data moved
+  const auto &relocated = storage.Relocated();
+  EXPECT_NE(relocated.end(), std::find(relocated.begin(), relocated.end(),
+      Entity{2}));
+  EXPECT_NE(relocated.end(), std::find(relocated.begin(), relocated.end(),
+      Entity{4}));
+  EXPECT_NE(relocated.end(), std::find(relocated.begin(), relocated.end(),
+      Entity{7}));
+
+  // Tags are shared
+  EXPECT_EQ(std::vector<Entity>({1, 2}),
+      storage.AddComponentToEntities({1, 2}, TagComponent()));
+  EXPECT_TRUE(storage.IsTag(TagComponent::typeId));
+  EXPECT_EQ(storage.Component(1, TagComponent::typeId),
+      storage.Component(2, TagComponent::typeId));
+
+  EXPECT_TRUE(storage.AddComponentToEntities({}, value).empty());
+}
+
+//////////////////////////////////////////////////
+TEST(ArchetypeStorage, Archetypes)
+{
+  ArchetypeStorage storage;
+  for (Entity e = 1; e <= 10; ++e)
+  {
+    storage.AddEntity(e);
+    storage.AddComponent(e, std::make_unique<IntComponent>(e));
+    if (e % 2 == 0)
+      storage.AddComponent(e, std::make_unique<DoubleComponent>(e));
+  }
+
+  // Empty, {int} and {int, double}
+  ASSERT_EQ(3u, storage.Archetypes().size());
+
+  std::size_t withDouble{0};
+  for (const auto &archetype : storage.Archetypes())
+  {
+    if (archetype.Includes({IntComponent::typeId, DoubleComponent::typeId}))
+    {
+      withDouble += archetype.Entities().size();
+      EXPECT_GE(archetype.Column(DoubleComponent::typeId), 0);
+    }
+    else
+    {
+      EXPECT_EQ(-1, archetype.Column(DoubleComponent::typeId));
+    }
+  }
+  EXPECT_EQ(5u, withDouble);
+
+  // Swap-removing rows keeps the other entities' components in place
+  storage.RemoveEntity(2);
+  storage.RemoveComponent(4, DoubleComponent::typeId);
+  for (Entity e = 1; e <= 10; ++e)
+  {
+    if (e == 2)
+    {
+      EXPECT_FALSE(storage.HasEntity(e));
+      continue;
+    }
+    auto comp = storage.Component(e, IntComponent::typeId);
+    ASSERT_NE(nullptr, comp);
+    EXPECT_EQ(static_cast<int>(e),
+        static_cast<IntComponent *>(comp)->Data());
+    EXPECT_EQ(e % 2 == 0 && e != 4,
+        nullptr != storage.Component(e, DoubleComponent::typeId));
+  }
+
+  // No new archetypes for known transitions
+  EXPECT_EQ(3u, storage.Archetypes().size());
+}
+
+//////////////////////////////////////////////////
+TEST(ArchetypeStorage, Columns)
+{
+  ArchetypeStorage storage;
+  for (Entity e = 1; e <= 100; ++e)
+  {
+    storage.AddEntity(e);
+    storage.AddComponent(e, std::make_unique<IntComponent>(e));
+  }
+
+  // The components of an archetype are stored next to each other
+  const Archetype *ints{nullptr};
+  for (const auto &archetype : storage.Archetypes())
+  {
+    if (archetype.Types().size() == 1)
+      ints = &archetype;
+  }
+  ASSERT_NE(nullptr, ints);
+  ASSERT_EQ(100u, ints->Entities().size());
+  const auto column = ints->Column(IntComponent::typeId);
+  for (std::size_t row = 1; row < ints->Entities().size(); ++row)
+  {
+    EXPECT_EQ(reinterpret_cast<char *>(ints->At(column, 0)) +
+        row * sizeof(IntComponent),
+        reinterpret_cast<char *>(ints->At(column, row)));
+    EXPECT_EQ(static_cast<int>(ints->Entities()[row]),
+        static_cast<IntComponent *>(ints->At(column, row))->Data());
+  }
+
+  // Snapshots copy the values into their own columns
+  auto snapshot = storage.Snapshot();
+  storage.Reset();
+  ASSERT_EQ(1u, snapshot.size());
+  for (std::size_t row = 0; row < snapshot[0].Entities().size(); ++row)
+  {
+    EXPECT_EQ(static_cast<int>(snapshot[0].Entities()[row]),
+        static_cast<IntComponent *>(snapshot[0].At(column, row))->Data());
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(ArchetypeStorage, Relocated)
+{
+  ArchetypeStorage storage;
+  for (Entity e = 1; e <= 3; ++e)
+  {
+    storage.AddEntity(e);
+    storage.AddComponent(e, std::make_unique<IntComponent>(e));
+  }
+
+  // Entities without data don't move
+  storage.AddEntity(4);
+  storage.AddComponent(4, std::make_unique<TagComponent>());
+  storage.ClearRelocated();
+  storage.RemoveEntity(4);
+  EXPECT_TRUE(storage.Relocated().empty());
+
+  // Moving 1 out of {int} swaps 3 into its row. The new archetype's columns
+  // are allocated, which doesn't move anything else.
+  storage.AddComponent(1, std::make_unique<DoubleComponent>(1.0));
+  EXPECT_EQ(std::vector<Entity>({1, 3}), storage.Relocated());
+  storage.ClearRelocated();
+  EXPECT_TRUE(storage.Relocated().empty());
+
+  // Removing the last row doesn't move anything
+  storage.RemoveEntity(2);
+  EXPECT_TRUE(storage.Relocated().empty());
+
+  // Growing {int, double} past its capacity moves its entities
+  for (Entity e = 10; e < 30; ++e)
+  {
+    storage.AddEntity(e);
+    std::vector<std::unique_ptr<components::BaseComponent>> comps;
+    comps.push_back(std::make_unique<IntComponent>(e));
+    comps.push_back(std::make_unique<DoubleComponent>(e));
+    storage.AddComponents(e, std::move(comps));
+  }
+  const auto &relocated = storage.Relocated();
+  EXPECT_NE(relocated.end(), std::find(relocated.begin(), relocated.end(),
+      Entity{1}));
+  EXPECT_NE(relocated.end(), std::find(relocated.begin(), relocated.end(),
+      Entity{10}));
+
+  // Removing many entities lists those moved into the removed rows, but not
+  // the removed ones
+  storage.ClearRelocated();
+  EXPECT_EQ(2u, storage.RemoveEntities({1, 10}));
+  EXPECT_FALSE(storage.Relocated().empty());
+  for (const Entity entity : storage.Relocated())
+  {
+    EXPECT_TRUE(storage.HasEntity(entity));
+    EXPECT_EQ(static_cast<int>(entity), static_cast<IntComponent *>(
+        storage.Component(entity, IntComponent::typeId))->Data());
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(ArchetypeStorage, ColumnWithoutLayout)
+{
+  // Types without a layout are stored as individual instances
+  ComponentColumn boxed;
+  ComponentColumn inPlace(components::ComponentLayoutOf(IntComponent::typeId));
+  ASSERT_NE(nullptr, inPlace.Layout());
+  EXPECT_EQ(nullptr, boxed.Layout());
+
+  for (int i = 0; i < 20; ++i)
+    boxed.Push(std::make_unique<IntComponent>(i));
+  auto first = boxed.At(0);
+  EXPECT_FALSE(boxed.EnsureCapacity(100));
+  EXPECT_EQ(first, boxed.At(0));
+
+  // Values move between both kinds of columns
+  inPlace.PushFrom(boxed, 5);
+  boxed.SwapRemove(5);
+  boxed.PushFrom(inPlace, 0);
+  inPlace.SwapRemove(0);
+  inPlace.PushCopy(*boxed.At(0));
+  auto taken = boxed.Take(1);
+  boxed.SwapRemove(1);
+
+  EXPECT_EQ(19u, boxed.Size());
+  EXPECT_EQ(5, static_cast<IntComponent *>(boxed.At(1))->Data());
+  EXPECT_EQ(19, static_cast<IntComponent *>(boxed.At(5))->Data());
+  EXPECT_EQ(1, static_cast<IntComponent *>(taken.get())->Data());
+  ASSERT_EQ(1u, inPlace.Size());
+  EXPECT_EQ(0, static_cast<IntComponent *>(inPlace.At(0))->Data());
+
+  ComponentColumn moved(std::move(boxed));
+  EXPECT_EQ(0u, boxed.Size());
+  EXPECT_EQ(19u, moved.Size());
+}
+
+//////////////////////////////////////////////////
+TEST(ArchetypeStorage, Tags)
+{
+  ArchetypeStorage storage;
+  storage.AddEntity(1);
+  storage.AddEntity(2);
+  storage.AddEntity(3);
+
+  // Tags are only known once one has been added
+  EXPECT_FALSE(storage.IsTag(TagComponent::typeId));
+  EXPECT_EQ(nullptr, storage.AddTag(1, TagComponent::typeId));
+
+  auto tag = storage.AddComponent(1, std::make_unique<TagComponent>());
+  ASSERT_NE(nullptr, tag);
+  EXPECT_TRUE(storage.IsTag(TagComponent::typeId));
+  EXPECT_FALSE(storage.IsTag(IntComponent::typeId));
+
+  // All entities share the same instance
+  EXPECT_EQ(tag, storage.AddComponent(2, std::make_unique<TagComponent>()));
+  EXPECT_EQ(tag, storage.AddTag(3, TagComponent::typeId));
+  EXPECT_EQ(nullptr, storage.AddTag(3, TagComponent::typeId));
+  EXPECT_EQ(nullptr, storage.AddTag(3, IntComponent::typeId));
+
+  std::vector<std::unique_ptr<components::BaseComponent>> comps;
+  storage.AddEntity(4);
+  comps.push_back(std::make_unique<IntComponent>(40));
+  comps.push_back(std::make_unique<TagComponent>());
+  EXPECT_TRUE(storage.AddComponents(4, std::move(comps)));
+  EXPECT_EQ(tag, storage.Component(4, TagComponent::typeId));
+  EXPECT_EQ(40,
+      static_cast<IntComponent *>(storage.Component(4, IntComponent::typeId))
+      ->Data());
+
+  // Tags are kept as entities move between archetypes
+  storage.AddComponent(1, std::make_unique<IntComponent>(10));
+  storage.AddComponent(2, std::make_unique<DoubleComponent>(2.0));
+  for (const Entity entity : {1, 2, 3, 4})
+  {
+    EXPECT_EQ(tag, storage.Component(entity, TagComponent::typeId));
+    EXPECT_TRUE(storage.EntityMatches(entity, {TagComponent::typeId}));
+  }
+  EXPECT_EQ(10,
+      static_cast<IntComponent *>(storage.Component(1, IntComponent::typeId))
+      ->Data());
+
+  // Removed tags can be restored
+  EXPECT_TRUE(storage.RemoveComponent(1, TagComponent::typeId));
+  EXPECT_EQ(nullptr, storage.Component(1, TagComponent::typeId));
+  EXPECT_TRUE(storage.HasRemovedComponent(1, TagComponent::typeId));
+  EXPECT_EQ(nullptr, storage.AddTag(1, TagComponent::typeId));
+  EXPECT_EQ(tag, storage.RestoreComponent(1, TagComponent::typeId));
+  EXPECT_EQ(tag, storage.Component(1, TagComponent::typeId));
+
+  // Removing rows doesn't disturb the other entities
+  storage.RemoveEntity(2);
+  EXPECT_EQ(1u, storage.RemoveEntities({3}));
+  EXPECT_EQ(tag, storage.Component(1, TagComponent::typeId));
+  EXPECT_EQ(tag, storage.Component(4, TagComponent::typeId));
+
+  // Snapshots share the tag
+  for (const auto &archetype : storage.Snapshot())
+  {
+    const auto column = archetype.Column(TagComponent::typeId);
+    if (column < 0)
+      continue;
+    for (std::size_t row = 0; row < archetype.Entities().size(); ++row)
+      EXPECT_EQ(tag, archetype.At(column, row));
+  }
+
+  storage.Reset();
+  EXPECT_FALSE(storage.IsTag(TagComponent::typeId));
+}
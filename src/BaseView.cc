@@ -16,6 +16,8 @@
 */
 #include "ignition/gazebo/detail/BaseView.hh"
 
+#include <algorithm>
+
 #include "ignition/gazebo/Entity.hh"
 #include "ignition/gazebo/Types.hh"
 
@@ -23,10 +25,17 @@ using namespace ignition;
 using namespace gazebo;
 using namespace detail;
 
+namespace
+{
+  /// \brief Innermost iteration over a view on this thread, see
+  /// ViewIteration.
+  thread_local ViewIteration *innermostIteration{nullptr};
+}
+
 //////////////////////////////////////////////////
 bool BaseView::HasEntity(const Entity _entity) const
 {
-  return this->entities.find(_entity) != this->entities.end();
+  return this->entityIndex.find(_entity) != this->entityIndex.end();
 }
 
 //////////////////////////////////////////////////
@@ -51,13 +60,35 @@ bool BaseView::RequiresComponent(const ComponentTypeId _typeId) const
   return this->componentTypes.find(_typeId) != this->componentTypes.end();
 }
 
+//////////////////////////////////////////////////
+bool BaseView::ExcludesComponent(const ComponentTypeId _typeId) const
+{
+  return this->excludedTypes.find(_typeId) != this->excludedTypes.end();
+}
+
+//////////////////////////////////////////////////
+bool BaseView::HasOptionalComponent(const ComponentTypeId _typeId) const
+{
+  return this->optionalTypes.find(_typeId) != this->optionalTypes.end();
+}
+
+//////////////////////////////////////////////////
+bool BaseView::MarkEntityToUpdate(const Entity _entity, bool _new)
+{
+  if (!this->HasEntity(_entity))
+    return false;
+
+  this->toAddEntities[_entity] = _new;
+  return true;
+}
+
 //////////////////////////////////////////////////
 bool BaseView::MarkEntityToRemove(const Entity _entity)
 {
   if (this->HasCachedComponentData(_entity) ||
       this->IsEntityMarkedForAddition(_entity))
   {
-    this->toRemoveEntities.insert(_entity);
+    InsertSorted(this->toRemoveEntities, _entity);
     return true;
   }
   return false;
@@ -79,19 +110,26 @@ const std::set<ComponentTypeId> &BaseView::ComponentTypes() const
   return this->componentTypes;
 }
 
-const std::set<Entity> &BaseView::Entities() const
+//////////////////////////////////////////////////
+const std::set<ComponentTypeId> &BaseView::ExcludedComponentTypes() const
+{
+  return this->excludedTypes;
+}
+
+//////////////////////////////////////////////////
+const std::vector<Entity> &BaseView::Entities() const
 {
   return this->entities;
 }
 
 //////////////////////////////////////////////////
-const std::set<Entity> &BaseView::NewEntities() const
+const std::vector<Entity> &BaseView::NewEntities() const
 {
   return this->newEntities;
 }
 
 //////////////////////////////////////////////////
-const std::set<Entity> &BaseView::ToRemoveEntities() const
+const std::vector<Entity> &BaseView::ToRemoveEntities() const
 {
   return this->toRemoveEntities;
 }
@@ -107,3 +145,120 @@ void BaseView::ClearToAddEntities()
 {
   this->toAddEntities.clear();
 }
+
+//////////////////////////////////////////////////
+std::size_t BaseView::AddPackedEntity(const Entity _entity)
+{
+  this->WillChangePacked();
+  const auto index = this->entities.size();
+  this->entities.push_back(_entity);
+  this->entityIndex[_entity] = index;
+  return index;
+}
+
+//////////////////////////////////////////////////
+bool BaseView::RemovePackedEntity(const Entity _entity, std::size_t &_index)
+{
+  auto it = this->entityIndex.find(_entity);
+  if (it == this->entityIndex.end())
+    return false;
+
+  this->WillChangePacked();
+  _index = it->second;
+  this->entityIndex.erase(it);
+
+  const auto last = this->entities.size() - 1;
+  if (_index != last)
+  {
+    const auto moved = this->entities[last];
+    this->entities[_index] = moved;
+    this->entityIndex[moved] = _index;
+  }
+  this->entities.pop_back();
+  return true;
+}
+
+//////////////////////////////////////////////////
+void BaseView::WillChangePacked()
+{
+  for (ViewIteration *iteration = innermostIteration; nullptr != iteration;
+       iteration = iteration->enclosing)
+  {
+    if (iteration->view == this && !iteration->changed)
+    {
+      iteration->entities = this->entities;
+      iteration->changed = true;
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void BaseView::RemoveFromLists(const EntityBitmap &_entities)
+{
+  auto contains = [&_entities](const Entity _entity)
+  {
+    return _entities.Contains(_entity);
+  };
+
+  this->newEntities.erase(std::remove_if(this->newEntities.begin(),
+      this->newEntities.end(), contains), this->newEntities.end());
+  this->toRemoveEntities.erase(std::remove_if(this->toRemoveEntities.begin(),
+      this->toRemoveEntities.end(), contains), this->toRemoveEntities.end());
+
+  for (auto it = this->toAddEntities.begin();
+       it != this->toAddEntities.end();)
+  {
+    if (_entities.Contains(it->first))
+      it = this->toAddEntities.erase(it);
+    else
+      ++it;
+  }
+}
+
+//////////////////////////////////////////////////
+void BaseView::InsertSorted(std::vector<Entity> &_vec, const Entity _entity)
+{
+  // Entities are usually added in increasing order, so check the back first
+  if (_vec.empty() || _vec.back() < _entity)
+  {
+    _vec.push_back(_entity);
+    return;
+  }
+
+  auto it = std::lower_bound(_vec.begin(), _vec.end(), _entity);
+  if (it == _vec.end() || *it != _entity)
+    _vec.insert(it, _entity);
+}
+
+//////////////////////////////////////////////////
+void BaseView::EraseSorted(std::vector<Entity> &_vec, const Entity _entity)
+{
+  auto it = std::lower_bound(_vec.begin(), _vec.end(), _entity);
+  if (it != _vec.end() && *it == _entity)
+    _vec.erase(it);
+}
+
+//////////////////////////////////////////////////
+ViewIteration::ViewIteration(const BaseView *_view)
+  : view(_view), enclosing(innermostIteration)
+{
+  innermostIteration = this;
+}
+
+//////////////////////////////////////////////////
+ViewIteration::~ViewIteration()
+{
+  innermostIteration = this->enclosing;
+}
+
+//////////////////////////////////////////////////
+bool ViewIteration::Changed() const
+{
+  return this->changed;
+}
+
+//////////////////////////////////////////////////
+const std::vector<Entity> &ViewIteration::OriginalEntities() const
+{
+  return this->entities;
+}
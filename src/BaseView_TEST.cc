@@ -17,6 +17,9 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <ignition/common/Console.hh>
 
 #include "ignition/gazebo/Entity.hh"
@@ -36,6 +39,14 @@ class BaseViewTest : public InternalFixture<::testing::Test>
 {
 };
 
+/////////////////////////////////////////////////
+/// \brief Check whether a view's entity list has an entity
+bool contains(const std::vector<Entity> &_entities, const Entity _entity)
+{
+  return std::find(_entities.begin(), _entities.end(), _entity) !=
+      _entities.end();
+}
+
 /////////////////////////////////////////////////
 TEST_F(BaseViewTest, ComponentTypes)
 {
@@ -145,11 +156,10 @@ TEST_F(BaseViewTest, AddEntities)
   EXPECT_TRUE(modelNameView.HasCachedComponentData(e1));
   EXPECT_TRUE(modelNameView.HasCachedComponentData(e2));
   EXPECT_EQ(2u, modelNameView.Entities().size());
-  EXPECT_NE(modelNameView.Entities().find(e1), modelNameView.Entities().end());
-  EXPECT_NE(modelNameView.Entities().find(e2), modelNameView.Entities().end());
+  EXPECT_EQ(e1, modelNameView.Entities()[0]);
+  EXPECT_EQ(e2, modelNameView.Entities()[1]);
   EXPECT_EQ(1u, modelNameView.NewEntities().size());
-  EXPECT_NE(modelNameView.NewEntities().find(e2),
-      modelNameView.NewEntities().end());
+  EXPECT_EQ(e2, modelNameView.NewEntities()[0]);
 
   auto e1ConstData = modelNameView.EntityComponentConstData(e1);
   EXPECT_EQ(e1, std::get<Entity>(e1ConstData));
@@ -213,7 +223,7 @@ TEST_F(BaseViewTest, RemoveEntities)
   EXPECT_EQ(1u, view.ToAddEntities().size());
   EXPECT_NE(view.ToAddEntities().end(), view.ToAddEntities().find(e1));
   EXPECT_EQ(1u, view.ToRemoveEntities().size());
-  EXPECT_NE(view.ToRemoveEntities().end(), view.ToRemoveEntities().find(e1));
+  EXPECT_EQ(e1, view.ToRemoveEntities()[0]);
 
   // remove entities e1 and e2 from the view and make sure that the toAdd and
   // toRemove queues are updated to no longer have the removed entities
@@ -317,17 +327,18 @@ TEST_F(BaseViewTest, CachedComponentData)
   view.AddEntityWithConstComps(e1, e1IsNew, &e1ModelComp);
   EXPECT_TRUE(view.HasCachedComponentData(e1));
 
-  // reset the view and add only const component data this time
+  // reset the view and add only const component data this time. Const and
+  // non-const access share the same cached data, so this is enough
   view.Reset();
   EXPECT_FALSE(view.HasCachedComponentData(e1));
   view.AddEntityWithConstComps(e1, e1IsNew, &e1ModelComp);
-  EXPECT_FALSE(view.HasCachedComponentData(e1));
+  EXPECT_TRUE(view.HasCachedComponentData(e1));
 
   // reset the view and add only non-const component data this time
   view.Reset();
   EXPECT_FALSE(view.HasCachedComponentData(e1));
   view.AddEntityWithComps(e1, e1IsNew, &e1ModelComp);
-  EXPECT_FALSE(view.HasCachedComponentData(e1));
+  EXPECT_TRUE(view.HasCachedComponentData(e1));
 }
 
 /////////////////////////////////////////////////
@@ -346,9 +357,9 @@ TEST_F(BaseViewTest, ComponentChangeNotification)
   EXPECT_TRUE(view.HasCachedComponentData(e1));
   EXPECT_TRUE(view.HasEntity(e1));
   EXPECT_EQ(1u, view.Entities().size());
-  EXPECT_NE(view.Entities().end(), view.Entities().find(e1));
+  EXPECT_TRUE(contains(view.Entities(), e1));
   EXPECT_EQ(1u, view.NewEntities().size());
-  EXPECT_NE(view.NewEntities().end(), view.NewEntities().find(e1));
+  EXPECT_TRUE(contains(view.NewEntities(), e1));
 
   // mimic a removal of e1's model component by notifying the view that this
   // component was removed
@@ -384,9 +395,14 @@ TEST_F(BaseViewTest, ComponentChangeNotification)
   EXPECT_TRUE(view.HasCachedComponentData(e1));
   EXPECT_TRUE(view.HasEntity(e1));
   EXPECT_EQ(1u, view.Entities().size());
-  EXPECT_NE(view.Entities().end(), view.Entities().find(e1));
+  EXPECT_TRUE(contains(view.Entities(), e1));
   EXPECT_EQ(1u, view.NewEntities().size());
-  EXPECT_NE(view.NewEntities().end(), view.NewEntities().find(e1));
+  EXPECT_TRUE(contains(view.NewEntities(), e1));
+
+  // e1's component data is fetched again the next time the view is used,
+  // since its components may have moved while it wasn't in the view
+  EXPECT_NE(view.ToAddEntities().end(), view.ToAddEntities().find(e1));
+  view.ClearToAddEntities();
 
   // try to call NotifyComponent* methods with component types that don't
   // belong to the view
@@ -422,16 +438,16 @@ TEST_F(BaseViewTest, ComponentChangeNotification)
   EXPECT_TRUE(view.HasCachedComponentData(e2));
   EXPECT_TRUE(view.HasEntity(e2));
   EXPECT_EQ(2u, view.Entities().size());
-  EXPECT_NE(view.Entities().end(), view.Entities().find(e1));
-  EXPECT_NE(view.Entities().end(), view.Entities().find(e2));
+  EXPECT_TRUE(contains(view.Entities(), e1));
+  EXPECT_TRUE(contains(view.Entities(), e2));
   EXPECT_EQ(1u, view.NewEntities().size());
-  EXPECT_EQ(view.NewEntities().end(), view.NewEntities().find(e2));
+  EXPECT_FALSE(contains(view.NewEntities(), e2));
 
   // call NotifyComponentRemoval on the entity that was just added to the view
   EXPECT_TRUE(view.NotifyComponentRemoval(e2, components::Model::typeId));
   EXPECT_FALSE(view.HasEntity(e2));
   EXPECT_EQ(1u, view.Entities().size());
-  EXPECT_EQ(view.Entities().end(), view.Entities().find(e2));
+  EXPECT_FALSE(contains(view.Entities(), e2));
   EXPECT_EQ(1u, view.NewEntities().size());
   EXPECT_TRUE(view.HasCachedComponentData(e2));
 
@@ -441,7 +457,7 @@ TEST_F(BaseViewTest, ComponentChangeNotification)
   EXPECT_TRUE(view.NotifyComponentRemoval(e2, components::Model::typeId));
   EXPECT_FALSE(view.HasEntity(e2));
   EXPECT_EQ(1u, view.Entities().size());
-  EXPECT_EQ(view.Entities().end(), view.Entities().find(e2));
+  EXPECT_FALSE(contains(view.Entities(), e2));
   EXPECT_EQ(1u, view.NewEntities().size());
   EXPECT_TRUE(view.HasCachedComponentData(e2));
 
@@ -451,10 +467,10 @@ TEST_F(BaseViewTest, ComponentChangeNotification)
   EXPECT_TRUE(view.HasCachedComponentData(e2));
   EXPECT_TRUE(view.HasEntity(e2));
   EXPECT_EQ(2u, view.Entities().size());
-  EXPECT_NE(view.Entities().end(), view.Entities().find(e1));
-  EXPECT_NE(view.Entities().end(), view.Entities().find(e2));
+  EXPECT_TRUE(contains(view.Entities(), e1));
+  EXPECT_TRUE(contains(view.Entities(), e2));
   EXPECT_EQ(1u, view.NewEntities().size());
-  EXPECT_EQ(view.NewEntities().end(), view.NewEntities().find(e2));
+  EXPECT_FALSE(contains(view.NewEntities(), e2));
 
   // call NotifyComponentAddition on a component that was already notified of
   // addition. While the notification should still take place, it will have no
@@ -464,10 +480,10 @@ TEST_F(BaseViewTest, ComponentChangeNotification)
   EXPECT_TRUE(view.HasCachedComponentData(e2));
   EXPECT_TRUE(view.HasEntity(e2));
   EXPECT_EQ(2u, view.Entities().size());
-  EXPECT_NE(view.Entities().end(), view.Entities().find(e1));
-  EXPECT_NE(view.Entities().end(), view.Entities().find(e2));
+  EXPECT_TRUE(contains(view.Entities(), e1));
+  EXPECT_TRUE(contains(view.Entities(), e2));
   EXPECT_EQ(1u, view.NewEntities().size());
-  EXPECT_EQ(view.NewEntities().end(), view.NewEntities().find(e2));
+  EXPECT_FALSE(contains(view.NewEntities(), e2));
 }
 
 /////////////////////////////////////////////////
@@ -517,3 +533,127 @@ TEST_F(BaseViewTest, ComponentTypeHasher)
   uniqueVecs.insert(vec7);
   EXPECT_EQ(7u, uniqueVecs.size());
 }
+
+/////////////////////////////////////////////////
+TEST_F(BaseViewTest, PackedData)
+{
+  auto view = detail::View<components::Model>();
+
+  const Entity e1 = 1;
+  auto e1ModelComp = components::Model();
+  const Entity e2 = 2;
+  auto e2ModelComp = components::Model();
+  const Entity e3 = 3;
+  auto e3ModelComp = components::Model();
+
+  view.AddEntityWithComps(e1, false, &e1ModelComp);
+  view.AddEntityWithComps(e2, false, &e2ModelComp);
+  view.AddEntityWithComps(e3, false, &e3ModelComp);
+  ASSERT_EQ(3u, view.Data().size());
+
+  // Removing an entity in the middle moves the last one into its place, and
+  // the component data follows the entities
+  EXPECT_TRUE(view.NotifyComponentRemoval(e2, components::Model::typeId));
+  ASSERT_EQ(2u, view.Entities().size());
+  ASSERT_EQ(2u, view.Data().size());
+  EXPECT_EQ(e1, view.Entities()[0]);
+  EXPECT_EQ(e3, view.Entities()[1]);
+  EXPECT_EQ(e3, std::get<Entity>(view.Data()[1]));
+  EXPECT_EQ(&e3ModelComp, std::get<components::Model *>(view.Data()[1]));
+  EXPECT_EQ(&e3ModelComp,
+      std::get<components::Model *>(view.EntityComponentData(e3)));
+
+  // Adding the component back appends the entity
+  EXPECT_TRUE(view.NotifyComponentAddition(e2, false,
+      components::Model::typeId));
+  ASSERT_EQ(3u, view.Data().size());
+  EXPECT_EQ(e2, view.Entities()[2]);
+  EXPECT_EQ(e2, std::get<Entity>(view.Data()[2]));
+  EXPECT_EQ(&e2ModelComp, std::get<components::Model *>(view.Data()[2]));
+
+  for (std::size_t i = 0; i < view.Entities().size(); ++i)
+    EXPECT_EQ(view.Entities()[i], std::get<Entity>(view.Data()[i]));
+}
+
+/////////////////////////////////////////////////
+TEST_F(BaseViewTest, RemoveEntitiesInBatch)
+{
+  auto view = detail::View<components::Model>();
+
+  std::vector<components::Model> models(10);
+  for (Entity e = 0; e < 10; ++e)
+    view.AddEntityWithComps(e, e % 2 == 0, &models[e]);
+  EXPECT_TRUE(view.MarkEntityToRemove(4));
+  EXPECT_TRUE(view.MarkEntityToRemove(5));
+  EXPECT_TRUE(view.MarkEntityToAdd(20, true));
+  EXPECT_TRUE(view.NotifyComponentRemoval(6, components::Model::typeId));
+
+  // Entities that aren't in the view are ignored
+  detail::EntityBitmap bitmap({0, 4, 6, 9, 20, 100});
+  EXPECT_EQ(6u, bitmap.Count());
+  EXPECT_TRUE(bitmap.Contains(100));
+  EXPECT_FALSE(bitmap.Contains(5));
+  EXPECT_EQ(3u, view.RemoveEntities(bitmap));
+
+  EXPECT_EQ(6u, view.Entities().size());
+  EXPECT_EQ(6u, view.Data().size());
+  for (std::size_t i = 0; i < view.Entities().size(); ++i)
+  {
+    const Entity entity = view.Entities()[i];
+    EXPECT_FALSE(bitmap.Contains(entity));
+    EXPECT_TRUE(view.HasEntity(entity));
+    EXPECT_EQ(entity, std::get<Entity>(view.Data()[i]));
+    EXPECT_EQ(&models[entity], std::get<components::Model *>(
+        view.EntityComponentData(entity)));
+  }
+  EXPECT_FALSE(view.HasCachedComponentData(6));
+  EXPECT_FALSE(view.IsEntityMarkedForAddition(20));
+  EXPECT_EQ(std::vector<Entity>({2, 8}), view.NewEntities());
+  EXPECT_EQ(std::vector<Entity>({5}), view.ToRemoveEntities());
+
+  // Entities far apart
+  detail::EntityBitmap sparse({3, 1000000000});
+  EXPECT_TRUE(sparse.Contains(1000000000));
+  EXPECT_FALSE(sparse.Contains(1));
+  EXPECT_EQ(1u, view.RemoveEntities(sparse));
+  EXPECT_FALSE(view.HasEntity(3));
+  EXPECT_EQ(5u, view.Entities().size());
+}
+
+/////////////////////////////////////////////////
+TEST_F(BaseViewTest, Iteration)
+{
+  auto view = detail::View<components::Model>();
+
+  std::vector<components::Model> models(4);
+  for (Entity e = 0; e < 3; ++e)
+    view.AddEntityWithComps(e, false, &models[e]);
+
+  // Changes to other views or to component data don't affect the iteration
+  auto other = detail::View<components::Model>();
+  detail::ViewIteration iteration(&view);
+  other.AddEntityWithComps(0, false, &models[0]);
+  view.AddEntityWithComps(1, false, &models[3]);
+  EXPECT_FALSE(iteration.Changed());
+
+  {
+    // The first change copies the entities for all the iterations over the
+    // view, and later ones don't
+    detail::ViewIteration nested(&view);
+    EXPECT_TRUE(view.NotifyComponentRemoval(0, components::Model::typeId));
+    EXPECT_TRUE(nested.Changed());
+    view.AddEntityWithComps(3, false, &models[3]);
+    EXPECT_EQ(std::vector<Entity>({0, 1, 2}), nested.OriginalEntities());
+  }
+  EXPECT_TRUE(iteration.Changed());
+  EXPECT_EQ(std::vector<Entity>({0, 1, 2}), iteration.OriginalEntities());
+  EXPECT_EQ(std::vector<Entity>({2, 1, 3}), view.Entities());
+
+  // Iterations which start afterwards see the current entities
+  detail::ViewIteration later(&view);
+  EXPECT_FALSE(later.Changed());
+  view.Reset();
+  EXPECT_TRUE(later.Changed());
+  EXPECT_EQ(std::vector<Entity>({2, 1, 3}), later.OriginalEntities());
+  EXPECT_EQ(std::vector<Entity>({0, 1, 2}), iteration.OriginalEntities());
+}
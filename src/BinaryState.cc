@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "ignition/gazebo/BinaryState.hh"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include <ignition/common/Console.hh>
+
+using namespace ignition;
+using namespace gazebo;
+
+namespace
+{
+  /// \brief Check that a table is aligned and fits in the buffer.
+  /// \param[in] _offset Offset of the table.
+  /// \param[in] _count Number of elements.
+  /// \param[in] _elementSize Size of an element.
+  /// \param[in] _size Size of the buffer.
+  /// \return True if the table is within the buffer.
+  bool tableInBounds(uint64_t _offset, uint64_t _count,
+      uint64_t _elementSize, uint64_t _size)
+  {
+    if (_offset % kBinaryStateAlignment != 0 || _offset > _size)
+      return false;
+    return _count <= (_size - _offset) / _elementSize;
+  }
+}
+
+//////////////////////////////////////////////////
+BinaryStateView::BinaryStateView(const void *_data, std::size_t _size)
+{
+  auto data = static_cast<const char *>(_data);
+  if (nullptr == data || _size < sizeof(BinaryStateHeader))
+  {
+    ignerr << "Binary state buffer is too small." << std::endl;
+    return;
+  }
+
+  if (reinterpret_cast<uintptr_t>(data) % kBinaryStateAlignment != 0)
+  {
+    ignerr << "Binary state buffer must be aligned to "
+           << kBinaryStateAlignment << " bytes." << std::endl;
+    return;
+  }
+
+  auto header = reinterpret_cast<const BinaryStateHeader *>(data);
+  if (std::memcmp(header->magic, kBinaryStateMagic,
+      sizeof(kBinaryStateMagic)) != 0)
+  {
+    ignerr << "Buffer doesn't contain binary state." << std::endl;
+    return;
+  }
+
+  if (header->byteOrder != kBinaryStateByteOrder)
+  {
+    ignerr << "Binary state buffer was written with a different byte order."
+           << std::endl;
+    return;
+  }
+
+  if (header->version != kBinaryStateVersion)
+  {
+    ignerr << "Unsupported binary state version [" << header->version
+           << "], expected [" << kBinaryStateVersion << "]." << std::endl;
+    return;
+  }
+
+  const uint64_t size = header->size;
+  if (size > _size || size < sizeof(BinaryStateHeader))
+  {
+    ignerr << "Binary state buffer is truncated." << std::endl;
+    return;
+  }
+
+  if (!tableInBounds(header->entitiesOffset, header->entityCount,
+          sizeof(BinaryStateEntity), size) ||
+      !tableInBounds(header->columnsOffset, header->columnCount,
+          sizeof(BinaryStateColumn), size))
+  {
+    ignerr << "Binary state tables are out of bounds." << std::endl;
+    return;
+  }
+
+  auto columns = reinterpret_cast<const BinaryStateColumn *>(
+      data + header->columnsOffset);
+  for (uint64_t c = 0; c < header->columnCount; ++c)
+  {
+    const auto &column = columns[c];
+    if (column.dataOffset > size ||
+        column.dataSize > size - column.dataOffset ||
+        !tableInBounds(column.entitiesOffset, column.count,
+            sizeof(uint64_t), size) ||
+        column.count == std::numeric_limits<uint64_t>::max() ||
+        !tableInBounds(column.offsetsOffset, column.count + 1,
+            sizeof(uint64_t), size))
+    {
+      ignerr << "Binary state column [" << c << "] is out of bounds."
+             << std::endl;
+      return;
+    }
+
+    // Offsets must be sorted and within the column's data, so that accessors
+    // don't need to check them
+    auto offsets = reinterpret_cast<const uint64_t *>(
+        data + column.offsetsOffset);
+    if (offsets[0] != 0 || offsets[column.count] != column.dataSize)
+    {
+      ignerr << "Binary state column [" << c << "] has invalid offsets."
+             << std::endl;
+      return;
+    }
+    for (uint64_t i = 0; i < column.count; ++i)
+    {
+      if (offsets[i] > offsets[i + 1])
+      {
+        ignerr << "Binary state column [" << c << "] has invalid offsets."
+               << std::endl;
+        return;
+      }
+    }
+  }
+
+  this->data = data;
+  this->header = header;
+  this->entities = reinterpret_cast<const BinaryStateEntity *>(
+      data + header->entitiesOffset);
+  this->columns = columns;
+}
+
+//////////////////////////////////////////////////
+bool BinaryStateView::Valid() const
+{
+  return nullptr != this->header;
+}
+
+//////////////////////////////////////////////////
+std::size_t BinaryStateView::Size() const
+{
+  if (nullptr == this->header)
+    return 0;
+  return static_cast<std::size_t>(this->header->size);
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ignition/gazebo/BinaryState.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+/////////////////////////////////////////////////
+/// \brief Build a buffer with 2 entities and a single column holding "ab"
+/// for entity 1 and "cde" for entity 2.
+/// \return 8-byte aligned buffer.
+std::vector<uint64_t> makeBuffer()
+{
+  const std::size_t entitiesOffset = sizeof(BinaryStateHeader);
+  const std::size_t columnsOffset =
+      entitiesOffset + 2 * sizeof(BinaryStateEntity);
+  const std::size_t dataOffset = columnsOffset + sizeof(BinaryStateColumn);
+  const std::size_t columnEntitiesOffset = dataOffset + 8;
+  const std::size_t offsetsOffset = columnEntitiesOffset + 2 * 8;
+  const std::size_t size = offsetsOffset + 3 * 8;
+
+  std::vector<uint64_t> buffer(size / 8, 0);
+  char *data = reinterpret_cast<char *>(buffer.data());
+
+  BinaryStateHeader header;
+  std::memcpy(header.magic, kBinaryStateMagic, sizeof(kBinaryStateMagic));
+  header.version = kBinaryStateVersion;
+  header.byteOrder = kBinaryStateByteOrder;
+  header.size = size;
+  header.entityCount = 2;
+  header.entitiesOffset = entitiesOffset;
+  header.columnCount = 1;
+  header.columnsOffset = columnsOffset;
+  std::memcpy(data, &header, sizeof(header));
+
+  BinaryStateEntity entities[2] = {{1, 0}, {2, kBinaryStateEntityRemoved}};
+  std::memcpy(data + entitiesOffset, entities, sizeof(entities));
+
+  BinaryStateColumn column;
+  column.type = 123;
+  column.count = 2;
+  column.dataOffset = dataOffset;
+  column.dataSize = 5;
+  column.entitiesOffset = columnEntitiesOffset;
+  column.offsetsOffset = offsetsOffset;
+  std::memcpy(data + columnsOffset, &column, sizeof(column));
+
+  std::memcpy(data + dataOffset, "abcde", 5);
+  uint64_t columnEntities[2] = {1, 2};
+  std::memcpy(data + columnEntitiesOffset, columnEntities,
+      sizeof(columnEntities));
+  uint64_t offsets[3] = {0, 2, 5};
+  std::memcpy(data + offsetsOffset, offsets, sizeof(offsets));
+
+  return buffer;
+}
+
+/////////////////////////////////////////////////
+TEST(BinaryState, Read)
+{
+  auto buffer = makeBuffer();
+  BinaryStateView view(buffer.data(), buffer.size() * 8);
+  ASSERT_TRUE(view.Valid());
+  EXPECT_EQ(buffer.size() * 8, view.Size());
+
+  ASSERT_EQ(2u, view.EntityCount());
+  EXPECT_EQ(1u, view.EntityAt(0).id);
+  EXPECT_EQ(0u, view.EntityAt(0).flags);
+  EXPECT_EQ(2u, view.EntityAt(1).id);
+  EXPECT_EQ(kBinaryStateEntityRemoved, view.EntityAt(1).flags);
+
+  ASSERT_EQ(1u, view.ColumnCount());
+  auto column = view.Column(0);
+  EXPECT_EQ(123u, column.TypeId());
+  ASSERT_EQ(2u, column.Count());
+  EXPECT_EQ(1u, column.EntityAt(0));
+  EXPECT_EQ("ab", std::string(column.Data(0), column.Size(0)));
+  EXPECT_EQ(2u, column.EntityAt(1));
+  EXPECT_EQ("cde", std::string(column.Data(1), column.Size(1)));
+
+  // Extra bytes after the buffer are fine
+  buffer.push_back(0);
+  EXPECT_TRUE(BinaryStateView(buffer.data(), buffer.size() * 8).Valid());
+}
+
+/////////////////////////////////////////////////
+TEST(BinaryState, Invalid)
+{
+  EXPECT_FALSE(BinaryStateView().Valid());
+  EXPECT_EQ(0u, BinaryStateView().Size());
+  EXPECT_FALSE(BinaryStateView(nullptr, 100).Valid());
+
+  const auto good = makeBuffer();
+  const std::size_t size = good.size() * 8;
+
+  // Truncated
+  EXPECT_FALSE(BinaryStateView(good.data(), size - 8).Valid());
+  EXPECT_FALSE(BinaryStateView(good.data(), 8).Valid());
+
+  // Misaligned
+  std::vector<uint64_t> shifted(good.size() + 1);
+  char *shiftedData = reinterpret_cast<char *>(shifted.data()) + 1;
+  std::memcpy(shiftedData, good.data(), size);
+  EXPECT_FALSE(BinaryStateView(shiftedData, size).Valid());
+
+  auto header = [](std::vector<uint64_t> &_buffer)
+  {
+    return reinterpret_cast<BinaryStateHeader *>(_buffer.data());
+  };
+  auto column = [&](std::vector<uint64_t> &_buffer)
+  {
+    return reinterpret_cast<BinaryStateColumn *>(
+        reinterpret_cast<char *>(_buffer.data()) +
+        header(_buffer)->columnsOffset);
+  };
+
+  // Bad magic
+  auto buffer = good;
+  header(buffer)->magic[0] = 'X';
+  EXPECT_FALSE(BinaryStateView(buffer.data(), size).Valid());
+
+  // Bad version
+  buffer = good;
+  header(buffer)->version = kBinaryStateVersion + 1;
+  EXPECT_FALSE(BinaryStateView(buffer.data(), size).Valid());
+
+  // Foreign byte order
+  buffer = good;
+  header(buffer)->byteOrder = 0x04030201;
+  EXPECT_FALSE(BinaryStateView(buffer.data(), size).Valid());
+
+  // Entity table out of bounds
+  buffer = good;
+  header(buffer)->entityCount = 1000;
+  EXPECT_FALSE(BinaryStateView(buffer.data(), size).Valid());
+
+  // Column table out of bounds
+  buffer = good;
+  header(buffer)->columnsOffset = size;
+  header(buffer)->columnCount = 1;
+  EXPECT_FALSE(BinaryStateView(buffer.data(), size).Valid());
+
+  // Column data out of bounds
+  buffer = good;
+  column(buffer)->dataSize = size;
+  EXPECT_FALSE(BinaryStateView(buffer.data(), size).Valid());
+
+  // Column count too large for the offsets table
+  buffer = good;
+  column(buffer)->count = 3;
+  EXPECT_FALSE(BinaryStateView(buffer.data(), size).Valid());
+
+  // Offsets not sorted
+  buffer = good;
+  auto offsets = reinterpret_cast<uint64_t *>(
+      reinterpret_cast<char *>(buffer.data()) + column(buffer)->offsetsOffset);
+  offsets[1] = 6;
+  EXPECT_FALSE(BinaryStateView(buffer.data(), size).Valid());
+}
@@ -0,0 +1,275 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "ChangeTracker.hh"
+
+#include <algorithm>
+
+using namespace ignition;
+using namespace gazebo;
+
+namespace
+{
+  /// \brief Journal entries allowed on top of one per tracked entity before
+  /// the journal is compacted.
+  constexpr std::size_t kJournalSlack{64};
+
+  /// \brief Tombstones that are always kept, no matter how few entities are
+  /// alive.
+  constexpr std::size_t kMinTombstones{1024};
+}
+
+//////////////////////////////////////////////////
+uint64_t ChangeTracker::Tick() const
+{
+  return this->tick;
+}
+
+//////////////////////////////////////////////////
+uint64_t ChangeTracker::MarkEntityCreated(const Entity _entity)
+{
+  Record &record = this->Get(_entity);
+
+  // Entities can be created again with the same ID, for example when a log
+  // is played back
+  if (record.removed)
+  {
+    record.removed = false;
+    --this->removedCount;
+  }
+  record.components.clear();
+
+  record.created = this->Touch(_entity, record);
+  return record.created;
+}
+
+//////////////////////////////////////////////////
+uint64_t ChangeTracker::MarkEntityChanged(const Entity _entity)
+{
+  return this->Touch(_entity, this->Get(_entity));
+}
+
+//////////////////////////////////////////////////
+uint64_t ChangeTracker::MarkEntityRemoved(const Entity _entity)
+{
+  Record &record = this->Get(_entity);
+  if (!record.removed)
+  {
+    record.removed = true;
+    ++this->removedCount;
+  }
+  record.components.clear();
+  record.components.shrink_to_fit();
+
+  const uint64_t changeTick = this->Touch(_entity, record);
+
+  const std::size_t alive = this->records.Size() - this->removedCount;
+  if (this->removedCount > 2 * std::max(kMinTombstones, alive))
+    this->Compact(true);
+
+  return changeTick;
+}
+
+//////////////////////////////////////////////////
+void ChangeTracker::MarkAllEntitiesRemoved()
+{
+  // Every tracked entity has an up to date journal entry
+  std::vector<Entity> alive;
+  for (const Entry &entry : this->journal)
+  {
+    const Record *record = this->records.Find(entry.entity);
+    if (nullptr != record && record->tick == entry.tick && !record->removed)
+      alive.push_back(entry.entity);
+  }
+
+  for (const Entity entity : alive)
+    this->MarkEntityRemoved(entity);
+}
+
+//////////////////////////////////////////////////
+uint64_t ChangeTracker::MarkComponentChanged(const Entity _entity,
+    const ComponentTypeId _typeId)
+{
+  Record &record = this->Get(_entity);
+  const uint64_t changeTick = this->Touch(_entity, record);
+
+  for (auto &component : record.components)
+  {
+    if (component.first == _typeId)
+    {
+      component.second = changeTick;
+      return changeTick;
+    }
+  }
+  record.components.emplace_back(_typeId, changeTick);
+  return changeTick;
+}
+
+//////////////////////////////////////////////////
+uint64_t ChangeTracker::EntityTick(const Entity _entity) const
+{
+  const Record *record = this->records.Find(_entity);
+  return nullptr == record ? 0 : record->tick;
+}
+
+//////////////////////////////////////////////////
+uint64_t ChangeTracker::CreationTick(const Entity _entity) const
+{
+  const Record *record = this->records.Find(_entity);
+  return nullptr == record ? 0 : record->created;
+}
+
+//////////////////////////////////////////////////
+uint64_t ChangeTracker::ComponentTick(const Entity _entity,
+    const ComponentTypeId _typeId) const
+{
+  const Record *record = this->records.Find(_entity);
+  if (nullptr == record)
+    return 0;
+
+  for (const auto &component : record->components)
+  {
+    if (component.first == _typeId)
+      return component.second;
+  }
+  return 0;
+}
+
+//////////////////////////////////////////////////
+bool ChangeTracker::Removed(const Entity _entity) const
+{
+  const Record *record = this->records.Find(_entity);
+  return nullptr != record && record->removed;
+}
+
+//////////////////////////////////////////////////
+bool ChangeTracker::ChangedSince(uint64_t _tick,
+    std::vector<Entity> &_entities) const
+{
+  auto it = std::upper_bound(this->journal.begin(), this->journal.end(),
+      _tick, [](uint64_t _t, const Entry &_entry)
+      {
+        return _t < _entry.tick;
+      });
+
+  // Only the latest entry of each entity matches its record, which skips
+  // superseded entries and reports every entity once
+  for (; it != this->journal.end(); ++it)
+  {
+    const Record *record = this->records.Find(it->entity);
+    if (nullptr != record && record->tick == it->tick)
+      _entities.push_back(it->entity);
+  }
+
+  return _tick >= this->historyStart;
+}
+
+//////////////////////////////////////////////////
+void ChangeTracker::ComponentsChangedSince(const Entity _entity,
+    uint64_t _tick, std::vector<ComponentTypeId> &_types) const
+{
+  const Record *record = this->records.Find(_entity);
+  if (nullptr == record || record->tick <= _tick)
+    return;
+
+  for (const auto &component : record->components)
+  {
+    if (component.second > _tick)
+      _types.push_back(component.first);
+  }
+}
+
+//////////////////////////////////////////////////
+uint64_t ChangeTracker::HistoryStart() const
+{
+  return this->historyStart;
+}
+
+//////////////////////////////////////////////////
+std::size_t ChangeTracker::Size() const
+{
+  return this->records.Size();
+}
+
+//////////////////////////////////////////////////
+std::size_t ChangeTracker::JournalSize() const
+{
+  return this->journal.size();
+}
+
+//////////////////////////////////////////////////
+uint64_t ChangeTracker::Touch(const Entity _entity, Record &_record)
+{
+  const uint64_t changeTick = ++this->tick;
+
+  // Consecutive changes of the same entity, such as several of its
+  // components being set, share a journal entry
+  if (!this->journal.empty() && this->journal.back().entity == _entity &&
+      this->journal.back().tick == _record.tick)
+  {
+    this->journal.back().tick = changeTick;
+    _record.tick = changeTick;
+    return changeTick;
+  }
+
+  _record.tick = changeTick;
+  this->journal.push_back({changeTick, _entity});
+
+  if (this->journal.size() > 2 * this->records.Size() + kJournalSlack)
+    this->Compact(false);
+
+  return changeTick;
+}
+
+//////////////////////////////////////////////////
+ChangeTracker::Record &ChangeTracker::Get(const Entity _entity)
+{
+  Record *record = this->records.Find(_entity);
+  if (nullptr == record)
+    record = this->records.Insert(_entity, Record());
+  return *record;
+}
+
+//////////////////////////////////////////////////
+void ChangeTracker::Compact(bool _dropTombstones)
+{
+  // Drop the oldest half of the tombstones
+  std::size_t dropTombstones = 0;
+  if (_dropTombstones)
+    dropTombstones = this->removedCount / 2;
+
+  std::size_t kept = 0;
+  for (const Entry &entry : this->journal)
+  {
+    const Record *record = this->records.Find(entry.entity);
+    if (nullptr == record || record->tick != entry.tick)
+      continue;
+
+    // The journal is sorted, so tombstones are dropped oldest first
+    if (record->removed && dropTombstones > 0)
+    {
+      this->historyStart = entry.tick;
+      this->records.Erase(entry.entity);
+      --this->removedCount;
+      --dropTombstones;
+      continue;
+    }
+
+    this->journal[kept++] = entry;
+  }
+  this->journal.resize(kept);
+}
@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_CHANGETRACKER_HH_
+#define IGNITION_GAZEBO_CHANGETRACKER_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <ignition/gazebo/config.hh>
+#include <ignition/gazebo/Export.hh>
+
+#include "ignition/gazebo/Entity.hh"
+#include "ignition/gazebo/Types.hh"
+#include "EntityIndex.hh"
+
+namespace ignition
+{
+  namespace gazebo
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+    /// \class ChangeTracker ChangeTracker.hh
+    /// \brief Records when entities and components last changed.
+    ///
+    /// Every change advances a global tick, and the entity and component
+    /// that changed store it. Ticks are never reset, so any number of
+    /// consumers can remember the tick they last looked at and ask for the
+    /// changes after it, each at its own rate.
+    ///
+    /// Changed entities are kept in a journal sorted by tick, with one entry
+    /// per change. Entries superseded by a later change of the same entity
+    /// are skipped by queries and dropped once they outnumber the tracked
+    /// entities, so queries are proportional to the number of entities that
+    /// changed and memory is proportional to the number of entities.
+    ///
+    /// Removed entities are kept as tombstones so that consumers learn about
+    /// the removal. Old tombstones are eventually dropped, see HistoryStart.
+    class IGNITION_GAZEBO_VISIBLE ChangeTracker
+    {
+      /// \brief Get the tick of the latest change.
+      /// \return The tick, or 0 if nothing changed yet.
+      public: uint64_t Tick() const;
+
+      /// \brief Record the creation of an entity.
+      /// \param[in] _entity Entity.
+      /// \return The tick of the change.
+      public: uint64_t MarkEntityCreated(const Entity _entity);
+
+      /// \brief Record a change of an entity that doesn't affect a single
+      /// component, such as a removal request.
+      /// \param[in] _entity Entity.
+      /// \return The tick of the change.
+      public: uint64_t MarkEntityChanged(const Entity _entity);
+
+      /// \brief Record that an entity no longer exists.
+      /// \param[in] _entity Entity.
+      /// \return The tick of the change.
+      public: uint64_t MarkEntityRemoved(const Entity _entity);
+
+      /// \brief Record that all tracked entities no longer exist.
+      public: void MarkAllEntitiesRemoved();
+
+      /// \brief Record that a component was created, modified or removed.
+      /// \param[in] _entity Entity.
+      /// \param[in] _typeId Component type.
+      /// \return The tick of the change.
+      public: uint64_t MarkComponentChanged(const Entity _entity,
+                  const ComponentTypeId _typeId);
+
+      /// \brief Get the tick of the latest change of an entity or of any of
+      /// its components.
+      /// \param[in] _entity Entity.
+      /// \return The tick, or 0 if the entity isn't tracked.
+      public: uint64_t EntityTick(const Entity _entity) const;
+
+      /// \brief Get the tick at which an entity was created.
+      /// \param[in] _entity Entity.
+      /// \return The tick, or 0 if the entity isn't tracked.
+      public: uint64_t CreationTick(const Entity _entity) const;
+
+      /// \brief Get the tick of the latest change of a component.
+      /// \param[in] _entity Entity.
+      /// \param[in] _typeId Component type.
+      /// \return The tick, or 0 if the component never changed.
+      public: uint64_t ComponentTick(const Entity _entity,
+                  const ComponentTypeId _typeId) const;
+
+      /// \brief Get whether an entity was marked as removed.
+      /// \param[in] _entity Entity.
+      /// \return True if the entity has a tombstone.
+      public: bool Removed(const Entity _entity) const;
+
+      /// \brief Get the entities that changed after a tick, in the order of
+      /// their latest change.
+      /// \param[in] _tick Tick of the last query.
+      /// \param[out] _entities Entities are appended to this vector, each
+      /// once.
+      /// \return False if _tick is older than HistoryStart, in which case the
+      /// removal of some entities is missing from the result.
+      public: bool ChangedSince(uint64_t _tick,
+                  std::vector<Entity> &_entities) const;
+
+      /// \brief Get the components of an entity that changed after a tick.
+      /// \param[in] _entity Entity.
+      /// \param[in] _tick Tick of the last query.
+      /// \param[out] _types Component types are appended to this vector.
+      public: void ComponentsChangedSince(const Entity _entity,
+                  uint64_t _tick, std::vector<ComponentTypeId> &_types) const;
+
+      /// \brief Get the oldest tick after which all changes are known.
+      /// Tombstones of entities removed at or before this tick were dropped.
+      /// \return The tick, 0 until a tombstone is dropped.
+      public: uint64_t HistoryStart() const;
+
+      /// \brief Number of tracked entities, including tombstones.
+      /// \return Entity count.
+      public: std::size_t Size() const;
+
+      /// \brief Number of journal entries, exposed for testing.
+      /// \return Entry count.
+      public: std::size_t JournalSize() const;
+
+      /// \brief Change history of an entity.
+      private: struct Record
+      {
+        /// \brief Tick at which the entity was created.
+        uint64_t created{0};
+
+        /// \brief Tick of the latest change of the entity or its components.
+        uint64_t tick{0};
+
+        /// \brief Whether the entity no longer exists.
+        bool removed{false};
+
+        /// \brief Tick of the latest change of each component.
+        std::vector<std::pair<ComponentTypeId, uint64_t>> components;
+      };
+
+      /// \brief Journal entry.
+      private: struct Entry
+      {
+        /// \brief Tick of the change.
+        uint64_t tick;
+
+        /// \brief Entity that changed.
+        Entity entity;
+      };
+
+      /// \brief Advance the tick and record it as the latest change of an
+      /// entity.
+      /// \param[in] _entity Entity.
+      /// \param[in] _record The entity's record.
+      /// \return The new tick.
+      private: uint64_t Touch(const Entity _entity, Record &_record);
+
+      /// \brief Find an entity's record, creating it if needed.
+      /// \param[in] _entity Entity.
+      /// \return The record.
+      private: Record &Get(const Entity _entity);
+
+      /// \brief Drop superseded journal entries.
+      /// \param[in] _dropTombstones True to also drop the oldest half of the
+      /// tombstones. Records of dropped tombstones are erased, so callers
+      /// must not hold references to records.
+      private: void Compact(bool _dropTombstones);
+
+      /// \brief Tick of the latest change.
+      private: uint64_t tick{0};
+
+      /// \brief See HistoryStart.
+      private: uint64_t historyStart{0};
+
+      /// \brief Number of tombstones.
+      private: std::size_t removedCount{0};
+
+      /// \brief Records of all tracked entities.
+      private: EntityIndex<Record> records;
+
+      /// \brief Journal of changes, sorted by tick.
+      private: std::vector<Entry> journal;
+    };
+    }
+  }
+}
+#endif
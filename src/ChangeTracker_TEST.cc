@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "ChangeTracker.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+/////////////////////////////////////////////////
+/// \brief Get the entities that changed after a tick.
+/// \param[in] _tracker Tracker.
+/// \param[in] _tick Tick.
+/// \return Changed entities.
+std::vector<Entity> changedSince(const ChangeTracker &_tracker,
+    uint64_t _tick)
+{
+  std::vector<Entity> entities;
+  EXPECT_TRUE(_tracker.ChangedSince(_tick, entities));
+  return entities;
+}
+
+/////////////////////////////////////////////////
+TEST(ChangeTracker, Ticks)
+{
+  ChangeTracker tracker;
+  EXPECT_EQ(0u, tracker.Tick());
+  EXPECT_EQ(0u, tracker.EntityTick(1));
+  EXPECT_EQ(0u, tracker.ComponentTick(1, 10));
+
+  EXPECT_EQ(1u, tracker.MarkEntityCreated(1));
+  EXPECT_EQ(2u, tracker.MarkEntityCreated(2));
+  EXPECT_EQ(3u, tracker.MarkComponentChanged(1, 10));
+  EXPECT_EQ(4u, tracker.MarkComponentChanged(1, 20));
+  EXPECT_EQ(4u, tracker.Tick());
+
+  EXPECT_EQ(1u, tracker.CreationTick(1));
+  EXPECT_EQ(4u, tracker.EntityTick(1));
+  EXPECT_EQ(3u, tracker.ComponentTick(1, 10));
+  EXPECT_EQ(4u, tracker.ComponentTick(1, 20));
+  EXPECT_EQ(0u, tracker.ComponentTick(1, 30));
+  EXPECT_EQ(2u, tracker.EntityTick(2));
+  EXPECT_EQ(0u, tracker.ComponentTick(2, 10));
+
+  std::vector<ComponentTypeId> types;
+  tracker.ComponentsChangedSince(1, 3, types);
+  EXPECT_EQ(std::vector<ComponentTypeId>({20}), types);
+  types.clear();
+  tracker.ComponentsChangedSince(1, 0, types);
+  EXPECT_EQ(2u, types.size());
+  types.clear();
+  tracker.ComponentsChangedSince(2, 0, types);
+  EXPECT_TRUE(types.empty());
+}
+
+/////////////////////////////////////////////////
+TEST(ChangeTracker, ChangedSince)
+{
+  ChangeTracker tracker;
+  EXPECT_TRUE(changedSince(tracker, 0).empty());
+
+  tracker.MarkEntityCreated(1);
+  tracker.MarkEntityCreated(2);
+  tracker.MarkEntityCreated(3);
+  EXPECT_EQ(std::vector<Entity>({1, 2, 3}), changedSince(tracker, 0));
+
+  // Two consumers at different rates
+  uint64_t fast = tracker.Tick();
+  uint64_t slow = tracker.Tick();
+
+  tracker.MarkComponentChanged(2, 10);
+  EXPECT_EQ(std::vector<Entity>({2}), changedSince(tracker, fast));
+  fast = tracker.Tick();
+
+  tracker.MarkComponentChanged(1, 10);
+  tracker.MarkComponentChanged(2, 10);
+  EXPECT_EQ(std::vector<Entity>({1, 2}), changedSince(tracker, fast));
+  fast = tracker.Tick();
+  EXPECT_TRUE(changedSince(tracker, fast).empty());
+
+  // Each entity is reported once, in the order of its latest change
+  EXPECT_EQ(std::vector<Entity>({1, 2}), changedSince(tracker, slow));
+  slow = tracker.Tick();
+
+  // Removal
+  tracker.MarkEntityRemoved(3);
+  EXPECT_TRUE(tracker.Removed(3));
+  EXPECT_FALSE(tracker.Removed(1));
+  EXPECT_EQ(std::vector<Entity>({3}), changedSince(tracker, slow));
+
+  // Created again with the same ID
+  tracker.MarkEntityCreated(3);
+  EXPECT_FALSE(tracker.Removed(3));
+  EXPECT_EQ(tracker.Tick(), tracker.CreationTick(3));
+
+  tracker.MarkAllEntitiesRemoved();
+  EXPECT_TRUE(tracker.Removed(1));
+  EXPECT_TRUE(tracker.Removed(2));
+  EXPECT_TRUE(tracker.Removed(3));
+  EXPECT_EQ(3u, changedSince(tracker, slow).size());
+}
+
+/////////////////////////////////////////////////
+TEST(ChangeTracker, Compaction)
+{
+  ChangeTracker tracker;
+  const Entity count = 100;
+  for (Entity e = 1; e <= count; ++e)
+    tracker.MarkEntityCreated(e);
+
+  uint64_t tick = tracker.Tick();
+
+  // Many steps changing all entities don't grow the journal
+  for (int step = 0; step < 100; ++step)
+  {
+    for (Entity e = 1; e <= count; ++e)
+      tracker.MarkComponentChanged(e, 10);
+  }
+  EXPECT_LE(tracker.JournalSize(), 2 * count + 64);
+  EXPECT_EQ(static_cast<std::size_t>(count),
+      changedSince(tracker, tick).size());
+
+  // Consecutive changes of an entity share an entry
+  tick = tracker.Tick();
+  const std::size_t journalSize = tracker.JournalSize();
+  tracker.MarkComponentChanged(1, 10);
+  tracker.MarkComponentChanged(1, 20);
+  tracker.MarkComponentChanged(1, 30);
+  EXPECT_EQ(journalSize + 1, tracker.JournalSize());
+  EXPECT_EQ(std::vector<Entity>({1}), changedSince(tracker, tick));
+}
+
+/////////////////////////////////////////////////
+TEST(ChangeTracker, Tombstones)
+{
+  ChangeTracker tracker;
+  tracker.MarkEntityCreated(1);
+  const uint64_t start = tracker.Tick();
+
+  // Create and remove many entities
+  for (Entity e = 2; e < 10000; ++e)
+  {
+    tracker.MarkEntityCreated(e);
+    tracker.MarkEntityRemoved(e);
+  }
+
+  // Old tombstones are dropped
+  EXPECT_LT(tracker.Size(), 5000u);
+  EXPECT_GT(tracker.HistoryStart(), start);
+  EXPECT_FALSE(tracker.Removed(2));
+
+  // Old ticks are reported as incomplete
+  std::vector<Entity> entities;
+  EXPECT_FALSE(tracker.ChangedSince(start, entities));
+  entities.clear();
+  EXPECT_TRUE(tracker.ChangedSince(tracker.HistoryStart(), entities));
+
+  // Recent tombstones and live entities are kept
+  EXPECT_TRUE(tracker.Removed(9999));
+  EXPECT_EQ(1u, tracker.CreationTick(1));
+}
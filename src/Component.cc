@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "ignition/gazebo/components/Component.hh"
+
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace ignition;
+using namespace gazebo;
+
+namespace
+{
+  /// \brief Properties of component types which aren't part of the
+  /// components' own interface.
+  struct TypeRegistry
+  {
+    /// \brief Protects the members below. Components are copied and added
+    /// from several threads, while plugins may register types.
+    std::shared_mutex mutex;
+
+    /// \brief Copy function of each type.
+    std::unordered_map<ComponentTypeId, components::ComponentCopyFn>
+        functions;
+
+    /// \brief Types which are tags.
+    std::unordered_set<ComponentTypeId> tags;
+
+    /// \brief Layout of each type.
+    std::unordered_map<ComponentTypeId, const components::ComponentLayout *>
+        layouts;
+  };
+
+  /// \brief Get the type registry. It's created on first use, since types
+  /// are registered during static initialization.
+  /// \return The registry.
+  TypeRegistry &typeRegistry()
+  {
+    static TypeRegistry registry;
+    return registry;
+  }
+
+  /// \brief Copy a component through its serialization, for types without
+  /// a copy function.
+  /// \param[in] _to Component to copy into.
+  /// \param[in] _from Component to copy from.
+  void copySerialized(components::BaseComponent &_to,
+      const components::BaseComponent &_from)
+  {
+    std::stringstream stream;
+    _from.Serialize(stream);
+    _to.Deserialize(stream);
+  }
+
+  /// \brief Number of BinarySerializationScope instances alive on this
+  /// thread.
+  thread_local unsigned int binaryScopeDepth{0};
+}
+
+//////////////////////////////////////////////////
+serializers::BinarySerializationScope::BinarySerializationScope()
+{
+  ++binaryScopeDepth;
+}
+
+//////////////////////////////////////////////////
+serializers::BinarySerializationScope::~BinarySerializationScope()
+{
+  --binaryScopeDepth;
+}
+
+//////////////////////////////////////////////////
+bool serializers::BinarySerialization()
+{
+  return binaryScopeDepth > 0;
+}
+
+//////////////////////////////////////////////////
+void components::RegisterComponentCopy(ComponentTypeId _typeId,
+    ComponentCopyFn _copy)
+{
+  auto &registry = typeRegistry();
+  std::unique_lock<std::shared_mutex> lock(registry.mutex);
+  registry.functions.emplace(_typeId, _copy);
+}
+
+//////////////////////////////////////////////////
+void components::UnregisterComponentCopy(ComponentTypeId _typeId)
+{
+  auto &registry = typeRegistry();
+  std::unique_lock<std::shared_mutex> lock(registry.mutex);
+  registry.functions.erase(_typeId);
+}
+
+//////////////////////////////////////////////////
+components::ComponentCopyFn components::ComponentCopy(
+    ComponentTypeId _typeId)
+{
+  auto &registry = typeRegistry();
+  std::shared_lock<std::shared_mutex> lock(registry.mutex);
+  auto it = registry.functions.find(_typeId);
+  if (it == registry.functions.end() || nullptr == it->second)
+    return copySerialized;
+  return it->second;
+}
+
+//////////////////////////////////////////////////
+void components::RegisterTagComponent(ComponentTypeId _typeId)
+{
+  auto &registry = typeRegistry();
+  std::unique_lock<std::shared_mutex> lock(registry.mutex);
+  registry.tags.insert(_typeId);
+}
+
+//////////////////////////////////////////////////
+void components::UnregisterTagComponent(ComponentTypeId _typeId)
+{
+  auto &registry = typeRegistry();
+  std::unique_lock<std::shared_mutex> lock(registry.mutex);
+  registry.tags.erase(_typeId);
+}
+
+//////////////////////////////////////////////////
+bool components::IsTagComponent(ComponentTypeId _typeId)
+{
+  auto &registry = typeRegistry();
+  std::shared_lock<std::shared_mutex> lock(registry.mutex);
+  return registry.tags.find(_typeId) != registry.tags.end();
+}
+
+//////////////////////////////////////////////////
+void components::RegisterComponentLayout(ComponentTypeId _typeId,
+    const ComponentLayout *_layout)
+{
+  auto &registry = typeRegistry();
+  std::unique_lock<std::shared_mutex> lock(registry.mutex);
+  registry.layouts.emplace(_typeId, _layout);
+}
+
+//////////////////////////////////////////////////
+void components::UnregisterComponentLayout(ComponentTypeId _typeId)
+{
+  auto &registry = typeRegistry();
+  std::unique_lock<std::shared_mutex> lock(registry.mutex);
+  registry.layouts.erase(_typeId);
+}
+
+//////////////////////////////////////////////////
+const components::ComponentLayout *components::ComponentLayoutOf(
+    ComponentTypeId _typeId)
+{
+  auto &registry = typeRegistry();
+  std::shared_lock<std::shared_mutex> lock(registry.mutex);
+  auto it = registry.layouts.find(_typeId);
+  if (it == registry.layouts.end())
+    return nullptr;
+  return it->second;
+}
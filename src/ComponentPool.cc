@@ -0,0 +1,452 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "ignition/gazebo/components/ComponentPool.hh"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+using namespace ignition;
+using namespace gazebo;
+using namespace components;
+
+namespace
+{
+  /// \brief Step between block sizes, which is also the block alignment.
+  constexpr std::size_t kGranularity{16};
+
+  /// \brief Number of block sizes.
+  constexpr std::size_t kSizeClassCount{
+      ComponentPool::kMaxBlockSize / kGranularity};
+
+  /// \brief Size of a chunk, in bytes. Chunks are aligned to their size, so
+  /// the chunk of a block is found by masking the block's address.
+  constexpr std::size_t kChunkSize{64 * 1024};
+
+  /// \brief Number of empty chunks kept per block size.
+  constexpr std::size_t kMaxEmptyChunks{1};
+
+  /// \brief Number of blocks a thread cache takes from or gives back to the
+  /// shared lists at once.
+  constexpr std::size_t kCacheBatch{32};
+
+  /// \brief Number of free blocks of each size a thread cache holds before
+  /// giving a batch back.
+  constexpr std::size_t kMaxCachedBlocks{2 * kCacheBatch};
+
+  struct SizeClass;
+
+  /// \brief A free block, linked to the next free block of its chunk, or of
+  /// a thread cache.
+  struct FreeBlock
+  {
+    /// \brief Next free block, or nullptr.
+    FreeBlock *next;
+  };
+
+  /// \brief Header at the start of each chunk, followed by the blocks.
+  struct alignas(kGranularity) Chunk
+  {
+    /// \brief Block size this chunk belongs to.
+    SizeClass *sizeClass;
+
+    /// \brief Free blocks of this chunk.
+    FreeBlock *freeList;
+
+    /// \brief Number of blocks in use or in thread caches.
+    std::size_t used;
+
+    /// \brief Previous chunk with free blocks of the same size class.
+    Chunk *prev;
+
+    /// \brief Next chunk with free blocks of the same size class.
+    Chunk *next;
+  };
+
+  /// \brief Chunks and counters of one block size.
+  struct SizeClass
+  {
+    /// \brief Protects the chunks.
+    std::mutex mutex;
+
+    /// \brief Index of this size class.
+    std::size_t index{0};
+
+    /// \brief Size of each block.
+    std::size_t blockSize{0};
+
+    /// \brief Chunks with at least one free block. Allocations are served
+    /// from the head.
+    Chunk *available{nullptr};
+
+    /// \brief Number of chunks held.
+    std::size_t chunks{0};
+
+    /// \brief Number of chunks without used blocks.
+    std::size_t emptyChunks{0};
+
+    /// \brief See ComponentPoolStats. Counted outside the lock, on their
+    /// own cache line, so that threads served by their caches don't contend.
+    alignas(64) std::atomic<uint64_t> allocations{0};
+
+    /// \brief See ComponentPoolStats.
+    std::atomic<uint64_t> deallocations{0};
+
+    /// \brief Number of blocks per chunk.
+    std::size_t BlocksPerChunk() const
+    {
+      return (kChunkSize - sizeof(Chunk)) / this->blockSize;
+    }
+
+    /// \brief Add a chunk to the head of the available list.
+    void Push(Chunk *_chunk)
+    {
+      _chunk->prev = nullptr;
+      _chunk->next = this->available;
+      if (nullptr != this->available)
+        this->available->prev = _chunk;
+      this->available = _chunk;
+    }
+
+    /// \brief Remove a chunk from the available list.
+    void Unlink(Chunk *_chunk)
+    {
+      if (nullptr != _chunk->prev)
+        _chunk->prev->next = _chunk->next;
+      else
+        this->available = _chunk->next;
+      if (nullptr != _chunk->next)
+        _chunk->next->prev = _chunk->prev;
+      _chunk->prev = nullptr;
+      _chunk->next = nullptr;
+    }
+
+    /// \brief Allocate a new chunk and add it to the available list.
+    void Grow()
+    {
+      auto memory = static_cast<unsigned char *>(::operator new(kChunkSize,
+          std::align_val_t(kChunkSize)));
+      auto chunk = new (memory) Chunk{this, nullptr, 0, nullptr, nullptr};
+
+      // Thread the free list through the blocks, in address order
+      unsigned char *first = memory + sizeof(Chunk);
+      const std::size_t count = this->BlocksPerChunk();
+      for (std::size_t i = count; i > 0; --i)
+      {
+        auto block = reinterpret_cast<FreeBlock *>(
+            first + (i - 1) * this->blockSize);
+        block->next = chunk->freeList;
+        chunk->freeList = block;
+      }
+
+      ++this->chunks;
+      ++this->emptyChunks;
+      this->Push(chunk);
+    }
+
+    /// \brief Give a chunk without used blocks back to the system.
+    void Release(Chunk *_chunk)
+    {
+      this->Unlink(_chunk);
+      --this->chunks;
+      --this->emptyChunks;
+      _chunk->~Chunk();
+      ::operator delete(_chunk, std::align_val_t(kChunkSize));
+    }
+
+    /// \brief Take blocks from the chunks. The mutex must be locked.
+    /// \param[in] _count Number of blocks.
+    /// \return The blocks, linked through FreeBlock::next.
+    FreeBlock *Take(std::size_t _count)
+    {
+      FreeBlock *blocks{nullptr};
+      for (std::size_t i = 0; i < _count; ++i)
+      {
+        if (nullptr == this->available)
+          this->Grow();
+
+        Chunk *chunk = this->available;
+        FreeBlock *block = chunk->freeList;
+        chunk->freeList = block->next;
+        if (0 == chunk->used++)
+          --this->emptyChunks;
+
+        // Full chunks leave the available list
+        if (nullptr == chunk->freeList)
+          this->Unlink(chunk);
+
+        block->next = blocks;
+        blocks = block;
+      }
+      return blocks;
+    }
+
+    /// \brief Give blocks back to their chunks. The mutex must be locked.
+    /// \param[in] _blocks Blocks, linked through FreeBlock::next.
+    void Give(FreeBlock *_blocks)
+    {
+      while (nullptr != _blocks)
+      {
+        FreeBlock *block = _blocks;
+        _blocks = block->next;
+
+        auto chunk = reinterpret_cast<Chunk *>(
+            reinterpret_cast<std::uintptr_t>(block) & ~(kChunkSize - 1));
+
+        // Full chunks come back to the available list
+        if (nullptr == chunk->freeList)
+          this->Push(chunk);
+
+        block->next = chunk->freeList;
+        chunk->freeList = block;
+
+        if (0 == --chunk->used)
+        {
+          ++this->emptyChunks;
+          if (this->emptyChunks > kMaxEmptyChunks)
+            this->Release(chunk);
+        }
+      }
+    }
+  };
+
+  /// \brief All size classes.
+  class Pool
+  {
+    /// \brief Constructor
+    public: Pool()
+    {
+      for (std::size_t i = 0; i < kSizeClassCount; ++i)
+      {
+        this->sizeClasses[i].index = i;
+        this->sizeClasses[i].blockSize = (i + 1) * kGranularity;
+      }
+    }
+
+    /// \brief Get the size class that serves a size.
+    /// \param[in] _size Size in bytes, up to kMaxBlockSize.
+    /// \return The size class.
+    public: SizeClass &Find(std::size_t _size)
+    {
+      const std::size_t index = _size == 0 ? 0 :
+          (_size + kGranularity - 1) / kGranularity - 1;
+      return this->sizeClasses[index];
+    }
+
+    /// \brief One size class per block size.
+    public: std::array<SizeClass, kSizeClassCount> sizeClasses;
+  };
+
+  /// \brief Get the pool. It's never destroyed, because components may
+  /// outlive any static object.
+  /// \return The pool.
+  Pool &pool()
+  {
+    static Pool *instance = new Pool();
+    return *instance;
+  }
+
+  /// \brief Free blocks held by one thread, so that most allocations and
+  /// deallocations don't lock the shared size classes.
+  class ThreadCache
+  {
+    /// \brief Destructor, gives the blocks back when the thread exits.
+    public: ~ThreadCache();
+
+    /// \brief Give all blocks back to the shared size classes.
+    public: void Flush()
+    {
+      for (auto &sizeClass : pool().sizeClasses)
+      {
+        if (nullptr == this->blocks[sizeClass.index])
+          continue;
+
+        std::lock_guard<std::mutex> lock(sizeClass.mutex);
+        sizeClass.Give(this->blocks[sizeClass.index]);
+        this->blocks[sizeClass.index] = nullptr;
+        this->counts[sizeClass.index] = 0;
+      }
+    }
+
+    /// \brief Free blocks of each size class.
+    public: std::array<FreeBlock *, kSizeClassCount> blocks{};
+
+    /// \brief Number of free blocks of each size class.
+    public: std::array<std::size_t, kSizeClassCount> counts{};
+  };
+
+  /// \brief Whether the calling thread's cache was destroyed, in which case
+  /// the thread uses the shared size classes directly.
+  thread_local bool tlCacheDestroyed{false};
+
+  //////////////////////////////////////////////////
+  ThreadCache::~ThreadCache()
+  {
+    this->Flush();
+    tlCacheDestroyed = true;
+  }
+
+  /// \brief Get the calling thread's cache.
+  /// \return The cache, or nullptr if the thread is exiting.
+  ThreadCache *threadCache()
+  {
+    if (tlCacheDestroyed)
+      return nullptr;
+    thread_local ThreadCache cache;
+    return &cache;
+  }
+}
+
+//////////////////////////////////////////////////
+void *ComponentPool::Allocate(std::size_t _size)
+{
+  if (_size > kMaxBlockSize)
+    return ::operator new(_size);
+
+  SizeClass &sizeClass = pool().Find(_size);
+  sizeClass.allocations.fetch_add(1, std::memory_order_relaxed);
+
+  ThreadCache *cache = threadCache();
+  if (nullptr == cache)
+  {
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    return sizeClass.Take(1);
+  }
+
+  // Refill the cache with a batch
+  FreeBlock *&blocks = cache->blocks[sizeClass.index];
+  if (nullptr == blocks)
+  {
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    blocks = sizeClass.Take(kCacheBatch);
+    cache->counts[sizeClass.index] = kCacheBatch;
+  }
+
+  FreeBlock *block = blocks;
+  blocks = block->next;
+  --cache->counts[sizeClass.index];
+  return block;
+}
+
+//////////////////////////////////////////////////
+void ComponentPool::Deallocate(void *_ptr, std::size_t _size) noexcept
+{
+  if (nullptr == _ptr)
+    return;
+
+  if (_size > kMaxBlockSize)
+  {
+    ::operator delete(_ptr);
+    return;
+  }
+
+  auto chunk = reinterpret_cast<Chunk *>(
+      reinterpret_cast<std::uintptr_t>(_ptr) & ~(kChunkSize - 1));
+  SizeClass &sizeClass = *chunk->sizeClass;
+  sizeClass.deallocations.fetch_add(1, std::memory_order_relaxed);
+
+  auto block = static_cast<FreeBlock *>(_ptr);
+  ThreadCache *cache = threadCache();
+  if (nullptr == cache)
+  {
+    block->next = nullptr;
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    sizeClass.Give(block);
+    return;
+  }
+
+  FreeBlock *&blocks = cache->blocks[sizeClass.index];
+  block->next = blocks;
+  blocks = block;
+
+  // Give a batch back once the cache holds too many
+  std::size_t &count = cache->counts[sizeClass.index];
+  if (++count > kMaxCachedBlocks)
+  {
+    FreeBlock *last = blocks;
+    for (std::size_t i = 1; i < kCacheBatch; ++i)
+      last = last->next;
+    FreeBlock *batch = blocks;
+    blocks = last->next;
+    last->next = nullptr;
+    count -= kCacheBatch;
+
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    sizeClass.Give(batch);
+  }
+}
+
+//////////////////////////////////////////////////
+std::vector<ComponentPoolStats> ComponentPool::Stats()
+{
+  std::vector<ComponentPoolStats> result;
+  for (auto &sizeClass : pool().sizeClasses)
+  {
+    const uint64_t allocations =
+        sizeClass.allocations.load(std::memory_order_relaxed);
+    if (0 == allocations)
+      continue;
+    const uint64_t deallocations =
+        sizeClass.deallocations.load(std::memory_order_relaxed);
+
+    ComponentPoolStats stats;
+    stats.blockSize = sizeClass.blockSize;
+    stats.blocksPerChunk = sizeClass.BlocksPerChunk();
+    {
+      std::lock_guard<std::mutex> lock(sizeClass.mutex);
+      stats.chunks = sizeClass.chunks;
+    }
+    stats.usedBlocks = static_cast<std::size_t>(
+        allocations - std::min(allocations, deallocations));
+    const std::size_t blocks = stats.chunks * stats.blocksPerChunk;
+    stats.freeBlocks = blocks - std::min(blocks, stats.usedBlocks);
+    stats.allocations = allocations;
+    stats.deallocations = deallocations;
+    result.push_back(stats);
+  }
+  return result;
+}
+
+//////////////////////////////////////////////////
+std::size_t ComponentPool::Trim()
+{
+  ThreadCache *cache = threadCache();
+  if (nullptr != cache)
+    cache->Flush();
+
+  std::size_t released{0};
+  for (auto &sizeClass : pool().sizeClasses)
+  {
+    std::lock_guard<std::mutex> lock(sizeClass.mutex);
+    Chunk *chunk = sizeClass.available;
+    while (nullptr != chunk && sizeClass.emptyChunks > 0)
+    {
+      Chunk *next = chunk->next;
+      if (0 == chunk->used)
+      {
+        sizeClass.Release(chunk);
+        released += kChunkSize;
+      }
+      chunk = next;
+    }
+  }
+  return released;
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "ignition/gazebo/components/Component.hh"
+#include "ignition/gazebo/components/ComponentPool.hh"
+#include "ignition/gazebo/components/Factory.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+// A data size which no other component in this test uses, so that its block
+// size isn't shared.
+using PooledComponent = components::Component<std::array<char, 200>,
+    class PooledComponentTag>;
+IGN_GAZEBO_REGISTER_COMPONENT("ign_gazebo_components.PooledComponent",
+    PooledComponent)
+
+using LargeComponent = components::Component<std::array<char, 4096>,
+    class LargeComponentTag>;
+IGN_GAZEBO_REGISTER_COMPONENT("ign_gazebo_components.LargeComponent",
+    LargeComponent)
+
+/////////////////////////////////////////////////
+/// \brief Get the statistics of a block size.
+/// \param[in] _size Component size.
+/// \return Statistics, or default ones if the size isn't used.
+components::ComponentPoolStats statsFor(std::size_t _size)
+{
+  for (const auto &stats : components::ComponentPool::Stats())
+  {
+    if (stats.blockSize >= _size && stats.blockSize < _size + 16)
+      return stats;
+  }
+  return components::ComponentPoolStats();
+}
+
+/////////////////////////////////////////////////
+TEST(ComponentPool, AllocateDeallocate)
+{
+  const std::size_t size = sizeof(PooledComponent);
+  ASSERT_LE(size, components::ComponentPool::kMaxBlockSize);
+  components::ComponentPool::Trim();
+  auto before = statsFor(size);
+
+  // Components created through the factory come from the pool
+  PooledComponent data;
+  data.Data()[0] = 'a';
+  auto comp = components::Factory::Instance()->New(PooledComponent::typeId,
+      &data);
+  ASSERT_NE(nullptr, comp);
+  EXPECT_EQ('a', static_cast<PooledComponent *>(comp.get())->Data()[0]);
+
+  auto stats = statsFor(size);
+  EXPECT_EQ(0u, stats.blockSize % 16);
+  EXPECT_EQ(before.usedBlocks + 1, stats.usedBlocks);
+  EXPECT_EQ(before.allocations + 1, stats.allocations);
+  EXPECT_GE(stats.chunks, 1u);
+  EXPECT_EQ(stats.chunks * stats.blocksPerChunk,
+      stats.usedBlocks + stats.freeBlocks);
+  EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(comp.get()) % 16);
+
+  comp.reset();
+  stats = statsFor(size);
+  EXPECT_EQ(before.usedBlocks, stats.usedBlocks);
+  EXPECT_EQ(before.deallocations + 1, stats.deallocations);
+}
+
+/////////////////////////////////////////////////
+TEST(ComponentPool, ReleaseChunks)
+{
+  const std::size_t size = sizeof(PooledComponent);
+  components::ComponentPool::Trim();
+  const auto before = statsFor(size);
+
+  // Fill several chunks
+  std::vector<std::unique_ptr<components::BaseComponent>> comps;
+  const std::size_t count = 3000;
+  for (std::size_t i = 0; i < count; ++i)
+    comps.push_back(std::make_unique<PooledComponent>());
+
+  auto stats = statsFor(size);
+  EXPECT_EQ(before.usedBlocks + count, stats.usedBlocks);
+  EXPECT_GT(stats.chunks, 1u);
+  const std::size_t peak = stats.chunks;
+
+  // Chunks are released as they empty, except for one spare and those the
+  // thread's cache still holds blocks of
+  comps.clear();
+  stats = statsFor(size);
+  EXPECT_EQ(before.usedBlocks, stats.usedBlocks);
+  EXPECT_LE(stats.chunks, before.chunks + 3);
+  EXPECT_LT(stats.chunks, peak);
+
+  components::ComponentPool::Trim();
+  stats = statsFor(size);
+  EXPECT_EQ(before.chunks, stats.chunks);
+}
+
+/////////////////////////////////////////////////
+TEST(ComponentPool, Large)
+{
+  ASSERT_GT(sizeof(LargeComponent), components::ComponentPool::kMaxBlockSize);
+
+  uint64_t allocations{0};
+  for (const auto &stats : components::ComponentPool::Stats())
+    allocations += stats.allocations;
+
+  // Large components use the system allocator
+  auto comp = std::make_unique<LargeComponent>();
+  comp->Data()[4095] = 'z';
+  EXPECT_EQ('z', comp->Data()[4095]);
+
+  uint64_t allocationsAfter{0};
+  for (const auto &stats : components::ComponentPool::Stats())
+    allocationsAfter += stats.allocations;
+  EXPECT_EQ(allocations, allocationsAfter);
+}
+
+/////////////////////////////////////////////////
+TEST(ComponentPool, Threads)
+{
+  const std::size_t size = sizeof(PooledComponent);
+  components::ComponentPool::Trim();
+  const auto before = statsFor(size);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([]()
+    {
+      std::vector<std::unique_ptr<components::BaseComponent>> comps;
+      for (int round = 0; round < 10; ++round)
+      {
+        for (int i = 0; i < 500; ++i)
+          comps.push_back(std::make_unique<PooledComponent>());
+        comps.clear();
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  EXPECT_EQ(before.usedBlocks, statsFor(size).usedBlocks);
+
+  // Components freed by another thread than the one which allocated them
+  std::vector<std::unique_ptr<components::BaseComponent>> comps;
+  for (int i = 0; i < 500; ++i)
+    comps.push_back(std::make_unique<PooledComponent>());
+  std::thread([&comps]()
+  {
+    comps.clear();
+  }).join();
+  EXPECT_EQ(before.usedBlocks, statsFor(size).usedBlocks);
+
+  // Exited threads gave their cached blocks back
+  components::ComponentPool::Trim();
+  EXPECT_EQ(before.chunks, statsFor(size).chunks);
+}
@@ -19,12 +19,21 @@
 #include <ignition/msgs/int32.pb.h>
 
 #include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
 
 #include <sdf/Element.hh>
 #include <ignition/common/Console.hh>
+#include <ignition/math/Color.hh>
 #include <ignition/math/Inertial.hh>
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Vector2.hh>
+#include <ignition/math/Vector3.hh>
+#include <ignition/math/Vector4.hh>
 
 #include "ignition/gazebo/components/Component.hh"
+#include "ignition/gazebo/components/Factory.hh"
 #include "ignition/gazebo/components/Serialization.hh"
 #include "ignition/gazebo/components/Name.hh"
 #include "ignition/gazebo/EntityComponentManager.hh"
@@ -592,3 +601,226 @@ TEST_F(ComponentTest, Clone)
     EXPECT_NE(&comp, derivedClone);
   }
 }
+
+//////////////////////////////////////////////////
+TEST_F(ComponentTest, ComponentCopy)
+{
+  // Registered components with assignable data are copied by assignment
+  {
+    using Custom = components::Component<std::string, class CopyCustomTag>;
+    components::Factory::Instance()->Register<Custom>(
+        "ign_gazebo_components.CopyCustom",
+        new components::ComponentDescriptor<Custom>());
+
+    auto copy = components::ComponentCopy(Custom::typeId);
+    EXPECT_EQ(&components::CopyComponentData<Custom>, copy);
+
+    Custom comp("original");
+    Custom other("copied");
+    copy(comp, other);
+    EXPECT_EQ("copied", comp.Data());
+    EXPECT_EQ("copied", other.Data());
+
+    // The copy doesn't share data
+    other.Data() = "changed";
+    EXPECT_EQ("copied", comp.Data());
+
+    const auto typeId = Custom::typeId;
+    components::Factory::Instance()->Unregister<Custom>();
+    EXPECT_NE(&components::CopyComponentData<Custom>,
+        components::ComponentCopy(typeId));
+  }
+
+  // Other components are copied through their serialization
+  {
+    using Custom = components::Component<int, class UnregisteredCopyTag>;
+    auto copy = components::ComponentCopy(Custom::typeId);
+    ASSERT_NE(nullptr, copy);
+
+    Custom comp(1);
+    Custom other(2);
+    copy(comp, other);
+    EXPECT_EQ(2, comp.Data());
+  }
+}
+
+//////////////////////////////////////////////////
+TEST_F(ComponentTest, TagComponent)
+{
+  using Tag = components::Component<components::NoData, class TagTestTag>;
+  using Custom = components::Component<int, class TagTestCustomTag>;
+  static_assert(components::IsTagType<Tag>::value);
+  static_assert(!components::IsTagType<Custom>::value);
+
+  components::Factory::Instance()->Register<Tag>(
+      "ign_gazebo_components.TagTest",
+      new components::ComponentDescriptor<Tag>());
+  components::Factory::Instance()->Register<Custom>(
+      "ign_gazebo_components.TagTestCustom",
+      new components::ComponentDescriptor<Custom>());
+
+  const auto tagId = Tag::typeId;
+  EXPECT_TRUE(components::IsTagComponent(tagId));
+  EXPECT_FALSE(components::IsTagComponent(Custom::typeId));
+
+  components::Factory::Instance()->Unregister<Tag>();
+  components::Factory::Instance()->Unregister<Custom>();
+  EXPECT_FALSE(components::IsTagComponent(tagId));
+}
+
+//////////////////////////////////////////////////
+/// \brief Serialize a component's data and deserialize it into a new
+/// component.
+/// \param[in] _data Data to serialize.
+/// \param[out] _serialized Serialized data.
+/// \return Deserialized data.
+template <typename DataType>
+DataType roundTrip(const DataType &_data, std::string &_serialized)
+{
+  using Custom = components::Component<DataType, class RoundTripTag>;
+
+  Custom comp(_data);
+  std::ostringstream ostr;
+  comp.Serialize(ostr);
+  _serialized = ostr.str();
+
+  Custom result;
+  std::istringstream istr(_serialized);
+  result.Deserialize(istr);
+  return result.Data();
+}
+
+//////////////////////////////////////////////////
+TEST_F(ComponentTest, BinarySerialization)
+{
+  EXPECT_FALSE(serializers::BinarySerialization());
+  serializers::BinarySerializationScope binaryScope;
+  EXPECT_TRUE(serializers::BinarySerialization());
+
+  // Scopes can be nested
+  {
+    serializers::BinarySerializationScope nested;
+    EXPECT_TRUE(serializers::BinarySerialization());
+  }
+  EXPECT_TRUE(serializers::BinarySerialization());
+
+  // Other threads still write text
+  std::thread([]
+  {
+    EXPECT_FALSE(serializers::BinarySerialization());
+  }).join();
+
+  std::string serialized;
+
+  // Values that don't survive a text round trip
+  const double third = 1.0 / 3.0;
+  EXPECT_EQ(third, roundTrip(third, serialized));
+  ASSERT_EQ(1u + sizeof(double), serialized.size());
+  EXPECT_EQ(serializers::kBinarySerializationMarker, serialized[0]);
+
+  const float tenth = 0.1f;
+  EXPECT_EQ(tenth, roundTrip(tenth, serialized));
+  EXPECT_EQ(1u + sizeof(float), serialized.size());
+
+  EXPECT_EQ(-123456789, roundTrip(-123456789, serialized));
+  EXPECT_EQ(uint64_t{1} << 63, roundTrip(uint64_t{1} << 63, serialized));
+
+  EXPECT_TRUE(roundTrip(true, serialized));
+  EXPECT_EQ(2u, serialized.size());
+  EXPECT_FALSE(roundTrip(false, serialized));
+
+  enum class Fruit {kApple, kBanana};
+  EXPECT_EQ(Fruit::kBanana, roundTrip(Fruit::kBanana, serialized));
+
+  // Little-endian bytes
+  roundTrip(uint32_t{0x01020304}, serialized);
+  EXPECT_EQ(std::string("\0\x04\x03\x02\x01", 5), serialized);
+
+  // Trivially copyable types without stream operators
+  struct Plain
+  {
+    int a;
+    double b;
+  };
+  auto plain = roundTrip(Plain{3, third}, serialized);
+  EXPECT_EQ(3, plain.a);
+  EXPECT_EQ(third, plain.b);
+
+  // Math types
+  const math::Vector3d vec(third, -2, 1e300);
+  EXPECT_EQ(vec, roundTrip(vec, serialized));
+  EXPECT_EQ(1u + 3 * sizeof(double), serialized.size());
+
+  const math::Vector2d vec2(third, 2);
+  EXPECT_EQ(vec2, roundTrip(vec2, serialized));
+
+  const math::Vector4d vec4(third, 2, 3, 4);
+  EXPECT_EQ(vec4, roundTrip(vec4, serialized));
+
+  const math::Pose3d pose(third, 2, 3, 0.1, 0.2, third);
+  const auto posePrime = roundTrip(pose, serialized);
+  EXPECT_EQ(1u + 7 * sizeof(double), serialized.size());
+  EXPECT_EQ(pose.Pos(), posePrime.Pos());
+  EXPECT_DOUBLE_EQ(pose.Rot().W(), posePrime.Rot().W());
+  EXPECT_DOUBLE_EQ(pose.Rot().X(), posePrime.Rot().X());
+  EXPECT_DOUBLE_EQ(pose.Rot().Y(), posePrime.Rot().Y());
+  EXPECT_DOUBLE_EQ(pose.Rot().Z(), posePrime.Rot().Z());
+
+  const math::Color color(0.1f, 0.2f, 0.3f, 0.4f);
+  EXPECT_EQ(color, roundTrip(color, serialized));
+
+  // Types without a binary encoding still use text
+  EXPECT_EQ("banana", roundTrip(std::string("banana"), serialized));
+  EXPECT_EQ("banana", serialized);
+
+  // Truncated data leaves the component unchanged
+  {
+    using Custom = components::Component<math::Vector3d, class TruncatedTag>;
+    Custom comp(math::Vector3d(1, 2, 3));
+    std::istringstream istr(std::string("\0\0\0\0", 4));
+    comp.Deserialize(istr);
+    EXPECT_EQ(math::Vector3d(1, 2, 3), comp.Data());
+  }
+}
+
+//////////////////////////////////////////////////
+TEST_F(ComponentTest, TextSerializationCompatibility)
+{
+  using Custom = components::Component<math::Vector3d, class CustomTag>;
+
+  // Text written by older versions is still read
+  {
+    Custom comp;
+    std::istringstream istr("1 2 3");
+    comp.Deserialize(istr);
+    EXPECT_EQ(math::Vector3d(1, 2, 3), comp.Data());
+  }
+
+  // Text is written by default, since serialized components are stored in
+  // protobuf string fields which must be valid UTF-8
+  EXPECT_FALSE(serializers::BinarySerialization());
+  {
+    Custom comp(math::Vector3d(1, 2, 3));
+    std::ostringstream ostr;
+    comp.Serialize(ostr);
+    EXPECT_EQ("1 2 3", ostr.str());
+
+    std::string serialized;
+    EXPECT_EQ(0.25, roundTrip(0.25, serialized));
+    EXPECT_EQ("0.25", serialized);
+  }
+
+  // Binary data is read regardless of the scope
+  std::string binary;
+  {
+    serializers::BinarySerializationScope binaryScope;
+    roundTrip(math::Vector3d(4, 5, 6), binary);
+  }
+  ASSERT_FALSE(binary.empty());
+  EXPECT_EQ(serializers::kBinarySerializationMarker, binary[0]);
+
+  Custom other;
+  std::istringstream istr(binary);
+  other.Deserialize(istr);
+  EXPECT_EQ(math::Vector3d(4, 5, 6), other.Data());
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "ignition/gazebo/EntityCommandBuffer.hh"
+
+#include <utility>
+#include <vector>
+
+#include <ignition/common/Profiler.hh>
+
+using namespace ignition;
+using namespace gazebo;
+
+class ignition::gazebo::EntityCommandBufferPrivate
+{
+  /// \brief Pointer to entity component manager. We don't assume ownership.
+  public: EntityComponentManager *ecm{nullptr};
+
+  /// \brief Recorded commands, in order.
+  public: std::vector<std::function<void(EntityComponentManager &)>> commands;
+};
+
+//////////////////////////////////////////////////
+EntityCommandBuffer::EntityCommandBuffer(EntityComponentManager &_ecm)
+  : dataPtr(std::make_unique<EntityCommandBufferPrivate>())
+{
+  this->dataPtr->ecm = &_ecm;
+}
+
+//////////////////////////////////////////////////
+EntityCommandBuffer::~EntityCommandBuffer() = default;
+
+//////////////////////////////////////////////////
+Entity EntityCommandBuffer::CreateEntity()
+{
+  Entity entity = this->dataPtr->ecm->ReserveEntity();
+  if (kNullEntity == entity)
+    return entity;
+
+  this->AddCommand([entity](EntityComponentManager &_ecm)
+  {
+    _ecm.CreateReservedEntity(entity);
+  });
+  return entity;
+}
+
+//////////////////////////////////////////////////
+void EntityCommandBuffer::SetParentEntity(const Entity _child,
+    const Entity _parent)
+{
+  this->AddCommand([_child, _parent](EntityComponentManager &_ecm)
+  {
+    _ecm.SetParentEntity(_child, _parent);
+  });
+}
+
+//////////////////////////////////////////////////
+void EntityCommandBuffer::RequestRemoveEntity(const Entity _entity,
+    bool _recursive)
+{
+  this->AddCommand([_entity, _recursive](EntityComponentManager &_ecm)
+  {
+    _ecm.RequestRemoveEntity(_entity, _recursive);
+  });
+}
+
+//////////////////////////////////////////////////
+void EntityCommandBuffer::AddCommand(
+    std::function<void(EntityComponentManager &)> _command)
+{
+  this->dataPtr->commands.push_back(std::move(_command));
+}
+
+//////////////////////////////////////////////////
+std::size_t EntityCommandBuffer::Size() const
+{
+  return this->dataPtr->commands.size();
+}
+
+//////////////////////////////////////////////////
+bool EntityCommandBuffer::Empty() const
+{
+  return this->dataPtr->commands.empty();
+}
+
+//////////////////////////////////////////////////
+void EntityCommandBuffer::Apply()
+{
+  if (this->dataPtr->commands.empty())
+    return;
+
+  IGN_PROFILE("EntityCommandBuffer::Apply");
+
+  // Move the commands out first, so that commands which record more commands
+  // don't invalidate the iteration. Those are applied on the next call.
+  std::vector<std::function<void(EntityComponentManager &)>> commands;
+  commands.swap(this->dataPtr->commands);
+  for (auto &command : commands)
+    command(*this->dataPtr->ecm);
+
+  // Keep the storage for the next commands, unless new ones were recorded
+  commands.clear();
+  if (this->dataPtr->commands.empty())
+    this->dataPtr->commands.swap(commands);
+}
+
+//////////////////////////////////////////////////
+void EntityCommandBuffer::Clear()
+{
+  this->dataPtr->commands.clear();
+}
@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "ignition/gazebo/components/Factory.hh"
+#include "ignition/gazebo/components/Name.hh"
+#include "ignition/gazebo/EntityCommandBuffer.hh"
+#include "ignition/gazebo/EntityComponentManager.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+using IntComponent = components::Component<int, class IntComponentTag>;
+IGN_GAZEBO_REGISTER_COMPONENT("ign_gazebo_components.IntComponent",
+    IntComponent)
+
+class EntityCompMgrTest : public EntityComponentManager
+{
+  public: using EntityComponentManager::CommandScope;
+
+  public: void RunApplyCommandBuffers()
+  {
+    this->ApplyCommandBuffers();
+  }
+  public: void ProcessEntityRemovals()
+  {
+    this->ProcessRemoveEntityRequests();
+  }
+};
+
+//////////////////////////////////////////////////
+TEST(EntityCommandBuffer, Commands)
+{
+  EntityCompMgrTest ecm;
+  Entity parent = ecm.CreateEntity();
+  Entity other = ecm.CreateEntity();
+  ecm.CreateComponent(other, IntComponent(1));
+
+  EntityCommandBuffer buffer(ecm);
+  EXPECT_TRUE(buffer.Empty());
+
+  // The ID is reserved, but the entity doesn't exist yet
+  Entity child = buffer.CreateEntity();
+  EXPECT_NE(kNullEntity, child);
+  EXPECT_FALSE(ecm.HasEntity(child));
+  EXPECT_NE(child, ecm.CreateEntity());
+
+  buffer.CreateComponent(child, components::Name("child"));
+  buffer.CreateComponent(child, IntComponent(5));
+  buffer.SetParentEntity(child, parent);
+  buffer.RemoveComponent<IntComponent>(other);
+  EXPECT_EQ(5u, buffer.Size());
+
+  // Nothing changes until the buffer is applied
+  EXPECT_NE(nullptr, ecm.Component<IntComponent>(other));
+
+  buffer.Apply();
+  EXPECT_TRUE(buffer.Empty());
+  EXPECT_TRUE(ecm.HasEntity(child));
+  EXPECT_EQ(parent, ecm.ParentEntity(child));
+  ASSERT_NE(nullptr, ecm.Component<components::Name>(child));
+  EXPECT_EQ("child", ecm.Component<components::Name>(child)->Data());
+  ASSERT_NE(nullptr, ecm.Component<IntComponent>(child));
+  EXPECT_EQ(5, ecm.Component<IntComponent>(child)->Data());
+  EXPECT_EQ(nullptr, ecm.Component<IntComponent>(other));
+
+  buffer.RequestRemoveEntity(parent);
+  buffer.Apply();
+  ecm.ProcessEntityRemovals();
+  EXPECT_FALSE(ecm.HasEntity(parent));
+  EXPECT_FALSE(ecm.HasEntity(child));
+
+  // Cleared commands are dropped
+  Entity dropped = buffer.CreateEntity();
+  buffer.Clear();
+  buffer.Apply();
+  EXPECT_FALSE(ecm.HasEntity(dropped));
+}
+
+//////////////////////////////////////////////////
+TEST(EntityCommandBuffer, PerThread)
+{
+  EntityCompMgrTest ecm;
+  EXPECT_EQ(&ecm.CommandBuffer(), &ecm.CommandBuffer());
+
+  const int kThreads{4};
+  const int kPerThread{100};
+  std::vector<std::vector<Entity>> created(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t)
+  {
+    threads.emplace_back([&, t]()
+    {
+      auto &buffer = ecm.CommandBuffer();
+      for (int i = 0; i < kPerThread; ++i)
+      {
+        Entity entity = buffer.CreateEntity();
+        buffer.CreateComponent(entity, IntComponent(t));
+        created[t].push_back(entity);
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  EXPECT_EQ(0u, ecm.EntityCount());
+  ecm.RunApplyCommandBuffers();
+  EXPECT_EQ(static_cast<std::size_t>(kThreads * kPerThread),
+      ecm.EntityCount());
+
+  // Reserved IDs are unique across threads
+  std::set<Entity> unique;
+  for (int t = 0; t < kThreads; ++t)
+  {
+    for (const Entity entity : created[t])
+    {
+      unique.insert(entity);
+      ASSERT_NE(nullptr, ecm.Component<IntComponent>(entity));
+      EXPECT_EQ(t, ecm.Component<IntComponent>(entity)->Data());
+    }
+  }
+  EXPECT_EQ(static_cast<std::size_t>(kThreads * kPerThread), unique.size());
+
+  // Buffers are emptied
+  ecm.RunApplyCommandBuffers();
+  EXPECT_EQ(static_cast<std::size_t>(kThreads * kPerThread),
+      ecm.EntityCount());
+}
+
+//////////////////////////////////////////////////
+TEST(EntityCommandBuffer, Order)
+{
+  EntityCompMgrTest ecm;
+
+  // Applied buffers are reused
+  auto *first = &ecm.CommandBuffer();
+  first->CreateEntity();
+  ecm.RunApplyCommandBuffers();
+  EXPECT_TRUE(first->Empty());
+  EXPECT_EQ(first, &ecm.CommandBuffer());
+  ecm.RunApplyCommandBuffers();
+
+  // Scoped buffers are applied in the order of their keys, whichever thread
+  // records first, then unscoped ones
+  const int kThreads{4};
+  std::vector<int> applied;
+  auto record = [&](int _value)
+  {
+    ecm.CommandBuffer().AddCommand([&applied, _value](
+        EntityComponentManager &)
+    {
+      applied.push_back(_value);
+    });
+  };
+
+  std::thread unscoped([&]()
+  {
+    record(-1);
+  });
+  unscoped.join();
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t)
+  {
+    threads.emplace_back([&, t]()
+    {
+      EntityCompMgrTest::CommandScope scope(kThreads - t);
+      record(t);
+      {
+        EntityCompMgrTest::CommandScope inner(0);
+        record(t + 10);
+      }
+      record(t);
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+
+  ecm.RunApplyCommandBuffers();
+  const std::vector<int> expected{3, 3, 13, 2, 2, 12, 1, 1, 11, 0, 0, 10,
+      -1};
+  EXPECT_EQ(expected, applied);
+}
@@ -17,34 +17,153 @@
 
 #include "ignition/gazebo/EntityComponentManager.hh"
 
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <functional>
+#include <istream>
+#include <limits>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <ostream>
 #include <set>
+#include <shared_mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include <ignition/common/Profiler.hh>
-#include <ignition/math/graph/GraphAlgorithms.hh>
 
+#include "ignition/gazebo/EntityCommandBuffer.hh"
 #include "ignition/gazebo/components/CanonicalLink.hh"
 #include "ignition/gazebo/components/ChildLinkName.hh"
 #include "ignition/gazebo/components/Component.hh"
+#include "ignition/gazebo/components/ComponentPool.hh"
 #include "ignition/gazebo/components/Factory.hh"
 #include "ignition/gazebo/components/Joint.hh"
 #include "ignition/gazebo/components/Link.hh"
 #include "ignition/gazebo/components/Name.hh"
 #include "ignition/gazebo/components/ParentEntity.hh"
 #include "ignition/gazebo/components/ParentLinkName.hh"
+#include "ignition/gazebo/components/Pose.hh"
 #include "ignition/gazebo/components/Recreate.hh"
 #include "ignition/gazebo/components/World.hh"
 
+#include "ArchetypeStorage.hh"
+#include "ChangeTracker.hh"
+#include "MemoryStreamBuf.hh"
+#include "WorkStealingPool.hh"
+
 using namespace ignition;
 using namespace gazebo;
 
+/// \brief When removing entities, views with up to this many times as many
+/// entities as are removed are swept once instead of having each entity
+/// looked up.
+static constexpr std::size_t kViewSweepRatio{4};
+
+/// \brief Last epoch given to a set of views. It's shared by all entity
+/// component managers, so that an epoch identifies both the manager and the
+/// state of its views.
+static std::atomic<uint64_t> lastViewsEpoch{0};
+
+/// \brief Keys of the command scopes the calling thread is in, outermost
+/// first, see EntityComponentManager::CommandScope.
+static thread_local std::vector<uint64_t> tlCommandScope;
+
+/// \brief Replaces the calling thread's command scopes for its lifetime, for
+/// tasks which may run on any thread.
+class CommandScopeOverride
+{
+  /// \brief Constructor
+  /// \param[in] _scope Command scopes for the lifetime of this object.
+  public: explicit CommandScopeOverride(std::vector<uint64_t> _scope)
+    : previous(std::move(_scope))
+  {
+    this->previous.swap(tlCommandScope);
+  }
+
+  /// \brief Destructor, restores the previous scopes.
+  public: ~CommandScopeOverride()
+  {
+    this->previous.swap(tlCommandScope);
+  }
+
+  /// \brief Scopes to restore.
+  private: std::vector<uint64_t> previous;
+};
+
+/// \brief Position of an entity in the entity tree. The children of an
+/// entity form a doubly linked list through their siblings, so attaching and
+/// detaching take constant time and don't allocate.
+struct HierarchyNode
+{
+  /// \brief Parent, or kNullEntity.
+  Entity parent{kNullEntity};
+
+  /// \brief First child, or kNullEntity.
+  Entity firstChild{kNullEntity};
+
+  /// \brief Last child, or kNullEntity.
+  Entity lastChild{kNullEntity};
+
+  /// \brief Previous child of the parent, or kNullEntity.
+  Entity prevSibling{kNullEntity};
+
+  /// \brief Next child of the parent, or kNullEntity.
+  Entity nextSibling{kNullEntity};
+};
+
+/// \brief Cached world pose of an entity.
+struct WorldPoseEntry
+{
+  /// \brief Pose in the world frame.
+  math::Pose3d pose;
+
+  /// \brief False if the entity has no components::Pose. Such entries are
+  /// kept so that giving the entity a pose invalidates its descendants,
+  /// whose poses stopped at it.
+  bool hasPose{false};
+
+  /// \brief False if the pose must be computed again.
+  bool valid{false};
+};
+
+/// \brief Index of the values of a component type.
+struct ValueIndex
+{
+  /// \brief Hashes the data of a component.
+  std::function<std::size_t(const components::BaseComponent &)> hash;
+
+  /// \brief Entities which have the component, by value hash.
+  std::unordered_map<std::size_t, std::set<Entity>> buckets;
+
+  /// \brief Value hash of each indexed entity, to find its bucket.
+  EntityIndex<std::size_t> keys;
+};
+
+/// \brief Copy of the entities and components of an entity component
+/// manager, see EntityComponentManager::Snapshot.
+class ignition::gazebo::EntityComponentManagerSnapshot
+{
+  /// \brief Last entity ID given by the manager.
+  public: uint64_t entityCount{0};
+
+  /// \brief Entities with clones of their components, grouped by archetype.
+  public: std::vector<Archetype> archetypes;
+
+  /// \brief Parent of each entity, in the same order as `archetypes`.
+  public: std::vector<std::vector<Entity>> parents;
+
+  /// \brief All entities in `archetypes`.
+  public: detail::EntityBitmap entities{std::vector<Entity>()};
+};
+
 class ignition::gazebo::EntityComponentManagerPrivate
 {
   /// \brief Implementation of the CreateEntity function, which takes a specific
@@ -67,9 +186,23 @@ class ignition::gazebo::EntityComponentManagerPrivate
   public: void EraseEntityRecursive(Entity _entity,
       std::unordered_set<Entity> &_set);
 
+  /// \brief Entities cached for the `State` function, split into ranges
+  /// that are serialized in parallel.
+  public: struct StateRanges
+  {
+    /// \brief All entities in the storage.
+    std::vector<Entity> entities;
+
+    /// \brief Indices into `entities` marking the evenly distributed
+    /// ranges of entities that each task in the `State` function processes.
+    std::vector<std::size_t> bounds;
+  };
+
   /// \brief Allots the work for multiple threads prior to running
   /// `AddEntityToMessage`.
-  public: void CalculateStateThreadLoad();
+  /// \return The entities and their ranges. They stay valid for the
+  /// caller even if another call recalculates them.
+  public: std::shared_ptr<const StateRanges> CalculateStateThreadLoad();
 
   /// \brief Create a message for the removed components
   /// \param[in] _entity Entity with the removed components
@@ -89,20 +222,69 @@ class ignition::gazebo::EntityComponentManagerPrivate
       msgs::SerializedStateMap &_msg,
       const std::unordered_set<ComponentTypeId> &_types = {});
 
+  /// \brief Remove a child from its parent's children.
+  /// \param[in] _child Child entity.
+  public: void Detach(const Entity _child);
+
+  /// \brief Remove an entity from the entity tree. Its children are left
+  /// without a parent.
+  /// \param[in] _entity Entity.
+  public: void RemoveFromHierarchy(const Entity _entity);
+
+  /// \brief Get the entity after another in a depth-first, pre-order
+  /// traversal of a subtree.
+  /// \param[in] _root Root of the subtree.
+  /// \param[in] _entity Current entity, which is in the subtree.
+  /// \return The next entity, or kNullEntity at the end of the subtree.
+  public: Entity NextDescendant(const Entity _root, const Entity _entity) const;
+
+  /// \brief Build `entities` from `hierarchy`.
+  public: void RebuildEntityGraph() const;
+
+  /// \brief Invalidate the cached world poses affected by the changes since
+  /// the cache was last refreshed. Must be called with worldPoseMutex
+  /// locked exclusively.
+  public: void RefreshWorldPoses();
+
+  /// \brief Invalidate the cached world pose of an entity and of all its
+  /// descendants.
+  /// \param[in] _entity Entity.
+  public: void InvalidateWorldPoses(const Entity _entity);
+
+  /// \brief Get the world pose of an entity, computing it and the world
+  /// poses of its ancestors if they aren't cached. Must be called with
+  /// worldPoseMutex locked exclusively, after RefreshWorldPoses.
+  /// \param[in] _entity Entity.
+  /// \return The cache entry, or nullptr if the entity has no pose.
+  public: const WorldPoseEntry *ComputeWorldPose(const Entity _entity);
+
+  /// \brief Apply the changes since the value indexes were last refreshed
+  /// to them. Must be called with valueIndexMutex locked exclusively.
+  public: void RefreshValueIndexes();
+
+  /// \brief Update the entry of an entity in a value index from its
+  /// current component, removing the entry if it doesn't have one.
+  /// \param[in] _typeId Component type of the index.
+  /// \param[in] _index Index.
+  /// \param[in] _entity Entity.
+  public: void UpdateValueIndex(const ComponentTypeId _typeId,
+      ValueIndex &_index, const Entity _entity);
+
+  /// \brief Remove an entity from a value index.
+  /// \param[in] _index Index.
+  /// \param[in] _entity Entity.
+  public: void EraseFromValueIndex(ValueIndex &_index, const Entity _entity);
+
   /// \brief Add newly modified (created/modified/removed) components to
   /// modifiedComponents list. The entity is added to the list when it is not
   /// a newly created entity or is not an entity to be removed
   /// \param[in] _entity Entity that has component newly modified
   public: void AddModifiedComponent(const Entity &_entity);
 
-  /// \brief Check whether a component is marked as a component that is
-  /// currently removed or not.
-  /// \param[in] _entity The entity
-  /// \param[in] _typeId The type ID for the component that belongs to _entity
-  /// \return True if _entity has a component of type _typeId that is currently
-  /// removed. False otherwise
-  public: bool ComponentMarkedAsRemoved(const Entity _entity,
-              const ComponentTypeId _typeId) const;
+  /// \brief Mark the entities whose components moved in the storage, see
+  /// ArchetypeStorage::Relocated, to be updated in the views which hold
+  /// them, so that the views don't keep pointers to the old addresses.
+  public: void UpdateRelocatedEntities();
 
   /// \brief Set a cloned joint's parent or child link name.
   /// \param[in] _joint The cloned joint.
@@ -123,9 +305,20 @@ class ignition::gazebo::EntityComponentManagerPrivate
   /// \brief All component types that have ever been created.
   public: std::unordered_set<ComponentTypeId> createdCompTypes;
 
+  /// \brief Parent and children of every entity.
+  public: EntityIndex<HierarchyNode> hierarchy;
+
   /// \brief A graph holding all entities, arranged according to their
-  /// parenting.
-  public: EntityGraph entities;
+  /// parenting. It's only built from `hierarchy` when requested through
+  /// Entities(), so that creating, removing and parenting entities doesn't
+  /// have to update it.
+  public: mutable EntityGraph entities;
+
+  /// \brief True if `entities` must be built again.
+  public: mutable bool entitiesDirty{false};
+
+  /// \brief Protects `entities` and `entitiesDirty`.
+  public: mutable std::mutex entitiesMutex;
 
   /// \brief Components that have been changed through a periodic change.
   /// The key is the type of component which has changed, and the value is the
@@ -151,6 +344,42 @@ class ignition::gazebo::EntityComponentManagerPrivate
   /// This is used for the ChangedState functions
   public: std::unordered_set<Entity> modifiedComponents;
 
+  /// \brief Ticks of the latest change of every entity and component, used
+  /// by ChangedStateSince. Unlike the sets above, it isn't reset every
+  /// iteration.
+  public: ChangeTracker changes;
+
+  /// \brief World poses computed by CachedWorldPose. The entry of an entity
+  /// is only valid if the entries of all its ancestors are valid.
+  public: EntityIndex<WorldPoseEntry> worldPoses;
+
+  /// \brief Change tick up to which changes were applied to `worldPoses`.
+  public: uint64_t worldPosesTick{0};
+
+  /// \brief True if CachedWorldPose caches poses, see EnableWorldPoseCache.
+  public: std::atomic<bool> worldPoseCache{false};
+
+  /// \brief Protects `worldPoses` and `worldPosesTick`, which are updated
+  /// by const functions that may be called from several threads.
+  public: std::shared_mutex worldPoseMutex;
+
+  /// \brief Value indexes enabled with EnableValueIndex, by component type.
+  public: std::unordered_map<ComponentTypeId, ValueIndex> valueIndexes;
+
+  /// \brief Change tick up to which changes were applied to `valueIndexes`.
+  public: uint64_t valueIndexesTick{0};
+
+  /// \brief Manager copied by the last call to Mirror.
+  public: const EntityComponentManager *mirrorSource{nullptr};
+
+  /// \brief Change tick of `mirrorSource` up to which changes were copied
+  /// by Mirror.
+  public: uint64_t mirrorTick{0};
+
+  /// \brief Protects `valueIndexes` and `valueIndexesTick`, which are
+  /// updated by const lookups that may be called from several threads.
+  public: std::shared_mutex valueIndexMutex;
+
   /// \brief Flag that indicates if all entities should be removed.
   public: bool removeAllEntities{false};
 
@@ -173,18 +402,39 @@ class ignition::gazebo::EntityComponentManagerPrivate
           std::pair<std::unique_ptr<detail::BaseView>,
             std::unique_ptr<std::mutex>>, detail::ComponentTypeHasher> views;
 
+  /// \brief Function that adds the waiting entities to each view, for the
+  /// views created through FindView.
+  public: std::unordered_map<detail::BaseView *,
+          void (*)(const EntityComponentManager &, detail::BaseView &)>
+          viewFlushFns;
+
+  /// \brief Epoch of the views, see ViewsEpoch. It changes whenever views
+  /// are destroyed.
+  public: std::atomic<uint64_t> viewsEpoch{++lastViewsEpoch};
+
   /// \brief A flag that indicates whether views should be locked while adding
   /// new entities to them or not.
   public: bool lockAddEntitiesToViews{false};
 
-  /// \brief Cache of previously queried descendants. The key is the parent
-  /// entity for which descendants were queried, and the value are all its
-  /// descendants.
-  public: mutable std::unordered_map<Entity, std::unordered_set<Entity>>
-          descendantCache;
-
   /// \brief Keep track of entities already used to ensure uniqueness.
-  public: uint64_t entityCount{0};
+  /// Atomic so that command buffers can reserve IDs from any thread.
+  public: std::atomic<uint64_t> entityCount{0};
+
+  /// \brief Command buffers requested since they were last applied, by the
+  /// key of the scope they were requested in, see CommandScope.
+  public: std::map<std::vector<uint64_t>,
+      std::unique_ptr<EntityCommandBuffer>> commandBuffers;
+
+  /// \brief Order of the first request of each thread outside any scope,
+  /// since the buffers were last applied.
+  public: std::unordered_map<std::thread::id, uint64_t> unscopedCommandBuffers;
+
+  /// \brief Applied command buffers, kept for reuse.
+  public: std::vector<std::unique_ptr<EntityCommandBuffer>> freeCommandBuffers;
+
+  /// \brief Protects `commandBuffers`, `unscopedCommandBuffers` and
+  /// `freeCommandBuffers`.
+  public: std::mutex commandBuffersMutex;
 
   /// \brief Unordered map of removed components. The key is the entity to
   /// which belongs the component, and the value is a set of the component types
@@ -192,50 +442,68 @@ class ignition::gazebo::EntityComponentManagerPrivate
   public: std::unordered_map<Entity, std::unordered_set<ComponentTypeId>>
     removedComponents;
 
-  /// \brief All components that have been removed. The difference between
-  /// removedComponents and componentsMarkedAsRemoved is that removedComponents
-  /// keeps track of components that were removed in the current simulation
-  /// step, while componentsMarkedAsRemoved keeps track of components that are
-  /// currently removed based on all simulation steps.
-  public: std::unordered_map<Entity, std::unordered_set<ComponentTypeId>>
-    componentsMarkedAsRemoved;
-
-  /// \brief A map of an entity to its components
-  public: std::unordered_map<Entity,
-           std::vector<std::unique_ptr<components::BaseComponent>>>
-             componentStorage;
-
-  /// \brief A map that keeps track of where each type of component is
-  /// located in the componentStorage vector. Since the componentStorage vector
-  /// is of type BaseComponent, we need to keep track of which component type
-  /// corresponds to a given index in the vector so that we can cast the
-  /// BaseComponent to this type if needed.
-  ///
-  /// The key of this map is the Entity, and the value is a map of the
-  /// component type to the corresponding index in the
-  /// componentStorage vector (a component of a particular type is
-  /// only a key for the value map if a component of this type exists in
-  /// the componentStorage vector)
+  /// \brief Storage for all entities and their components. Entities are
+  /// grouped by component signature into archetypes. Components removed
+  /// through RemoveComponent are kept by the storage until the entity is
+  /// removed, see ArchetypeStorage::RemoveComponent.
   ///
-  /// NOTE: Any modification of this data structure must be followed
-  /// by setting `componentTypeIndexDirty` to true.
-  public: std::unordered_map<Entity,
-           std::unordered_map<ComponentTypeId, std::size_t>>
-                                componentTypeIndex;
-
-  /// \brief A vector of iterators to evenly distributed spots in the
-  /// `componentTypeIndex` map.  Threads in the `State` function use this
-  /// vector for easy access of their pre-allocated work.  This vector
-  /// is recalculated if `componentTypeIndex` is changed (when
-  /// `componentTypeIndexDirty` == true).
-  public: std::vector<std::unordered_map<Entity,
-          std::unordered_map<ComponentTypeId, std::size_t>>::iterator>
-            componentTypeIndexIterators;
-
-  /// \brief True if the componentTypeIndex map was changed.  Primarily used
-  /// by the multithreading functionality in `State()` to allocate work to
-  /// each thread.
-  public: bool componentTypeIndexDirty{true};
+  /// NOTE: Any addition or removal of entities must be followed by setting
+  /// `stateEntitiesDirty` to true.
+  public: ArchetypeStorage storage;
+
+  /// \brief All entities in the storage, cached for the `State` function.
+  /// They're recalculated if entities are added or removed (when
+  /// `stateEntitiesDirty` == true). A recalculation creates new ranges, so
+  /// that `State` calls still using the old ones aren't affected.
+  public: std::shared_ptr<const StateRanges> stateRanges;
+
+  /// \brief Protects `stateRanges` and `stateEntitiesDirty` from
+  /// concurrent `State` calls.
+  public: std::mutex stateEntitiesMutex;
+
+  /// \brief Output buffers for the `State` function, one per range in
+  /// `stateThreadBounds`. Each task only writes to its own buffer, so they
+  /// need no locking.
+  public: using StateBuffers = std::vector<msgs::SerializedStateMap>;
+
+  /// \brief Get a set of state buffers that isn't in use by another `State`
+  /// call, creating one if needed.
+  /// \return The buffers, to be handed back through ReleaseStateBuffers.
+  public: std::unique_ptr<StateBuffers> AcquireStateBuffers();
+
+  /// \brief Return state buffers so that later `State` calls reuse their
+  /// allocations.
+  /// \param[in] _buffers Buffers obtained from AcquireStateBuffers.
+  public: void ReleaseStateBuffers(std::unique_ptr<StateBuffers> _buffers);
+
+  /// \brief State buffers that aren't in use. There's usually a single one,
+  /// but callers on different threads, such as the scene broadcaster and the
+  /// log recorder, may serialize at the same time.
+  public: std::vector<std::unique_ptr<StateBuffers>> freeStateBuffers;
+
+  /// \brief Protects `freeStateBuffers`.
+  public: std::mutex stateBuffersMutex;
+
+  /// \brief Get the worker pool used by parallel iteration, creating it if
+  /// needed.
+  /// \return The pool.
+  public: WorkStealingPool &Pool();
+
+  /// \brief Worker pool used by EachParallel, ForEachChunk and `State`.
+  /// It's either set by SetWorkerPool or `ownPool`.
+  public: WorkStealingPool *pool{nullptr};
+
+  /// \brief Pool owned by the manager, created the first time a pool is
+  /// needed if none was set.
+  public: std::unique_ptr<WorkStealingPool> ownPool;
+
+  /// \brief Makes sure the pool is only created once.
+  public: std::once_flag poolOnce;
+
+  /// \brief True if entities were added or removed since the thread load
+  /// was last calculated. Primarily used by the multithreading
+  /// functionality in `State()` to allocate work to each task.
+  public: std::atomic<bool> stateEntitiesDirty{true};
 
   /// \brief During cloning, we populate two maps:
   ///  - map of cloned model entities to the non-cloned model's canonical link
@@ -290,7 +558,7 @@ EntityComponentManager::~EntityComponentManager() = default;
 //////////////////////////////////////////////////
 size_t EntityComponentManager::EntityCount() const
 {
-  return this->dataPtr->entities.Vertices().size();
+  return this->dataPtr->storage.EntityCount();
 }
 
 /////////////////////////////////////////////////
@@ -308,38 +576,88 @@ Entity EntityComponentManager::CreateEntity()
   return this->dataPtr->CreateEntityImplementation(entity);
 }
 
+/////////////////////////////////////////////////
+std::vector<Entity> EntityComponentManager::CreateEntities(
+    const std::size_t _count)
+{
+  IGN_PROFILE("EntityComponentManager::CreateEntities");
+  std::vector<Entity> result;
+  if (0u == _count)
+    return result;
+
+  if (_count >= std::numeric_limits<uint64_t>::max() -
+      this->dataPtr->entityCount)
+  {
+    ignwarn << "Can't create [" << _count << "] entities, it would exceed the "
+            << "maximum number of entities." << std::endl;
+    return result;
+  }
+
+  this->ReserveEntities(_count);
+  result.reserve(_count);
+  for (std::size_t i = 0; i < _count; ++i)
+  {
+    Entity entity = ++this->dataPtr->entityCount;
+    this->dataPtr->hierarchy.Insert(entity, HierarchyNode());
+    this->dataPtr->changes.MarkEntityCreated(entity);
+    if (!this->dataPtr->storage.AddEntity(entity))
+    {
+      ignwarn << "Attempted to add entity [" << entity
+        << "] to component storage, but this entity is already in component "
+        << "storage.\n";
+    }
+    result.push_back(entity);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->entityCreatedMutex);
+    this->dataPtr->newlyCreatedEntities.insert(result.begin(), result.end());
+  }
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->entitiesMutex);
+    this->dataPtr->entitiesDirty = true;
+  }
+  this->dataPtr->stateEntitiesDirty = true;
+
+  return result;
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManager::ReserveEntities(const std::size_t _count)
+{
+  const std::size_t total = this->dataPtr->storage.EntityCount() + _count;
+  this->dataPtr->storage.Reserve(total);
+  this->dataPtr->hierarchy.Reserve(total);
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->entityCreatedMutex);
+  this->dataPtr->newlyCreatedEntities.reserve(
+      this->dataPtr->newlyCreatedEntities.size() + _count);
+}
+
 /////////////////////////////////////////////////
 Entity EntityComponentManagerPrivate::CreateEntityImplementation(Entity _entity)
 {
   IGN_PROFILE("EntityComponentManager::CreateEntityImplementation");
-  this->entities.AddVertex(std::to_string(_entity), _entity, _entity);
+  this->hierarchy.Insert(_entity, HierarchyNode());
+  {
+    std::lock_guard<std::mutex> lock(this->entitiesMutex);
+    this->entitiesDirty = true;
+  }
 
   // Add entity to the list of newly created entities
   {
     std::lock_guard<std::mutex> lock(this->entityCreatedMutex);
     this->newlyCreatedEntities.insert(_entity);
   }
+  this->changes.MarkEntityCreated(_entity);
 
-  // Reset descendants cache
-  this->descendantCache.clear();
-
-  const auto result = this->componentStorage.insert({_entity,
-      std::vector<std::unique_ptr<components::BaseComponent>>()});
-  if (!result.second)
+  if (!this->storage.AddEntity(_entity))
   {
     ignwarn << "Attempted to add entity [" << _entity
       << "] to component storage, but this entity is already in component "
       << "storage.\n";
   }
-
-  const auto result2 = this->componentTypeIndex.insert({_entity,
-      std::unordered_map<ComponentTypeId, std::size_t>()});
-  if (!result2.second)
-  {
-    ignwarn << "Attempted to add entity [" << _entity
-      << "] to component type index, but this entity is already in component "
-      << "type index.\n";
-  }
+  this->stateEntitiesDirty = true;
 
   return _entity;
 }
@@ -571,8 +889,15 @@ Entity EntityComponentManager::CloneImpl(Entity _entity, Entity _parent,
     this->dataPtr->originalToClonedLink[_entity] = clonedEntity;
   }
 
-  for (const auto &childEntity :
-      this->EntitiesByComponents(components::ParentEntity(_entity)))
+  std::vector<Entity> children;
+  for (Entity child = this->FirstChild(_entity); child != kNullEntity;
+       child = this->NextSibling(child))
+  {
+    if (child != clonedEntity)
+      children.push_back(child);
+  }
+
+  for (const auto &childEntity : children)
   {
     std::string name;
     if (!_allowRename)
@@ -623,22 +948,22 @@ void EntityComponentManager::ClearRemovedComponents()
 void EntityComponentManagerPrivate::InsertEntityRecursive(Entity _entity,
     std::unordered_set<Entity> &_set)
 {
-  for (const auto &vertex : this->entities.AdjacentsFrom(_entity))
+  for (Entity entity = _entity; entity != kNullEntity;
+       entity = this->NextDescendant(_entity, entity))
   {
-    this->InsertEntityRecursive(vertex.first, _set);
+    _set.insert(entity);
   }
-  _set.insert(_entity);
 }
 
 /////////////////////////////////////////////////
 void EntityComponentManagerPrivate::EraseEntityRecursive(Entity _entity,
     std::unordered_set<Entity> &_set)
 {
-  for (const auto &vertex : this->entities.AdjacentsFrom(_entity))
+  for (Entity entity = _entity; entity != kNullEntity;
+       entity = this->NextDescendant(_entity, entity))
   {
-    this->EraseEntityRecursive(vertex.first, _set);
+    _set.erase(entity);
   }
-  _set.erase(_entity);
 }
 
 /////////////////////////////////////////////////
@@ -682,6 +1007,7 @@ void EntityComponentManager::RequestRemoveEntity(Entity _entity,
 
   for (const auto &removedEntity : tmpToRemoveEntities)
   {
+    this->dataPtr->changes.MarkEntityChanged(removedEntity);
     for (auto &view : this->dataPtr->views)
     {
       view.second.first->MarkEntityToRemove(removedEntity);
@@ -706,13 +1032,16 @@ void EntityComponentManager::RequestRemoveEntities()
 
     // Store the to-be-removed entities in a temporary set so we can
     // mark each of them to be removed from views that contain them.
-    for (const auto &vertex : this->dataPtr->entities.Vertices())
+    for (const auto &archetype : this->dataPtr->storage.Archetypes())
     {
-      if (std::find(this->dataPtr->pinnedEntities.begin(),
-                    this->dataPtr->pinnedEntities.end(), vertex.first) ==
-          this->dataPtr->pinnedEntities.end())
+      for (const Entity entity : archetype.Entities())
       {
-        tmpToRemoveEntities.insert(vertex.first);
+        if (std::find(this->dataPtr->pinnedEntities.begin(),
+                      this->dataPtr->pinnedEntities.end(), entity) ==
+            this->dataPtr->pinnedEntities.end())
+        {
+          tmpToRemoveEntities.insert(entity);
+        }
       }
     }
 
@@ -724,6 +1053,7 @@ void EntityComponentManager::RequestRemoveEntities()
 
     for (const auto &removedEntity : tmpToRemoveEntities)
     {
+      this->dataPtr->changes.MarkEntityChanged(removedEntity);
       for (auto &view : this->dataPtr->views)
       {
         view.second.first->MarkEntityToRemove(removedEntity);
@@ -742,48 +1072,73 @@ void EntityComponentManager::ProcessRemoveEntityRequests()
   {
     IGN_PROFILE("RemoveAll");
     this->dataPtr->removeAllEntities = false;
-    this->dataPtr->entities = EntityGraph();
+    this->dataPtr->hierarchy.Clear();
     this->dataPtr->toRemoveEntities.clear();
-    this->dataPtr->componentsMarkedAsRemoved.clear();
 
     // reset the entity component storage
-    this->dataPtr->componentStorage.clear();
-    this->dataPtr->componentTypeIndex.clear();
-    this->dataPtr->componentTypeIndexDirty = true;
+    this->dataPtr->storage.Reset();
+    this->dataPtr->stateEntitiesDirty = true;
+    this->dataPtr->changes.MarkAllEntitiesRemoved();
 
     // All views are now invalid.
     this->dataPtr->views.clear();
+    this->dataPtr->viewFlushFns.clear();
+    this->dataPtr->viewsEpoch = ++lastViewsEpoch;
+
+    // Give the memory of all the destroyed components back to the system
+    components::ComponentPool::Trim();
   }
   else
   {
     IGN_PROFILE("Remove");
     // Otherwise iterate through the list of entities to remove.
+    std::vector<Entity> removed;
+    removed.reserve(this->dataPtr->toRemoveEntities.size());
     for (const Entity entity : this->dataPtr->toRemoveEntities)
     {
       // Make sure the entity exists and is not removed.
       if (!this->HasEntity(entity))
         continue;
 
-      // Remove from graph
-      this->dataPtr->entities.RemoveVertex(entity);
+      // Remove from the entity tree
+      this->dataPtr->RemoveFromHierarchy(entity);
 
-      this->dataPtr->componentsMarkedAsRemoved.erase(entity);
-      this->dataPtr->componentStorage.erase(entity);
-      this->dataPtr->componentTypeIndex.erase(entity);
-      this->dataPtr->componentTypeIndexDirty = true;
+      this->dataPtr->changes.MarkEntityRemoved(entity);
+      removed.push_back(entity);
+    }
+    // Clear the set of entities to remove.
+    this->dataPtr->toRemoveEntities.clear();
+
+    if (!removed.empty())
+    {
+      // Remove all entities from the storage together
+      this->dataPtr->storage.RemoveEntities(removed);
+      this->dataPtr->stateEntitiesDirty = true;
 
-      // Remove the entity from views.
+      // Remove the entities from views. Views are swept once if a good part
+      // of them may be removed, otherwise entities are looked up one by one.
+      const detail::EntityBitmap bitmap(removed);
       for (auto &view : this->dataPtr->views)
       {
-        view.second.first->RemoveEntity(entity);
+        auto &baseView = view.second.first;
+        if (removed.size() * kViewSweepRatio >= baseView->Entities().size())
+        {
+          baseView->RemoveEntities(bitmap);
+        }
+        else
+        {
+          for (const Entity entity : removed)
+            baseView->RemoveEntity(entity);
+        }
       }
+
+      // Entities moved into the rows of the removed ones
+      this->dataPtr->UpdateRelocatedEntities();
     }
-    // Clear the set of entities to remove.
-    this->dataPtr->toRemoveEntities.clear();
   }
 
-  // Reset descendants cache
-  this->dataPtr->descendantCache.clear();
+  std::lock_guard<std::mutex> graphLock(this->dataPtr->entitiesMutex);
+  this->dataPtr->entitiesDirty = true;
 }
 
 /////////////////////////////////////////////////
@@ -811,17 +1166,36 @@ bool EntityComponentManager::RemoveComponent(
       this->dataPtr->periodicChangedComponents.erase(periodicIter);
   }
 
-  auto compPtr = this->ComponentImplementation(_entity, _typeId);
-  if (compPtr)
+  if (this->dataPtr->storage.RemoveComponent(_entity, _typeId))
   {
-    this->dataPtr->componentsMarkedAsRemoved[_entity].insert(_typeId);
-
     // update views to reflect the component removal
     for (auto &viewPair : this->dataPtr->views)
-      viewPair.second.first->NotifyComponentRemoval(_entity, _typeId);
+    {
+      auto &view = viewPair.second.first;
+      if (view->ExcludesComponent(_typeId))
+      {
+        // the entity may now belong to views that exclude the type
+        if (this->EntityMatchesView(_entity, *view))
+        {
+          view->MarkEntityToAdd(_entity, this->IsNewEntity(_entity));
+          if (this->IsMarkedForRemoval(_entity))
+            view->MarkEntityToRemove(_entity);
+        }
+      }
+      else if (view->HasOptionalComponent(_typeId))
+      {
+        view->MarkEntityToUpdate(_entity, this->IsNewEntity(_entity));
+      }
+      else
+      {
+        view->NotifyComponentRemoval(_entity, _typeId);
+      }
+    }
+    this->dataPtr->UpdateRelocatedEntities();
   }
 
   this->dataPtr->AddModifiedComponent(_entity);
+  this->dataPtr->changes.MarkComponentChanged(_entity, _typeId);
 
   // Add component to map of removed components
   {
@@ -884,17 +1258,10 @@ ComponentState EntityComponentManager::ComponentState(const Entity _entity,
 {
   auto result = ComponentState::NoChange;
 
-  auto ctIter = this->dataPtr->componentTypeIndex.find(_entity);
-
-  if (ctIter == this->dataPtr->componentTypeIndex.end())
-    return result;
-
-  auto typeIter = ctIter->second.find(_typeId);
-  if (typeIter == ctIter->second.end() ||
-      this->dataPtr->ComponentMarkedAsRemoved(_entity, _typeId))
+  if (nullptr == this->dataPtr->storage.Component(_entity, _typeId))
     return result;
 
-  auto typeId = typeIter->first;
+  auto typeId = _typeId;
 
   auto oneTimeIter = this->dataPtr->oneTimeChangedComponents.find(typeId);
   if (oneTimeIter != this->dataPtr->oneTimeChangedComponents.end() &&
@@ -950,42 +1317,190 @@ std::unordered_set<ComponentTypeId>
 /////////////////////////////////////////////////
 bool EntityComponentManager::HasEntity(const Entity _entity) const
 {
-  auto vertex = this->dataPtr->entities.VertexFromId(_entity);
-  return vertex.Id() != math::graph::kNullId;
+  return this->dataPtr->storage.HasEntity(_entity);
 }
 
 /////////////////////////////////////////////////
 Entity EntityComponentManager::ParentEntity(const Entity _entity) const
 {
-  auto parents = this->Entities().AdjacentsTo(_entity);
-  if (parents.empty())
+  const HierarchyNode *node = this->dataPtr->hierarchy.Find(_entity);
+  if (nullptr == node)
+    return kNullEntity;
+
+  return node->parent;
+}
+
+/////////////////////////////////////////////////
+Entity EntityComponentManager::FirstChild(const Entity _entity) const
+{
+  const HierarchyNode *node = this->dataPtr->hierarchy.Find(_entity);
+  if (nullptr == node)
+    return kNullEntity;
+
+  return node->firstChild;
+}
+
+/////////////////////////////////////////////////
+Entity EntityComponentManager::NextSibling(const Entity _entity) const
+{
+  const HierarchyNode *node = this->dataPtr->hierarchy.Find(_entity);
+  if (nullptr == node)
     return kNullEntity;
 
-  // TODO(louise) Do we want to support multiple parents?
-  return parents.begin()->first;
+  return node->nextSibling;
 }
 
 /////////////////////////////////////////////////
 bool EntityComponentManager::SetParentEntity(const Entity _child,
     const Entity _parent)
 {
-  // Remove current parent(s)
-  auto parents = this->Entities().AdjacentsTo(_child);
-  for (const auto &parent : parents)
+  // There's nothing to detach from an unknown child
+  HierarchyNode *childNode = this->dataPtr->hierarchy.Find(_child);
+  if (nullptr == childNode)
+    return _parent == kNullEntity;
+
+  // Validate the new parent before touching the current one, so that a
+  // failed call leaves the hierarchy as it was
+  HierarchyNode *parentNode{nullptr};
+  if (_parent != kNullEntity)
+  {
+    parentNode = this->dataPtr->hierarchy.Find(_parent);
+    if (nullptr == parentNode)
+      return false;
+
+    // The tree must stay a tree
+    for (Entity ancestor = _parent; ancestor != kNullEntity;
+         ancestor = this->dataPtr->hierarchy.Find(ancestor)->parent)
+    {
+      if (ancestor == _child)
+      {
+        ignerr << "Can't set entity [" << _parent << "] as the parent of ["
+               << _child << "], because it is one of its descendants."
+               << std::endl;
+        return false;
+      }
+    }
+  }
+
+  // Remove current parent
+  this->dataPtr->Detach(_child);
+
   {
-    auto edge = this->dataPtr->entities.EdgeFromVertices(parent.first, _child);
-    this->dataPtr->entities.RemoveEdge(edge);
+    std::lock_guard<std::mutex> lock(this->dataPtr->entitiesMutex);
+    this->dataPtr->entitiesDirty = true;
   }
 
   // Leave parent-less
-  if (_parent == kNullEntity)
+  if (nullptr == parentNode)
   {
     return true;
   }
 
-  // Add edge
-  auto edge = this->dataPtr->entities.AddEdge({_parent, _child}, true);
-  return (math::graph::kNullId != edge.Id());
+  // Append to the parent's children
+  childNode->parent = _parent;
+  childNode->prevSibling = parentNode->lastChild;
+  if (parentNode->lastChild != kNullEntity)
+    this->dataPtr->hierarchy.Find(parentNode->lastChild)->nextSibling = _child;
+  else
+    parentNode->firstChild = _child;
+  parentNode->lastChild = _child;
+
+  return true;
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManagerPrivate::Detach(const Entity _child)
+{
+  HierarchyNode *node = this->hierarchy.Find(_child);
+  if (nullptr == node || node->parent == kNullEntity)
+    return;
+
+  HierarchyNode *parentNode = this->hierarchy.Find(node->parent);
+  if (node->prevSibling != kNullEntity)
+    this->hierarchy.Find(node->prevSibling)->nextSibling = node->nextSibling;
+  else
+    parentNode->firstChild = node->nextSibling;
+
+  if (node->nextSibling != kNullEntity)
+    this->hierarchy.Find(node->nextSibling)->prevSibling = node->prevSibling;
+  else
+    parentNode->lastChild = node->prevSibling;
+
+  node->parent = kNullEntity;
+  node->prevSibling = kNullEntity;
+  node->nextSibling = kNullEntity;
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManagerPrivate::RemoveFromHierarchy(const Entity _entity)
+{
+  HierarchyNode *node = this->hierarchy.Find(_entity);
+  if (nullptr == node)
+    return;
+
+  this->Detach(_entity);
+
+  // Orphan the children
+  Entity child = node->firstChild;
+  while (child != kNullEntity)
+  {
+    HierarchyNode *childNode = this->hierarchy.Find(child);
+    child = childNode->nextSibling;
+    *childNode = HierarchyNode{kNullEntity, childNode->firstChild,
+        childNode->lastChild, kNullEntity, kNullEntity};
+  }
+
+  this->hierarchy.Erase(_entity);
+}
+
+/////////////////////////////////////////////////
+Entity EntityComponentManagerPrivate::NextDescendant(const Entity _root,
+    const Entity _entity) const
+{
+  const HierarchyNode *node = this->hierarchy.Find(_entity);
+  if (nullptr == node)
+    return kNullEntity;
+
+  if (node->firstChild != kNullEntity)
+    return node->firstChild;
+
+  // Go up until there's a next sibling, without leaving the subtree
+  Entity entity = _entity;
+  while (entity != _root)
+  {
+    if (node->nextSibling != kNullEntity)
+      return node->nextSibling;
+
+    entity = node->parent;
+    node = this->hierarchy.Find(entity);
+  }
+  return kNullEntity;
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManagerPrivate::RebuildEntityGraph() const
+{
+  IGN_PROFILE("EntityComponentManager::RebuildEntityGraph");
+  std::vector<Entity> all;
+  all.reserve(this->storage.EntityCount());
+  for (const auto &archetype : this->storage.Archetypes())
+  {
+    all.insert(all.end(), archetype.Entities().begin(),
+        archetype.Entities().end());
+  }
+  std::sort(all.begin(), all.end());
+
+  this->entities = EntityGraph();
+  for (const Entity entity : all)
+    this->entities.AddVertex(std::to_string(entity), entity, entity);
+
+  for (const Entity entity : all)
+  {
+    const HierarchyNode *node = this->hierarchy.Find(entity);
+    if (nullptr != node && node->parent != kNullEntity)
+      this->entities.AddEdge({node->parent, entity}, true);
+  }
+  this->entitiesDirty = false;
 }
 
 /////////////////////////////////////////////////
@@ -1019,76 +1534,86 @@ bool EntityComponentManager::CreateComponentImplementation(
 
   this->dataPtr->AddModifiedComponent(_entity);
   this->dataPtr->oneTimeChangedComponents[_componentTypeId].insert(_entity);
-
-  // make sure the entity exists
-  auto typeMapIter = this->dataPtr->componentTypeIndex.find(_entity);
-  if (typeMapIter == this->dataPtr->componentTypeIndex.end())
-  {
-    ignerr << "Attempt to create a component of type [" << _componentTypeId
-      << "] attached to entity [" << _entity
-      << "] failed: entity not in componentTypeIndex." << std::endl;
-    return false;
-  }
-
-  auto entityCompIter = this->dataPtr->componentStorage.find(_entity);
-  if (entityCompIter == this->dataPtr->componentStorage.end())
-  {
-    ignerr << "Attempt to create a component of type [" << _componentTypeId
-      << "] attached to entity [" << _entity
-      << "] failed: entity not in storage." << std::endl;
-    return false;
-  }
-
-  // Instantiate the new component.
-  auto newComp = components::Factory::Instance()->New(_componentTypeId, _data);
-
-  const auto compIdxIter = typeMapIter->second.find(_componentTypeId);
-  // If entity has never had a component of this type
-  if (compIdxIter == typeMapIter->second.end())
+  this->dataPtr->changes.MarkComponentChanged(_entity, _componentTypeId);
+
+  // if the component is marked as removed, this means that the component was
+  // added to the entity previously, but later removed. In this case, a
+  // re-addition of the component is occuring, and the storage restores it
+  // with the new data. The data is copied before the entity moves, since it
+  // may point to a component of another entity that moves as well. If the
+  // component exists and is not marked as removed, we are simply modifying
+  // the data of the pre-existing component (the modification of the data is
+  // done externally in a templated ECM method call, because we need the
+  // derived component class in order to update the derived component data)
+  if (this->dataPtr->storage.HasRemovedComponent(_entity, _componentTypeId))
   {
-    const auto vectorIdx = entityCompIter->second.size();
-    entityCompIter->second.push_back(std::move(newComp));
-    this->dataPtr->componentTypeIndex[_entity][_componentTypeId] = vectorIdx;
-    this->dataPtr->componentTypeIndexDirty = true;
-
     updateData = false;
+    if (nullptr == this->dataPtr->storage.RestoreComponent(_entity,
+        _componentTypeId, _data))
+    {
+      ignerr << "Internal error: failed to restore component of type ["
+        << _componentTypeId << "] for entity [" << _entity
+        << "]. This should never happen!" << std::endl;
+      return false;
+    }
+
     for (auto &viewPair : this->dataPtr->views)
     {
       auto &view = viewPair.second.first;
-      if (this->EntityMatches(_entity, view->ComponentTypes()))
-        view->MarkEntityToAdd(_entity, this->IsNewEntity(_entity));
+      if (view->ExcludesComponent(_componentTypeId))
+      {
+        view->RemoveEntity(_entity);
+      }
+      else if (view->HasOptionalComponent(_componentTypeId))
+      {
+        view->MarkEntityToUpdate(_entity, this->IsNewEntity(_entity));
+      }
+      else
+      {
+        view->NotifyComponentAddition(_entity, this->IsNewEntity(_entity),
+            _componentTypeId);
+      }
     }
+    this->dataPtr->UpdateRelocatedEntities();
   }
-  else
+  // If entity has never had a component of this type
+  else if (nullptr == this->dataPtr->storage.Component(_entity,
+      _componentTypeId))
   {
-    // if the pre-existing component is marked as removed, this means that the
-    // component was added to the entity previously, but later removed. In this
-    // case, a re-addition of the component is occuring. If the pre-existing
-    // component is not marked as removed, this means that the component was
-    // added to the entity previously and never removed. In this case, we are
-    // simply modifying the data of the pre-existing component (the modification
-    // of the data is done externally in a templated ECM method call, because we
-    // need the derived component class in order to update the derived component
-    // data)
-    auto existingCompPtr = entityCompIter->second.at(compIdxIter->second).get();
-    if (!existingCompPtr)
-    {
-      ignerr << "Internal error: entity [" << _entity << "] has a component of "
-        << "type [" << _componentTypeId << "] in the storage, but the instance "
-        << "of this component is nullptr. This should never happen!"
-        << std::endl;
-      return false;
+    // Tags are shared, so only instantiate a component the first time its
+    // type is seen.
+    components::BaseComponent *added{nullptr};
+    if (this->dataPtr->storage.IsTag(_componentTypeId))
+    {
+      added = this->dataPtr->storage.AddTag(_entity, _componentTypeId);
     }
-    else if (this->dataPtr->ComponentMarkedAsRemoved(_entity, _componentTypeId))
+    else
     {
-      this->dataPtr->componentsMarkedAsRemoved[_entity].erase(_componentTypeId);
+      auto newComp = components::Factory::Instance()->New(_componentTypeId,
+          _data);
+      added = this->dataPtr->storage.AddComponent(_entity, std::move(newComp));
+    }
 
-      for (auto &viewPair : this->dataPtr->views)
-      {
-        viewPair.second.first->NotifyComponentAddition(_entity,
-            this->IsNewEntity(_entity), _componentTypeId);
-      }
+    if (nullptr == added)
+    {
+      ignerr << "Attempt to create a component of type [" << _componentTypeId
+        << "] attached to entity [" << _entity
+        << "] failed: component could not be added to storage." << std::endl;
+      return false;
+    }
+
+    updateData = false;
+    for (auto &viewPair : this->dataPtr->views)
+    {
+      auto &view = viewPair.second.first;
+      if (view->ExcludesComponent(_componentTypeId))
+        view->RemoveEntity(_entity);
+      else if (view->HasOptionalComponent(_componentTypeId))
+        view->MarkEntityToUpdate(_entity, this->IsNewEntity(_entity));
+      else if (this->EntityMatchesView(_entity, *view))
+        view->MarkEntityToAdd(_entity, this->IsNewEntity(_entity));
     }
+    this->dataPtr->UpdateRelocatedEntities();
   }
 
   this->dataPtr->createdCompTypes.insert(_componentTypeId);
@@ -1105,77 +1630,257 @@ bool EntityComponentManager::CreateComponentImplementation(
 }
 
 /////////////////////////////////////////////////
-bool EntityComponentManager::EntityMatches(Entity _entity,
-    const std::set<ComponentTypeId> &_types) const
+bool EntityComponentManager::CreateComponentsImplementation(
+    const Entity _entity,
+    std::vector<const components::BaseComponent *> &_data)
 {
-  auto iter = this->dataPtr->componentTypeIndex.find(_entity);
-  if (iter == this->dataPtr->componentTypeIndex.end())
-    return false;
+  IGN_PROFILE("EntityComponentManager::CreateComponentsImplementation");
 
-  // quick check: the entity cannot match _types if _types is larger than the
-  // number of component types the entity has
-  if (_types.size() > iter->second.size())
+  // make sure the entity exists
+  if (!this->HasEntity(_entity))
+  {
+    ignerr << "Trying to create [" << _data.size() << "] components attached "
+      << "to entity [" << _entity << "], but this entity does not exist. "
+      << "This create components request will be ignored." << std::endl;
     return false;
+  }
 
-  // \todo(nkoenig) The performance of this could be improved.
-  // It might be possible to create bitmask for component sets.
-  // Fixing this might not be high priority, unless we expect frequent
-  // creation of entities and/or queries.
-  for (const ComponentTypeId &type : _types)
+  // make sure all the component types are valid before changing anything
+  for (const auto *data : _data)
   {
-    auto typeIter = iter->second.find(type);
-    if (typeIter == iter->second.end() ||
-        this->dataPtr->ComponentMarkedAsRemoved(_entity, type))
+    const auto typeId = data->TypeId();
+    if (!this->HasComponentType(typeId) &&
+        !components::Factory::Instance()->HasType(typeId))
+    {
+      ignerr << "Failed to create components for entity [" << _entity
+             << "]. Type [" << typeId << "] has not been properly registered."
+             << std::endl;
       return false;
+    }
+  }
+
+  // Components which the entity already has, or had and were removed, are
+  // handled one at a time. The others are added to the storage together.
+  std::vector<std::unique_ptr<components::BaseComponent>> newComps;
+  std::vector<ComponentTypeId> newTypes;
+  bool hasParent{false};
+  for (auto &data : _data)
+  {
+    const auto typeId = data->TypeId();
+    if (std::find(newTypes.begin(), newTypes.end(), typeId) ==
+        newTypes.end() &&
+        nullptr == this->dataPtr->storage.Component(_entity, typeId) &&
+        !this->dataPtr->storage.HasRemovedComponent(_entity, typeId))
+    {
+      newComps.push_back(components::Factory::Instance()->New(typeId, data));
+      newTypes.push_back(typeId);
+      hasParent = hasParent || typeId == components::ParentEntity::typeId;
+      data = nullptr;
+      continue;
+    }
+
+    // A type listed twice only keeps the last value
+    if (std::find(newTypes.begin(), newTypes.end(), typeId) != newTypes.end())
+      continue;
+
+    if (!this->CreateComponentImplementation(_entity, typeId, data))
+      data = nullptr;
+  }
+
+  if (newComps.empty())
+    return true;
+
+  if (!this->dataPtr->storage.AddComponents(_entity, std::move(newComps)))
+  {
+    ignerr << "Attempt to create [" << newTypes.size() << "] components "
+      << "attached to entity [" << _entity
+      << "] failed: components could not be added to storage." << std::endl;
+    return false;
+  }
+
+  this->dataPtr->AddModifiedComponent(_entity);
+  for (const auto typeId : newTypes)
+  {
+    this->dataPtr->oneTimeChangedComponents[typeId].insert(_entity);
+    this->dataPtr->changes.MarkComponentChanged(_entity, typeId);
+    this->dataPtr->createdCompTypes.insert(typeId);
+  }
+
+  // Only views which require one of the new types can start matching. Views
+  // which exclude one of them stop matching, and views which have one of them
+  // as optional need to fetch it.
+  const bool isNew = this->IsNewEntity(_entity);
+  for (auto &viewPair : this->dataPtr->views)
+  {
+    auto &view = viewPair.second.first;
+    bool requiresNewType{false};
+    bool excludesNewType{false};
+    bool hasOptionalNewType{false};
+    for (const auto typeId : newTypes)
+    {
+      requiresNewType = requiresNewType || view->RequiresComponent(typeId);
+      excludesNewType = excludesNewType || view->ExcludesComponent(typeId);
+      hasOptionalNewType = hasOptionalNewType ||
+          view->HasOptionalComponent(typeId);
+    }
+
+    if (excludesNewType)
+    {
+      view->RemoveEntity(_entity);
+      continue;
+    }
+
+    if (hasOptionalNewType)
+      view->MarkEntityToUpdate(_entity, isNew);
+
+    if (requiresNewType && this->EntityMatchesView(_entity, *view))
+      view->MarkEntityToAdd(_entity, isNew);
+  }
+  this->dataPtr->UpdateRelocatedEntities();
+
+  // If one of the components is a components::ParentEntity, then make sure to
+  // update the entities graph.
+  if (hasParent)
+  {
+    auto parentComp = this->Component<components::ParentEntity>(_entity);
+    this->SetParentEntity(_entity, parentComp->Data());
   }
 
   return true;
 }
 
 /////////////////////////////////////////////////
-const components::BaseComponent
-    *EntityComponentManager::ComponentImplementation(
-    const Entity _entity, const ComponentTypeId _type) const
+std::size_t EntityComponentManager::CreateComponentsImplementation(
+    const std::vector<Entity> &_entities,
+    const components::BaseComponent *_data,
+    std::vector<Entity> &_existing)
 {
-  IGN_PROFILE("EntityComponentManager::ComponentImplementation");
+  IGN_PROFILE("EntityComponentManager::CreateComponentsImplementation");
 
-  // make sure the entity exists
-  const auto typeMapIter = this->dataPtr->componentTypeIndex.find(_entity);
-  if (typeMapIter == this->dataPtr->componentTypeIndex.end())
-    return nullptr;
+  const auto typeId = _data->TypeId();
+  if (!this->HasComponentType(typeId) &&
+      !components::Factory::Instance()->HasType(typeId))
+  {
+    ignerr << "Failed to create components of type [" << typeId
+           << "] for [" << _entities.size() << "] entities. Type has not "
+           << "been properly registered." << std::endl;
+    return 0;
+  }
 
-  // make sure the component type exists for the entity
-  const auto compIdxIter = typeMapIter->second.find(_type);
-  if (compIdxIter == typeMapIter->second.end())
-    return nullptr;
+  // Entities which already have the component, or had it and it was
+  // removed, are handled one at a time. The others are added to the storage
+  // together.
+  std::size_t count{0};
+  std::vector<Entity> newEntities;
+  newEntities.reserve(_entities.size());
+  for (const Entity entity : _entities)
+  {
+    if (!this->HasEntity(entity))
+    {
+      ignerr << "Trying to create a component of type [" << typeId
+        << "] attached to entity [" << entity << "], but this entity does "
+        << "not exist. This create component request will be ignored."
+        << std::endl;
+      continue;
+    }
+
+    if (nullptr == this->dataPtr->storage.Component(entity, typeId) &&
+        !this->dataPtr->storage.HasRemovedComponent(entity, typeId))
+    {
+      newEntities.push_back(entity);
+    }
+    else if (this->CreateComponentImplementation(entity, typeId, _data))
+    {
+      _existing.push_back(entity);
+    }
+    else
+    {
+      ++count;
+    }
+  }
+
+  if (newEntities.empty())
+    return count;
 
-  // get the pointer to the component
-  const auto compVecIter = this->dataPtr->componentStorage.find(_entity);
-  if (compVecIter == this->dataPtr->componentStorage.end())
+  const auto added = this->dataPtr->storage.AddComponentToEntities(
+      newEntities, *_data);
+  if (added.empty())
+    return count;
+
+  auto &oneTimeChanged = this->dataPtr->oneTimeChangedComponents[typeId];
+  for (const Entity entity : added)
   {
-    ignerr << "Internal error: Entity [" << _entity
-      << "] is missing in storage, but is in "
-      << "componentTypeIndex. This should never happen!" << std::endl;
-    return nullptr;
+    this->dataPtr->AddModifiedComponent(entity);
+    oneTimeChanged.insert(entity);
+    this->dataPtr->changes.MarkComponentChanged(entity, typeId);
   }
+  this->dataPtr->createdCompTypes.insert(typeId);
 
-  auto compPtr = compVecIter->second.at(compIdxIter->second).get();
-  if (nullptr == compPtr)
+  std::vector<char> isNew;
+  isNew.reserve(added.size());
+  for (const Entity entity : added)
+    isNew.push_back(this->IsNewEntity(entity));
+
+  // Only views which require the type can start matching. Views which
+  // exclude it stop matching, and views which have it as optional need to
+  // fetch it.
+  for (auto &viewPair : this->dataPtr->views)
   {
-    ignerr << "Internal error: entity [" << _entity << "] has a component of "
-      << "type [" << _type << "] in the storage, but the instance "
-      << "of this component is nullptr. This should never happen!"
-      << std::endl;
-    return nullptr;
+    auto &view = viewPair.second.first;
+    if (view->ExcludesComponent(typeId))
+    {
+      for (const Entity entity : added)
+        view->RemoveEntity(entity);
+    }
+    else if (view->HasOptionalComponent(typeId))
+    {
+      for (std::size_t i = 0; i < added.size(); ++i)
+        view->MarkEntityToUpdate(added[i], isNew[i]);
+    }
+    else if (view->RequiresComponent(typeId))
+    {
+      for (std::size_t i = 0; i < added.size(); ++i)
+      {
+        if (this->EntityMatchesView(added[i], *view))
+          view->MarkEntityToAdd(added[i], isNew[i]);
+      }
+    }
   }
+  this->dataPtr->UpdateRelocatedEntities();
 
-  // Return component if not marked as removed.
-  if (!this->dataPtr->ComponentMarkedAsRemoved(_entity, _type))
-    return compPtr;
+  // If the component is a components::ParentEntity, then make sure to
+  // update the entities graph.
+  if (typeId == components::ParentEntity::typeId)
+  {
+    for (const Entity entity : added)
+    {
+      auto parentComp = this->Component<components::ParentEntity>(entity);
+      this->SetParentEntity(entity, parentComp->Data());
+    }
+  }
+
+  return count + added.size();
+}
+
+/////////////////////////////////////////////////
+bool EntityComponentManager::EntityMatches(Entity _entity,
+    const std::set<ComponentTypeId> &_types) const
+{
+  return this->dataPtr->storage.EntityMatches(_entity, _types);
+}
+
+/////////////////////////////////////////////////
+const components::BaseComponent
+    *EntityComponentManager::ComponentImplementation(
+    const Entity _entity, const ComponentTypeId _type) const
+{
+  IGN_PROFILE("EntityComponentManager::ComponentImplementation");
 
-  return nullptr;
+  // Components marked as removed are not returned by the storage
+  return this->dataPtr->storage.Component(_entity, _type);
 }
 
+/////////////////////////////////////////////////
 /////////////////////////////////////////////////
 components::BaseComponent *EntityComponentManager::ComponentImplementation(
     const Entity _entity, const ComponentTypeId _type)
@@ -1197,9 +1902,82 @@ bool EntityComponentManager::HasComponentType(
 //////////////////////////////////////////////////
 const EntityGraph &EntityComponentManager::Entities() const
 {
+  std::lock_guard<std::mutex> lock(this->dataPtr->entitiesMutex);
+  if (this->dataPtr->entitiesDirty)
+    this->dataPtr->RebuildEntityGraph();
   return this->dataPtr->entities;
 }
 
+/////////////////////////////////////////////////
+WorkStealingPool &EntityComponentManagerPrivate::Pool()
+{
+  std::call_once(this->poolOnce, [this]
+  {
+    if (nullptr != this->pool)
+      return;
+
+    this->ownPool = std::make_unique<WorkStealingPool>(
+        WorkStealingPool::DefaultWorkerCount());
+    this->pool = this->ownPool.get();
+    igndbg << "Created ECM worker pool with " << this->pool->WorkerCount()
+           << " workers." << std::endl;
+  });
+  return *this->pool;
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManager::SetWorkerPool(WorkStealingPool *_pool)
+{
+  if (nullptr != this->dataPtr->ownPool)
+  {
+    ignerr << "Internal error: the worker pool must be set before the "
+           << "manager's first parallel iteration." << std::endl;
+    return;
+  }
+  this->dataPtr->pool = _pool;
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManager::ParallelChunks(std::size_t _count,
+    std::size_t _chunkSize,
+    const std::function<void(std::size_t, std::size_t)> &_fn) const
+{
+  IGN_PROFILE("EntityComponentManager::ParallelChunks");
+
+  if (_count == 0)
+    return;
+
+  auto &pool = this->dataPtr->Pool();
+
+  std::size_t chunkSize = _chunkSize;
+  if (chunkSize == 0)
+  {
+    // A few chunks per thread, so that threads that finish early can steal
+    // work from the others, but not so small that the overhead of
+    // dispatching a chunk dominates.
+    const std::size_t kChunksPerThread{4};
+    const std::size_t kMinChunkSize{16};
+    const std::size_t threads = pool.WorkerCount() + 1;
+    chunkSize = std::max(kMinChunkSize,
+        (_count + threads * kChunksPerThread - 1) /
+        (threads * kChunksPerThread));
+  }
+
+  // Each chunk's command buffer is applied after the caller's, in chunk
+  // order, whichever thread runs it
+  const std::vector<uint64_t> scope = tlCommandScope;
+  const std::size_t chunkCount = (_count + chunkSize - 1) / chunkSize;
+  pool.ParallelFor(chunkCount, [&](std::size_t _chunk)
+  {
+    std::vector<uint64_t> chunkScope(scope);
+    chunkScope.push_back(_chunk);
+    CommandScopeOverride scopeOverride(std::move(chunkScope));
+
+    const std::size_t begin = _chunk * chunkSize;
+    _fn(begin, std::min(begin + chunkSize, _count));
+  });
+}
+
 //////////////////////////////////////////////////
 std::pair<detail::BaseView *, std::mutex *> EntityComponentManager::FindView(
     const std::vector<ComponentTypeId> &_types) const
@@ -1215,6 +1993,12 @@ std::pair<detail::BaseView *, std::mutex *> EntityComponentManager::FindView(
   return viewMutexPair;
 }
 
+//////////////////////////////////////////////////
+uint64_t EntityComponentManager::ViewsEpoch() const
+{
+  return this->dataPtr->viewsEpoch.load(std::memory_order_acquire);
+}
+
 //////////////////////////////////////////////////
 detail::BaseView *EntityComponentManager::AddView(
     const detail::ComponentTypeKey &_types,
@@ -1229,6 +2013,58 @@ detail::BaseView *EntityComponentManager::AddView(
   return iter->second.first.get();
 }
 
+//////////////////////////////////////////////////
+detail::BaseView *EntityComponentManager::AddView(
+    const detail::ComponentTypeKey &_types,
+    std::unique_ptr<detail::BaseView> _view, ViewFlushFn _flush) const
+{
+  std::lock_guard<std::mutex> lockViews(this->dataPtr->viewsMutex);
+  auto iter = this->dataPtr->views.insert(std::make_pair(_types,
+        std::make_pair(std::move(_view),
+          std::make_unique<std::mutex>()))).first;
+  auto view = iter->second.first.get();
+  this->dataPtr->viewFlushFns.emplace(view, _flush);
+  return view;
+}
+
+//////////////////////////////////////////////////
+bool EntityComponentManager::EntityMatchesView(const Entity _entity,
+    const detail::BaseView &_view) const
+{
+  if (!this->EntityMatches(_entity, _view.ComponentTypes()))
+    return false;
+
+  for (const auto typeId : _view.ExcludedComponentTypes())
+  {
+    if (this->EntityHasComponentType(_entity, typeId))
+      return false;
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::vector<Entity> EntityComponentManager::EntitiesMatching(
+    const std::set<ComponentTypeId> &_types,
+    const std::set<ComponentTypeId> &_excluded) const
+{
+  std::vector<Entity> result;
+  for (const auto &archetype : this->dataPtr->storage.Archetypes())
+  {
+    if (!archetype.Includes(_types))
+      continue;
+
+    bool excluded{false};
+    for (const auto typeId : _excluded)
+      excluded = excluded || archetype.Column(typeId) >= 0;
+    if (excluded)
+      continue;
+
+    result.insert(result.end(), archetype.Entities().begin(),
+        archetype.Entities().end());
+  }
+  return result;
+}
+
 //////////////////////////////////////////////////
 void EntityComponentManager::RebuildViews()
 {
@@ -1238,20 +2074,16 @@ void EntityComponentManager::RebuildViews()
     auto &view = viewPair.second.first;
     view->Reset();
 
-    // Add all the entities that match the component types to the
-    // view.
-    for (const auto &vertex : this->dataPtr->entities.Vertices())
+    // Add all the entities that match the component types to the view
+    for (const Entity entity : this->EntitiesMatching(view->ComponentTypes(),
+             view->ExcludedComponentTypes()))
     {
-      Entity entity = vertex.first;
-      if (this->EntityMatches(entity, view->ComponentTypes()))
-      {
-        view->MarkEntityToAdd(entity, this->IsNewEntity(entity));
+      view->MarkEntityToAdd(entity, this->IsNewEntity(entity));
 
-        // If there is a request to delete this entity, update the view as
-        // well
-        if (this->IsMarkedForRemoval(entity))
-          view->MarkEntityToRemove(entity);
-      }
+      // If there is a request to delete this entity, update the view as
+      // well
+      if (this->IsMarkedForRemoval(entity))
+        view->MarkEntityToRemove(entity);
     }
   }
 }
@@ -1333,8 +2165,8 @@ void EntityComponentManager::AddEntityToMessage(msgs::SerializedState &_msg,
 {
   auto entityMsg = _msg.add_entities();
   entityMsg->set_id(_entity);
-  auto iter = this->dataPtr->componentTypeIndex.find(_entity);
-  if (iter == this->dataPtr->componentTypeIndex.end())
+  auto entityTypes = this->dataPtr->storage.ComponentTypes(_entity);
+  if (nullptr == entityTypes)
     return;
 
   if (this->dataPtr->toRemoveEntities.find(_entity) !=
@@ -1347,22 +2179,12 @@ void EntityComponentManager::AddEntityToMessage(msgs::SerializedState &_msg,
   // set is empty
   auto types = _types;
   if (types.empty())
-  {
-    for (auto &type : this->dataPtr->componentTypeIndex[_entity])
-    {
-      if (!this->dataPtr->ComponentMarkedAsRemoved(_entity, type.first))
-        types.insert(type.first);
-    }
-  }
+    types.insert(entityTypes->begin(), entityTypes->end());
 
   for (const ComponentTypeId type : types)
   {
-    // If the entity does not have the component, continue
-    auto typeIter = iter->second.find(type);
-    if (typeIter == iter->second.end())
-      continue;
-
-    // The component instance is nullptr if the component was removed
+    // The component instance is nullptr if the entity does not have the
+    // component or if the component was removed
     auto compBase = this->ComponentImplementation(_entity, type);
     if (nullptr == compBase)
       continue;
@@ -1386,8 +2208,8 @@ void EntityComponentManager::AddEntityToMessage(msgs::SerializedStateMap &_msg,
     Entity _entity, const std::unordered_set<ComponentTypeId> &_types,
     bool _full) const
 {
-  auto iter = this->dataPtr->componentTypeIndex.find(_entity);
-  if (iter == this->dataPtr->componentTypeIndex.end())
+  auto entityTypes = this->dataPtr->storage.ComponentTypes(_entity);
+  if (nullptr == entityTypes)
     return;
 
   // Set the default entity iterator to the end. This will allow us to know
@@ -1415,25 +2237,15 @@ void EntityComponentManager::AddEntityToMessage(msgs::SerializedStateMap &_msg,
   // set is empty
   auto types = _types;
   if (types.empty())
-  {
-    for (auto &type : this->dataPtr->componentTypeIndex[_entity])
-    {
-      if (!this->dataPtr->ComponentMarkedAsRemoved(_entity, type.first))
-        types.insert(type.first);
-    }
-  }
+    types.insert(entityTypes->begin(), entityTypes->end());
 
   // Empty means all types
   for (const ComponentTypeId type : types)
   {
-    auto typeIter = iter->second.find(type);
-    if (typeIter == iter->second.end())
-    {
-      continue;
-    }
-
     const components::BaseComponent *compBase =
       this->ComponentImplementation(_entity, type);
+    if (nullptr == compBase)
+      continue;
 
     // If not sending full state, skip unchanged components
     if (!_full)
@@ -1548,118 +2360,580 @@ void EntityComponentManager::ChangedState(
 }
 
 //////////////////////////////////////////////////
-void EntityComponentManagerPrivate::CalculateStateThreadLoad()
+uint64_t EntityComponentManager::ChangeTick() const
 {
-  // If the entity component vector is dirty, we need to recalculate the
-  // threads and each thread's work load
-  if (!this->componentTypeIndexDirty)
-    return;
+  return this->dataPtr->changes.Tick();
+}
 
-  this->componentTypeIndexDirty = false;
-  this->componentTypeIndexIterators.clear();
-  auto startIt = this->componentTypeIndex.begin();
-  int numEntities = this->componentTypeIndex.size();
+//////////////////////////////////////////////////
+uint64_t EntityComponentManager::ComponentChangeTick(const Entity _entity,
+    const ComponentTypeId _typeId) const
+{
+  return this->dataPtr->changes.ComponentTick(_entity, _typeId);
+}
 
-  // Set the number of threads to spawn to the min of the calculated thread
-  // count or max threads that the hardware supports
-  int maxThreads = std::thread::hardware_concurrency();
-  uint64_t numThreads = std::min(numEntities, maxThreads);
+//////////////////////////////////////////////////
+bool EntityComponentManager::ChangedStateSince(uint64_t _tick,
+    msgs::SerializedStateMap &_state) const
+{
+  IGN_PROFILE("EntityComponentManager::ChangedStateSince");
+  const ChangeTracker &changes = this->dataPtr->changes;
 
-  int entitiesPerThread = static_cast<int>(std::ceil(
-    static_cast<double>(numEntities) / numThreads));
+  std::vector<Entity> entities;
+  const bool complete = changes.ChangedSince(_tick, entities);
 
-  igndbg << "Updated state thread iterators: " << numThreads
-         << " threads processing around " << entitiesPerThread
-         << " entities each." << std::endl;
+  auto entityMsg = [&_state](const Entity _entity)
+  {
+    auto entIter = _state.mutable_entities()->find(_entity);
+    if (entIter == _state.mutable_entities()->end())
+    {
+      msgs::SerializedEntityMap ent;
+      ent.set_id(_entity);
+      entIter = _state.mutable_entities()->insert(
+          {static_cast<uint64_t>(_entity), ent}).first;
+    }
+    return &entIter->second;
+  };
 
-  // Push back the starting iterator
-  this->componentTypeIndexIterators.push_back(startIt);
-  for (uint64_t i = 0; i < numThreads; ++i)
+  std::vector<ComponentTypeId> changedTypes;
+  std::unordered_set<ComponentTypeId> types;
+  for (const Entity entity : entities)
   {
-    // If we have added all of the entities to the iterator vector, we are
-    // done so push back the end iterator
-    numEntities -= entitiesPerThread;
-    if (numEntities <= 0)
+    // Entities that no longer exist
+    if (changes.Removed(entity))
+    {
+      entityMsg(entity)->set_remove(true);
+      continue;
+    }
+
+    // New entities and all of their components, if they have any
+    if (changes.CreationTick(entity) > _tick)
+    {
+      entityMsg(entity);
+      this->AddEntityToMessage(_state, entity, {}, true);
+      continue;
+    }
+
+    // Changed and removed components
+    changedTypes.clear();
+    changes.ComponentsChangedSince(entity, _tick, changedTypes);
+    types.clear();
+    for (const ComponentTypeId type : changedTypes)
     {
-      this->componentTypeIndexIterators.push_back(
-          this->componentTypeIndex.end());
-      break;
+      if (this->dataPtr->storage.HasRemovedComponent(entity, type))
+      {
+        msgs::SerializedComponent compMsg;
+
+        // Empty data is needed for the component to be processed afterwards
+        compMsg.set_component(" ");
+        compMsg.set_type(type);
+        compMsg.set_remove(true);
+        (*entityMsg(entity)->mutable_components())[
+            static_cast<int64_t>(type)] = compMsg;
+      }
+      else
+      {
+        types.insert(type);
+      }
     }
 
-    // Get the iterator to the next starting group of entities
-    auto nextIt = std::next(startIt, entitiesPerThread);
-    this->componentTypeIndexIterators.push_back(nextIt);
-    startIt = nextIt;
+    if (!types.empty())
+      this->AddEntityToMessage(_state, entity, types, true);
+
+    // Entities marked for removal
+    if (this->dataPtr->toRemoveEntities.find(entity) !=
+        this->dataPtr->toRemoveEntities.end())
+    {
+      entityMsg(entity)->set_remove(true);
+    }
   }
+
+  return complete;
 }
 
 //////////////////////////////////////////////////
-ignition::msgs::SerializedState EntityComponentManager::State(
-    const std::unordered_set<Entity> &_entities,
-    const std::unordered_set<ComponentTypeId> &_types) const
+void EntityComponentManager::EnableWorldPoseCache(const bool _enable)
 {
-  ignition::msgs::SerializedState stateMsg;
-  for (const auto &it : this->dataPtr->componentTypeIndex)
+  std::unique_lock<std::shared_mutex> lock(this->dataPtr->worldPoseMutex);
+
+  // Poses may have been written without SetChanged while the cache was off
+  this->dataPtr->worldPoses.Clear();
+  this->dataPtr->worldPosesTick = this->dataPtr->changes.Tick();
+  this->dataPtr->worldPoseCache = _enable;
+}
+
+//////////////////////////////////////////////////
+bool EntityComponentManager::WorldPoseCacheEnabled() const
+{
+  return this->dataPtr->worldPoseCache;
+}
+
+//////////////////////////////////////////////////
+bool EntityComponentManager::CachedWorldPose(const Entity _entity,
+    math::Pose3d &_pose) const
+{
+  if (!this->dataPtr->worldPoseCache)
   {
-    auto entity = it.first;
-    if (!_entities.empty() && _entities.find(entity) == _entities.end())
+    auto poseComp = this->Component<components::Pose>(_entity);
+    if (nullptr == poseComp)
+      return false;
+
+    // Work out the pose in the world frame, up to the first ancestor
+    // without a pose
+    _pose = poseComp->Data();
+    auto parentComp = this->Component<components::ParentEntity>(_entity);
+    while (nullptr != parentComp)
     {
-      continue;
+      auto parentPose = this->Component<components::Pose>(parentComp->Data());
+      if (nullptr == parentPose)
+        break;
+      _pose = _pose + parentPose->Data();
+      parentComp = this->Component<components::ParentEntity>(
+          parentComp->Data());
     }
+    return true;
+  }
 
-    this->AddEntityToMessage(stateMsg, entity, _types);
+  {
+    std::shared_lock<std::shared_mutex> lock(this->dataPtr->worldPoseMutex);
+    if (this->dataPtr->worldPosesTick == this->dataPtr->changes.Tick())
+    {
+      const WorldPoseEntry *entry = this->dataPtr->worldPoses.Find(_entity);
+      if (nullptr != entry && entry->valid)
+      {
+        if (entry->hasPose)
+          _pose = entry->pose;
+        return entry->hasPose;
+      }
+    }
   }
 
-  return stateMsg;
+  std::unique_lock<std::shared_mutex> lock(this->dataPtr->worldPoseMutex);
+  this->dataPtr->RefreshWorldPoses();
+  const WorldPoseEntry *entry = this->dataPtr->ComputeWorldPose(_entity);
+  if (nullptr == entry || !entry->hasPose)
+    return false;
+
+  _pose = entry->pose;
+  return true;
 }
 
 //////////////////////////////////////////////////
-void EntityComponentManager::State(
-    msgs::SerializedStateMap  &_state,
-    const std::unordered_set<Entity> &_entities,
-    const std::unordered_set<ComponentTypeId> &_types,
-    bool _full) const
+void EntityComponentManagerPrivate::RefreshWorldPoses()
 {
-  std::mutex stateMapMutex;
-  std::vector<std::thread> workers;
+  const uint64_t tick = this->worldPosesTick;
+  if (tick == this->changes.Tick())
+    return;
+
+  IGN_PROFILE("EntityComponentManager::RefreshWorldPoses");
+  this->worldPosesTick = this->changes.Tick();
 
-  this->dataPtr->CalculateStateThreadLoad();
+  std::vector<Entity> changed;
+  if (!this->changes.ChangedSince(tick, changed))
+  {
+    this->worldPoses.Clear();
+    return;
+  }
 
-  auto functor = [&](auto itStart, auto itEnd)
+  for (const Entity entity : changed)
   {
-    msgs::SerializedStateMap threadMap;
-    while (itStart != itEnd)
+    // The children of a removed entity are no longer in the graph, and may
+    // still exist if the removal wasn't recursive
+    if (this->changes.Removed(entity))
     {
-      auto entity = (*itStart).first;
-      if (_entities.empty() || _entities.find(entity) != _entities.end())
+      const WorldPoseEntry *entry = this->worldPoses.Find(entity);
+      if (nullptr != entry && entry->valid)
       {
-        this->AddEntityToMessage(threadMap, entity, _types, _full);
+        this->worldPoses.Clear();
+        return;
       }
-      itStart++;
+      this->worldPoses.Erase(entity);
+      continue;
     }
-    std::lock_guard<std::mutex> lock(stateMapMutex);
 
-    for (const auto &entity : threadMap.entities())
+    if (this->changes.CreationTick(entity) > tick ||
+        this->changes.ComponentTick(entity, components::Pose::typeId) >
+            tick ||
+        this->changes.ComponentTick(entity,
+            components::ParentEntity::typeId) > tick)
     {
-      (*_state.mutable_entities())[static_cast<uint64_t>(entity.first)] =
-          entity.second;
+      this->InvalidateWorldPoses(entity);
     }
-  };
+  }
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManagerPrivate::InvalidateWorldPoses(const Entity _entity)
+{
+  std::vector<Entity> stack{_entity};
+  while (!stack.empty())
+  {
+    const Entity entity = stack.back();
+    stack.pop_back();
+
+    // Entries are only valid if their ancestors' are, so there's nothing to
+    // do below an entity that isn't cached
+    WorldPoseEntry *entry = this->worldPoses.Find(entity);
+    if (nullptr == entry || !entry->valid)
+      continue;
+
+    entry->valid = false;
+    const HierarchyNode *node = this->hierarchy.Find(entity);
+    for (Entity child = nullptr == node ? kNullEntity : node->firstChild;
+         child != kNullEntity; child = this->hierarchy.Find(child)->nextSibling)
+    {
+      stack.push_back(child);
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+const WorldPoseEntry *EntityComponentManagerPrivate::ComputeWorldPose(
+    const Entity _entity)
+{
+  const WorldPoseEntry *cached = this->worldPoses.Find(_entity);
+  if (nullptr != cached && cached->valid)
+    return cached;
+
+  if (!this->storage.HasEntity(_entity))
+    return nullptr;
+
+  WorldPoseEntry result;
+  result.valid = true;
+  auto poseComp = static_cast<const components::Pose *>(
+      this->storage.Component(_entity, components::Pose::typeId));
+  if (nullptr != poseComp)
+  {
+    result.pose = poseComp->Data();
+    result.hasPose = true;
+
+    // Like the ancestors' poses, stop at the first ancestor without a pose
+    auto parentComp = static_cast<const components::ParentEntity *>(
+        this->storage.Component(_entity, components::ParentEntity::typeId));
+    if (nullptr != parentComp)
+    {
+      const WorldPoseEntry *parent =
+          this->ComputeWorldPose(parentComp->Data());
+      if (nullptr != parent && parent->hasPose)
+        result.pose = result.pose + parent->pose;
+    }
+  }
+
+  // Look the entry up again, since computing the ancestors may have grown
+  // the index
+  WorldPoseEntry *entry = this->worldPoses.Find(_entity);
+  if (nullptr == entry)
+    return this->worldPoses.Insert(_entity, result);
+
+  *entry = result;
+  return entry;
+}
 
-  // Spawn workers
-  uint64_t numThreads = this->dataPtr->componentTypeIndexIterators.size() - 1;
-  for (uint64_t i = 0; i < numThreads; i++)
+//////////////////////////////////////////////////
+void EntityComponentManager::EnableValueIndex(const ComponentTypeId _typeId,
+    ValueHashFn _hash)
+{
+  std::unique_lock<std::shared_mutex> lock(this->dataPtr->valueIndexMutex);
+
+  // Bring the existing indexes up to date, so they can share the tick
+  this->dataPtr->RefreshValueIndexes();
+
+  auto inserted = this->dataPtr->valueIndexes.emplace(_typeId, ValueIndex());
+  if (!inserted.second)
+    return;
+
+  IGN_PROFILE("EntityComponentManager::EnableValueIndex");
+  ValueIndex &index = inserted.first->second;
+  index.hash = std::move(_hash);
+  for (const auto &archetype : this->dataPtr->storage.Archetypes())
   {
-    workers.push_back(std::thread(functor,
-        this->dataPtr->componentTypeIndexIterators[i],
-        this->dataPtr->componentTypeIndexIterators[i+1]));
+    for (const Entity entity : archetype.Entities())
+      this->dataPtr->UpdateValueIndex(_typeId, index, entity);
   }
+}
+
+//////////////////////////////////////////////////
+bool EntityComponentManager::HasValueIndex(const ComponentTypeId _typeId)
+    const
+{
+  std::shared_lock<std::shared_mutex> lock(this->dataPtr->valueIndexMutex);
+  return this->dataPtr->valueIndexes.find(_typeId) !=
+      this->dataPtr->valueIndexes.end();
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManager::MarkComponentChanged(const Entity _entity,
+    const ComponentTypeId _typeId)
+{
+  this->dataPtr->changes.MarkComponentChanged(_entity, _typeId);
+}
+
+//////////////////////////////////////////////////
+bool EntityComponentManager::IndexedCandidates(
+    const std::vector<const components::BaseComponent *> &_desiredComponents,
+    std::vector<Entity> &_candidates) const
+{
+  auto candidates = [&]()
+  {
+    // Pick the smallest bucket among the indexed components
+    const std::set<Entity> *best{nullptr};
+    bool indexed{false};
+    for (const components::BaseComponent *desired : _desiredComponents)
+    {
+      auto indexIt = this->dataPtr->valueIndexes.find(desired->TypeId());
+      if (indexIt == this->dataPtr->valueIndexes.end())
+        continue;
+
+      indexed = true;
+      const ValueIndex &index = indexIt->second;
+      auto bucketIt = index.buckets.find(index.hash(*desired));
+      if (bucketIt == index.buckets.end())
+        return true;
+
+      if (nullptr == best || bucketIt->second.size() < best->size())
+        best = &bucketIt->second;
+    }
+
+    if (nullptr != best)
+      _candidates.assign(best->begin(), best->end());
+    return indexed;
+  };
 
-  // Wait for each thread to finish processing its components
-  std::for_each(workers.begin(), workers.end(), [](std::thread &_t)
   {
-    _t.join();
+    std::shared_lock<std::shared_mutex> lock(this->dataPtr->valueIndexMutex);
+    if (this->dataPtr->valueIndexes.empty())
+      return false;
+
+    if (this->dataPtr->valueIndexesTick == this->dataPtr->changes.Tick())
+      return candidates();
+  }
+
+  std::unique_lock<std::shared_mutex> lock(this->dataPtr->valueIndexMutex);
+  this->dataPtr->RefreshValueIndexes();
+  return candidates();
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManagerPrivate::RefreshValueIndexes()
+{
+  const uint64_t tick = this->valueIndexesTick;
+  if (tick == this->changes.Tick())
+    return;
+
+  IGN_PROFILE("EntityComponentManager::RefreshValueIndexes");
+  this->valueIndexesTick = this->changes.Tick();
+
+  std::vector<Entity> changed;
+  if (!this->changes.ChangedSince(tick, changed))
+  {
+    // Some removals are unknown, so start over
+    for (auto &[typeId, index] : this->valueIndexes)
+    {
+      index.buckets.clear();
+      index.keys.Clear();
+      for (const auto &archetype : this->storage.Archetypes())
+      {
+        for (const Entity entity : archetype.Entities())
+          this->UpdateValueIndex(typeId, index, entity);
+      }
+    }
+    return;
+  }
+
+  for (const Entity entity : changed)
+  {
+    const bool removed = this->changes.Removed(entity);
+    const bool created = this->changes.CreationTick(entity) > tick;
+    for (auto &[typeId, index] : this->valueIndexes)
+    {
+      if (removed)
+        this->EraseFromValueIndex(index, entity);
+      else if (created || this->changes.ComponentTick(entity, typeId) > tick)
+        this->UpdateValueIndex(typeId, index, entity);
+    }
+  }
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManagerPrivate::UpdateValueIndex(
+    const ComponentTypeId _typeId, ValueIndex &_index, const Entity _entity)
+{
+  const components::BaseComponent *comp =
+      this->storage.Component(_entity, _typeId);
+  if (nullptr == comp)
+  {
+    this->EraseFromValueIndex(_index, _entity);
+    return;
+  }
+
+  const std::size_t key = _index.hash(*comp);
+  std::size_t *oldKey = _index.keys.Find(_entity);
+  if (nullptr != oldKey)
+  {
+    if (*oldKey == key)
+      return;
+    this->EraseFromValueIndex(_index, _entity);
+  }
+
+  _index.keys.Insert(_entity, key);
+  _index.buckets[key].insert(_entity);
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManagerPrivate::EraseFromValueIndex(ValueIndex &_index,
+    const Entity _entity)
+{
+  const std::size_t *key = _index.keys.Find(_entity);
+  if (nullptr == key)
+    return;
+
+  auto bucketIt = _index.buckets.find(*key);
+  if (bucketIt != _index.buckets.end())
+  {
+    bucketIt->second.erase(_entity);
+    if (bucketIt->second.empty())
+      _index.buckets.erase(bucketIt);
+  }
+  _index.keys.Erase(_entity);
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const EntityComponentManagerPrivate::StateRanges>
+    EntityComponentManagerPrivate::CalculateStateThreadLoad()
+{
+  std::lock_guard<std::mutex> lock(this->stateEntitiesMutex);
+
+  // If entities were added or removed, we need to recalculate the
+  // ranges and each range's work load
+  if (!this->stateEntitiesDirty && nullptr != this->stateRanges)
+    return this->stateRanges;
+
+  this->stateEntitiesDirty = false;
+  auto ranges = std::make_shared<StateRanges>();
+  ranges->entities.reserve(this->storage.EntityCount());
+  for (const auto &archetype : this->storage.Archetypes())
+  {
+    ranges->entities.insert(ranges->entities.end(),
+        archetype.Entities().begin(), archetype.Entities().end());
+  }
+
+  const std::size_t numEntities = ranges->entities.size();
+
+  // Split the entities into a few ranges per pool thread, so threads that
+  // finish early can steal from the others, but keep the ranges big enough
+  // for the serialization to outweigh the cost of dispatching them.
+  const std::size_t kRangesPerThread{4};
+  const std::size_t kMinEntitiesPerRange{32};
+  const std::size_t numThreads = this->Pool().WorkerCount() + 1;
+  const std::size_t numRanges = std::max<std::size_t>(1, std::min(
+      numThreads * kRangesPerThread,
+      (numEntities + kMinEntitiesPerRange - 1) / kMinEntitiesPerRange));
+  const std::size_t entitiesPerRange =
+      (numEntities + numRanges - 1) / numRanges;
+
+  igndbg << "Updated state ranges: " << numRanges
+         << " ranges of around " << entitiesPerRange
+         << " entities each." << std::endl;
+
+  for (std::size_t start = 0; start < numEntities; start += entitiesPerRange)
+    ranges->bounds.push_back(start);
+  ranges->bounds.push_back(numEntities);
+
+  this->stateRanges = ranges;
+  return ranges;
+}
+
+//////////////////////////////////////////////////
+std::unique_ptr<EntityComponentManagerPrivate::StateBuffers>
+    EntityComponentManagerPrivate::AcquireStateBuffers()
+{
+  std::lock_guard<std::mutex> lock(this->stateBuffersMutex);
+  if (this->freeStateBuffers.empty())
+    return std::make_unique<StateBuffers>();
+
+  auto buffers = std::move(this->freeStateBuffers.back());
+  this->freeStateBuffers.pop_back();
+  return buffers;
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManagerPrivate::ReleaseStateBuffers(
+    std::unique_ptr<StateBuffers> _buffers)
+{
+  std::lock_guard<std::mutex> lock(this->stateBuffersMutex);
+  this->freeStateBuffers.push_back(std::move(_buffers));
+}
+
+//////////////////////////////////////////////////
+ignition::msgs::SerializedState EntityComponentManager::State(
+    const std::unordered_set<Entity> &_entities,
+    const std::unordered_set<ComponentTypeId> &_types) const
+{
+  ignition::msgs::SerializedState stateMsg;
+  for (const auto &archetype : this->dataPtr->storage.Archetypes())
+  {
+    for (const Entity entity : archetype.Entities())
+    {
+      if (!_entities.empty() && _entities.find(entity) == _entities.end())
+      {
+        continue;
+      }
+
+      this->AddEntityToMessage(stateMsg, entity, _types);
+    }
+  }
+
+  return stateMsg;
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManager::State(
+    msgs::SerializedStateMap  &_state,
+    const std::unordered_set<Entity> &_entities,
+    const std::unordered_set<ComponentTypeId> &_types,
+    bool _full) const
+{
+  IGN_PROFILE("EntityComponentManager::State Map");
+
+  const auto ranges = this->dataPtr->CalculateStateThreadLoad();
+  const auto &bounds = ranges->bounds;
+  const std::size_t numRanges = bounds.size() - 1;
+  if (numRanges == 0)
+    return;
+
+  // Each range is serialized into its own buffer, so the tasks don't need to
+  // synchronize with each other
+  auto buffers = this->dataPtr->AcquireStateBuffers();
+  if (buffers->size() < numRanges)
+    buffers->resize(numRanges);
+
+  this->dataPtr->Pool().ParallelFor(numRanges, [&](std::size_t _range)
+  {
+    auto &buffer = (*buffers)[_range];
+    for (std::size_t i = bounds[_range]; i < bounds[_range + 1]; ++i)
+    {
+      auto entity = ranges->entities[i];
+      if (_entities.empty() || _entities.find(entity) != _entities.end())
+      {
+        this->AddEntityToMessage(buffer, entity, _types, _full);
+      }
+    }
   });
+
+  // Move the entities into the output. Swapping hands over the serialized
+  // components without copying them.
+  {
+    IGN_PROFILE("Merge");
+    auto &entities = *_state.mutable_entities();
+    for (std::size_t r = 0; r < numRanges; ++r)
+    {
+      for (auto &entity : *(*buffers)[r].mutable_entities())
+        entities[entity.first].Swap(&entity.second);
+      (*buffers)[r].mutable_entities()->clear();
+    }
+  }
+
+  this->dataPtr->ReleaseStateBuffers(std::move(buffers));
 }
 
 //////////////////////////////////////////////////
@@ -1746,6 +3020,7 @@ void EntityComponentManager::SetState(
       {
         comp->Deserialize(istr);
         this->dataPtr->AddModifiedComponent(entity);
+        this->dataPtr->changes.MarkComponentChanged(entity, type);
       }
     }
   }
@@ -1843,27 +3118,515 @@ void EntityComponentManager::SetState(
 }
 
 //////////////////////////////////////////////////
-std::unordered_set<Entity> EntityComponentManager::Descendants(Entity _entity)
-    const
+void EntityComponentManager::BinaryState(std::vector<char> &_buffer,
+    const std::unordered_set<Entity> &_entities,
+    const std::unordered_set<ComponentTypeId> &_types) const
+{
+  IGN_PROFILE("EntityComponentManager::BinaryState");
+
+  auto included = [&_entities](const Entity _entity)
+  {
+    return _entities.empty() || _entities.find(_entity) != _entities.end();
+  };
+
+  auto align = [&_buffer]
+  {
+    const std::size_t size = (_buffer.size() + kBinaryStateAlignment - 1) /
+        kBinaryStateAlignment * kBinaryStateAlignment;
+    _buffer.resize(size, 0);
+  };
+
+  auto append = [&_buffer](const void *_data, std::size_t _size)
+  {
+    auto data = static_cast<const char *>(_data);
+    _buffer.insert(_buffer.end(), data, data + _size);
+  };
+
+  // Entity table, and the component types present in the serialized
+  // entities, sorted so that columns have a stable order
+  std::vector<BinaryStateEntity> entities;
+  std::set<ComponentTypeId> types;
+  for (const auto &archetype : this->dataPtr->storage.Archetypes())
+  {
+    bool hasEntities{false};
+    for (const Entity entity : archetype.Entities())
+    {
+      if (!included(entity))
+        continue;
+
+      hasEntities = true;
+      uint64_t flags{0};
+      if (this->dataPtr->toRemoveEntities.find(entity) !=
+          this->dataPtr->toRemoveEntities.end())
+      {
+        flags |= kBinaryStateEntityRemoved;
+      }
+      entities.push_back({entity, flags});
+    }
+
+    if (!hasEntities)
+      continue;
+
+    for (const ComponentTypeId type : archetype.Types())
+    {
+      if (_types.empty() || _types.find(type) != _types.end())
+        types.insert(type);
+    }
+  }
+
+  BinaryStateHeader header;
+  std::memcpy(header.magic, kBinaryStateMagic, sizeof(kBinaryStateMagic));
+  header.version = kBinaryStateVersion;
+  header.byteOrder = kBinaryStateByteOrder;
+  header.entityCount = entities.size();
+  header.columnCount = types.size();
+
+  // The header and column table are filled in at the end
+  _buffer.clear();
+  _buffer.resize(sizeof(BinaryStateHeader), 0);
+  align();
+  header.entitiesOffset = _buffer.size();
+  append(entities.data(), entities.size() * sizeof(BinaryStateEntity));
+  align();
+  header.columnsOffset = _buffer.size();
+  _buffer.resize(_buffer.size() + types.size() * sizeof(BinaryStateColumn),
+      0);
+
+  // A single stream writes all components straight into the buffer. The
+  // buffer isn't a protobuf string, so components can use binary data.
+  serializers::BinarySerializationScope binaryScope;
+  VectorOutStreamBuf streamBuf(_buffer);
+  std::ostream ostr(&streamBuf);
+  const auto defaultFlags = ostr.flags();
+  const auto defaultPrecision = ostr.precision();
+
+  std::vector<BinaryStateColumn> columns;
+  columns.reserve(types.size());
+  std::vector<uint64_t> columnEntities;
+  std::vector<uint64_t> offsets;
+  for (const ComponentTypeId type : types)
+  {
+    BinaryStateColumn column;
+    column.type = type;
+    column.dataOffset = _buffer.size();
+    columnEntities.clear();
+    offsets.clear();
+
+    for (const auto &archetype : this->dataPtr->storage.Archetypes())
+    {
+      const int col = archetype.Column(type);
+      if (col < 0)
+        continue;
+
+      const auto &archetypeEntities = archetype.Entities();
+      for (std::size_t row = 0; row < archetypeEntities.size(); ++row)
+      {
+        if (!included(archetypeEntities[row]))
+          continue;
+
+        columnEntities.push_back(archetypeEntities[row]);
+        offsets.push_back(_buffer.size() - column.dataOffset);
+
+        // Don't let a component's formatting leak into the next one
+        ostr.flags(defaultFlags);
+        ostr.precision(defaultPrecision);
+        archetype.At(col, row)->Serialize(ostr);
+      }
+    }
+
+    column.count = columnEntities.size();
+    column.dataSize = _buffer.size() - column.dataOffset;
+    offsets.push_back(column.dataSize);
+
+    align();
+    column.entitiesOffset = _buffer.size();
+    append(columnEntities.data(), columnEntities.size() * sizeof(uint64_t));
+    column.offsetsOffset = _buffer.size();
+    append(offsets.data(), offsets.size() * sizeof(uint64_t));
+    columns.push_back(column);
+  }
+
+  header.size = _buffer.size();
+  std::memcpy(_buffer.data(), &header, sizeof(BinaryStateHeader));
+  std::memcpy(_buffer.data() + header.columnsOffset, columns.data(),
+      columns.size() * sizeof(BinaryStateColumn));
+}
+
+//////////////////////////////////////////////////
+bool EntityComponentManager::SetBinaryState(const BinaryStateView &_state)
+{
+  IGN_PROFILE("EntityComponentManager::SetBinaryState");
+
+  if (!_state.Valid())
+  {
+    ignerr << "Can't set state from an invalid binary state buffer."
+           << std::endl;
+    return false;
+  }
+
+  // Create / remove entities
+  std::unordered_set<Entity> removed;
+  for (std::size_t e = 0; e < _state.EntityCount(); ++e)
+  {
+    const auto &entityEntry = _state.EntityAt(e);
+    Entity entity{entityEntry.id};
+
+    if (entityEntry.flags & kBinaryStateEntityRemoved)
+    {
+      this->RequestRemoveEntity(entity);
+      removed.insert(entity);
+      continue;
+    }
+
+    if (!this->HasEntity(entity))
+    {
+      this->dataPtr->CreateEntityImplementation(entity);
+    }
+  }
+
+  // A single stream reads all components in place from the buffer
+  MemoryInStreamBuf streamBuf;
+  std::istream istr(&streamBuf);
+  const auto defaultFlags = istr.flags();
+
+  auto deserialize = [&](const BinaryStateColumnView &_column, std::size_t _i,
+      components::BaseComponent *_comp)
+  {
+    streamBuf.Reset(_column.Data(_i), _column.Size(_i));
+    istr.clear();
+    istr.flags(defaultFlags);
+    _comp->Deserialize(istr);
+  };
+
+  // Create / update components
+  for (std::size_t c = 0; c < _state.ColumnCount(); ++c)
+  {
+    const auto column = _state.Column(c);
+    const ComponentTypeId type = column.TypeId();
+
+    // Components which haven't been registered in this process, such as 3rd
+    // party components streamed to other secondaries and the GUI.
+    if (!components::Factory::Instance()->HasType(type))
+    {
+      static std::unordered_set<ComponentTypeId> printedComps;
+      if (printedComps.find(type) == printedComps.end())
+      {
+        printedComps.insert(type);
+        ignwarn << "Component type [" << type << "] has not been "
+                << "registered in this process, so it can't be deserialized."
+                << std::endl;
+      }
+      continue;
+    }
+
+    for (std::size_t i = 0; i < column.Count(); ++i)
+    {
+      const Entity entity = column.EntityAt(i);
+      if (!removed.empty() && removed.find(entity) != removed.end())
+        continue;
+
+      components::BaseComponent *comp =
+        this->ComponentImplementation(entity, type);
+
+      // Update component value
+      if (nullptr != comp)
+      {
+        deserialize(column, i, comp);
+        this->SetChanged(entity, type, ComponentState::PeriodicChange);
+        continue;
+      }
+
+      // Create if new
+      auto newComp = components::Factory::Instance()->New(type);
+      if (nullptr == newComp)
+      {
+        ignerr << "Failed to create component of type [" << type << "]"
+               << std::endl;
+        continue;
+      }
+      deserialize(column, i, newComp.get());
+
+      // A previously removed instance is restored with the new value
+      this->CreateComponentImplementation(entity, type, newComp.get());
+    }
+  }
+
+  return true;
+}
+
+//////////////////////////////////////////////////
+std::shared_ptr<const EntityComponentManagerSnapshot>
+    EntityComponentManager::Snapshot() const
 {
-  // Check cache
-  if (this->dataPtr->descendantCache.find(_entity) !=
-      this->dataPtr->descendantCache.end())
+  IGN_PROFILE("EntityComponentManager::Snapshot");
+  auto snapshot = std::make_shared<EntityComponentManagerSnapshot>();
+  snapshot->entityCount = this->dataPtr->entityCount;
+  snapshot->archetypes = this->dataPtr->storage.Snapshot();
+
+  std::vector<Entity> all;
+  all.reserve(this->dataPtr->storage.EntityCount());
+  snapshot->parents.reserve(snapshot->archetypes.size());
+  for (const auto &archetype : snapshot->archetypes)
+  {
+    std::vector<Entity> parents;
+    parents.reserve(archetype.Entities().size());
+    for (const Entity entity : archetype.Entities())
+    {
+      parents.push_back(this->ParentEntity(entity));
+      all.push_back(entity);
+    }
+    snapshot->parents.push_back(std::move(parents));
+  }
+  snapshot->entities = detail::EntityBitmap(std::move(all));
+
+  return snapshot;
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManager::Restore(
+    const EntityComponentManagerSnapshot &_snapshot)
+{
+  IGN_PROFILE("EntityComponentManager::Restore");
+
+  // Entities of the snapshot may take the place of entities whose removal is
+  // pending
+  if (this->HasEntitiesMarkedForRemoval())
+    this->ProcessRemoveEntityRequests();
+
+  // Remove entities created since the snapshot
+  std::vector<Entity> created;
+  for (const auto &archetype : this->dataPtr->storage.Archetypes())
   {
-    return this->dataPtr->descendantCache[_entity];
+    for (const Entity entity : archetype.Entities())
+    {
+      if (!_snapshot.entities.Contains(entity))
+        created.push_back(entity);
+    }
   }
+  for (const Entity entity : created)
+    this->RequestRemoveEntity(entity, false);
+
+  for (const auto &archetype : _snapshot.archetypes)
+  {
+    const auto &types = archetype.Types();
+    const auto &entities = archetype.Entities();
+
+    // Create entities removed since the snapshot, and remove components
+    // added since the snapshot
+    for (const Entity entity : entities)
+    {
+      if (!this->HasEntity(entity))
+      {
+        this->dataPtr->CreateEntityImplementation(entity);
+        continue;
+      }
+
+      this->dataPtr->AddModifiedComponent(entity);
+      const auto *currentTypes = this->dataPtr->storage.ComponentTypes(entity);
+      if (*currentTypes == types)
+        continue;
 
+      const std::vector<ComponentTypeId> addedTypes(*currentTypes);
+      for (const ComponentTypeId typeId : addedTypes)
+      {
+        if (!std::binary_search(types.begin(), types.end(), typeId))
+          this->RemoveComponent(entity, typeId);
+      }
+    }
+
+    // Copy component values into the current instances, creating the
+    // components removed since the snapshot
+    for (std::size_t c = 0; c < types.size(); ++c)
+    {
+      const ComponentTypeId typeId = types[c];
+      const components::ComponentCopyFn copy =
+          components::ComponentCopy(typeId);
+      auto &oneTimeChanged = this->dataPtr->oneTimeChangedComponents[typeId];
+      for (std::size_t row = 0; row < entities.size(); ++row)
+      {
+        const Entity entity = entities[row];
+        const components::BaseComponent *data = archetype.At(c, row);
+        components::BaseComponent *comp =
+            this->dataPtr->storage.Component(entity, typeId);
+
+        // A previously removed instance is restored with the data
+        if (nullptr == comp)
+        {
+          this->CreateComponentImplementation(entity, typeId, data);
+          continue;
+        }
+
+        oneTimeChanged.insert(entity);
+        this->dataPtr->changes.MarkComponentChanged(entity, typeId);
+        copy(*comp, *data);
+      }
+
+      auto periodicIter =
+          this->dataPtr->periodicChangedComponents.find(typeId);
+      if (periodicIter != this->dataPtr->periodicChangedComponents.end())
+      {
+        for (const Entity entity : entities)
+          periodicIter->second.erase(entity);
+      }
+    }
+  }
+
+  // Parents are set once all entities exist
+  for (std::size_t a = 0; a < _snapshot.archetypes.size(); ++a)
+  {
+    const auto &entities = _snapshot.archetypes[a].Entities();
+    const auto &parents = _snapshot.parents[a];
+    for (std::size_t row = 0; row < entities.size(); ++row)
+    {
+      if (this->ParentEntity(entities[row]) != parents[row])
+        this->SetParentEntity(entities[row], parents[row]);
+    }
+  }
+
+  // IDs aren't reused, since IDs handed out since the snapshot may still be
+  // held, for example by command buffers or systems
+  if (this->dataPtr->entityCount < _snapshot.entityCount)
+    this->dataPtr->entityCount = _snapshot.entityCount;
+}
+
+//////////////////////////////////////////////////
+void EntityComponentManager::Mirror(const EntityComponentManager &_source)
+{
+  IGN_PROFILE("EntityComponentManager::Mirror");
+  const auto &source = *_source.dataPtr;
+
+  // Only the entities which changed since the last call are copied, unless
+  // the source is new or its change history doesn't reach back that far
+  std::vector<Entity> changed;
+  const bool full = this->dataPtr->mirrorSource != &_source ||
+      !source.changes.ChangedSince(this->dataPtr->mirrorTick, changed);
+  if (full)
+  {
+    changed.clear();
+    changed.reserve(source.storage.EntityCount());
+    for (const auto &archetype : source.storage.Archetypes())
+    {
+      changed.insert(changed.end(), archetype.Entities().begin(),
+          archetype.Entities().end());
+    }
+
+    for (const auto &archetype : this->dataPtr->storage.Archetypes())
+    {
+      for (const Entity entity : archetype.Entities())
+      {
+        if (!source.storage.HasEntity(entity))
+          changed.push_back(entity);
+      }
+    }
+  }
+
+  // Entities removed from the source outside of the previous iteration's
+  // removal requests are removed right away
+  bool removed{false};
+  for (const Entity entity : changed)
+  {
+    if (!source.storage.HasEntity(entity) && this->HasEntity(entity))
+    {
+      this->RequestRemoveEntity(entity, false);
+      removed = true;
+    }
+  }
+  if (removed)
+    this->ProcessRemoveEntityRequests();
+
+  std::vector<ComponentTypeId> changedTypes;
+  for (const Entity entity : changed)
+  {
+    const auto *types = source.storage.ComponentTypes(entity);
+    if (nullptr == types)
+      continue;
+
+    changedTypes.clear();
+    if (!this->HasEntity(entity))
+    {
+      this->dataPtr->CreateEntityImplementation(entity);
+      changedTypes = *types;
+    }
+    else if (full)
+    {
+      changedTypes = *types;
+    }
+    else
+    {
+      source.changes.ComponentsChangedSince(entity, this->dataPtr->mirrorTick,
+          changedTypes);
+    }
+
+    const auto *currentTypes = this->dataPtr->storage.ComponentTypes(entity);
+    if (*currentTypes != *types)
+    {
+      const std::vector<ComponentTypeId> oldTypes(*currentTypes);
+      for (const ComponentTypeId typeId : oldTypes)
+      {
+        if (!std::binary_search(types->begin(), types->end(), typeId))
+          this->RemoveComponent(entity, typeId);
+      }
+
+      // Missing components are created, or restored, with the source's value
+      for (const ComponentTypeId typeId : *types)
+      {
+        if (nullptr == this->dataPtr->storage.Component(entity, typeId))
+        {
+          this->CreateComponentImplementation(entity, typeId,
+              source.storage.Component(entity, typeId));
+        }
+      }
+    }
+
+    for (const ComponentTypeId typeId : changedTypes)
+    {
+      const components::BaseComponent *data =
+          source.storage.Component(entity, typeId);
+      components::BaseComponent *comp =
+          this->dataPtr->storage.Component(entity, typeId);
+      if (nullptr != data && nullptr != comp)
+        components::ComponentCopy(typeId)(*comp, *data);
+    }
+  }
+
+  // Parents are set once all entities exist
+  for (const Entity entity : changed)
+  {
+    if (!source.storage.HasEntity(entity))
+      continue;
+
+    const Entity parent = _source.ParentEntity(entity);
+    if (this->ParentEntity(entity) != parent)
+      this->SetParentEntity(entity, parent);
+  }
+
+  // The changes made above are replaced by those of the source
+  this->dataPtr->periodicChangedComponents = source.periodicChangedComponents;
+  this->dataPtr->oneTimeChangedComponents = source.oneTimeChangedComponents;
+  this->dataPtr->modifiedComponents = source.modifiedComponents;
+
+  if (source.removeAllEntities)
+    this->RequestRemoveEntities();
+  for (const Entity entity : source.toRemoveEntities)
+    this->RequestRemoveEntity(entity, false);
+
+  if (this->dataPtr->entityCount < source.entityCount)
+    this->dataPtr->entityCount = source.entityCount;
+
+  this->dataPtr->mirrorSource = &_source;
+  this->dataPtr->mirrorTick = source.changes.Tick();
+}
+
+//////////////////////////////////////////////////
+std::unordered_set<Entity> EntityComponentManager::Descendants(Entity _entity)
+    const
+{
   std::unordered_set<Entity> descendants;
 
   if (!this->HasEntity(_entity))
     return descendants;
 
-  auto descVector = math::graph::BreadthFirstSort(this->dataPtr->entities,
-      _entity);
-  std::move(descVector.begin(), descVector.end(), std::inserter(descendants,
-      descendants.end()));
-
-  this->dataPtr->descendantCache[_entity] = descendants;
+  this->dataPtr->InsertEntityRecursive(_entity, descendants);
   return descendants;
 }
 
@@ -1880,14 +3643,8 @@ void EntityComponentManager::SetChanged(
     const Entity _entity, const ComponentTypeId _type,
     gazebo::ComponentState _c)
 {
-  // make sure _entity exists
-  auto ecIter = this->dataPtr->componentTypeIndex.find(_entity);
-  if (ecIter == this->dataPtr->componentTypeIndex.end())
-    return;
-
-  // make sure the entity has a component of type _type
-  if (ecIter->second.find(_type) == ecIter->second.end() ||
-      this->dataPtr->ComponentMarkedAsRemoved(_entity, _type))
+  // make sure _entity exists and has a component of type _type
+  if (nullptr == this->dataPtr->storage.Component(_entity, _type))
     return;
 
   if (_c == ComponentState::PeriodicChange)
@@ -1914,6 +3671,9 @@ void EntityComponentManager::SetChanged(
       oneTimeIter->second.erase(_entity);
   }
 
+  if (_c != ComponentState::NoChange)
+    this->dataPtr->changes.MarkComponentChanged(_entity, _type);
+
   this->dataPtr->AddModifiedComponent(_entity);
 }
 
@@ -1921,18 +3681,11 @@ void EntityComponentManager::SetChanged(
 std::unordered_set<ComponentTypeId> EntityComponentManager::ComponentTypes(
     const Entity _entity) const
 {
-  auto it = this->dataPtr->componentTypeIndex.find(_entity);
-  if (it == this->dataPtr->componentTypeIndex.end())
+  auto types = this->dataPtr->storage.ComponentTypes(_entity);
+  if (nullptr == types)
     return {};
 
-  std::unordered_set<ComponentTypeId> result;
-  for (const auto &type : it->second)
-  {
-    if (!this->dataPtr->ComponentMarkedAsRemoved(_entity, type.first))
-      result.insert(type.first);
-  }
-
-  return result;
+  return std::unordered_set<ComponentTypeId>(types->begin(), types->end());
 }
 
 /////////////////////////////////////////////////
@@ -1951,6 +3704,14 @@ void EntityComponentManager::SetEntityCreateOffset(uint64_t _offset)
 /////////////////////////////////////////////////
 void EntityComponentManager::LockAddingEntitiesToViews(bool _lock)
 {
+  // Views only grow when entities are added to them, so once all of them
+  // are up to date, threads can iterate over them while others look them up
+  if (_lock && !this->dataPtr->lockAddEntitiesToViews)
+  {
+    std::lock_guard<std::mutex> lockViews(this->dataPtr->viewsMutex);
+    for (auto &[view, flush] : this->dataPtr->viewFlushFns)
+      flush(*this, *view);
+  }
   this->dataPtr->lockAddEntitiesToViews = _lock;
 }
 
@@ -1977,14 +3738,23 @@ void EntityComponentManagerPrivate::AddModifiedComponent(const Entity &_entity)
 }
 
 /////////////////////////////////////////////////
-bool EntityComponentManagerPrivate::ComponentMarkedAsRemoved(
-    const Entity _entity, const ComponentTypeId _typeId) const
+void EntityComponentManagerPrivate::UpdateRelocatedEntities()
 {
-  auto iter = this->componentsMarkedAsRemoved.find(_entity);
-  if (iter != this->componentsMarkedAsRemoved.end())
-    return iter->second.find(_typeId) != iter->second.end();
+  const auto &relocated = this->storage.Relocated();
+  if (relocated.empty())
+    return;
 
-  return false;
+  {
+    std::lock_guard<std::mutex> lock(this->entityCreatedMutex);
+    for (const Entity entity : relocated)
+    {
+      const bool isNew = this->newlyCreatedEntities.find(entity) !=
+          this->newlyCreatedEntities.end();
+      for (auto &view : this->views)
+        view.second.first->MarkEntityToUpdate(entity, isNew);
+    }
+  }
+  this->storage.ClearRelocated();
 }
 
 /////////////////////////////////////////////////
@@ -2068,3 +3838,92 @@ void EntityComponentManager::UnpinAllEntities()
 {
   this->dataPtr->pinnedEntities.clear();
 }
+
+/////////////////////////////////////////////////
+EntityCommandBuffer &EntityComponentManager::CommandBuffer()
+{
+  std::vector<uint64_t> key = tlCommandScope;
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->commandBuffersMutex);
+  if (key.empty())
+  {
+    // After the scoped buffers, in the order of the threads' first requests
+    auto &unscoped = this->dataPtr->unscopedCommandBuffers;
+    auto inserted = unscoped.emplace(std::this_thread::get_id(),
+        unscoped.size());
+    key = {std::numeric_limits<uint64_t>::max(), inserted.first->second};
+  }
+
+  auto &buffer = this->dataPtr->commandBuffers[key];
+  if (nullptr == buffer)
+  {
+    auto &free = this->dataPtr->freeCommandBuffers;
+    if (free.empty())
+    {
+      buffer = std::make_unique<EntityCommandBuffer>(*this);
+    }
+    else
+    {
+      buffer = std::move(free.back());
+      free.pop_back();
+    }
+  }
+  return *buffer;
+}
+
+/////////////////////////////////////////////////
+EntityComponentManager::CommandScope::CommandScope(uint64_t _key)
+{
+  tlCommandScope.push_back(_key);
+}
+
+/////////////////////////////////////////////////
+EntityComponentManager::CommandScope::~CommandScope()
+{
+  tlCommandScope.pop_back();
+}
+
+/////////////////////////////////////////////////
+Entity EntityComponentManager::ReserveEntity()
+{
+  Entity entity = ++this->dataPtr->entityCount;
+  if (entity == std::numeric_limits<uint64_t>::max())
+  {
+    ignwarn << "Reached maximum number of entities [" << entity << "]"
+            << std::endl;
+    return kNullEntity;
+  }
+  return entity;
+}
+
+/////////////////////////////////////////////////
+Entity EntityComponentManager::CreateReservedEntity(const Entity _entity)
+{
+  return this->dataPtr->CreateEntityImplementation(_entity);
+}
+
+/////////////////////////////////////////////////
+void EntityComponentManager::ApplyCommandBuffers()
+{
+  IGN_PROFILE("EntityComponentManager::ApplyCommandBuffers");
+
+  // Don't hold the lock while applying, commands may request buffers too.
+  // Those are applied by the next call.
+  std::map<std::vector<uint64_t>, std::unique_ptr<EntityCommandBuffer>>
+      buffers;
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->commandBuffersMutex);
+    buffers.swap(this->dataPtr->commandBuffers);
+    this->dataPtr->unscopedCommandBuffers.clear();
+  }
+
+  if (buffers.empty())
+    return;
+
+  for (auto &buffer : buffers)
+    buffer.second->Apply();
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->commandBuffersMutex);
+  for (auto &buffer : buffers)
+    this->dataPtr->freeCommandBuffers.push_back(std::move(buffer.second));
+}
@@ -17,6 +17,16 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
 #include <ignition/common/Console.hh>
 #include <ignition/common/Util.hh>
 #include <ignition/math/Pose3.hh>
@@ -105,8 +115,26 @@ class EntityCompMgrTest : public EntityComponentManager
   {
     this->ClearRemovedComponents();
   }
+  public: void RunMirror(const EntityComponentManager &_source)
+  {
+    this->Mirror(_source);
+  }
 };
 
+/////////////////////////////////////////////////
+/// \brief Deserialize the data of a serialized component.
+/// \param[in] _msg Serialized component.
+/// \return The component's data.
+template <typename ComponentTypeT>
+typename ComponentTypeT::Type componentData(
+    const msgs::SerializedComponent &_msg)
+{
+  ComponentTypeT comp;
+  std::istringstream istr(_msg.component());
+  comp.Deserialize(istr);
+  return comp.Data();
+}
+
 class EntityComponentManagerFixture
   : public InternalFixture<::testing::TestWithParam<int>>
 {
@@ -1529,6 +1557,18 @@ TEST_P(EntityComponentManagerFixture, EntityGraph)
   EXPECT_TRUE(manager.SetParentEntity(e5, e3));
   EXPECT_EQ(e3, manager.ParentEntity(e5));
 
+  // Can't create cycles
+  EXPECT_FALSE(manager.SetParentEntity(e1, e1));
+  EXPECT_FALSE(manager.SetParentEntity(e1, e5));
+  EXPECT_EQ(gazebo::kNullEntity, manager.ParentEntity(e1));
+
+  // Failed calls keep the current parent
+  EXPECT_FALSE(manager.SetParentEntity(e2, e4));
+  EXPECT_FALSE(manager.SetParentEntity(e5, gazebo::Entity(1000)));
+  EXPECT_EQ(e1, manager.ParentEntity(e2));
+  EXPECT_EQ(e3, manager.ParentEntity(e5));
+  EXPECT_EQ(1u, manager.Descendants(e3).count(e5));
+
   /*        1       7
    *      /   \
    *     2     3
@@ -1671,7 +1711,7 @@ TEST_P(EntityComponentManagerFixture, State)
     auto compIter = e1Msg.components().begin();
     const auto &e1c0Msg = compIter->second;
     EXPECT_EQ(IntComponent::typeId, e1c0Msg.type());
-    EXPECT_EQ(e1c0, std::stoi(e1c0Msg.component()));
+    EXPECT_EQ(e1c0, componentData<IntComponent>(e1c0Msg));
 
     iter = stateMsg.entities().find(e2);
     const auto &e2Msg = iter->second;
@@ -1683,7 +1723,7 @@ TEST_P(EntityComponentManagerFixture, State)
     {
       const auto &e2c0Msg = compIter->second;
       EXPECT_EQ(DoubleComponent::typeId, e2c0Msg.type());
-      EXPECT_DOUBLE_EQ(e2c0, std::stod(e2c0Msg.component()));
+      EXPECT_DOUBLE_EQ(e2c0, componentData<DoubleComponent>(e2c0Msg));
     }
     else
     {
@@ -1697,7 +1737,7 @@ TEST_P(EntityComponentManagerFixture, State)
     {
       const auto &e2c0Msg = compIter->second;
       EXPECT_EQ(DoubleComponent::typeId, e2c0Msg.type());
-      EXPECT_DOUBLE_EQ(e2c0, std::stod(e2c0Msg.component()));
+      EXPECT_DOUBLE_EQ(e2c0, componentData<DoubleComponent>(e2c0Msg));
     }
     else
     {
@@ -1713,7 +1753,7 @@ TEST_P(EntityComponentManagerFixture, State)
 
     const auto &e3c0Msg = e3Msg.components().begin()->second;
     EXPECT_EQ(IntComponent::typeId, e3c0Msg.type());
-    EXPECT_EQ(e3c0, std::stoi(e3c0Msg.component()));
+    EXPECT_EQ(e3c0, componentData<IntComponent>(e3c0Msg));
   }
 
   // Serialize changed state into a message, it should be the same
@@ -1884,7 +1924,7 @@ TEST_P(EntityComponentManagerFixture, State)
     auto compIter = e3Msg.components().begin();
     const auto &e3c0Msg = compIter->second;
     EXPECT_EQ(IntComponent::typeId, e3c0Msg.type());
-    EXPECT_EQ(e3c0New, std::stoi(e3c0Msg.component()));
+    EXPECT_EQ(e3c0New, componentData<IntComponent>(e3c0Msg));
 
     iter = stateMsg2.entities().find(e4);
     const auto &e4Msg = iter->second;
@@ -1894,7 +1934,7 @@ TEST_P(EntityComponentManagerFixture, State)
     auto compIter4 = e4Msg.components().begin();
     const auto &e4c0Msg = compIter4->second;
     EXPECT_EQ(IntComponent::typeId, e4c0Msg.type());
-    EXPECT_EQ(e4c0, std::stoi(e4c0Msg.component()));
+    EXPECT_EQ(e4c0, componentData<IntComponent>(e4c0Msg));
   }
 }
 
@@ -1968,6 +2008,113 @@ TEST_P(EntityComponentManagerFixture, ChangedStateComponents)
   EXPECT_EQ(1, changedStateMsg.entities_size());
 }
 
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, ChangedStateSince)
+{
+  EXPECT_EQ(0u, manager.ChangeTick());
+
+  Entity e1 = manager.CreateEntity();
+  Entity e2 = manager.CreateEntity();
+  manager.CreateComponent<IntComponent>(e1, IntComponent(1));
+  manager.CreateComponent<IntComponent>(e2, IntComponent(2));
+  manager.CreateComponent<DoubleComponent>(e2, DoubleComponent(2.0));
+  EXPECT_LT(0u, manager.ComponentChangeTick(e1, IntComponent::typeId));
+  EXPECT_EQ(0u, manager.ComponentChangeTick(e1, DoubleComponent::typeId));
+
+  // Everything is new
+  msgs::SerializedStateMap stateMsg;
+  EXPECT_TRUE(manager.ChangedStateSince(0, stateMsg));
+  ASSERT_EQ(2, stateMsg.entities_size());
+  EXPECT_EQ(2, stateMsg.entities().at(e2).components_size());
+
+  // Two consumers at different rates
+  uint64_t fast = manager.ChangeTick();
+  uint64_t slow = manager.ChangeTick();
+
+  stateMsg.Clear();
+  EXPECT_TRUE(manager.ChangedStateSince(fast, stateMsg));
+  EXPECT_EQ(0, stateMsg.entities_size());
+
+  // Per-iteration changes are cleared, ticks aren't
+  manager.RunClearNewlyCreatedEntities();
+  manager.RunSetAllComponentsUnchanged();
+
+  manager.Component<DoubleComponent>(e2)->Data() = 3.0;
+  manager.SetChanged(e2, DoubleComponent::typeId,
+      ComponentState::PeriodicChange);
+  EXPECT_EQ(manager.ChangeTick(),
+      manager.ComponentChangeTick(e2, DoubleComponent::typeId));
+
+  // Only the changed component is serialized
+  stateMsg.Clear();
+  EXPECT_TRUE(manager.ChangedStateSince(fast, stateMsg));
+  ASSERT_EQ(1, stateMsg.entities_size());
+  const auto &e2Msg = stateMsg.entities().at(e2);
+  ASSERT_EQ(1, e2Msg.components_size());
+  EXPECT_DOUBLE_EQ(3.0, componentData<DoubleComponent>(
+      e2Msg.components().at(DoubleComponent::typeId)));
+  fast = manager.ChangeTick();
+
+  // So is data set through SetComponentData
+  EXPECT_TRUE(manager.SetComponentData<DoubleComponent>(e2, 4.0));
+  EXPECT_EQ(manager.ChangeTick(),
+      manager.ComponentChangeTick(e2, DoubleComponent::typeId));
+  stateMsg.Clear();
+  EXPECT_TRUE(manager.ChangedStateSince(fast, stateMsg));
+  ASSERT_EQ(1, stateMsg.entities_size());
+  EXPECT_DOUBLE_EQ(4.0, componentData<DoubleComponent>(
+      stateMsg.entities().at(e2).components().at(DoubleComponent::typeId)));
+  fast = manager.ChangeTick();
+
+  manager.RunSetAllComponentsUnchanged();
+  EXPECT_TRUE(manager.RemoveComponent(e1, IntComponent::typeId));
+  manager.RunClearRemovedComponents();
+
+  // The removal is still reported after the iteration ended
+  manager.RunSetAllComponentsUnchanged();
+  stateMsg.Clear();
+  EXPECT_TRUE(manager.ChangedStateSince(fast, stateMsg));
+  ASSERT_EQ(1, stateMsg.entities_size());
+  const auto &e1Msg = stateMsg.entities().at(e1);
+  EXPECT_FALSE(e1Msg.remove());
+  ASSERT_EQ(1, e1Msg.components_size());
+  EXPECT_TRUE(e1Msg.components().at(IntComponent::typeId).remove());
+  fast = manager.ChangeTick();
+
+  // Entity removal
+  manager.RequestRemoveEntity(e2);
+  stateMsg.Clear();
+  EXPECT_TRUE(manager.ChangedStateSince(fast, stateMsg));
+  ASSERT_EQ(1, stateMsg.entities_size());
+  EXPECT_TRUE(stateMsg.entities().at(e2).remove());
+
+  manager.ProcessEntityRemovals();
+  stateMsg.Clear();
+  EXPECT_TRUE(manager.ChangedStateSince(fast, stateMsg));
+  ASSERT_EQ(1, stateMsg.entities_size());
+  EXPECT_TRUE(stateMsg.entities().at(e2).remove());
+  EXPECT_EQ(0, stateMsg.entities().at(e2).components_size());
+
+  // The slow consumer gets everything since its last query at once
+  stateMsg.Clear();
+  EXPECT_TRUE(manager.ChangedStateSince(slow, stateMsg));
+  ASSERT_EQ(2, stateMsg.entities_size());
+  EXPECT_TRUE(
+      stateMsg.entities().at(e1).components().at(IntComponent::typeId)
+      .remove());
+  EXPECT_TRUE(stateMsg.entities().at(e2).remove());
+
+  // Apply the changes to another manager
+  EntityCompMgrTest other;
+  msgs::SerializedStateMap fullMsg;
+  EXPECT_TRUE(manager.ChangedStateSince(0, fullMsg));
+  other.SetState(fullMsg);
+  other.ProcessEntityRemovals();
+  EXPECT_TRUE(other.HasEntity(e1));
+  EXPECT_FALSE(other.HasEntity(e2));
+  EXPECT_EQ(nullptr, other.Component<IntComponent>(e1));
+}
+
 /////////////////////////////////////////////////
 TEST_P(EntityComponentManagerFixture, Descendants)
 {
@@ -2229,7 +2376,7 @@ TEST_P(EntityComponentManagerFixture, SetChanged)
     auto compIter = e1Msg.components().begin();
     const auto &e1c1Msg = compIter->second;
     EXPECT_EQ(IntComponent::typeId, e1c1Msg.type());
-    EXPECT_EQ(123, std::stoi(e1c1Msg.component()));
+    EXPECT_EQ(123, componentData<IntComponent>(e1c1Msg));
   }
 
   manager.SetChanged(e2, c2->TypeId(), ComponentState::OneTimeChange);
@@ -3113,6 +3260,1218 @@ TEST_P(EntityComponentManagerFixture, StateMsgUpdateComponent)
   EXPECT_EQ(1, foundEntities);
 }
 
+//////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, EachParallel)
+{
+  // Entities with both components, and some that only have one
+  const int kMatching{1000};
+  for (int i = 0; i < kMatching; ++i)
+  {
+    Entity entity = manager.CreateEntity();
+    manager.CreateComponent<IntComponent>(entity, IntComponent(i));
+    manager.CreateComponent<DoubleComponent>(entity, DoubleComponent(0.0));
+  }
+  for (int i = 0; i < 100; ++i)
+  {
+    Entity entity = manager.CreateEntity();
+    manager.CreateComponent<IntComponent>(entity, IntComponent(i));
+  }
+
+  // Write to the components of each entity, with automatic and small chunks
+  for (std::size_t chunkSize : {0u, 1u, 7u})
+  {
+    std::atomic<int> count{0};
+    manager.EachParallel<IntComponent, DoubleComponent>(
+        [&](const Entity &, IntComponent *_int, DoubleComponent *_double)
+        {
+          _double->Data() += _int->Data();
+          count++;
+        }, chunkSize);
+    EXPECT_EQ(kMatching, count.load());
+  }
+
+  // Every entity was visited exactly once per call
+  const EntityComponentManager &constManager = manager;
+  std::atomic<int> mismatches{0};
+  constManager.EachParallel<IntComponent, DoubleComponent>(
+      [&](const Entity &, const IntComponent *_int,
+          const DoubleComponent *_double)
+      {
+        if (!math::equal(_double->Data(), 3.0 * _int->Data()))
+          mismatches++;
+      });
+  EXPECT_EQ(0, mismatches.load());
+
+  // Chunks cover all entities without overlapping
+  std::mutex mutex;
+  std::set<Entity> visited;
+  std::size_t chunks{0};
+  manager.ForEachChunk<IntComponent, DoubleComponent>(
+      [&](const std::tuple<Entity, IntComponent *, DoubleComponent *> *_chunk,
+          std::size_t _count)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++chunks;
+        EXPECT_GE(10u, _count);
+        for (std::size_t i = 0; i < _count; ++i)
+          EXPECT_TRUE(visited.insert(std::get<Entity>(_chunk[i])).second);
+      }, 10);
+  EXPECT_EQ(static_cast<std::size_t>(kMatching), visited.size());
+  EXPECT_EQ(static_cast<std::size_t>(kMatching / 10), chunks);
+
+  // Nothing to do for views without entities
+  manager.EachParallel<StringComponent>(
+      [&](const Entity &, StringComponent *)
+      {
+        ADD_FAILURE() << "Unexpected callback";
+      });
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, StateMapConcurrent)
+{
+  // Enough entities to be split into several ranges
+  for (int i = 0; i < 1000; ++i)
+  {
+    auto entity = manager.CreateEntity();
+    manager.CreateComponent<IntComponent>(entity, IntComponent(i));
+    manager.CreateComponent<StringComponent>(entity,
+        StringComponent(std::to_string(i)));
+  }
+
+  int count{1000};
+  auto checkState = [&count](const msgs::SerializedStateMap &_state)
+  {
+    ASSERT_EQ(count, _state.entities_size());
+    for (const auto &entity : _state.entities())
+    {
+      EXPECT_EQ(entity.first, entity.second.id());
+      EXPECT_EQ(2, entity.second.components_size());
+    }
+  };
+
+  // Serialize from several threads at once, the way the scene broadcaster and
+  // the log recorder do, several times so buffers are reused
+  std::vector<msgs::SerializedStateMap> states(4);
+  auto serializeConcurrently = [&]
+  {
+    std::vector<std::thread> threads;
+    for (auto &state : states)
+    {
+      threads.emplace_back([&]
+      {
+        for (int i = 0; i < 5; ++i)
+        {
+          state.Clear();
+          manager.State(state, {}, {}, true);
+        }
+      });
+    }
+    for (auto &thread : threads)
+      thread.join();
+
+    for (const auto &state : states)
+      checkState(state);
+  };
+  serializeConcurrently();
+
+  // New entities make the first of the concurrent calls split the entities
+  // again, which mustn't affect the calls already serializing
+  for (int i = 0; i < 500; ++i)
+  {
+    auto entity = manager.CreateEntity();
+    manager.CreateComponent<IntComponent>(entity, IntComponent(i));
+    manager.CreateComponent<StringComponent>(entity,
+        StringComponent(std::to_string(i)));
+  }
+  count = 1500;
+  serializeConcurrently();
+
+  // Entries already in the message are overwritten
+  msgs::SerializedStateMap state;
+  (*state.mutable_entities())[1].set_id(12345);
+  manager.State(state, {}, {}, true);
+  checkState(state);
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, BinaryState)
+{
+  auto e1 = manager.CreateEntity();
+  manager.CreateComponent(e1, IntComponent(1));
+  manager.CreateComponent(e1, StringComponent("first"));
+  manager.CreateComponent(e1, components::Name("name with spaces"));
+
+  auto e2 = manager.CreateEntity();
+  manager.CreateComponent(e2, IntComponent(2));
+  manager.CreateComponent(e2, DoubleComponent(2.5));
+  manager.CreateComponent(e2,
+      components::Pose(math::Pose3d(1, 2, 3, 0, 0, 0)));
+  manager.CreateComponent(e2, Even());
+
+  auto e3 = manager.CreateEntity();
+  manager.CreateComponent(e3, IntComponent(3));
+  manager.RequestRemoveEntity(e3);
+
+  std::vector<char> buffer;
+  manager.BinaryState(buffer);
+
+  BinaryStateView view(buffer.data(), buffer.size());
+  ASSERT_TRUE(view.Valid());
+  EXPECT_EQ(buffer.size(), view.Size());
+  EXPECT_EQ(3u, view.EntityCount());
+  for (std::size_t i = 0; i < view.EntityCount(); ++i)
+  {
+    EXPECT_EQ(view.EntityAt(i).id == e3 ? kBinaryStateEntityRemoved : 0u,
+        view.EntityAt(i).flags);
+  }
+
+  // One column per type
+  EXPECT_EQ(6u, view.ColumnCount());
+  for (std::size_t c = 0; c < view.ColumnCount(); ++c)
+  {
+    auto column = view.Column(c);
+    if (column.TypeId() == IntComponent::typeId)
+    {
+      EXPECT_EQ(3u, column.Count());
+    }
+    else if (column.TypeId() == DoubleComponent::typeId)
+    {
+      ASSERT_EQ(1u, column.Count());
+      EXPECT_EQ(e2, column.EntityAt(0));
+      ASSERT_EQ(1u + sizeof(double), column.Size(0));
+      EXPECT_EQ(serializers::kBinarySerializationMarker, column.Data(0)[0]);
+    }
+  }
+
+  // Apply to a new manager
+  EntityComponentManager other;
+  EXPECT_TRUE(other.SetBinaryState(view));
+  EXPECT_TRUE(other.HasEntity(e1));
+  EXPECT_TRUE(other.HasEntity(e2));
+  EXPECT_FALSE(other.HasEntity(e3));
+
+  ASSERT_NE(nullptr, other.Component<IntComponent>(e1));
+  EXPECT_EQ(1, other.Component<IntComponent>(e1)->Data());
+  ASSERT_NE(nullptr, other.Component<StringComponent>(e1));
+  EXPECT_EQ("first", other.Component<StringComponent>(e1)->Data());
+  ASSERT_NE(nullptr, other.Component<components::Name>(e1));
+  EXPECT_EQ("name with spaces",
+      other.Component<components::Name>(e1)->Data());
+  ASSERT_NE(nullptr, other.Component<IntComponent>(e2));
+  EXPECT_EQ(2, other.Component<IntComponent>(e2)->Data());
+  ASSERT_NE(nullptr, other.Component<DoubleComponent>(e2));
+  EXPECT_DOUBLE_EQ(2.5, other.Component<DoubleComponent>(e2)->Data());
+  ASSERT_NE(nullptr, other.Component<components::Pose>(e2));
+  EXPECT_EQ(math::Pose3d(1, 2, 3, 0, 0, 0),
+      other.Component<components::Pose>(e2)->Data());
+  EXPECT_NE(nullptr, other.Component<Even>(e2));
+
+  // Update existing components, including one that was removed
+  manager.SetComponentData<IntComponent>(e1, 10);
+  manager.SetComponentData<DoubleComponent>(e2, 20.5);
+  EXPECT_TRUE(other.RemoveComponent<DoubleComponent>(e2));
+
+  manager.BinaryState(buffer, {e1, e2}, {IntComponent::typeId,
+      DoubleComponent::typeId});
+  BinaryStateView filtered(buffer.data(), buffer.size());
+  ASSERT_TRUE(filtered.Valid());
+  EXPECT_EQ(2u, filtered.EntityCount());
+  EXPECT_EQ(2u, filtered.ColumnCount());
+
+  EXPECT_TRUE(other.SetBinaryState(filtered));
+  EXPECT_EQ(10, other.Component<IntComponent>(e1)->Data());
+  EXPECT_EQ(ComponentState::PeriodicChange,
+      other.ComponentState(e1, IntComponent::typeId));
+  ASSERT_NE(nullptr, other.Component<DoubleComponent>(e2));
+  EXPECT_DOUBLE_EQ(20.5, other.Component<DoubleComponent>(e2)->Data());
+  EXPECT_EQ("first", other.Component<StringComponent>(e1)->Data());
+
+  // Invalid buffers are rejected
+  EXPECT_FALSE(other.SetBinaryState(BinaryStateView()));
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, StateMapWireRoundTrip)
+{
+  // Components go into protobuf string fields, which must be valid UTF-8,
+  // so state messages must survive serialization to the wire
+  auto e1 = manager.CreateEntity();
+  manager.CreateComponent(e1, IntComponent(-1));
+  manager.CreateComponent(e1, DoubleComponent(1.0 / 3.0));
+  manager.CreateComponent(e1,
+      components::Pose(math::Pose3d(1, -2, 3, 0.1, 0.2, 0.3)));
+
+  auto e2 = manager.CreateEntity();
+  manager.CreateComponent(e2, IntComponent(256));
+  manager.CreateComponent(e2, Even());
+
+  // Binary state doesn't leak into messages
+  std::vector<char> buffer;
+  manager.BinaryState(buffer);
+
+  msgs::SerializedStateMap stateMsg;
+  manager.State(stateMsg);
+
+  std::string wire;
+  ASSERT_TRUE(stateMsg.SerializeToString(&wire));
+  msgs::SerializedStateMap parsed;
+  ASSERT_TRUE(parsed.ParseFromString(wire));
+  EXPECT_EQ(2, parsed.entities_size());
+
+  EntityComponentManager other;
+  other.SetState(parsed);
+
+  ASSERT_NE(nullptr, other.Component<IntComponent>(e1));
+  EXPECT_EQ(-1, other.Component<IntComponent>(e1)->Data());
+  ASSERT_NE(nullptr, other.Component<DoubleComponent>(e1));
+  EXPECT_NEAR(1.0 / 3.0, other.Component<DoubleComponent>(e1)->Data(),
+      1e-6);
+  ASSERT_NE(nullptr, other.Component<components::Pose>(e1));
+  EXPECT_EQ(math::Pose3d(1, -2, 3, 0.1, 0.2, 0.3),
+      other.Component<components::Pose>(e1)->Data());
+  ASSERT_NE(nullptr, other.Component<IntComponent>(e2));
+  EXPECT_EQ(256, other.Component<IntComponent>(e2)->Data());
+  EXPECT_NE(nullptr, other.Component<Even>(e2));
+
+  // Changed state messages, as published by the scene broadcaster and
+  // recorded in logs, too
+  manager.SetComponentData<DoubleComponent>(e1, 0.1);
+  manager.SetChanged(e1, DoubleComponent::typeId,
+      ComponentState::OneTimeChange);
+  msgs::SerializedStateMap changedMsg;
+  manager.ChangedState(changedMsg);
+  ASSERT_TRUE(changedMsg.SerializeToString(&wire));
+  ASSERT_TRUE(parsed.ParseFromString(wire));
+  other.SetState(parsed);
+  EXPECT_DOUBLE_EQ(0.1, other.Component<DoubleComponent>(e1)->Data());
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, CachedWorldPose)
+{
+  EXPECT_FALSE(manager.WorldPoseCacheEnabled());
+  manager.EnableWorldPoseCache(true);
+  EXPECT_TRUE(manager.WorldPoseCacheEnabled());
+
+  // world -> model -> link -> sensor, and a second model
+  Entity world = manager.CreateEntity();
+  Entity model = manager.CreateEntity();
+  Entity link = manager.CreateEntity();
+  Entity sensor = manager.CreateEntity();
+  Entity other = manager.CreateEntity();
+  Entity noPose = manager.CreateEntity();
+
+  manager.SetParentEntity(model, world);
+  manager.SetParentEntity(link, model);
+  manager.SetParentEntity(sensor, link);
+  manager.SetParentEntity(other, world);
+  manager.SetParentEntity(noPose, world);
+
+  manager.CreateComponent(model, components::ParentEntity(world));
+  manager.CreateComponent(link, components::ParentEntity(model));
+  manager.CreateComponent(sensor, components::ParentEntity(link));
+  manager.CreateComponent(other, components::ParentEntity(world));
+  manager.CreateComponent(noPose, components::ParentEntity(world));
+
+  const math::Pose3d modelPose(1, 2, 3, 0, 0, IGN_PI_2);
+  const math::Pose3d linkPose(1, 0, 0, 0, 0, 0);
+  const math::Pose3d sensorPose(0, 0, 1, 0, 0, 0);
+  manager.CreateComponent(model, components::Pose(modelPose));
+  manager.CreateComponent(link, components::Pose(linkPose));
+  manager.CreateComponent(sensor, components::Pose(sensorPose));
+  manager.CreateComponent(other, components::Pose(linkPose));
+
+  math::Pose3d pose;
+  EXPECT_FALSE(manager.CachedWorldPose(world, pose));
+  EXPECT_FALSE(manager.CachedWorldPose(noPose, pose));
+  EXPECT_FALSE(manager.CachedWorldPose(kNullEntity, pose));
+
+  // The world has no pose, so the model pose is used as is
+  ASSERT_TRUE(manager.CachedWorldPose(model, pose));
+  EXPECT_EQ(modelPose, pose);
+  ASSERT_TRUE(manager.CachedWorldPose(sensor, pose));
+  EXPECT_EQ(sensorPose + linkPose + modelPose, pose);
+  ASSERT_TRUE(manager.CachedWorldPose(link, pose));
+  EXPECT_EQ(linkPose + modelPose, pose);
+  ASSERT_TRUE(manager.CachedWorldPose(other, pose));
+  EXPECT_EQ(linkPose, pose);
+
+  // Repeated queries are stable
+  ASSERT_TRUE(manager.CachedWorldPose(sensor, pose));
+  EXPECT_EQ(sensorPose + linkPose + modelPose, pose);
+
+  // Moving the model moves its descendants
+  const math::Pose3d newModelPose(-1, 0, 0, 0, 0, 0);
+  manager.Component<components::Pose>(model)->Data() = newModelPose;
+  manager.SetChanged(model, components::Pose::typeId,
+      ComponentState::OneTimeChange);
+  ASSERT_TRUE(manager.CachedWorldPose(sensor, pose));
+  EXPECT_EQ(sensorPose + linkPose + newModelPose, pose);
+  ASSERT_TRUE(manager.CachedWorldPose(link, pose));
+  EXPECT_EQ(linkPose + newModelPose, pose);
+  ASSERT_TRUE(manager.CachedWorldPose(other, pose));
+  EXPECT_EQ(linkPose, pose);
+
+  // SetComponentData is seen without SetChanged
+  const math::Pose3d newLinkPose(0, 5, 0, 0, 0, 0);
+  EXPECT_TRUE(manager.SetComponentData<components::Pose>(link, newLinkPose));
+  ASSERT_TRUE(manager.CachedWorldPose(sensor, pose));
+  EXPECT_EQ(sensorPose + newLinkPose + newModelPose, pose);
+
+  // Reparenting the sensor
+  manager.SetParentEntity(sensor, other);
+  *manager.Component<components::ParentEntity>(sensor) =
+      components::ParentEntity(other);
+  manager.SetChanged(sensor, components::ParentEntity::typeId,
+      ComponentState::OneTimeChange);
+  ASSERT_TRUE(manager.CachedWorldPose(sensor, pose));
+  EXPECT_EQ(sensorPose + linkPose, pose);
+
+  // Removing the pose component
+  manager.RemoveComponent<components::Pose>(other);
+  EXPECT_FALSE(manager.CachedWorldPose(other, pose));
+  ASSERT_TRUE(manager.CachedWorldPose(sensor, pose));
+  EXPECT_EQ(sensorPose, pose);
+
+  // Removing entities
+  manager.RequestRemoveEntity(model);
+  manager.ProcessEntityRemovals();
+  EXPECT_FALSE(manager.CachedWorldPose(model, pose));
+  EXPECT_FALSE(manager.CachedWorldPose(link, pose));
+  ASSERT_TRUE(manager.CachedWorldPose(sensor, pose));
+  EXPECT_EQ(sensorPose, pose);
+
+  // Concurrent queries from const references
+  const EntityComponentManager &constManager = manager;
+  std::vector<std::thread> threads;
+  std::atomic<int> mismatches{0};
+  for (int i = 0; i < 4; ++i)
+  {
+    threads.emplace_back([&]()
+    {
+      for (int j = 0; j < 1000; ++j)
+      {
+        math::Pose3d threadPose;
+        if (!constManager.CachedWorldPose(sensor, threadPose) ||
+            threadPose != sensorPose)
+        {
+          ++mismatches;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads)
+    thread.join();
+  EXPECT_EQ(0, mismatches);
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, CachedWorldPoseUntracked)
+{
+  Entity model = manager.CreateEntity();
+  Entity link = manager.CreateEntity();
+  manager.SetParentEntity(link, model);
+  manager.CreateComponent(link, components::ParentEntity(model));
+  manager.CreateComponent(link,
+      components::Pose(math::Pose3d(1, 0, 0, 0, 0, 0)));
+
+  // The model has no pose yet, so the link pose is used as is
+  math::Pose3d pose;
+  ASSERT_TRUE(manager.CachedWorldPose(link, pose));
+  EXPECT_EQ(math::Pose3d(1, 0, 0, 0, 0, 0), pose);
+
+  // Without the cache, writes that aren't followed by SetChanged are seen
+  manager.CreateComponent(model,
+      components::Pose(math::Pose3d(0, 2, 0, 0, 0, 0)));
+  *manager.Component<components::Pose>(link) =
+      components::Pose(math::Pose3d(3, 0, 0, 0, 0, 0));
+  ASSERT_TRUE(manager.CachedWorldPose(link, pose));
+  EXPECT_EQ(math::Pose3d(3, 2, 0, 0, 0, 0), pose);
+
+  EXPECT_TRUE(manager.SetComponentData<components::Pose>(model,
+      math::Pose3d(0, 4, 0, 0, 0, 0)));
+  ASSERT_TRUE(manager.CachedWorldPose(link, pose));
+  EXPECT_EQ(math::Pose3d(3, 4, 0, 0, 0, 0), pose);
+
+  // With the cache, an ancestor which gets a pose after its descendants
+  // were cached invalidates them
+  manager.EnableWorldPoseCache(true);
+  Entity world = manager.CreateEntity();
+  manager.SetParentEntity(model, world);
+  manager.CreateComponent(model, components::ParentEntity(world));
+  ASSERT_TRUE(manager.CachedWorldPose(link, pose));
+  EXPECT_EQ(math::Pose3d(3, 4, 0, 0, 0, 0), pose);
+  EXPECT_FALSE(manager.CachedWorldPose(world, pose));
+
+  manager.CreateComponent(world,
+      components::Pose(math::Pose3d(0, 0, 5, 0, 0, 0)));
+  ASSERT_TRUE(manager.CachedWorldPose(world, pose));
+  EXPECT_EQ(math::Pose3d(0, 0, 5, 0, 0, 0), pose);
+  ASSERT_TRUE(manager.CachedWorldPose(link, pose));
+  EXPECT_EQ(math::Pose3d(3, 4, 5, 0, 0, 0), pose);
+
+  // Disabling the cache drops poses that may be stale
+  *manager.Component<components::Pose>(world) =
+      components::Pose(math::Pose3d(0, 0, 6, 0, 0, 0));
+  manager.EnableWorldPoseCache(false);
+  ASSERT_TRUE(manager.CachedWorldPose(link, pose));
+  EXPECT_EQ(math::Pose3d(3, 4, 6, 0, 0, 0), pose);
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, ValueIndex)
+{
+  // Entities created before the index is enabled are indexed too
+  Entity parentA = manager.CreateEntity();
+  manager.CreateComponent(parentA, components::Name("a"));
+
+  EXPECT_FALSE(manager.HasValueIndex(components::Name::typeId));
+  manager.EnableValueIndex<components::Name>();
+  manager.EnableValueIndex<components::ParentEntity>();
+  EXPECT_TRUE(manager.HasValueIndex(components::Name::typeId));
+  EXPECT_TRUE(manager.HasValueIndex(components::ParentEntity::typeId));
+  EXPECT_FALSE(manager.HasValueIndex(IntComponent::typeId));
+
+  // Enabling twice is harmless
+  manager.EnableValueIndex<components::Name>();
+
+  Entity parentB = manager.CreateEntity();
+  manager.CreateComponent(parentB, components::Name("b"));
+
+  // Each parent has children named "link" and "other"
+  std::vector<Entity> links;
+  for (Entity parent : {parentA, parentB})
+  {
+    for (const std::string name : {"link", "other"})
+    {
+      Entity child = manager.CreateEntity();
+      manager.SetParentEntity(child, parent);
+      manager.CreateComponent(child, components::Name(name));
+      manager.CreateComponent(child, components::ParentEntity(parent));
+      manager.CreateComponent(child, IntComponent(123));
+      if (name == "link")
+        links.push_back(child);
+    }
+  }
+
+  EXPECT_EQ(parentA, manager.EntityByComponents(components::Name("a")));
+  EXPECT_EQ(parentB, manager.EntityByComponents(components::Name("b")));
+  EXPECT_EQ(kNullEntity, manager.EntityByComponents(components::Name("c")));
+  EXPECT_EQ(links, manager.EntitiesByComponents(components::Name("link")));
+  EXPECT_EQ(links, manager.EntitiesByComponents(components::Name("link"),
+      IntComponent(123)));
+  EXPECT_TRUE(manager.EntitiesByComponents(components::Name("link"),
+      IntComponent(456)).empty());
+
+  // Entities must have all the desired components
+  EXPECT_EQ(kNullEntity, manager.EntityByComponents(components::Name("a"),
+      IntComponent(123)));
+
+  // Lookups combining several indexes
+  EXPECT_EQ(links[1], manager.EntityByComponents(components::Name("link"),
+      components::ParentEntity(parentB)));
+  EXPECT_EQ(std::vector<Entity>({links[0]}),
+      manager.ChildrenByComponents(parentA, components::Name("link")));
+  EXPECT_EQ(2u, manager.ChildrenByComponents(parentA, IntComponent(123),
+      components::ParentEntity(parentA)).size());
+  EXPECT_TRUE(manager.ChildrenByComponents(parentB,
+      components::ParentEntity(parentA)).empty());
+
+  // Changes marked with SetChanged are seen
+  manager.Component<components::Name>(links[0])->Data() = "renamed";
+  manager.SetChanged(links[0], components::Name::typeId,
+      ComponentState::OneTimeChange);
+  EXPECT_EQ(links[0], manager.EntityByComponents(components::Name("renamed")));
+  EXPECT_EQ(std::vector<Entity>({links[1]}),
+      manager.EntitiesByComponents(components::Name("link")));
+
+  // SetComponentData is seen without SetChanged
+  uint64_t tick = manager.ChangeTick();
+  EXPECT_TRUE(manager.SetComponentData<components::Name>(links[1], "set"));
+  EXPECT_LT(tick, manager.ChangeTick());
+  EXPECT_EQ(links[1], manager.EntityByComponents(components::Name("set")));
+  EXPECT_EQ(std::vector<Entity>({links[1]}),
+      manager.EntitiesByComponents(components::Name("set")));
+  EXPECT_EQ(std::vector<Entity>({links[1]}),
+      manager.ChildrenByComponents(parentB, components::Name("set")));
+  EXPECT_TRUE(manager.EntitiesByComponents(components::Name("link")).empty());
+
+  // Setting the same value doesn't advance the tick
+  tick = manager.ChangeTick();
+  EXPECT_FALSE(manager.SetComponentData<components::Name>(links[1], "set"));
+  EXPECT_EQ(tick, manager.ChangeTick());
+
+  // So are values replaced through CreateComponent(s)
+  manager.CreateComponent(links[1], components::Name("created"));
+  EXPECT_EQ(links[1],
+      manager.EntityByComponents(components::Name("created")));
+  manager.CreateComponents(links[1], components::Name("link"));
+  EXPECT_EQ(std::vector<Entity>({links[1]}),
+      manager.EntitiesByComponents(components::Name("link")));
+
+  // Writes through the pointer aren't seen until SetChanged, and all the
+  // lookups agree
+  manager.Component<components::Name>(links[1])->Data() = "untracked";
+  EXPECT_EQ(kNullEntity,
+      manager.EntityByComponents(components::Name("untracked")));
+  EXPECT_TRUE(
+      manager.EntitiesByComponents(components::Name("untracked")).empty());
+  EXPECT_TRUE(manager.ChildrenByComponents(parentB,
+      components::Name("untracked")).empty());
+  manager.SetChanged(links[1], components::Name::typeId,
+      ComponentState::OneTimeChange);
+  EXPECT_EQ(links[1],
+      manager.EntityByComponents(components::Name("untracked")));
+  EXPECT_TRUE(manager.SetComponentData<components::Name>(links[1], "link"));
+
+  // Removed components and entities are dropped
+  manager.RemoveComponent<components::Name>(links[0]);
+  EXPECT_EQ(kNullEntity,
+      manager.EntityByComponents(components::Name("renamed")));
+
+  manager.RequestRemoveEntity(parentB);
+  manager.ProcessEntityRemovals();
+  EXPECT_EQ(kNullEntity, manager.EntityByComponents(components::Name("b")));
+  EXPECT_TRUE(manager.EntitiesByComponents(components::Name("link")).empty());
+  EXPECT_TRUE(manager.EntitiesByComponents(
+      components::ParentEntity(parentB)).empty());
+
+  // Entities created again are found
+  Entity parentC = manager.CreateEntity();
+  manager.CreateComponent(parentC, components::Name("b"));
+  EXPECT_EQ(parentC, manager.EntityByComponents(components::Name("b")));
+
+  // The results match a manager without indexes
+  EntityComponentManager plain;
+  plain.SetState(manager.State());
+  EXPECT_FALSE(plain.HasValueIndex(components::Name::typeId));
+  for (const std::string name : {"a", "b", "link", "other", "renamed"})
+  {
+    EXPECT_EQ(plain.EntitiesByComponents(components::Name(name)),
+        manager.EntitiesByComponents(components::Name(name))) << name;
+  }
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, CreateInBulk)
+{
+  EXPECT_TRUE(manager.CreateEntities(0).empty());
+
+  Entity first = manager.CreateEntity();
+  auto entities = manager.CreateEntities(100);
+  ASSERT_EQ(100u, entities.size());
+  EXPECT_EQ(101u, manager.EntityCount());
+  for (std::size_t i = 0; i < entities.size(); ++i)
+  {
+    EXPECT_EQ(first + 1 + i, entities[i]);
+    EXPECT_TRUE(manager.HasEntity(entities[i]));
+  }
+
+  // Views created before the components see the new entities
+  EXPECT_EQ(0, (newCount<IntComponent, DoubleComponent>(manager)));
+
+  for (const Entity entity : entities)
+  {
+    EXPECT_TRUE(manager.CreateComponents(entity,
+        IntComponent(static_cast<int>(entity)), DoubleComponent(0.5),
+        components::ParentEntity(first)));
+  }
+  EXPECT_EQ(100, (newCount<IntComponent, DoubleComponent>(manager)));
+  EXPECT_EQ(101u, manager.Descendants(first).size());
+  EXPECT_EQ(first, manager.ParentEntity(entities[0]));
+
+  auto intComp = manager.Component<IntComponent>(entities[0]);
+  ASSERT_NE(nullptr, intComp);
+  EXPECT_EQ(static_cast<int>(entities[0]), intComp->Data());
+
+  // Existing components are updated and the others are added
+  EXPECT_TRUE(manager.CreateComponents(entities[0], IntComponent(-1),
+      BoolComponent(true)));
+  EXPECT_EQ(intComp, manager.Component<IntComponent>(entities[0]));
+  EXPECT_EQ(-1, intComp->Data());
+  ASSERT_NE(nullptr, manager.Component<BoolComponent>(entities[0]));
+  EXPECT_TRUE(manager.Component<BoolComponent>(entities[0])->Data());
+
+  // Removed components are restored
+  EXPECT_TRUE(manager.RemoveComponent<DoubleComponent>(entities[1]));
+  EXPECT_TRUE(manager.CreateComponents(entities[1], DoubleComponent(1.5),
+      BoolComponent(false)));
+  ASSERT_NE(nullptr, manager.Component<DoubleComponent>(entities[1]));
+  EXPECT_DOUBLE_EQ(1.5,
+      manager.Component<DoubleComponent>(entities[1])->Data());
+
+  // Same component on several entities
+  EXPECT_EQ(100u, manager.CreateComponents(entities, StringComponent("s")));
+  EXPECT_EQ(100u, manager.EntitiesByComponents(StringComponent("s")).size());
+
+  // Nonexistent entities
+  EXPECT_FALSE(manager.CreateComponents(Entity(5000), IntComponent(1)));
+  EXPECT_EQ(0u, manager.CreateComponents(std::vector<Entity>{5000},
+      IntComponent(1)));
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, CreateComponentOnEntities)
+{
+  Entity parent = manager.CreateEntity();
+  auto entities = manager.CreateEntities(12);
+
+  // Entities start in different archetypes
+  for (std::size_t i = 0; i < entities.size(); ++i)
+  {
+    if (i % 2 == 0)
+      manager.CreateComponent(entities[i], IntComponent(static_cast<int>(i)));
+    if (i % 3 == 0)
+      manager.CreateComponent(entities[i], BoolComponent(true));
+  }
+
+  // Views created before the new components see them, with their data
+  auto doubleSum = [&]()
+  {
+    double sum{0.0};
+    manager.Each<IntComponent, DoubleComponent>(
+        [&](const Entity &, const IntComponent *_int,
+            const DoubleComponent *_double) -> bool
+        {
+          EXPECT_EQ(0, _int->Data() % 2);
+          sum += _double->Data();
+          return true;
+        });
+    return sum;
+  };
+  EXPECT_DOUBLE_EQ(0.0, doubleSum());
+  EXPECT_EQ(6, (newCount<IntComponent>(manager)));
+
+  // One entity already has the component, one had it and one is listed
+  // twice. Nonexistent entities are skipped.
+  manager.CreateComponent(entities[0], DoubleComponent(5.0));
+  manager.CreateComponent(entities[1], DoubleComponent(5.0));
+  EXPECT_TRUE(manager.RemoveComponent<DoubleComponent>(entities[1]));
+  auto targets = entities;
+  targets.push_back(entities[2]);
+  targets.push_back(Entity(5000));
+  EXPECT_EQ(12u, manager.CreateComponents(targets, DoubleComponent(0.5)));
+
+  for (const Entity entity : entities)
+  {
+    auto comp = manager.Component<DoubleComponent>(entity);
+    ASSERT_NE(nullptr, comp) << entity;
+    EXPECT_DOUBLE_EQ(0.5, comp->Data());
+  }
+  EXPECT_DOUBLE_EQ(3.0, doubleSum());
+  EXPECT_EQ(6, (newCount<IntComponent, DoubleComponent>(manager)));
+  EXPECT_EQ(12, (newCount<DoubleComponent>(manager)));
+
+  // The other components weren't changed by moving
+  for (std::size_t i = 0; i < entities.size(); i += 2)
+  {
+    auto intComp = manager.Component<IntComponent>(entities[i]);
+    ASSERT_NE(nullptr, intComp);
+    EXPECT_EQ(static_cast<int>(i), intComp->Data());
+    EXPECT_EQ(i % 3 == 0,
+        nullptr != manager.Component<BoolComponent>(entities[i]));
+  }
+
+  // The new components are reported as changed
+  EXPECT_TRUE(manager.HasOneTimeComponentChanges());
+  EXPECT_EQ(ComponentState::OneTimeChange,
+      manager.ComponentState(entities[3], DoubleComponent::typeId));
+
+  // Parents are set for all entities
+  EXPECT_EQ(12u, manager.CreateComponents(entities,
+      components::ParentEntity(parent)));
+  EXPECT_EQ(13u, manager.Descendants(parent).size());
+  EXPECT_EQ(parent, manager.ParentEntity(entities[5]));
+
+  EXPECT_EQ(0u, manager.CreateComponents(std::vector<Entity>{},
+      IntComponent(1)));
+}
+
+//////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, EachCallable)
+{
+  for (int i = 0; i < 10; ++i)
+  {
+    Entity entity = manager.CreateEntity();
+    manager.CreateComponent(entity, IntComponent(i));
+    if (i % 2 == 0)
+      manager.CreateComponent(entity, Even());
+  }
+
+  // Lambdas are called directly and may modify the components
+  int sum{0};
+  manager.Each<IntComponent>(
+      [&](const Entity &, IntComponent *_int)
+      {
+        sum += _int->Data();
+        _int->Data() *= 2;
+        return true;
+      });
+  EXPECT_EQ(45, sum);
+
+  // Generic lambdas, const access and stopping early
+  const EntityComponentManager &constManager = manager;
+  int count{0};
+  constManager.Each<IntComponent, Even>(
+      [&](const Entity &, const auto *_int, const auto *)
+      {
+        EXPECT_EQ(0, _int->Data() % 4);
+        return ++count < 3;
+      });
+  EXPECT_EQ(3, count);
+
+  // A std::function is still accepted
+  std::function<bool(const Entity &, const IntComponent *)> f =
+      [&](const Entity &, const IntComponent *_int)
+      {
+        sum += _int->Data();
+        return true;
+      };
+  sum = 0;
+  constManager.Each<IntComponent>(f);
+  EXPECT_EQ(90, sum);
+
+  count = 0;
+  manager.EachNew<IntComponent, Even>(
+      [&](const Entity &, IntComponent *, Even *)
+      {
+        ++count;
+        return true;
+      });
+  EXPECT_EQ(5, count);
+
+  count = 0;
+  manager.RequestRemoveEntity(manager.EntityByComponents(IntComponent(0)));
+  manager.EachRemoved<IntComponent>(
+      [&](const Entity &, const IntComponent *_int)
+      {
+        EXPECT_EQ(0, _int->Data());
+        ++count;
+        return true;
+      });
+  EXPECT_EQ(1, count);
+}
+
+//////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, EachModifiesView)
+{
+  std::vector<Entity> entities;
+  for (int i = 0; i < 10; ++i)
+  {
+    entities.push_back(manager.CreateEntity());
+    manager.CreateComponent(entities.back(), IntComponent(i));
+  }
+
+  // Removing the component being visited and adding it to new entities
+  // neither skips nor revisits entities
+  std::set<Entity> visited;
+  std::vector<Entity> created;
+  manager.Each<IntComponent>(
+      [&](const Entity &_entity, IntComponent *_int)
+      {
+        EXPECT_TRUE(visited.insert(_entity).second) << _entity;
+        EXPECT_EQ(_entity, entities[_int->Data()]);
+        manager.RemoveComponent<IntComponent>(_entity);
+        created.push_back(manager.CreateEntity());
+        manager.CreateComponent(created.back(), IntComponent(-1));
+        return true;
+      });
+  EXPECT_EQ(std::set<Entity>(entities.begin(), entities.end()), visited);
+
+  EXPECT_EQ(10u, created.size());
+
+  // Entities which leave the view before being visited are skipped
+  for (auto entity : created)
+    manager.RemoveComponent<IntComponent>(entity);
+  for (auto entity : entities)
+    manager.CreateComponent(entity, IntComponent(0));
+  visited.clear();
+  const EntityComponentManager &constManager = manager;
+  constManager.Each<IntComponent>(
+      [&](const Entity &_entity, const IntComponent *_int)
+      {
+        EXPECT_TRUE(visited.insert(_entity).second) << _entity;
+        for (auto entity : entities)
+        {
+          if (entity != _entity && !visited.count(entity))
+            manager.RemoveComponent<IntComponent>(entity);
+        }
+        EXPECT_NE(nullptr, _int);
+        return true;
+      });
+  EXPECT_EQ(1u, visited.size());
+}
+
+//////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, LookupOrder)
+{
+  std::vector<Entity> entities;
+  for (int i = 0; i < 4; ++i)
+  {
+    entities.push_back(manager.CreateEntity());
+    manager.CreateComponent(entities.back(), IntComponent(7));
+  }
+
+  // Reorder the view by moving the first entities to its end
+  for (int i = 0; i < 2; ++i)
+  {
+    EXPECT_EQ(entities[0], manager.EntityByComponents(IntComponent(7)));
+    manager.RemoveComponent<IntComponent>(entities[i]);
+    manager.CreateComponent(entities[i], IntComponent(7));
+  }
+
+  // Lookups without an index still return the lowest IDs first
+  EXPECT_EQ(entities[0], manager.EntityByComponents(IntComponent(7)));
+  EXPECT_EQ(entities, manager.EntitiesByComponents(IntComponent(7)));
+}
+
+//////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, EachFilters)
+{
+  std::vector<Entity> entities;
+  for (int i = 0; i < 6; ++i)
+  {
+    Entity entity = manager.CreateEntity();
+    manager.CreateComponent(entity, IntComponent(i));
+    if (i % 2 == 0)
+      manager.CreateComponent(entity, Even());
+    if (i < 2)
+      manager.CreateComponent(entity, DoubleComponent(i * 0.5));
+    entities.push_back(entity);
+  }
+
+  auto withoutEven = [&]()
+  {
+    std::set<Entity> result;
+    manager.Each<IntComponent, Without<Even>>(
+        [&](const Entity &_entity, IntComponent *) -> bool
+        {
+          result.insert(_entity);
+          return true;
+        });
+    return result;
+  };
+
+  auto optionalDouble = [&]()
+  {
+    std::map<Entity, const DoubleComponent *> result;
+    manager.Each<IntComponent, Optional<DoubleComponent>>(
+        [&](const Entity &_entity, const IntComponent *,
+            const DoubleComponent *_double) -> bool
+        {
+          result[_entity] = _double;
+          return true;
+        });
+    return result;
+  };
+
+  EXPECT_EQ(std::set<Entity>({entities[1], entities[3], entities[5]}),
+      withoutEven());
+
+  auto doubles = optionalDouble();
+  ASSERT_EQ(6u, doubles.size());
+  ASSERT_NE(nullptr, doubles[entities[0]]);
+  ASSERT_NE(nullptr, doubles[entities[1]]);
+  EXPECT_DOUBLE_EQ(0.5, doubles[entities[1]]->Data());
+  for (int i = 2; i < 6; ++i)
+    EXPECT_EQ(nullptr, doubles[entities[i]]);
+
+  // Filters and optional components follow component changes
+  EXPECT_TRUE(manager.RemoveComponent<Even>(entities[0]));
+  manager.CreateComponent(entities[1], Even());
+  EXPECT_TRUE(manager.RemoveComponent<DoubleComponent>(entities[0]));
+  manager.CreateComponent(entities[4], DoubleComponent(2.0));
+
+  EXPECT_EQ(std::set<Entity>({entities[0], entities[3], entities[5]}),
+      withoutEven());
+
+  doubles = optionalDouble();
+  ASSERT_EQ(6u, doubles.size());
+  EXPECT_EQ(nullptr, doubles[entities[0]]);
+  ASSERT_NE(nullptr, doubles[entities[4]]);
+  EXPECT_DOUBLE_EQ(2.0, doubles[entities[4]]->Data());
+
+  // Removed components which are added back
+  manager.CreateComponent(entities[0], Even());
+  manager.CreateComponent(entities[0], DoubleComponent(3.0));
+  EXPECT_EQ(std::set<Entity>({entities[3], entities[5]}), withoutEven());
+  doubles = optionalDouble();
+  ASSERT_NE(nullptr, doubles[entities[0]]);
+  EXPECT_DOUBLE_EQ(3.0, doubles[entities[0]]->Data());
+
+  // An entity loses a required component while the optional one changes
+  EXPECT_TRUE(manager.RemoveComponent<IntComponent>(entities[4]));
+  EXPECT_TRUE(manager.RemoveComponent<DoubleComponent>(entities[4]));
+  EXPECT_EQ(5u, optionalDouble().size());
+  manager.CreateComponent(entities[4], IntComponent(4));
+  doubles = optionalDouble();
+  ASSERT_EQ(6u, doubles.size());
+  EXPECT_EQ(nullptr, doubles[entities[4]]);
+
+  // Filtered views are separate from the unfiltered view of the same types
+  EXPECT_EQ(6, eachCount<IntComponent>(manager));
+
+  // EachNew and EachRemoved accept filters
+  int count{0};
+  manager.EachNew<IntComponent, Without<Even>>(
+      [&](const Entity &, IntComponent *) -> bool
+      {
+        ++count;
+        return true;
+      });
+  EXPECT_EQ(2, count);
+
+  manager.RequestRemoveEntity(entities[3]);
+  manager.RequestRemoveEntity(entities[0]);
+  count = 0;
+  manager.EachRemoved<IntComponent, Without<Even>>(
+      [&](const Entity &_entity, const IntComponent *) -> bool
+      {
+        EXPECT_EQ(entities[3], _entity);
+        ++count;
+        return true;
+      });
+  EXPECT_EQ(1, count);
+
+  // Removed entities leave filtered views
+  manager.ProcessEntityRemovals();
+  EXPECT_EQ(std::set<Entity>({entities[5]}), withoutEven());
+}
+
+//////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, ViewCache)
+{
+  // Views found by a thread are cached per component types, so alternating
+  // between managers and clearing views must not return stale views
+  EntityCompMgrTest other;
+  for (int i = 0; i < 3; ++i)
+  {
+    manager.CreateComponent(manager.CreateEntity(), IntComponent(i));
+    other.CreateComponent(other.CreateEntity(), IntComponent(i));
+  }
+  other.CreateComponent(other.CreateEntity(), IntComponent(3));
+
+  for (int i = 0; i < 3; ++i)
+  {
+    EXPECT_EQ(3, eachCount<IntComponent>(manager));
+    EXPECT_EQ(4, eachCount<IntComponent>(other));
+  }
+
+  // Removing all entities destroys the views
+  manager.RequestRemoveEntities();
+  manager.ProcessEntityRemovals();
+  EXPECT_EQ(0, eachCount<IntComponent>(manager));
+  manager.CreateComponent(manager.CreateEntity(), IntComponent(5));
+  EXPECT_EQ(1, eachCount<IntComponent>(manager));
+  EXPECT_EQ(4, eachCount<IntComponent>(other));
+
+  // Other threads have their own cache
+  std::thread thread([&]()
+  {
+    EXPECT_EQ(1, eachCount<IntComponent>(manager));
+    EXPECT_EQ(4, eachCount<IntComponent>(other));
+  });
+  thread.join();
+
+  // A manager created where another one was gets new views
+  {
+    EntityCompMgrTest temp;
+    temp.CreateComponent(temp.CreateEntity(), IntComponent(1));
+    EXPECT_EQ(1, eachCount<IntComponent>(temp));
+  }
+  {
+    EntityCompMgrTest temp;
+    EXPECT_EQ(0, eachCount<IntComponent>(temp));
+  }
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, SnapshotRestore)
+{
+  const Entity parent = manager.CreateEntity();
+  const Entity child = manager.CreateEntity();
+  const Entity removed = manager.CreateEntity();
+  manager.CreateComponent(parent, IntComponent(1));
+  manager.CreateComponent(child, IntComponent(2));
+  manager.CreateComponent(child, StringComponent("child"));
+  manager.CreateComponent(child, Even());
+  manager.CreateComponent(removed, DoubleComponent(0.5));
+  manager.SetParentEntity(child, parent);
+  manager.RunClearNewlyCreatedEntities();
+  manager.RunSetAllComponentsUnchanged();
+
+  auto snapshot = manager.Snapshot();
+  ASSERT_NE(nullptr, snapshot);
+
+  const IntComponent *childInt = manager.Component<IntComponent>(child);
+  EXPECT_EQ(2, eachCount<IntComponent>(manager));
+
+  // Change values, components, parents and entities
+  manager.Component<IntComponent>(child)->Data() = 20;
+  manager.Component<StringComponent>(child)->Data() = "changed";
+  manager.RemoveComponent<Even>(child);
+  manager.CreateComponent(child, Odd());
+  manager.CreateComponent(parent, StringComponent("added"));
+  manager.SetParentEntity(child, kNullEntity);
+  manager.RequestRemoveEntity(removed);
+  manager.ProcessEntityRemovals();
+  const Entity created = manager.CreateEntity();
+  manager.CreateComponent(created, IntComponent(3));
+  const Entity gone = manager.CreateEntity();
+  manager.RequestRemoveEntity(gone);
+  manager.ProcessEntityRemovals();
+  manager.RunClearNewlyCreatedEntities();
+  manager.RunClearRemovedComponents();
+  manager.RunSetAllComponentsUnchanged();
+  EXPECT_EQ(3, eachCount<IntComponent>(manager));
+
+  manager.Restore(*snapshot);
+
+  // Values are copied into the same instances
+  EXPECT_EQ(childInt, manager.Component<IntComponent>(child));
+  EXPECT_EQ(2, childInt->Data());
+  EXPECT_EQ("child", manager.Component<StringComponent>(child)->Data());
+  EXPECT_EQ(ComponentState::OneTimeChange,
+      manager.ComponentState(child, IntComponent::typeId));
+  EXPECT_TRUE(manager.EntityHasComponentType(child, Even::typeId));
+  EXPECT_FALSE(manager.EntityHasComponentType(child, Odd::typeId));
+  EXPECT_FALSE(manager.EntityHasComponentType(parent,
+      StringComponent::typeId));
+  EXPECT_EQ(parent, manager.ParentEntity(child));
+
+  // The removed entity is back with the same ID
+  ASSERT_TRUE(manager.HasEntity(removed));
+  EXPECT_DOUBLE_EQ(0.5, manager.Component<DoubleComponent>(removed)->Data());
+  int newCount{0};
+  manager.EachNew<DoubleComponent>(
+      [&](const Entity &_entity, const DoubleComponent *) -> bool
+      {
+        EXPECT_EQ(removed, _entity);
+        ++newCount;
+        return true;
+      });
+  EXPECT_EQ(1, newCount);
+
+  // The created entity is removed at the end of the step
+  EXPECT_TRUE(manager.HasEntitiesMarkedForRemoval());
+  int removedCount{0};
+  manager.EachRemoved<IntComponent>(
+      [&](const Entity &_entity, const IntComponent *) -> bool
+      {
+        EXPECT_EQ(created, _entity);
+        ++removedCount;
+        return true;
+      });
+  EXPECT_EQ(1, removedCount);
+  manager.ProcessEntityRemovals();
+  EXPECT_FALSE(manager.HasEntity(created));
+  EXPECT_EQ(2, eachCount<IntComponent>(manager));
+  EXPECT_EQ(3u, manager.EntityCount());
+
+  // IDs handed out since the snapshot aren't reused
+  EXPECT_EQ(gone + 1, manager.CreateEntity());
+
+  // Snapshots can be restored into other managers
+  EntityCompMgrTest other;
+  other.Restore(*snapshot);
+  EXPECT_EQ(3u, other.EntityCount());
+  EXPECT_EQ(parent, other.ParentEntity(child));
+  EXPECT_EQ(2, other.Component<IntComponent>(child)->Data());
+  EXPECT_EQ(2, eachCount<IntComponent>(other));
+  EXPECT_EQ(removed + 1, other.CreateEntity());
+}
+
+/////////////////////////////////////////////////
+TEST_P(EntityComponentManagerFixture, Mirror)
+{
+  EntityCompMgrTest mirror;
+  auto endIteration = [](EntityCompMgrTest &_ecm)
+  {
+    _ecm.RunClearNewlyCreatedEntities();
+    _ecm.ProcessEntityRemovals();
+    _ecm.RunClearRemovedComponents();
+    _ecm.RunSetAllComponentsUnchanged();
+  };
+
+  // First iteration creates entities
+  const Entity kept = manager.CreateEntity();
+  const Entity removed = manager.CreateEntity();
+  manager.CreateComponent(kept, IntComponent(1));
+  manager.CreateComponent(removed, IntComponent(2));
+
+  mirror.RunMirror(manager);
+  EXPECT_EQ(2u, mirror.EntityCount());
+  int newCount{0};
+  mirror.EachNew<IntComponent>(
+      [&](const Entity &, const IntComponent *) -> bool
+      {
+        ++newCount;
+        return true;
+      });
+  EXPECT_EQ(2, newCount);
+  EXPECT_EQ(manager.ComponentState(kept, IntComponent::typeId),
+      mirror.ComponentState(kept, IntComponent::typeId));
+
+  endIteration(manager);
+  endIteration(mirror);
+
+  // Second iteration changes one entity and removes the other
+  manager.Component<IntComponent>(kept)->Data() = 10;
+  manager.SetChanged(kept, IntComponent::typeId,
+      ComponentState::PeriodicChange);
+  manager.RequestRemoveEntity(removed);
+
+  mirror.RunMirror(manager);
+  EXPECT_EQ(10, mirror.Component<IntComponent>(kept)->Data());
+  EXPECT_EQ(ComponentState::PeriodicChange,
+      mirror.ComponentState(kept, IntComponent::typeId));
+  EXPECT_EQ(ComponentState::NoChange,
+      mirror.ComponentState(removed, IntComponent::typeId));
+  EXPECT_FALSE(mirror.HasOneTimeComponentChanges());
+
+  newCount = 0;
+  mirror.EachNew<IntComponent>(
+      [&](const Entity &, const IntComponent *) -> bool
+      {
+        ++newCount;
+        return true;
+      });
+  EXPECT_EQ(0, newCount);
+
+  int removedCount{0};
+  mirror.EachRemoved<IntComponent>(
+      [&](const Entity &_entity, const IntComponent *) -> bool
+      {
+        EXPECT_EQ(removed, _entity);
+        ++removedCount;
+        return true;
+      });
+  EXPECT_EQ(1, removedCount);
+
+  endIteration(manager);
+  endIteration(mirror);
+  EXPECT_FALSE(mirror.HasEntity(removed));
+  EXPECT_EQ(1, eachCount<IntComponent>(mirror));
+
+  // Third iteration adds a child and a component. Only changes are copied,
+  // so a value modified without SetChanged isn't.
+  manager.Component<IntComponent>(kept)->Data() = 20;
+  manager.CreateComponent(kept, DoubleComponent(0.5));
+  const Entity child = manager.CreateEntity();
+  manager.CreateComponent(child, IntComponent(3));
+  manager.SetParentEntity(child, kept);
+
+  mirror.RunMirror(manager);
+  EXPECT_EQ(10, mirror.Component<IntComponent>(kept)->Data());
+  ASSERT_NE(nullptr, mirror.Component<DoubleComponent>(kept));
+  EXPECT_DOUBLE_EQ(0.5, mirror.Component<DoubleComponent>(kept)->Data());
+  ASSERT_NE(nullptr, mirror.Component<IntComponent>(child));
+  EXPECT_EQ(3, mirror.Component<IntComponent>(child)->Data());
+  EXPECT_EQ(kept, mirror.ParentEntity(child));
+  EXPECT_EQ(manager.EntityCount(), mirror.EntityCount());
+}
+
 // Run multiple times. We want to make sure that static globals don't cause
 // problems.
 INSTANTIATE_TEST_SUITE_P(EntityComponentManagerRepeat,
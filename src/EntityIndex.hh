@@ -0,0 +1,376 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_ENTITYINDEX_HH_
+#define IGNITION_GAZEBO_ENTITYINDEX_HH_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <ignition/gazebo/config.hh>
+
+#include "ignition/gazebo/Entity.hh"
+
+namespace ignition
+{
+  namespace gazebo
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+    /// \class EntityIndex EntityIndex.hh
+    /// \brief A slot map from entities to values of type T.
+    ///
+    /// Values live in a dense vector of slots. Each slot has a generation
+    /// counter which is incremented whenever the slot is freed, and freed
+    /// slots are recycled through a free list. Entities are mapped to slots
+    /// through a paged sparse array indexed directly by the entity ID, so
+    /// lookups are a couple of array accesses and never hash.
+    ///
+    /// Entity IDs are allocated in increasing order from one or more
+    /// offsets (see EntityComponentManager::SetEntityCreateOffset), so the
+    /// sparse array is split into blocks of contiguous pages, one per
+    /// cluster of IDs.
+    ///
+    /// A Handle identifies a slot at a given generation. Holding on to a
+    /// handle is safe: once the entity is erased and its slot recycled, the
+    /// handle becomes stale and is rejected by Find and Valid.
+    template <typename T>
+    class EntityIndex
+    {
+      /// \brief Sentinel for an invalid slot.
+      public: static constexpr uint32_t kInvalidSlot =
+                  std::numeric_limits<uint32_t>::max();
+
+      /// \brief Reference to a slot at a given generation.
+      public: struct Handle
+      {
+        /// \brief Index of the slot.
+        uint32_t slot{kInvalidSlot};
+
+        /// \brief Generation of the slot when the handle was created.
+        uint32_t generation{0};
+      };
+
+      /// \brief Insert a value for an entity.
+      /// \param[in] _entity Entity, must not be kNullEntity.
+      /// \param[in] _value Value to store.
+      /// \return Pointer to the stored value, or nullptr if the entity is
+      /// already in the index.
+      public: T *Insert(const Entity _entity, T _value)
+      {
+        if (_entity == kNullEntity)
+          return nullptr;
+
+        Handle *entry = this->SparseEntry(_entity, true);
+        if (entry->slot != kInvalidSlot)
+          return nullptr;
+
+        uint32_t slotIdx;
+        if (!this->freeSlots.empty())
+        {
+          slotIdx = this->freeSlots.back();
+          this->freeSlots.pop_back();
+        }
+        else
+        {
+          slotIdx = static_cast<uint32_t>(this->slots.size());
+          this->slots.emplace_back();
+        }
+
+        Slot &slot = this->slots[slotIdx];
+        slot.entity = _entity;
+        slot.alive = true;
+        slot.value = std::move(_value);
+
+        entry->slot = slotIdx;
+        entry->generation = slot.generation;
+        ++this->count;
+        return &slot.value;
+      }
+
+      /// \brief Erase an entity from the index. Its slot is recycled and all
+      /// handles to it become stale.
+      /// \param[in] _entity Entity to erase.
+      /// \return True if the entity was in the index.
+      public: bool Erase(const Entity _entity)
+      {
+        Handle *entry = this->SparseEntry(_entity, false);
+        if (nullptr == entry || entry->slot == kInvalidSlot)
+          return false;
+
+        Slot &slot = this->slots[entry->slot];
+        slot.alive = false;
+        slot.value = T();
+        ++slot.generation;
+        this->freeSlots.push_back(entry->slot);
+
+        *entry = Handle();
+        --this->count;
+        return true;
+      }
+
+      /// \brief Remove all entities. Outstanding handles become stale.
+      public: void Clear()
+      {
+        this->blocks.clear();
+        this->freeSlots.clear();
+        for (uint32_t i = 0; i < this->slots.size(); ++i)
+        {
+          Slot &slot = this->slots[i];
+          if (slot.alive)
+          {
+            slot.alive = false;
+            slot.value = T();
+            ++slot.generation;
+          }
+          this->freeSlots.push_back(i);
+        }
+        this->count = 0;
+      }
+
+      /// \brief Find the value of an entity.
+      /// \param[in] _entity Entity.
+      /// \return Pointer to the value, or nullptr if the entity is not in the
+      /// index.
+      public: T *Find(const Entity _entity)
+      {
+        return const_cast<T *>(
+            static_cast<const EntityIndex &>(*this).Find(_entity));
+      }
+
+      /// \brief Find the value of an entity.
+      /// \param[in] _entity Entity.
+      /// \return Pointer to the value, or nullptr if the entity is not in the
+      /// index.
+      public: const T *Find(const Entity _entity) const
+      {
+        const Handle *entry = this->SparseEntry(_entity);
+        if (nullptr == entry || entry->slot == kInvalidSlot)
+          return nullptr;
+        return &this->slots[entry->slot].value;
+      }
+
+      /// \brief Find a value through a handle.
+      /// \param[in] _handle Handle obtained from HandleOf.
+      /// \return Pointer to the value, or nullptr if the handle is stale.
+      public: T *Find(const Handle &_handle)
+      {
+        if (!this->Valid(_handle))
+          return nullptr;
+        return &this->slots[_handle.slot].value;
+      }
+
+      /// \brief Get a handle to the slot of an entity.
+      /// \param[in] _entity Entity.
+      /// \return Handle, which is invalid if the entity is not in the index.
+      public: Handle HandleOf(const Entity _entity) const
+      {
+        const Handle *entry = this->SparseEntry(_entity);
+        if (nullptr == entry)
+          return Handle();
+        return *entry;
+      }
+
+      /// \brief Check whether a handle still refers to a live slot.
+      /// \param[in] _handle Handle to check.
+      /// \return False if the handle's entity has been erased since the
+      /// handle was created.
+      public: bool Valid(const Handle &_handle) const
+      {
+        if (_handle.slot >= this->slots.size())
+          return false;
+        const Slot &slot = this->slots[_handle.slot];
+        return slot.alive && slot.generation == _handle.generation;
+      }
+
+      /// \brief Get the entity stored in a handle's slot.
+      /// \param[in] _handle Handle.
+      /// \return The entity, or kNullEntity if the handle is stale.
+      public: Entity EntityOf(const Handle &_handle) const
+      {
+        if (!this->Valid(_handle))
+          return kNullEntity;
+        return this->slots[_handle.slot].entity;
+      }
+
+      /// \brief Number of entities in the index.
+      /// \return Entity count.
+      public: std::size_t Size() const
+      {
+        return this->count;
+      }
+
+      /// \brief Reserve slots so that the index can hold at least _count
+      /// entities without reallocating.
+      /// \param[in] _count Number of entities.
+      public: void Reserve(std::size_t _count)
+      {
+        this->slots.reserve(_count);
+      }
+
+      /// \brief Number of bits of the entity ID used to index into a page.
+      private: static constexpr unsigned int kPageBits{12};
+
+      /// \brief Number of entries per page.
+      private: static constexpr std::size_t kPageSize{1u << kPageBits};
+
+      /// \brief Maximum number of missing pages between a block and a new
+      /// page for the block to be extended instead of creating a new block.
+      private: static constexpr uint64_t kMaxPageGap{64};
+
+      /// \brief Page of the sparse array.
+      private: using Page = std::array<Handle, kPageSize>;
+
+      /// \brief Range of contiguous pages.
+      private: struct Block
+      {
+        /// \brief Page number of the first page.
+        uint64_t firstPage{0};
+
+        /// \brief Pages, which may be null if nothing was ever stored in
+        /// their range.
+        std::vector<std::unique_ptr<Page>> pages;
+      };
+
+      /// \brief Dense storage for values.
+      private: struct Slot
+      {
+        /// \brief Entity that owns the slot.
+        Entity entity{kNullEntity};
+
+        /// \brief Incremented every time the slot is freed.
+        uint32_t generation{0};
+
+        /// \brief Whether the slot is in use.
+        bool alive{false};
+
+        /// \brief Stored value.
+        T value{};
+      };
+
+      /// \brief Get the sparse entry of an entity.
+      /// \param[in] _entity Entity.
+      /// \return Pointer to the entry, or nullptr if its page doesn't exist.
+      private: const Handle *SparseEntry(const Entity _entity) const
+      {
+        const uint64_t page = _entity >> kPageBits;
+        for (const Block &block : this->blocks)
+        {
+          if (page < block.firstPage)
+            continue;
+          const uint64_t pageIdx = page - block.firstPage;
+          if (pageIdx >= block.pages.size() || !block.pages[pageIdx])
+            continue;
+          return &(*block.pages[pageIdx])[_entity & (kPageSize - 1)];
+        }
+        return nullptr;
+      }
+
+      /// \brief Get the sparse entry of an entity, optionally creating the
+      /// page that contains it.
+      /// \param[in] _entity Entity.
+      /// \param[in] _create True to create the page if needed.
+      /// \return Pointer to the entry, or nullptr if its page doesn't exist
+      /// and _create is false.
+      private: Handle *SparseEntry(const Entity _entity, bool _create)
+      {
+        Handle *entry = const_cast<Handle *>(
+            static_cast<const EntityIndex &>(*this).SparseEntry(_entity));
+        if (nullptr != entry || !_create)
+          return entry;
+
+        const uint64_t page = _entity >> kPageBits;
+
+        // Use the block which already covers the page, or else find a block
+        // close enough to be extended, so that IDs allocated sequentially
+        // stay in a single block. Blocks never overlap, so that every page
+        // belongs to a single block.
+        Block *target{nullptr};
+        for (Block &block : this->blocks)
+        {
+          if (page >= block.firstPage &&
+              page < block.firstPage + block.pages.size())
+          {
+            target = &block;
+            break;
+          }
+        }
+
+        for (auto it = this->blocks.begin();
+             nullptr == target && it != this->blocks.end(); ++it)
+        {
+          const uint64_t end = it->firstPage + it->pages.size();
+          if (page + kMaxPageGap < it->firstPage || page > end + kMaxPageGap)
+            continue;
+
+          const uint64_t first = std::min(page, it->firstPage);
+          const uint64_t last = std::max(page + 1, end);
+          const bool overlaps = std::any_of(this->blocks.begin(),
+              this->blocks.end(), [&](const Block &_other)
+              {
+                return &_other != &*it && _other.firstPage < last &&
+                    first < _other.firstPage + _other.pages.size();
+              });
+          if (!overlaps)
+            target = &*it;
+        }
+
+        if (nullptr == target)
+        {
+          this->blocks.emplace_back();
+          target = &this->blocks.back();
+          target->firstPage = page;
+        }
+        else if (page < target->firstPage)
+        {
+          std::vector<std::unique_ptr<Page>> pages(
+              target->firstPage - page + target->pages.size());
+          std::move(target->pages.begin(), target->pages.end(),
+              pages.begin() + (target->firstPage - page));
+          target->pages = std::move(pages);
+          target->firstPage = page;
+        }
+
+        const uint64_t pageIdx = page - target->firstPage;
+        if (pageIdx >= target->pages.size())
+          target->pages.resize(pageIdx + 1);
+        if (!target->pages[pageIdx])
+          target->pages[pageIdx] = std::make_unique<Page>();
+
+        return &(*target->pages[pageIdx])[_entity & (kPageSize - 1)];
+      }
+
+      /// \brief Blocks of the sparse array.
+      private: std::vector<Block> blocks;
+
+      /// \brief Dense slots.
+      private: std::vector<Slot> slots;
+
+      /// \brief Indices of the slots that can be recycled.
+      private: std::vector<uint32_t> freeSlots;
+
+      /// \brief Number of live slots.
+      private: std::size_t count{0};
+    };
+    }
+  }
+}
+#endif
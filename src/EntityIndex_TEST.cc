@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <limits>
+
+#include "EntityIndex.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+//////////////////////////////////////////////////
+TEST(EntityIndex, InsertFindErase)
+{
+  EntityIndex<int> index;
+  EXPECT_EQ(0u, index.Size());
+  EXPECT_EQ(nullptr, index.Find(1));
+
+  ASSERT_NE(nullptr, index.Insert(1, 10));
+  ASSERT_NE(nullptr, index.Insert(2, 20));
+  EXPECT_EQ(nullptr, index.Insert(1, 11));
+  EXPECT_EQ(nullptr, index.Insert(kNullEntity, 0));
+  EXPECT_EQ(2u, index.Size());
+
+  ASSERT_NE(nullptr, index.Find(1));
+  EXPECT_EQ(10, *index.Find(1));
+  EXPECT_EQ(20, *index.Find(2));
+  EXPECT_EQ(nullptr, index.Find(3));
+
+  *index.Find(2) = 21;
+  EXPECT_EQ(21, *index.Find(2));
+
+  EXPECT_TRUE(index.Erase(1));
+  EXPECT_FALSE(index.Erase(1));
+  EXPECT_FALSE(index.Erase(100));
+  EXPECT_EQ(nullptr, index.Find(1));
+  EXPECT_EQ(1u, index.Size());
+
+  index.Clear();
+  EXPECT_EQ(0u, index.Size());
+  EXPECT_EQ(nullptr, index.Find(2));
+  EXPECT_NE(nullptr, index.Insert(2, 22));
+}
+
+//////////////////////////////////////////////////
+TEST(EntityIndex, StaleHandles)
+{
+  EntityIndex<int> index;
+  index.Insert(1, 10);
+  auto handle = index.HandleOf(1);
+  EXPECT_TRUE(index.Valid(handle));
+  EXPECT_EQ(1u, index.EntityOf(handle));
+  ASSERT_NE(nullptr, index.Find(handle));
+  EXPECT_EQ(10, *index.Find(handle));
+
+  EXPECT_FALSE(index.Valid(index.HandleOf(2)));
+
+  // The slot is recycled for entity 2, but the old handle stays stale
+  index.Erase(1);
+  index.Insert(2, 20);
+  auto handle2 = index.HandleOf(2);
+  EXPECT_EQ(handle.slot, handle2.slot);
+  EXPECT_NE(handle.generation, handle2.generation);
+  EXPECT_FALSE(index.Valid(handle));
+  EXPECT_EQ(nullptr, index.Find(handle));
+  EXPECT_EQ(kNullEntity, index.EntityOf(handle));
+  EXPECT_TRUE(index.Valid(handle2));
+
+  // Clearing invalidates everything
+  index.Clear();
+  EXPECT_FALSE(index.Valid(handle2));
+  index.Insert(3, 30);
+  EXPECT_FALSE(index.Valid(handle2));
+}
+
+//////////////////////////////////////////////////
+TEST(EntityIndex, SparseIds)
+{
+  // IDs far apart, as created after EntityComponentManager's
+  // SetEntityCreateOffset
+  const Entity offsets[] = {0u, 1u << 20,
+      static_cast<Entity>(std::numeric_limits<int64_t>::max() / 2)};
+
+  EntityIndex<Entity> index;
+  for (auto offset : offsets)
+  {
+    for (Entity e = offset + 1; e < offset + 10000; ++e)
+      ASSERT_NE(nullptr, index.Insert(e, e));
+  }
+  EXPECT_EQ(3u * 9999u, index.Size());
+
+  for (auto offset : offsets)
+  {
+    for (Entity e = offset + 1; e < offset + 10000; ++e)
+    {
+      auto value = index.Find(e);
+      ASSERT_NE(nullptr, value);
+      EXPECT_EQ(e, *value);
+    }
+    EXPECT_EQ(nullptr, index.Find(offset + 10000));
+  }
+
+  // Pages before an existing block
+  EXPECT_NE(nullptr, index.Insert(offsets[2] - 5000, 1));
+  EXPECT_NE(nullptr, index.Find(offsets[2] - 5000));
+  EXPECT_NE(nullptr, index.Find(offsets[2] + 1));
+}
+
+//////////////////////////////////////////////////
+TEST(EntityIndex, NearbyClusters)
+{
+  // Clusters of IDs close enough for a block to be extended towards another
+  // block, as created with several nearby SetEntityCreateOffset calls
+  constexpr Entity kPage{1u << 12};
+  const Entity offsets[] = {0u, 100 * kPage, 36 * kPage, 101 * kPage,
+      90 * kPage};
+
+  EntityIndex<Entity> index;
+  for (auto offset : offsets)
+  {
+    for (Entity e = offset + 1; e < offset + 100; ++e)
+      ASSERT_NE(nullptr, index.Insert(e, e));
+
+    // Everything inserted so far can still be found
+    for (auto previous : offsets)
+    {
+      for (Entity e = previous + 1; e < previous + 100; ++e)
+      {
+        auto value = index.Find(e);
+        ASSERT_NE(nullptr, value) << e;
+        EXPECT_EQ(e, *value);
+      }
+      if (previous == offset)
+        break;
+    }
+  }
+  EXPECT_EQ(5u * 99u, index.Size());
+
+  // Erasing and inserting again finds the same pages
+  EXPECT_TRUE(index.Erase(100 * kPage + 1));
+  EXPECT_EQ(nullptr, index.Find(100 * kPage + 1));
+  EXPECT_NE(nullptr, index.Insert(100 * kPage + 1, 1));
+  EXPECT_NE(nullptr, index.Find(101 * kPage + 1));
+}
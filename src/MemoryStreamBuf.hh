@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_MEMORYSTREAMBUF_HH_
+#define IGNITION_GAZEBO_MEMORYSTREAMBUF_HH_
+
+#include <cstddef>
+#include <streambuf>
+#include <vector>
+
+#include <ignition/gazebo/config.hh>
+
+namespace ignition
+{
+  namespace gazebo
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+    /// \brief Stream buffer that appends everything written to it to a
+    /// vector. A single std::ostream over it can serialize many components
+    /// without constructing a stream per component.
+    class VectorOutStreamBuf : public std::streambuf
+    {
+      /// \brief Constructor
+      /// \param[in] _buffer Vector to append to. It must outlive this.
+      public: explicit VectorOutStreamBuf(std::vector<char> &_buffer)
+              : buffer(_buffer)
+      {
+      }
+
+      // Documentation inherited
+      protected: int_type overflow(int_type _c) override
+      {
+        if (!traits_type::eq_int_type(_c, traits_type::eof()))
+          this->buffer.push_back(traits_type::to_char_type(_c));
+        return traits_type::not_eof(_c);
+      }
+
+      // Documentation inherited
+      protected: std::streamsize xsputn(const char *_s,
+                     std::streamsize _n) override
+      {
+        this->buffer.insert(this->buffer.end(), _s, _s + _n);
+        return _n;
+      }
+
+      /// \brief Vector to append to.
+      private: std::vector<char> &buffer;
+    };
+
+    /// \brief Stream buffer that reads from a range of memory without copying
+    /// it. The range can be changed, so a single std::istream over it can
+    /// deserialize many components.
+    class MemoryInStreamBuf : public std::streambuf
+    {
+      /// \brief Set the range to read from.
+      /// \param[in] _data Start of the range.
+      /// \param[in] _size Size of the range.
+      public: void Reset(const char *_data, std::size_t _size)
+      {
+        // The get area is never written to, the const_cast is only needed by
+        // the std::streambuf interface
+        char *begin = const_cast<char *>(_data);
+        this->setg(begin, begin, begin + _size);
+      }
+    };
+    }
+  }
+}
+#endif
@@ -180,6 +180,27 @@ static Entity FindDescendentLinkEntityByName(const std::string &_name,
   }
 }
 
+//////////////////////////////////////////////////
+/// \brief Count the entities that will be created for a model.
+/// \param[in] _model Model DOM.
+/// \return Number of entities, including the model itself.
+static std::size_t CountEntities(const sdf::Model *_model)
+{
+  std::size_t count{1u + _model->JointCount()};
+  for (uint64_t i = 0; i < _model->LinkCount(); ++i)
+  {
+    auto link = _model->LinkByIndex(i);
+    count += 1u + link->VisualCount() + link->CollisionCount() +
+        link->LightCount() + link->SensorCount() +
+        link->ParticleEmitterCount();
+  }
+  for (uint64_t i = 0; i < _model->JointCount(); ++i)
+    count += _model->JointByIndex(i)->SensorCount();
+  for (uint64_t i = 0; i < _model->ModelCount(); ++i)
+    count += CountEntities(_model->ModelByIndex(i));
+  return count;
+}
+
 //////////////////////////////////////////////////
 SdfEntityCreator::SdfEntityCreator(EntityComponentManager &_ecm,
           EventManager &_eventManager)
@@ -218,12 +239,20 @@ Entity SdfEntityCreator::CreateEntities(const sdf::World *_world)
 {
   IGN_PROFILE("SdfEntityCreator::CreateEntities(sdf::World)");
 
+  // Reserve storage for all the entities in the world up front
+  std::size_t entityCount{1u + _world->ActorCount() + _world->LightCount()};
+  for (uint64_t modelIndex = 0; modelIndex < _world->ModelCount();
+      ++modelIndex)
+  {
+    entityCount += CountEntities(_world->ModelByIndex(modelIndex));
+  }
+  this->dataPtr->ecm->ReserveEntities(entityCount);
+
   // World entity
   Entity worldEntity = this->dataPtr->ecm->CreateEntity();
 
   // World components
-  this->dataPtr->ecm->CreateComponent(worldEntity, components::World());
-  this->dataPtr->ecm->CreateComponent(worldEntity,
+  this->dataPtr->ecm->CreateComponents(worldEntity, components::World(),
       components::Name(_world->Name()));
 
   // scene
@@ -369,20 +398,15 @@ Entity SdfEntityCreator::CreateEntities(const sdf::Model *_model,
   Entity modelEntity = this->dataPtr->ecm->CreateEntity();
 
   // Components
-  this->dataPtr->ecm->CreateComponent(modelEntity, components::Model());
-  this->dataPtr->ecm->CreateComponent(modelEntity,
-      components::Pose(ResolveSdfPose(_model->SemanticPose())));
-  this->dataPtr->ecm->CreateComponent(modelEntity,
-      components::Name(_model->Name()));
   bool isStatic = _model->Static() || _staticParent;
-  this->dataPtr->ecm->CreateComponent(modelEntity,
-      components::Static(isStatic));
-  this->dataPtr->ecm->CreateComponent(
-      modelEntity, components::WindMode(_model->EnableWind()));
-  this->dataPtr->ecm->CreateComponent(
-      modelEntity, components::SelfCollide(_model->SelfCollide()));
-  this->dataPtr->ecm->CreateComponent(
-      modelEntity, components::SourceFilePath(_model->Element()->FilePath()));
+  this->dataPtr->ecm->CreateComponents(modelEntity,
+      components::Model(),
+      components::Pose(ResolveSdfPose(_model->SemanticPose())),
+      components::Name(_model->Name()),
+      components::Static(isStatic),
+      components::WindMode(_model->EnableWind()),
+      components::SelfCollide(_model->SelfCollide()),
+      components::SourceFilePath(_model->Element()->FilePath()));
 
   // NOTE: Pose components of links, visuals, and collisions are expressed in
   // the parent frame until we get frames working.
@@ -475,10 +499,9 @@ Entity SdfEntityCreator::CreateEntities(const sdf::Actor *_actor)
   Entity actorEntity = this->dataPtr->ecm->CreateEntity();
 
   // Components
-  this->dataPtr->ecm->CreateComponent(actorEntity, components::Actor(*_actor));
-  this->dataPtr->ecm->CreateComponent(actorEntity,
-      components::Pose(_actor->RawPose()));
-  this->dataPtr->ecm->CreateComponent(actorEntity,
+  this->dataPtr->ecm->CreateComponents(actorEntity,
+      components::Actor(*_actor),
+      components::Pose(_actor->RawPose()),
       components::Name(_actor->Name()));
 
   // Actor plugins
@@ -497,14 +520,11 @@ Entity SdfEntityCreator::CreateEntities(const sdf::Light *_light)
   Entity lightEntity = this->dataPtr->ecm->CreateEntity();
 
   // Components
-  this->dataPtr->ecm->CreateComponent(lightEntity, components::Light(*_light));
-  this->dataPtr->ecm->CreateComponent(lightEntity,
-      components::Pose(ResolveSdfPose(_light->SemanticPose())));
-  this->dataPtr->ecm->CreateComponent(lightEntity,
-      components::Name(_light->Name()));
-
-  this->dataPtr->ecm->CreateComponent(lightEntity,
-    components::LightType(convert(_light->Type())));
+  this->dataPtr->ecm->CreateComponents(lightEntity,
+      components::Light(*_light),
+      components::Pose(ResolveSdfPose(_light->SemanticPose())),
+      components::Name(_light->Name()),
+      components::LightType(convert(_light->Type())));
 
   return lightEntity;
 }
@@ -518,13 +538,10 @@ Entity SdfEntityCreator::CreateEntities(const sdf::Link *_link)
   Entity linkEntity = this->dataPtr->ecm->CreateEntity();
 
   // Components
-  this->dataPtr->ecm->CreateComponent(linkEntity, components::Link());
-
-  this->dataPtr->ecm->CreateComponent(linkEntity,
-      components::Pose(ResolveSdfPose(_link->SemanticPose())));
-  this->dataPtr->ecm->CreateComponent(linkEntity,
-      components::Name(_link->Name()));
-  this->dataPtr->ecm->CreateComponent(linkEntity,
+  this->dataPtr->ecm->CreateComponents(linkEntity,
+      components::Link(),
+      components::Pose(ResolveSdfPose(_link->SemanticPose())),
+      components::Name(_link->Name()),
       components::Inertial(_link->Inertial()));
 
   if (_link->EnableWind())
@@ -602,9 +619,8 @@ Entity SdfEntityCreator::CreateEntities(const sdf::Joint *_joint,
   Entity jointEntity = this->dataPtr->ecm->CreateEntity();
 
   // Components
-  this->dataPtr->ecm->CreateComponent(jointEntity,
-      components::Joint());
-  this->dataPtr->ecm->CreateComponent(jointEntity,
+  this->dataPtr->ecm->CreateComponents(jointEntity,
+      components::Joint(),
       components::JointType(_joint->Type()));
 
   // Sensors
@@ -645,11 +661,9 @@ Entity SdfEntityCreator::CreateEntities(const sdf::Joint *_joint,
         components::JointAxis2(std::move(*resolvedAxis)));
   }
 
-  this->dataPtr->ecm->CreateComponent(jointEntity,
-      components::Pose(ResolveSdfPose(_joint->SemanticPose())));
-  this->dataPtr->ecm->CreateComponent(jointEntity ,
-      components::Name(_joint->Name()));
-  this->dataPtr->ecm->CreateComponent(jointEntity ,
+  this->dataPtr->ecm->CreateComponents(jointEntity,
+      components::Pose(ResolveSdfPose(_joint->SemanticPose())),
+      components::Name(_joint->Name()),
       components::ThreadPitch(_joint->ThreadPitch()));
 
 
@@ -717,16 +731,12 @@ Entity SdfEntityCreator::CreateEntities(const sdf::Visual *_visual)
   Entity visualEntity = this->dataPtr->ecm->CreateEntity();
 
   // Components
-  this->dataPtr->ecm->CreateComponent(visualEntity, components::Visual());
-  this->dataPtr->ecm->CreateComponent(visualEntity,
-      components::Pose(ResolveSdfPose(_visual->SemanticPose())));
-  this->dataPtr->ecm->CreateComponent(visualEntity,
-      components::Name(_visual->Name()));
-  this->dataPtr->ecm->CreateComponent(visualEntity,
-      components::CastShadows(_visual->CastShadows()));
-  this->dataPtr->ecm->CreateComponent(visualEntity,
-      components::Transparency(_visual->Transparency()));
-  this->dataPtr->ecm->CreateComponent(visualEntity,
+  this->dataPtr->ecm->CreateComponents(visualEntity,
+      components::Visual(),
+      components::Pose(ResolveSdfPose(_visual->SemanticPose())),
+      components::Name(_visual->Name()),
+      components::CastShadows(_visual->CastShadows()),
+      components::Transparency(_visual->Transparency()),
       components::VisibilityFlags(_visual->VisibilityFlags()));
 
   if (_visual->HasLaserRetro())
@@ -764,11 +774,9 @@ Entity SdfEntityCreator::CreateEntities(const sdf::ParticleEmitter *_emitter)
   Entity emitterEntity = this->dataPtr->ecm->CreateEntity();
 
   // Components
-  this->dataPtr->ecm->CreateComponent(emitterEntity,
-      components::ParticleEmitter(convert<msgs::ParticleEmitter>(*_emitter)));
-  this->dataPtr->ecm->CreateComponent(emitterEntity,
-      components::Pose(ResolveSdfPose(_emitter->SemanticPose())));
-  this->dataPtr->ecm->CreateComponent(emitterEntity,
+  this->dataPtr->ecm->CreateComponents(emitterEntity,
+      components::ParticleEmitter(convert<msgs::ParticleEmitter>(*_emitter)),
+      components::Pose(ResolveSdfPose(_emitter->SemanticPose())),
       components::Name(_emitter->Name()));
 
   return emitterEntity;
@@ -783,11 +791,9 @@ Entity SdfEntityCreator::CreateEntities(const sdf::Collision *_collision)
   Entity collisionEntity = this->dataPtr->ecm->CreateEntity();
 
   // Components
-  this->dataPtr->ecm->CreateComponent(collisionEntity,
-      components::Collision());
-  this->dataPtr->ecm->CreateComponent(collisionEntity,
-      components::Pose(ResolveSdfPose(_collision->SemanticPose())));
-  this->dataPtr->ecm->CreateComponent(collisionEntity,
+  this->dataPtr->ecm->CreateComponents(collisionEntity,
+      components::Collision(),
+      components::Pose(ResolveSdfPose(_collision->SemanticPose())),
       components::Name(_collision->Name()));
 
   if (_collision->Geom())
@@ -811,11 +817,9 @@ Entity SdfEntityCreator::CreateEntities(const sdf::Sensor *_sensor)
   Entity sensorEntity = this->dataPtr->ecm->CreateEntity();
 
   // Components
-  this->dataPtr->ecm->CreateComponent(sensorEntity,
-      components::Sensor());
-  this->dataPtr->ecm->CreateComponent(sensorEntity,
-      components::Pose(ResolveSdfPose(_sensor->SemanticPose())));
-  this->dataPtr->ecm->CreateComponent(sensorEntity,
+  this->dataPtr->ecm->CreateComponents(sensorEntity,
+      components::Sensor(),
+      components::Pose(ResolveSdfPose(_sensor->SemanticPose())),
       components::Name(_sensor->Name()));
 
   if (_sensor->Type() == sdf::SensorType::CAMERA)
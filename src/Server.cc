@@ -396,6 +396,43 @@ std::optional<Entity> Server::EntityByName(const std::string &_name,
   return std::nullopt;
 }
 
+//////////////////////////////////////////////////
+std::optional<WorldSnapshot> Server::Snapshot(const unsigned int _worldIndex)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->runMutex);
+  if (this->dataPtr->running)
+  {
+    ignerr << "Cannot take a snapshot while the server is running.\n";
+    return std::nullopt;
+  }
+
+  if (_worldIndex < this->dataPtr->simRunners.size())
+    return this->dataPtr->simRunners[_worldIndex]->Snapshot();
+
+  return std::nullopt;
+}
+
+//////////////////////////////////////////////////
+bool Server::Restore(const WorldSnapshot &_snapshot,
+    const unsigned int _worldIndex)
+{
+  std::lock_guard<std::mutex> lock(this->dataPtr->runMutex);
+  if (this->dataPtr->running)
+  {
+    ignerr << "Cannot restore a snapshot while the server is running.\n";
+    return false;
+  }
+
+  if (nullptr == _snapshot.ecm ||
+      _worldIndex >= this->dataPtr->simRunners.size())
+  {
+    return false;
+  }
+
+  this->dataPtr->simRunners[_worldIndex]->Restore(_snapshot);
+  return true;
+}
+
 //////////////////////////////////////////////////
 bool Server::RequestRemoveEntity(const std::string &_name,
     bool _recursive, const unsigned int _worldIndex)
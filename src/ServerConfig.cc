@@ -18,6 +18,8 @@
 
 #include <tinyxml2.h>
 
+#include <algorithm>
+
 #include <ignition/common/Console.hh>
 #include <ignition/common/Filesystem.hh>
 #include <ignition/common/Util.hh>
@@ -236,6 +238,11 @@ class ignition::gazebo::ServerConfigPrivate
             networkRole(_cfg->networkRole),
             networkSecondaries(_cfg->networkSecondaries),
             seed(_cfg->seed),
+            systemWorkerCount(_cfg->systemWorkerCount),
+            pipelinedPostUpdate(_cfg->pipelinedPostUpdate),
+            worldPoseCache(_cfg->worldPoseCache),
+            componentValueIndexes(_cfg->componentValueIndexes),
+            throughputPeriod(_cfg->throughputPeriod),
             logRecordTopics(_cfg->logRecordTopics),
             isHeadlessRendering(_cfg->isHeadlessRendering) { }
 
@@ -293,6 +300,23 @@ class ignition::gazebo::ServerConfigPrivate
   /// \brief The given random seed.
   public: unsigned int seed = 0;
 
+  /// \brief Number of worker threads which run systems, if set.
+  public: std::optional<unsigned int> systemWorkerCount;
+
+  /// \brief True to run lag tolerant PostUpdate systems in parallel with
+  /// the next iteration.
+  public: bool pipelinedPostUpdate{false};
+
+  /// \brief True to cache world poses.
+  public: bool worldPoseCache{false};
+
+  /// \brief True to index the values of the components entities are most
+  /// often looked up by.
+  public: bool componentValueIndexes{false};
+
+  /// \brief Iterations between statistics in throughput mode, if enabled.
+  public: std::optional<unsigned int> throughputPeriod;
+
   /// \brief Timestamp that marks when this ServerConfig was created.
   public: std::chrono::time_point<std::chrono::system_clock> timestamp;
 
@@ -526,6 +550,66 @@ void ServerConfig::SetRenderEngineServer(const std::string &_renderEngineServer)
   this->dataPtr->renderEngineServer = _renderEngineServer;
 }
 
+/////////////////////////////////////////////////
+void ServerConfig::SetSystemWorkerCount(unsigned int _count)
+{
+  this->dataPtr->systemWorkerCount = _count;
+}
+
+/////////////////////////////////////////////////
+std::optional<unsigned int> ServerConfig::SystemWorkerCount() const
+{
+  return this->dataPtr->systemWorkerCount;
+}
+
+/////////////////////////////////////////////////
+void ServerConfig::SetPipelinedPostUpdate(const bool _pipelined)
+{
+  this->dataPtr->pipelinedPostUpdate = _pipelined;
+}
+
+/////////////////////////////////////////////////
+bool ServerConfig::PipelinedPostUpdate() const
+{
+  return this->dataPtr->pipelinedPostUpdate;
+}
+
+/////////////////////////////////////////////////
+void ServerConfig::SetWorldPoseCache(const bool _cache)
+{
+  this->dataPtr->worldPoseCache = _cache;
+}
+
+/////////////////////////////////////////////////
+bool ServerConfig::WorldPoseCache() const
+{
+  return this->dataPtr->worldPoseCache;
+}
+
+/////////////////////////////////////////////////
+void ServerConfig::SetComponentValueIndexes(const bool _index)
+{
+  this->dataPtr->componentValueIndexes = _index;
+}
+
+/////////////////////////////////////////////////
+bool ServerConfig::ComponentValueIndexes() const
+{
+  return this->dataPtr->componentValueIndexes;
+}
+
+/////////////////////////////////////////////////
+void ServerConfig::SetThroughputPeriod(unsigned int _iterations)
+{
+  this->dataPtr->throughputPeriod = std::max(_iterations, 1u);
+}
+
+/////////////////////////////////////////////////
+std::optional<unsigned int> ServerConfig::ThroughputPeriod() const
+{
+  return this->dataPtr->throughputPeriod;
+}
+
 /////////////////////////////////////////////////
 void ServerConfig::SetHeadlessRendering(const bool _headless)
 {
@@ -228,3 +228,70 @@ TEST(ServerConfig, GenerateRecordPlugin)
   EXPECT_EQ(plugin.Name(), "ignition::gazebo::systems::LogRecord");
 }
 
+
+//////////////////////////////////////////////////
+TEST(ServerConfig, SystemWorkerCount)
+{
+  ServerConfig config;
+  EXPECT_EQ(std::nullopt, config.SystemWorkerCount());
+
+  config.SetSystemWorkerCount(0);
+  EXPECT_EQ(0u, config.SystemWorkerCount());
+
+  config.SetSystemWorkerCount(3);
+  ServerConfig copy(config);
+  EXPECT_EQ(3u, copy.SystemWorkerCount());
+}
+
+//////////////////////////////////////////////////
+TEST(ServerConfig, PipelinedPostUpdate)
+{
+  ServerConfig config;
+  EXPECT_FALSE(config.PipelinedPostUpdate());
+
+  config.SetPipelinedPostUpdate(true);
+  EXPECT_TRUE(config.PipelinedPostUpdate());
+
+  ServerConfig copy(config);
+  EXPECT_TRUE(copy.PipelinedPostUpdate());
+}
+
+//////////////////////////////////////////////////
+TEST(ServerConfig, WorldPoseCache)
+{
+  ServerConfig config;
+  EXPECT_FALSE(config.WorldPoseCache());
+
+  config.SetWorldPoseCache(true);
+  EXPECT_TRUE(config.WorldPoseCache());
+
+  ServerConfig copy(config);
+  EXPECT_TRUE(copy.WorldPoseCache());
+}
+
+//////////////////////////////////////////////////
+TEST(ServerConfig, ComponentValueIndexes)
+{
+  ServerConfig config;
+  EXPECT_FALSE(config.ComponentValueIndexes());
+
+  config.SetComponentValueIndexes(true);
+  EXPECT_TRUE(config.ComponentValueIndexes());
+
+  ServerConfig copy(config);
+  EXPECT_TRUE(copy.ComponentValueIndexes());
+}
+
+//////////////////////////////////////////////////
+TEST(ServerConfig, ThroughputPeriod)
+{
+  ServerConfig config;
+  EXPECT_EQ(std::nullopt, config.ThroughputPeriod());
+
+  config.SetThroughputPeriod(0);
+  EXPECT_EQ(1u, config.ThroughputPeriod());
+
+  config.SetThroughputPeriod(100);
+  ServerConfig copy(config);
+  EXPECT_EQ(100u, copy.ThroughputPeriod());
+}
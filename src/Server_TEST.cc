@@ -71,6 +71,9 @@ TEST_P(ServerFixture, DefaultServerConfig)
   EXPECT_TRUE(serverConfig.PhysicsEngine().empty());
   EXPECT_TRUE(serverConfig.Plugins().empty());
   EXPECT_TRUE(serverConfig.LogRecordTopics().empty());
+  EXPECT_FALSE(serverConfig.SystemWorkerCount());
+  EXPECT_FALSE(serverConfig.PipelinedPostUpdate());
+  EXPECT_FALSE(serverConfig.ThroughputPeriod());
 
   gazebo::Server server(serverConfig);
   EXPECT_FALSE(server.Running());
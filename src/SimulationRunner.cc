@@ -18,6 +18,13 @@
 #include "SimulationRunner.hh"
 
 #include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <typeinfo>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
 
 #include <sdf/Root.hh>
 
@@ -28,6 +35,7 @@
 #include "ignition/gazebo/components/Visual.hh"
 #include "ignition/gazebo/components/World.hh"
 #include "ignition/gazebo/components/ParentEntity.hh"
+#include "ignition/gazebo/components/ParentLinkName.hh"
 #include "ignition/gazebo/components/Physics.hh"
 #include "ignition/gazebo/components/PhysicsCmd.hh"
 #include "ignition/gazebo/components/Recreate.hh"
@@ -43,6 +51,37 @@ using namespace gazebo;
 
 using StringSet = std::unordered_set<std::string>;
 
+/// \brief Get a readable name for a system, which is the name of its class.
+/// For systems loaded from plugins, this matches the plugin name.
+/// \param[in] _system The system.
+/// \return The demangled class name.
+static std::string systemName(const System *_system)
+{
+  if (nullptr == _system)
+    return "unknown";
+
+  std::string name = typeid(*_system).name();
+#ifdef __GNUG__
+  int status{-1};
+  char *demangled =
+      abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+  if (0 == status && nullptr != demangled)
+    name = demangled;
+  free(demangled);
+#endif
+  return name;
+}
+
+/// \brief Time a call.
+/// \param[in] _fn Function to call.
+/// \return Wall time taken by the call.
+template <typename Fn>
+static std::chrono::steady_clock::duration timed(Fn &&_fn)
+{
+  const auto start = std::chrono::steady_clock::now();
+  _fn();
+  return std::chrono::steady_clock::now() - start;
+}
 
 //////////////////////////////////////////////////
 SimulationRunner::SimulationRunner(const sdf::World *_world,
@@ -64,6 +103,17 @@ SimulationRunner::SimulationRunner(const sdf::World *_world,
   // Keep system loader so plugins can be loaded at runtime
   this->systemLoader = _systemLoader;
 
+  // Systems and the manager's parallel iteration share one pool, so that
+  // together they don't use more threads than the machine has
+  const unsigned int workers = this->serverConfig.SystemWorkerCount()
+      .value_or(WorkStealingPool::DefaultWorkerCount());
+  this->systemsPool = std::make_unique<WorkStealingPool>(workers);
+  this->entityCompMgr.SetWorkerPool(this->systemsPool.get());
+  this->entityCompMgr.EnableWorldPoseCache(
+      this->serverConfig.WorldPoseCache());
+  igndbg << "Created system worker pool with "
+         << this->systemsPool->WorkerCount() << " threads" << std::endl;
+
   // Get the physics profile
   // TODO(luca): remove duplicated logic in SdfEntityCreator and LevelManager
   auto physics = _world->PhysicsByIndex(0);
@@ -118,9 +168,20 @@ SimulationRunner::SimulationRunner(const sdf::World *_world,
       std::bind(&SimulationRunner::LoadPlugins, this, std::placeholders::_1,
       std::placeholders::_2));
 
+  // Index the components that entities are most often looked up by, such as
+  // when resolving scoped names
+  if (_config.ComponentValueIndexes())
+  {
+    this->entityCompMgr.EnableValueIndex<components::Name>();
+    this->entityCompMgr.EnableValueIndex<components::ParentEntity>();
+    this->entityCompMgr.EnableValueIndex<components::ParentLinkName>();
+  }
+
   // Create the level manager
   this->levelMgr = std::make_unique<LevelManager>(this, _config.UseLevels());
 
+  this->throughputPeriod = _config.ThroughputPeriod().value_or(0);
+
   // Check if this is going to be a distributed runner
   // Attempt to create the manager based on environment variables.
   // If the configuration is invalid, then networkMgr will be `nullptr`.
@@ -222,6 +283,13 @@ SimulationRunner::SimulationRunner(const sdf::World *_world,
   ignmsg << "World [" << _world->Name() << "] initialized with ["
          << physics->Name() << "] physics profile." << std::endl;
 
+  std::string systemStatsService{"stats/systems"};
+  this->node->Advertise(systemStatsService,
+      &SimulationRunner::SystemStatsService, this);
+
+  ignmsg << "Serving system statistics on [" << opts.NameSpace() << "/"
+         << systemStatsService << "]" << std::endl;
+
   std::string genWorldSdfService{"generate_world_sdf"};
   this->node->Advertise(
       genWorldSdfService, &SimulationRunner::GenerateWorldSdf, this);
@@ -233,7 +301,8 @@ SimulationRunner::SimulationRunner(const sdf::World *_world,
 //////////////////////////////////////////////////
 SimulationRunner::~SimulationRunner()
 {
-  this->StopWorkerThreads();
+  // Pipelined PostUpdate systems may still be reading the lagged manager
+  this->WaitForLaggedPostUpdate();
 }
 
 /////////////////////////////////////////////////
@@ -420,6 +489,13 @@ void SimulationRunner::PublishStats()
     headerData->set_key("step");
   }
 
+  if (this->throughputPeriod > 0)
+  {
+    auto headerData = msg.mutable_header()->add_data();
+    headerData->set_key("iterations_per_second");
+    headerData->add_value(std::to_string(this->iterationsPerSecond.load()));
+  }
+
   // Publish the stats message. The stats message is throttled.
   this->statsPub.Publish(msg);
 
@@ -441,6 +517,84 @@ void SimulationRunner::PublishStats()
   // Only publish to root topic if no others are.
   if (this->rootClockPub.Valid())
     this->rootClockPub.Publish(clockMsg);
+
+  this->PublishSystemStats();
+}
+
+/////////////////////////////////////////////////
+void SimulationRunner::PublishSystemStats()
+{
+  // Summaries sort the recent samples, so they're computed at a fixed wall
+  // time rate instead of every iteration.
+  const auto now = std::chrono::steady_clock::now();
+  if (now - this->systemStatsPubTime < 1s || this->systemStats.Size() == 0)
+    return;
+  this->systemStatsPubTime = now;
+
+  // Pipelined PostUpdate systems record their samples in the background
+  this->WaitForLaggedPostUpdate();
+
+  IGN_PROFILE("SimulationRunner::PublishSystemStats");
+
+  static const std::array<std::string, SystemStats::kPhaseCount> kPhaseNames{
+      "pre_update", "update", "post_update"};
+
+  auto setDouble = [](msgs::Param &_param, const std::string &_key,
+      double _value)
+  {
+    auto &any = (*_param.mutable_params())[_key];
+    any.set_type(msgs::Any::DOUBLE);
+    any.set_double_value(_value);
+  };
+
+  auto setInt = [](msgs::Param &_param, const std::string &_key, int _value)
+  {
+    auto &any = (*_param.mutable_params())[_key];
+    any.set_type(msgs::Any::INT32);
+    any.set_int_value(_value);
+  };
+
+  auto toMs = [](std::chrono::steady_clock::duration _duration)
+  {
+    return std::chrono::duration<double, std::milli>(_duration).count();
+  };
+
+  msgs::Param_V msg;
+  msg.mutable_header()->mutable_stamp()->CopyFrom(
+      convert<msgs::Time>(this->currentInfo.simTime));
+  for (std::size_t i = 0; i < this->systemStats.Size(); ++i)
+  {
+    auto *param = msg.add_param();
+
+    auto &name = (*param->mutable_params())["name"];
+    name.set_type(msgs::Any::STRING);
+    name.set_string_value(this->systemStats.Name(i));
+
+    // Entities are 64 bits, which don't fit in msgs::Any's integer
+    auto &entity = (*param->mutable_params())["entity"];
+    entity.set_type(msgs::Any::STRING);
+    entity.set_string_value(
+        std::to_string(this->systemStats.SystemEntity(i)));
+
+    for (std::size_t phase = 0; phase < SystemStats::kPhaseCount; ++phase)
+    {
+      auto summary = this->systemStats.Summarize(i,
+          static_cast<SystemStats::Phase>(phase));
+      if (!summary)
+        continue;
+
+      const auto &prefix = kPhaseNames[phase];
+      setDouble(*param, prefix + "_p50_ms", toMs(summary->p50));
+      setDouble(*param, prefix + "_p99_ms", toMs(summary->p99));
+      setDouble(*param, prefix + "_max_ms", toMs(summary->max));
+      setInt(*param, prefix + "_samples", static_cast<int>(summary->samples));
+    }
+  }
+
+  this->systemStatsPub.Publish(msg);
+
+  std::lock_guard<std::mutex> lock(this->systemStatsMsgMutex);
+  this->systemStatsMsg = std::move(msg);
 }
 
 //////////////////////////////////////////////////
@@ -466,16 +620,18 @@ void SimulationRunner::AddSystemImpl(
       std::optional<Entity> _entity,
       std::optional<std::shared_ptr<const sdf::Element>> _sdf)
 {
+  // Default to world entity
+  _system.parentEntity = _entity.has_value() ? _entity.value()
+      : worldEntity(this->entityCompMgr);
+
   // Call configure
   if (_system.configure)
   {
-    // Default to world entity and SDF
-    auto entity = _entity.has_value() ? _entity.value()
-        : worldEntity(this->entityCompMgr);
+    // Default to world SDF
     auto sdf = _sdf.has_value() ? _sdf.value() : this->sdfWorld->Element();
 
     _system.configure->Configure(
-        entity, sdf,
+        _system.parentEntity, sdf,
         this->entityCompMgr,
         this->eventMgr);
   }
@@ -490,110 +646,176 @@ void SimulationRunner::AddSystemToRunner(SystemInternal _system)
 {
   this->systems.push_back(_system);
 
+  std::optional<SystemScheduler::Access> access;
+  if (_system.componentAccess)
+  {
+    access = SystemScheduler::Access();
+    _system.componentAccess->ComponentAccess(access->reads, access->writes);
+  }
+
+  // The system's index also orders the command buffers it records in
+  const auto stats = this->systemStats.Add(systemName(_system.system),
+      _system.parentEntity);
+
   if (_system.preupdate)
-    this->systemsPreupdate.push_back(_system.preupdate);
+  {
+    this->systemsPreupdate.Add([this, system = _system.preupdate, stats]
+    {
+      EntityComponentManager::CommandScope scope(stats);
+      this->systemStats.Record(stats, SystemStats::Phase::kPreUpdate, timed([&]
+      {
+        system->PreUpdate(this->currentInfo, this->entityCompMgr);
+      }));
+    }, access);
+  }
 
   if (_system.update)
-    this->systemsUpdate.push_back(_system.update);
+  {
+    this->systemsUpdate.Add([this, system = _system.update, stats]
+    {
+      EntityComponentManager::CommandScope scope(stats);
+      this->systemStats.Record(stats, SystemStats::Phase::kUpdate, timed([&]
+      {
+        system->Update(this->currentInfo, this->entityCompMgr);
+      }));
+    }, access);
+  }
 
   if (_system.postupdate)
-    this->systemsPostupdate.push_back(_system.postupdate);
+  {
+    if (this->serverConfig.PipelinedPostUpdate() && _system.postUpdateLag &&
+        _system.postUpdateLag->PostUpdateLagTolerated())
+    {
+      this->systemsPostupdateLagged.push_back(_system.postupdate);
+      this->systemsPostupdateLaggedStats.push_back(stats);
+    }
+    else
+    {
+      this->systemsPostupdate.push_back(_system.postupdate);
+      this->systemsPostupdateStats.push_back(stats);
+    }
+  }
 }
 
 /////////////////////////////////////////////////
 void SimulationRunner::ProcessSystemQueue()
 {
   std::lock_guard<std::mutex> lock(this->pendingSystemsMutex);
-  auto pending = this->pendingSystems.size();
-
-  if (pending > 0)
-  {
-    // If additional systems are to be added, stop the existing threads.
-    this->StopWorkerThreads();
-  }
-
   for (const auto &system : this->pendingSystems)
   {
     this->AddSystemToRunner(system);
   }
   this->pendingSystems.clear();
+}
 
-  // If additional systems were added, recreate the worker threads.
-  if (pending > 0)
+/////////////////////////////////////////////////
+void SimulationRunner::UpdateSystems()
+{
+  IGN_PROFILE("SimulationRunner::UpdateSystems");
+  // Systems which declared the components they access may run
+  // concurrently, in which case views are locked like during PostUpdate.
+  // The others run alone, in order.
+  auto onConcurrent = [this](bool _concurrent)
   {
-    igndbg << "Creating PostUpdate worker threads: "
-      << this->systemsPostupdate.size() + 1 << std::endl;
+    this->entityCompMgr.LockAddingEntitiesToViews(_concurrent);
+  };
 
-    this->postUpdateStartBarrier =
-      std::make_unique<Barrier>(this->systemsPostupdate.size() + 1u);
-    this->postUpdateStopBarrier =
-      std::make_unique<Barrier>(this->systemsPostupdate.size() + 1u);
+  {
+    IGN_PROFILE("PreUpdate");
+    this->systemsPreupdate.Run(this->systemsPool.get(), onConcurrent);
+    this->entityCompMgr.ApplyCommandBuffers();
+  }
 
-    this->postUpdateThreadsRunning = true;
-    int id = 0;
+  {
+    IGN_PROFILE("Update");
+    this->systemsUpdate.Run(this->systemsPool.get(), onConcurrent);
+    this->entityCompMgr.ApplyCommandBuffers();
+  }
 
-    for (auto &system : this->systemsPostupdate)
+  {
+    IGN_PROFILE("PostUpdate");
+    // PostUpdate systems only read the manager, so they all run at once
+    if (!this->systemsPostupdate.empty())
     {
-      igndbg << "Creating postupdate worker thread (" << id << ")" << std::endl;
-
-      this->postUpdateThreads.push_back(std::thread([&, id]()
-      {
-        std::stringstream ss;
-        ss << "PostUpdateThread: " << id;
-        IGN_PROFILE_THREAD_NAME(ss.str().c_str());
-        while (this->postUpdateThreadsRunning)
-        {
-          this->postUpdateStartBarrier->Wait();
-          if (this->postUpdateThreadsRunning)
+      this->entityCompMgr.LockAddingEntitiesToViews(true);
+      this->systemsPool->ParallelFor(this->systemsPostupdate.size(),
+          [this](std::size_t _index)
           {
-            system->PostUpdate(this->currentInfo, this->entityCompMgr);
-          }
-          this->postUpdateStopBarrier->Wait();
-        }
-        igndbg << "Exiting postupdate worker thread ("
-          << id << ")" << std::endl;
-      }));
-      id++;
+            EntityComponentManager::CommandScope scope(
+                this->systemsPostupdateStats[_index]);
+            this->systemStats.Record(this->systemsPostupdateStats[_index],
+                SystemStats::Phase::kPostUpdate, timed([&]
+                {
+                  this->systemsPostupdate[_index]->PostUpdate(
+                      this->currentInfo, this->entityCompMgr);
+                }));
+          });
+      this->entityCompMgr.LockAddingEntitiesToViews(false);
     }
+
+    // Changes recorded during PostUpdate are seen by the next iteration
+    this->entityCompMgr.ApplyCommandBuffers();
+
+    this->PipelinePostUpdate();
   }
 }
 
 /////////////////////////////////////////////////
-void SimulationRunner::UpdateSystems()
+void SimulationRunner::PipelinePostUpdate()
 {
-  IGN_PROFILE("SimulationRunner::UpdateSystems");
-  // \todo(nkoenig)  Systems used to be updated in parallel using
-  // an ignition::common::WorkerPool. There is overhead associated with
-  // this, most notably the creation and destruction of WorkOrders (see
-  // WorkerPool.cc). We could turn on parallel updates in the future, and/or
-  // turn it on if there are sufficient systems. More testing is required.
+  if (this->systemsPostupdateLagged.empty())
+    return;
 
+  IGN_PROFILE("PipelinePostUpdate");
+  this->WaitForLaggedPostUpdate();
+
+  // Finish the lagged manager's previous iteration like the live one's, then
+  // bring it to the current iteration
+  if (nullptr == this->laggedEntityCompMgr)
   {
-    IGN_PROFILE("PreUpdate");
-    for (auto& system : this->systemsPreupdate)
-      system->PreUpdate(this->currentInfo, this->entityCompMgr);
+    this->laggedEntityCompMgr = std::make_unique<EntityComponentManager>();
+    this->laggedEntityCompMgr->SetWorkerPool(this->systemsPool.get());
   }
-
+  else
   {
-    IGN_PROFILE("Update");
-    for (auto& system : this->systemsUpdate)
-      system->Update(this->currentInfo, this->entityCompMgr);
+    this->laggedEntityCompMgr->ClearNewlyCreatedEntities();
+    this->laggedEntityCompMgr->ProcessRemoveEntityRequests();
+    this->laggedEntityCompMgr->ClearRemovedComponents();
+    this->laggedEntityCompMgr->SetAllComponentsUnchanged();
   }
+  this->laggedEntityCompMgr->Mirror(this->entityCompMgr);
+  this->laggedInfo = this->currentInfo;
 
+  // The systems run while the next iteration proceeds, until the next call
+  this->laggedEntityCompMgr->LockAddingEntitiesToViews(true);
+  for (std::size_t i = 0; i < this->systemsPostupdateLagged.size(); ++i)
   {
-    IGN_PROFILE("PostUpdate");
-    this->entityCompMgr.LockAddingEntitiesToViews(true);
-    // If no systems implementing PostUpdate have been added, then
-    // the barriers will be uninitialized, so guard against that condition.
-    if (this->postUpdateStartBarrier && this->postUpdateStopBarrier)
-    {
-      this->postUpdateStartBarrier->Wait();
-      this->postUpdateStopBarrier->Wait();
-    }
-    this->entityCompMgr.LockAddingEntitiesToViews(false);
+    this->systemsPool->Submit(this->laggedPostUpdates,
+        [this, system = this->systemsPostupdateLagged[i],
+         stats = this->systemsPostupdateLaggedStats[i]]
+        {
+          EntityComponentManager::CommandScope scope(stats);
+          this->systemStats.Record(stats, SystemStats::Phase::kPostUpdate,
+              timed([&]
+              {
+                system->PostUpdate(this->laggedInfo,
+                    *this->laggedEntityCompMgr);
+              }));
+        });
   }
 }
 
+/////////////////////////////////////////////////
+void SimulationRunner::WaitForLaggedPostUpdate()
+{
+  if (nullptr == this->systemsPool)
+    return;
+
+  this->systemsPool->Wait(this->laggedPostUpdates);
+  if (nullptr != this->laggedEntityCompMgr)
+    this->laggedEntityCompMgr->LockAddingEntitiesToViews(false);
+}
+
 /////////////////////////////////////////////////
 void SimulationRunner::Stop()
 {
@@ -607,25 +829,6 @@ void SimulationRunner::OnStop()
   this->running = false;
 }
 
-/////////////////////////////////////////////////
-void SimulationRunner::StopWorkerThreads()
-{
-  this->postUpdateThreadsRunning = false;
-  if (this->postUpdateStartBarrier)
-  {
-    this->postUpdateStartBarrier->Cancel();
-  }
-  if (this->postUpdateStopBarrier)
-  {
-    this->postUpdateStopBarrier->Cancel();
-  }
-  for (auto &thread : this->postUpdateThreads)
-  {
-    thread.join();
-  }
-  this->postUpdateThreads.clear();
-}
-
 /////////////////////////////////////////////////
 bool SimulationRunner::Run(const uint64_t _iterations)
 {
@@ -682,6 +885,13 @@ bool SimulationRunner::Run(const uint64_t _iterations)
         "stats", advertOpts);
   }
 
+  // Create the system statistics publisher.
+  if (!this->systemStatsPub.Valid())
+  {
+    this->systemStatsPub = this->node->Advertise<ignition::msgs::Param_V>(
+        "stats/systems");
+  }
+
   if (!this->rootStatsPub.Valid())
   {
     // Check for the existence of other publishers on `/stats`
@@ -745,6 +955,12 @@ bool SimulationRunner::Run(const uint64_t _iterations)
 
   // Keep number of iterations requested by caller
   uint64_t processedIterations{0};
+  const auto runStartTime = std::chrono::steady_clock::now();
+
+  // Batches of the throughput mode carry over between calls, so that control
+  // is still due every few iterations when stepping one iteration per call
+  if (0 == this->iterationsSinceControl)
+    this->controlTime = runStartTime;
 
   // Execute all the systems until we are told to stop, or the number of
   // iterations is reached.
@@ -757,30 +973,34 @@ bool SimulationRunner::Run(const uint64_t _iterations)
     this->UpdatePhysicsParams();
 
     // Compute the time to sleep in order to match, as closely as possible,
-    // the update period.
-    sleepTime = 0ns;
-    actualSleep = 0ns;
+    // the update period. Throughput mode runs as fast as possible, but still
+    // sleeps while paused to not spin.
+    if (0 == this->throughputPeriod || this->currentInfo.paused)
+    {
+      sleepTime = 0ns;
+      actualSleep = 0ns;
 
-    sleepTime = std::max(0ns, this->prevUpdateRealTime +
-        this->updatePeriod - std::chrono::steady_clock::now() -
-        this->sleepOffset);
+      sleepTime = std::max(0ns, this->prevUpdateRealTime +
+          this->updatePeriod - std::chrono::steady_clock::now() -
+          this->sleepOffset);
 
-    // Only sleep if needed.
-    if (sleepTime > 0ns)
-    {
-      IGN_PROFILE("Sleep");
-      // Get the current time, sleep for the duration needed to match the
-      // updatePeriod, and then record the actual time slept.
-      startTime = std::chrono::steady_clock::now();
-      std::this_thread::sleep_for(sleepTime);
-      actualSleep = std::chrono::steady_clock::now() - startTime;
-    }
+      // Only sleep if needed.
+      if (sleepTime > 0ns)
+      {
+        IGN_PROFILE("Sleep");
+        // Get the current time, sleep for the duration needed to match the
+        // updatePeriod, and then record the actual time slept.
+        startTime = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(sleepTime);
+        actualSleep = std::chrono::steady_clock::now() - startTime;
+      }
 
-    // Exponentially average out the difference between expected sleep time
-    // and actual sleep time.
-    this->sleepOffset =
-      std::chrono::duration_cast<std::chrono::nanoseconds>(
-          (actualSleep - sleepTime) * 0.01 + this->sleepOffset * 0.99);
+      // Exponentially average out the difference between expected sleep
+      // time and actual sleep time.
+      this->sleepOffset =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            (actualSleep - sleepTime) * 0.01 + this->sleepOffset * 0.99);
+    }
 
     // Update time information. This will update the iteration count, RTF,
     // and other values.
@@ -813,6 +1033,25 @@ bool SimulationRunner::Run(const uint64_t _iterations)
 
   this->running = false;
 
+  if (this->throughputPeriod > 0)
+  {
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - runStartTime;
+    if (elapsed.count() > 0)
+    {
+      this->iterationsPerSecond =
+          static_cast<double>(processedIterations) / elapsed.count();
+    }
+    // Server::RunOnce would log every iteration
+    if (processedIterations > 1)
+    {
+      ignmsg << "Ran [" << processedIterations << "] iterations in ["
+             << elapsed.count() << "] s, ["
+             << this->iterationsPerSecond.load()
+             << "] iterations per second." << std::endl;
+    }
+  }
+
   return true;
 }
 
@@ -822,12 +1061,19 @@ void SimulationRunner::Step(const UpdateInfo &_info)
   IGN_PROFILE("SimulationRunner::Step");
   this->currentInfo = _info;
 
-  // Process new ECM state information, typically sent from the GUI after
-  // a change was made to the GUI's ECM.
-  this->ProcessNewWorldControlState();
+  // In throughput mode, control messages and statistics are only handled
+  // every few iterations
+  const bool controlDue = this->ControlDue();
 
-  // Publish info
-  this->PublishStats();
+  if (controlDue)
+  {
+    // Process new ECM state information, typically sent from the GUI after
+    // a change was made to the GUI's ECM.
+    this->ProcessNewWorldControlState();
+
+    // Publish info
+    this->PublishStats();
+  }
 
   // Record when the update step starts.
   this->prevUpdateRealTime = std::chrono::steady_clock::now();
@@ -868,7 +1114,8 @@ void SimulationRunner::Step(const UpdateInfo &_info)
   }
 
   // Process world control messages.
-  this->ProcessMessages();
+  if (controlDue)
+    this->ProcessMessages();
 
   // Clear all new entities
   this->entityCompMgr.ClearNewlyCreatedEntities();
@@ -1122,6 +1369,39 @@ bool SimulationRunner::Stepping() const
   return this->stepping;
 }
 
+/////////////////////////////////////////////////
+bool SimulationRunner::ControlDue()
+{
+  if (0 == this->throughputPeriod)
+    return true;
+
+  // Requests are handled right away, and stepping must be stopped once its
+  // iterations are done
+  ++this->iterationsSinceControl;
+  if (!this->controlRequested.exchange(false) && !this->Stepping() &&
+      this->iterationsSinceControl < this->throughputPeriod)
+  {
+    return false;
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  const std::chrono::duration<double> elapsed = now - this->controlTime;
+  if (elapsed.count() > 0)
+  {
+    this->iterationsPerSecond =
+        static_cast<double>(this->iterationsSinceControl) / elapsed.count();
+  }
+  this->controlTime = now;
+  this->iterationsSinceControl = 0;
+  return true;
+}
+
+/////////////////////////////////////////////////
+double SimulationRunner::IterationsPerSecond() const
+{
+  return this->iterationsPerSecond;
+}
+
 /////////////////////////////////////////////////
 void SimulationRunner::SetRunToSimTime(
     const std::chrono::steady_clock::duration &_time)
@@ -1193,6 +1473,7 @@ bool SimulationRunner::OnWorldControlState(const msgs::WorldControlState &_req,
   }
 
   this->worldControls.push_back(control);
+  this->controlRequested = true;
 
   _res.set_data(true);
   return true;
@@ -1236,6 +1517,7 @@ bool SimulationRunner::OnPlaybackControl(const msgs::LogPlaybackControl &_req,
   }
 
   this->worldControls.push_back(control);
+  this->controlRequested = true;
 
   _res.set_data(true);
   return true;
@@ -1365,6 +1647,40 @@ const EntityComponentManager &SimulationRunner::EntityCompMgr() const
   return this->entityCompMgr;
 }
 
+/////////////////////////////////////////////////
+WorldSnapshot SimulationRunner::Snapshot() const
+{
+  WorldSnapshot snapshot;
+  snapshot.ecm = this->entityCompMgr.Snapshot();
+  snapshot.simTime = this->currentInfo.simTime;
+  snapshot.iterations = this->currentInfo.iterations;
+  return snapshot;
+}
+
+/////////////////////////////////////////////////
+void SimulationRunner::Restore(const WorldSnapshot &_snapshot)
+{
+  IGN_PROFILE("SimulationRunner::Restore");
+  this->entityCompMgr.Restore(*_snapshot.ecm);
+
+  // Like a seek, the real time factor starts over
+  this->realTimes.clear();
+  this->simTimes.clear();
+  this->realTimeFactor = 0;
+
+  this->currentInfo.dt = _snapshot.simTime - this->currentInfo.simTime;
+  this->currentInfo.simTime = _snapshot.simTime;
+  this->currentInfo.iterations = _snapshot.iterations;
+
+  // Let systems which keep their own state, such as physics, catch up with
+  // the restored entities and components
+  for (auto &system : this->systems)
+  {
+    if (system.reset)
+      system.reset->Reset(this->currentInfo, this->entityCompMgr);
+  }
+}
+
 /////////////////////////////////////////////////
 EventManager &SimulationRunner::EventMgr()
 {
@@ -1476,6 +1792,14 @@ bool SimulationRunner::GuiInfoService(ignition::msgs::GUI &_res)
   return true;
 }
 
+//////////////////////////////////////////////////
+bool SimulationRunner::SystemStatsService(ignition::msgs::Param_V &_res)
+{
+  std::lock_guard<std::mutex> lock(this->systemStatsMsgMutex);
+  _res.CopyFrom(this->systemStatsMsg);
+  return true;
+}
+
 //////////////////////////////////////////////////
 bool SimulationRunner::GenerateWorldSdf(const msgs::SdfGeneratorConfig &_req,
                                         msgs::StringMsg &_res)
@@ -26,6 +26,7 @@
 #include <functional>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <set>
 #include <string>
@@ -47,6 +48,7 @@
 #include "ignition/gazebo/EntityComponentManager.hh"
 #include "ignition/gazebo/EventManager.hh"
 #include "ignition/gazebo/Export.hh"
+#include "ignition/gazebo/Server.hh"
 #include "ignition/gazebo/ServerConfig.hh"
 #include "ignition/gazebo/System.hh"
 #include "ignition/gazebo/SystemLoader.hh"
@@ -55,7 +57,9 @@
 
 #include "network/NetworkManager.hh"
 #include "LevelManager.hh"
-#include "Barrier.hh"
+#include "SystemScheduler.hh"
+#include "SystemStats.hh"
+#include "WorkStealingPool.hh"
 
 using namespace std::chrono_literals;
 
@@ -107,7 +111,12 @@ namespace ignition
                 configure(systemPlugin->QueryInterface<ISystemConfigure>()),
                 preupdate(systemPlugin->QueryInterface<ISystemPreUpdate>()),
                 update(systemPlugin->QueryInterface<ISystemUpdate>()),
-                postupdate(systemPlugin->QueryInterface<ISystemPostUpdate>())
+                postupdate(systemPlugin->QueryInterface<ISystemPostUpdate>()),
+                componentAccess(
+                    systemPlugin->QueryInterface<ISystemComponentAccess>()),
+                postUpdateLag(
+                    systemPlugin->QueryInterface<ISystemPostUpdateLag>()),
+                reset(systemPlugin->QueryInterface<ISystemReset>())
       {
       }
 
@@ -119,7 +128,12 @@ namespace ignition
                 configure(dynamic_cast<ISystemConfigure *>(_system.get())),
                 preupdate(dynamic_cast<ISystemPreUpdate *>(_system.get())),
                 update(dynamic_cast<ISystemUpdate *>(_system.get())),
-                postupdate(dynamic_cast<ISystemPostUpdate *>(_system.get()))
+                postupdate(dynamic_cast<ISystemPostUpdate *>(_system.get())),
+                componentAccess(
+                    dynamic_cast<ISystemComponentAccess *>(_system.get())),
+                postUpdateLag(
+                    dynamic_cast<ISystemPostUpdateLag *>(_system.get())),
+                reset(dynamic_cast<ISystemReset *>(_system.get()))
       {
       }
 
@@ -151,6 +165,22 @@ namespace ignition
       /// Will be nullptr if the System doesn't implement this interface.
       public: ISystemPostUpdate *postupdate = nullptr;
 
+      /// \brief Access this system via the ISystemComponentAccess interface
+      /// Will be nullptr if the System doesn't implement this interface.
+      public: ISystemComponentAccess *componentAccess = nullptr;
+
+      /// \brief Access this system via the ISystemPostUpdateLag interface
+      /// Will be nullptr if the System doesn't implement this interface.
+      public: ISystemPostUpdateLag *postUpdateLag = nullptr;
+
+      /// \brief Access this system via the ISystemReset interface
+      /// Will be nullptr if the System doesn't implement this interface.
+      public: ISystemReset *reset = nullptr;
+
+      /// \brief Entity the system is attached to, which is the world unless
+      /// another entity was given when adding it.
+      public: Entity parentEntity{kNullEntity};
+
       /// \brief Vector of queries and callbacks
       public: std::vector<EntityQueryCallback> updates;
     };
@@ -174,9 +204,6 @@ namespace ignition
       /// \brief Internal method for handling stop event (to prevent recursion)
       private: void OnStop();
 
-      /// \brief Stop and join all post update worker threads
-      private: void StopWorkerThreads();
-
       /// \brief Run the simulationrunner.
       /// \param[in] _iterations Number of iterations.
       /// \return True if the operation completed successfully.
@@ -220,9 +247,22 @@ namespace ignition
       /// \brief Update all the systems
       public: void UpdateSystems();
 
+      /// \brief Wait for the pipelined PostUpdate of the previous iteration,
+      /// copy the entity component manager, and start the pipelined
+      /// PostUpdate of the current iteration in the background.
+      private: void PipelinePostUpdate();
+
+      /// \brief Wait for pipelined PostUpdate systems to finish, if they are
+      /// running.
+      private: void WaitForLaggedPostUpdate();
+
       /// \brief Publish current world statistics.
       public: void PublishStats();
 
+      /// \brief Publish the wall time spent by each system, summarized over
+      /// recent iterations. This is throttled to once per second of wall time.
+      public: void PublishSystemStats();
+
       /// \brief Load system plugin for a given entity.
       /// \param[in] _entity Entity
       /// \param[in] _fname Filename of the plugin library
@@ -249,6 +289,12 @@ namespace ignition
       /// \param[in] _config Configuration to load plugins from.
       public: void LoadLoggingPlugins(const ServerConfig &_config);
 
+      /// \brief Get the number of iterations per second in throughput mode,
+      /// measured over the last call to Run, or over the latest iterations
+      /// between statistics while running.
+      /// \return Iterations per second, or zero if not in throughput mode.
+      public: double IterationsPerSecond() const;
+
       /// \brief Get whether this is running. When running is true,
       /// then simulation is stepping forward.
       /// \return True if the server is running.
@@ -357,6 +403,16 @@ namespace ignition
       public: bool RequestRemoveEntity(const Entity _entity,
           bool _recursive = true);
 
+      /// \brief Capture the entities, components and simulation time of the
+      /// world. Must not be called while running.
+      /// \return The snapshot.
+      public: WorldSnapshot Snapshot() const;
+
+      /// \brief Bring the world back to a snapshot and reset the systems
+      /// which implement ISystemReset. Must not be called while running.
+      /// \param[in] _snapshot Snapshot taken with Snapshot.
+      public: void Restore(const WorldSnapshot &_snapshot);
+
       /// \brief Get the EventManager
       /// \return Reference to the event manager.
       public: EventManager &EventMgr();
@@ -408,6 +464,11 @@ namespace ignition
       /// \return True if successful.
       private: bool GuiInfoService(ignition::msgs::GUI &_res);
 
+      /// \brief Callback for the system statistics service.
+      /// \param[out] _res Response containing the latest system statistics.
+      /// \return True if successful.
+      private: bool SystemStatsService(ignition::msgs::Param_V &_res);
+
       /// \brief Calculate real time factor and populate currentInfo.
       private: void UpdateCurrentInfo();
 
@@ -418,6 +479,12 @@ namespace ignition
       /// \brief Process world control service messages.
       private: void ProcessWorldControl();
 
+      /// \brief Check whether control messages should be processed and
+      /// statistics published in the current iteration. This is always the
+      /// case, except in throughput mode.
+      /// \return True if control and statistics are due.
+      private: bool ControlDue();
+
       /// \brief Actually add system to the runner
       /// \param[in] _system System to be added
       public: void AddSystemToRunner(SystemInternal _system);
@@ -499,14 +566,38 @@ namespace ignition
       private: std::vector<ISystemConfigure *> systemsConfigure;
 
       /// \brief Systems implementing PreUpdate
-      private: std::vector<ISystemPreUpdate *> systemsPreupdate;
+      private: SystemScheduler systemsPreupdate;
 
       /// \brief Systems implementing Update
-      private: std::vector<ISystemUpdate *> systemsUpdate;
+      private: SystemScheduler systemsUpdate;
 
       /// \brief Systems implementing PostUpdate
       private: std::vector<ISystemPostUpdate *> systemsPostupdate;
 
+      /// \brief Index in systemStats of each system in systemsPostupdate.
+      private: std::vector<std::size_t> systemsPostupdateStats;
+
+      /// \brief Systems implementing PostUpdate which run one iteration
+      /// behind, when PostUpdate is pipelined.
+      private: std::vector<ISystemPostUpdate *> systemsPostupdateLagged;
+
+      /// \brief Index in systemStats of each system in
+      /// systemsPostupdateLagged.
+      private: std::vector<std::size_t> systemsPostupdateLaggedStats;
+
+      /// \brief Copy of the entity component manager at the end of the
+      /// previous iteration, read by systemsPostupdateLagged.
+      private: std::unique_ptr<EntityComponentManager> laggedEntityCompMgr;
+
+      /// \brief Update info of the iteration in laggedEntityCompMgr.
+      private: UpdateInfo laggedInfo;
+
+      /// \brief Tasks running systemsPostupdateLagged.
+      private: WorkStealingPool::TaskGroup laggedPostUpdates;
+
+      /// \brief Wall time spent by each system in each phase.
+      private: SystemStats systemStats;
+
       /// \brief Manager of all events.
       private: EventManager eventMgr;
 
@@ -522,6 +613,11 @@ namespace ignition
       /// \brief A pool of worker threads.
       private: common::WorkerPool workerPool{2};
 
+      /// \brief Pool which runs PostUpdate systems, and PreUpdate and Update
+      /// systems that can overlap. The entity component managers use it for
+      /// parallel iteration too.
+      private: std::unique_ptr<WorkStealingPool> systemsPool;
+
       /// \brief Wall time of the previous update.
       private: std::chrono::steady_clock::time_point prevUpdateRealTime;
 
@@ -551,6 +647,18 @@ namespace ignition
       /// \brief World statistics publisher.
       private: ignition::transport::Node::Publisher statsPub;
 
+      /// \brief System statistics publisher.
+      private: ignition::transport::Node::Publisher systemStatsPub;
+
+      /// \brief Wall time at which system statistics were last published.
+      private: std::chrono::steady_clock::time_point systemStatsPubTime;
+
+      /// \brief Latest system statistics, returned by the service.
+      private: ignition::msgs::Param_V systemStatsMsg;
+
+      /// \brief Mutex to protect systemStatsMsg.
+      private: std::mutex systemStatsMsgMutex;
+
       /// \brief Clock publisher for the root `/stats` topic.
       private: ignition::transport::Node::Publisher rootStatsPub;
 
@@ -618,18 +726,6 @@ namespace ignition
       /// \brief Copy of the server configuration.
       public: ServerConfig serverConfig;
 
-      /// \brief Collection of threads running system PostUpdates
-      private: std::vector<std::thread> postUpdateThreads;
-
-      /// \brief Flag to indicate running status of PostUpdate threads
-      private: std::atomic<bool> postUpdateThreadsRunning{false};
-
-      /// \brief Barrier to signal beginning of PostUpdate thread execution
-      private: std::unique_ptr<Barrier> postUpdateStartBarrier;
-
-      /// \brief Barrier to signal end of PostUpdate thread execution
-      private: std::unique_ptr<Barrier> postUpdateStopBarrier;
-
       /// \brief Map from file paths to Fuel URIs.
       private: std::unordered_map<std::string, std::string> fuelUriMap;
 
@@ -647,6 +743,27 @@ namespace ignition
       /// at the appropriate time.
       private: std::unique_ptr<msgs::WorldControlState> newWorldControlState;
 
+      /// \brief Iterations between control processing and statistics in
+      /// throughput mode, or zero if throughput mode is disabled.
+      private: unsigned int throughputPeriod{0};
+
+      /// \brief Iterations since control messages were last processed, in
+      /// throughput mode. It's only reset by ControlDue, so it counts across
+      /// calls to Run.
+      private: unsigned int iterationsSinceControl{0};
+
+      /// \brief Wall time at which control messages were last processed, in
+      /// throughput mode.
+      private: std::chrono::steady_clock::time_point controlTime;
+
+      /// \brief True if a control request arrived since control messages
+      /// were last processed.
+      private: std::atomic<bool> controlRequested{false};
+
+      /// \brief Latest measurement of iterations per second in throughput
+      /// mode.
+      private: std::atomic<double> iterationsPerSecond{0.0};
+
       friend class LevelManager;
     };
     }
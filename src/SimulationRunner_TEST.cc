@@ -18,6 +18,14 @@
 #include <gtest/gtest.h>
 #include <tinyxml2.h>
 
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
 #include <ignition/common/Console.hh>
 #include <ignition/common/Util.hh>
 #include <ignition/transport/Node.hh>
@@ -1615,6 +1623,291 @@ TEST_P(SimulationRunnerTest, GeneratedSdfHasNoSpuriousPlugins)
   EXPECT_TRUE(checkForSpuriousPlugins(newRoot.Element()));
 }
 
+/// \brief System which declares the components it accesses, and writes the
+/// iteration count to a component of the world through the command buffer.
+template <typename ComponentT>
+class DeclaredSystem
+  : public System,
+    public ISystemComponentAccess,
+    public ISystemPreUpdate,
+    public ISystemUpdate
+{
+  // Documentation inherited
+  public: void ComponentAccess(std::set<ComponentTypeId> &_reads,
+              std::set<ComponentTypeId> &_writes) const override
+  {
+    _reads.insert(components::World::typeId);
+    _writes.insert(ComponentT::typeId);
+  }
+
+  // Documentation inherited
+  public: void PreUpdate(const UpdateInfo &_info,
+              EntityComponentManager &_ecm) override
+  {
+    _ecm.Each<components::World>(
+        [&](const Entity &_entity, const components::World *) -> bool
+        {
+          _ecm.CommandBuffer().CreateComponent(_entity,
+              ComponentT(static_cast<int>(_info.iterations)));
+          return true;
+        });
+    this->preUpdates++;
+  }
+
+  // Documentation inherited
+  public: void Update(const UpdateInfo &,
+              EntityComponentManager &) override
+  {
+    this->updates++;
+  }
+
+  /// \brief Number of PreUpdate calls.
+  public: std::atomic<int> preUpdates{0};
+
+  /// \brief Number of Update calls.
+  public: std::atomic<int> updates{0};
+};
+
+/////////////////////////////////////////////////
+TEST_P(SimulationRunnerTest, DeclaredSystems)
+{
+  sdf::Root root;
+  root.Load(common::joinPaths(PROJECT_SOURCE_PATH,
+      "test", "worlds", "shapes.sdf"));
+  ASSERT_EQ(1u, root.WorldCount());
+
+  auto systemLoader = std::make_shared<SystemLoader>();
+  SimulationRunner runner(root.WorldByIndex(0), systemLoader);
+
+  // The two systems don't conflict, so they may run at the same time
+  auto intSystem = std::make_shared<DeclaredSystem<IntComponent>>();
+  auto doubleSystem = std::make_shared<DeclaredSystem<DoubleComponent>>();
+  runner.AddSystem(intSystem);
+  runner.AddSystem(doubleSystem);
+
+  EXPECT_TRUE(runner.Run(10));
+  EXPECT_EQ(10, intSystem->preUpdates.load());
+  EXPECT_EQ(10, intSystem->updates.load());
+  EXPECT_EQ(10, doubleSystem->preUpdates.load());
+  EXPECT_EQ(10, doubleSystem->updates.load());
+
+  // Both command buffers were applied
+  auto &ecm = runner.EntityCompMgr();
+  const Entity world = worldEntity(ecm);
+  auto intComp = ecm.Component<IntComponent>(world);
+  ASSERT_NE(nullptr, intComp);
+  EXPECT_EQ(static_cast<int>(runner.CurrentInfo().iterations),
+      intComp->Data());
+  auto doubleComp = ecm.Component<DoubleComponent>(world);
+  ASSERT_NE(nullptr, doubleComp);
+  EXPECT_DOUBLE_EQ(static_cast<double>(runner.CurrentInfo().iterations),
+      doubleComp->Data());
+}
+
+/////////////////////////////////////////////////
+TEST_P(SimulationRunnerTest, SystemStats)
+{
+  sdf::Root root;
+  root.Load(common::joinPaths(PROJECT_SOURCE_PATH,
+      "test", "worlds", "shapes.sdf"));
+  ASSERT_EQ(1u, root.WorldCount());
+
+  auto systemLoader = std::make_shared<SystemLoader>();
+  SimulationRunner runner(root.WorldByIndex(0), systemLoader);
+
+  runner.AddSystem(std::make_shared<DeclaredSystem<IntComponent>>());
+  EXPECT_TRUE(runner.Run(10));
+
+  transport::Node node;
+  bool result{false};
+  unsigned int timeout{5000};
+  msgs::Param_V res;
+  EXPECT_TRUE(node.Request("/world/default/stats/systems", timeout, res,
+      result));
+  EXPECT_TRUE(result);
+
+  ASSERT_EQ(1, res.param_size());
+  const auto &params = res.param(0).params();
+  ASSERT_NE(params.end(), params.find("name"));
+  EXPECT_NE(std::string::npos,
+      params.at("name").string_value().find("DeclaredSystem"));
+  ASSERT_NE(params.end(), params.find("entity"));
+  EXPECT_EQ(std::to_string(worldEntity(runner.EntityCompMgr())),
+      params.at("entity").string_value());
+
+  // Only the phases the system implements are summarized
+  ASSERT_NE(params.end(), params.find("pre_update_samples"));
+  EXPECT_GE(params.at("pre_update_samples").int_value(), 1);
+  ASSERT_NE(params.end(), params.find("update_p99_ms"));
+  EXPECT_GE(params.at("update_max_ms").double_value(),
+      params.at("update_p99_ms").double_value());
+  EXPECT_EQ(params.end(), params.find("post_update_p50_ms"));
+}
+
+/// \brief PostUpdate system which tolerates lag, and records the value of
+/// the component written by DeclaredSystem<IntComponent> at every iteration.
+class LaggedSystem
+  : public System,
+    public ISystemPostUpdate,
+    public ISystemPostUpdateLag
+{
+  // Documentation inherited
+  public: bool PostUpdateLagTolerated() const override
+  {
+    return true;
+  }
+
+  // Documentation inherited
+  public: void PostUpdate(const UpdateInfo &_info,
+              const EntityComponentManager &_ecm) override
+  {
+    auto comp = _ecm.Component<IntComponent>(worldEntity(_ecm));
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->ecms.insert(&_ecm);
+    this->values.emplace_back(static_cast<int>(_info.iterations),
+        nullptr == comp ? -1 : comp->Data());
+  }
+
+  /// \brief Managers given to PostUpdate.
+  public: std::set<const EntityComponentManager *> ecms;
+
+  /// \brief Iteration and component value seen by each PostUpdate call.
+  public: std::vector<std::pair<int, int>> values;
+
+  /// \brief Protects the members above.
+  public: std::mutex mutex;
+};
+
+/////////////////////////////////////////////////
+TEST_P(SimulationRunnerTest, PipelinedPostUpdate)
+{
+  sdf::Root root;
+  root.Load(common::joinPaths(PROJECT_SOURCE_PATH,
+      "test", "worlds", "shapes.sdf"));
+  ASSERT_EQ(1u, root.WorldCount());
+
+  ServerConfig config;
+  config.SetPipelinedPostUpdate(true);
+  config.SetSystemWorkerCount(2);
+
+  auto lagged = std::make_shared<LaggedSystem>();
+  const EntityComponentManager *liveEcm{nullptr};
+  {
+    auto systemLoader = std::make_shared<SystemLoader>();
+    SimulationRunner runner(root.WorldByIndex(0), systemLoader, config);
+    liveEcm = &runner.EntityCompMgr();
+
+    runner.AddSystem(std::make_shared<DeclaredSystem<IntComponent>>());
+    runner.AddSystem(lagged);
+    EXPECT_TRUE(runner.Run(10));
+
+    // The runner waits for the last PostUpdate when it's destroyed
+  }
+
+  // Every call saw the state of a single iteration, on a copy of the
+  // manager
+  ASSERT_EQ(10u, lagged->values.size());
+  for (const auto &[iteration, value] : lagged->values)
+    EXPECT_EQ(iteration, value);
+  ASSERT_EQ(1u, lagged->ecms.size());
+  EXPECT_NE(liveEcm, *lagged->ecms.begin());
+}
+
+/////////////////////////////////////////////////
+TEST_P(SimulationRunnerTest, LaggedPostUpdateNotPipelined)
+{
+  sdf::Root root;
+  root.Load(common::joinPaths(PROJECT_SOURCE_PATH,
+      "test", "worlds", "shapes.sdf"));
+  ASSERT_EQ(1u, root.WorldCount());
+
+  // Pipelining is off by default, so the system runs on the live manager
+  auto systemLoader = std::make_shared<SystemLoader>();
+  SimulationRunner runner(root.WorldByIndex(0), systemLoader);
+
+  auto lagged = std::make_shared<LaggedSystem>();
+  runner.AddSystem(std::make_shared<DeclaredSystem<IntComponent>>());
+  runner.AddSystem(lagged);
+  EXPECT_TRUE(runner.Run(10));
+
+  ASSERT_EQ(10u, lagged->values.size());
+  ASSERT_EQ(1u, lagged->ecms.size());
+  EXPECT_EQ(&runner.EntityCompMgr(), *lagged->ecms.begin());
+}
+
+/////////////////////////////////////////////////
+TEST_P(SimulationRunnerTest, ThroughputMode)
+{
+  sdf::Root root;
+  root.Load(common::joinPaths(PROJECT_SOURCE_PATH,
+      "test", "worlds", "shapes.sdf"));
+  ASSERT_EQ(1u, root.WorldCount());
+
+  std::atomic<int> clockCount{0};
+  std::function<void(const msgs::Clock &)> countClock =
+      [&](const msgs::Clock &)
+      {
+        clockCount++;
+      };
+  transport::Node node;
+  node.Subscribe("/world/default/clock", countClock);
+
+  ServerConfig config;
+  config.SetThroughputPeriod(100);
+
+  auto systemLoader = std::make_shared<SystemLoader>();
+  SimulationRunner runner(root.WorldByIndex(0), systemLoader, config);
+  EXPECT_DOUBLE_EQ(0.0, runner.IterationsPerSecond());
+
+  runner.SetPaused(false);
+  EXPECT_TRUE(runner.Run(1000));
+  EXPECT_EQ(1000u, runner.CurrentInfo().iterations);
+  EXPECT_EQ(1000ms, runner.CurrentInfo().simTime);
+
+  // Without sleeping, the iterations take less than the 1s of real time
+  EXPECT_GT(runner.IterationsPerSecond(), 1000.0);
+
+  // The clock is only published every 100 iterations
+  std::this_thread::sleep_for(100ms);
+  EXPECT_LE(clockCount.load(), 10);
+}
+
+/////////////////////////////////////////////////
+TEST_P(SimulationRunnerTest, ThroughputModeSingleSteps)
+{
+  sdf::Root root;
+  root.Load(common::joinPaths(PROJECT_SOURCE_PATH,
+      "test", "worlds", "shapes.sdf"));
+  ASSERT_EQ(1u, root.WorldCount());
+
+  std::atomic<int> clockCount{0};
+  std::function<void(const msgs::Clock &)> countClock =
+      [&](const msgs::Clock &)
+      {
+        clockCount++;
+      };
+  transport::Node node;
+  node.Subscribe("/world/default/clock", countClock);
+
+  ServerConfig config;
+  config.SetThroughputPeriod(10);
+
+  auto systemLoader = std::make_shared<SystemLoader>();
+  SimulationRunner runner(root.WorldByIndex(0), systemLoader, config);
+
+  // Iterations are counted across calls to Run, so the clock is still
+  // published every 10 iterations
+  runner.SetPaused(false);
+  for (int i = 0; i < 25; ++i)
+    EXPECT_TRUE(runner.Run(1));
+  EXPECT_EQ(25u, runner.CurrentInfo().iterations);
+
+  std::this_thread::sleep_for(100ms);
+  EXPECT_GE(clockCount.load(), 2);
+  EXPECT_LE(clockCount.load(), 3);
+  EXPECT_GT(runner.IterationsPerSecond(), 0.0);
+}
+
 // Run multiple times. We want to make sure that static globals don't cause
 // problems.
 INSTANTIATE_TEST_SUITE_P(ServerRepeat, SimulationRunnerTest,
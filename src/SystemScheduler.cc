@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "SystemScheduler.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <utility>
+
+#include <ignition/common/Profiler.hh>
+
+using namespace ignition;
+using namespace gazebo;
+
+//////////////////////////////////////////////////
+void SystemScheduler::Add(std::function<void()> _run,
+    std::optional<Access> _access)
+{
+  const std::size_t index = this->nodes.size();
+  const std::size_t begin =
+      this->segmentEnds.empty() ? 0 : this->segmentEnds.back();
+
+  if (!_access)
+  {
+    // Close the segment of declared systems before this one, if any, and
+    // give this system a segment of its own.
+    if (begin != index)
+      this->segmentEnds.push_back(index);
+    this->nodes.push_back({std::move(_run), std::nullopt, 0, {}});
+    this->segmentEnds.push_back(index + 1);
+    return;
+  }
+
+  Node node{std::move(_run), std::move(_access), 0, {}};
+  for (std::size_t i = begin; i < index; ++i)
+  {
+    if (Conflicts(*this->nodes[i].access, *node.access))
+    {
+      this->nodes[i].dependents.push_back(index);
+      ++node.dependencies;
+    }
+  }
+  this->nodes.push_back(std::move(node));
+}
+
+//////////////////////////////////////////////////
+void SystemScheduler::Clear()
+{
+  this->nodes.clear();
+  this->segmentEnds.clear();
+}
+
+//////////////////////////////////////////////////
+std::size_t SystemScheduler::Size() const
+{
+  return this->nodes.size();
+}
+
+//////////////////////////////////////////////////
+bool SystemScheduler::HasConcurrency() const
+{
+  // Edges only go forward within a segment, so a system can only be
+  // reached from the one right before it through a direct edge. Without
+  // it, the two can run at the same time.
+  std::size_t begin = 0;
+  for (std::size_t i = 0; i < this->nodes.size(); ++i)
+  {
+    if (std::find(this->segmentEnds.begin(), this->segmentEnds.end(), i) !=
+        this->segmentEnds.end())
+    {
+      begin = i;
+    }
+
+    if (i == begin || !this->nodes[i].access)
+      continue;
+
+    const auto &previous = this->nodes[i - 1].dependents;
+    if (std::find(previous.begin(), previous.end(), i) == previous.end())
+      return true;
+  }
+  return false;
+}
+
+//////////////////////////////////////////////////
+void SystemScheduler::Run(WorkStealingPool *_pool,
+    const std::function<void(bool)> &_onConcurrent)
+{
+  std::size_t begin = 0;
+  auto runSegment = [&](std::size_t _end)
+  {
+    if (nullptr == _pool || _end - begin < 2)
+    {
+      for (std::size_t i = begin; i < _end; ++i)
+        this->nodes[i].run();
+    }
+    else
+    {
+      if (_onConcurrent)
+        _onConcurrent(true);
+      this->RunSegment(*_pool, begin, _end);
+      if (_onConcurrent)
+        _onConcurrent(false);
+    }
+    begin = _end;
+  };
+
+  for (const auto end : this->segmentEnds)
+    runSegment(end);
+
+  // The last segment stays open until an undeclared system is added
+  if (begin != this->nodes.size())
+    runSegment(this->nodes.size());
+}
+
+//////////////////////////////////////////////////
+bool SystemScheduler::Conflicts(const Access &_a, const Access &_b)
+{
+  auto writesAny = [](const Access &_writer, const Access &_other)
+  {
+    for (const auto typeId : _writer.writes)
+    {
+      if (_other.reads.count(typeId) || _other.writes.count(typeId))
+        return true;
+    }
+    return false;
+  };
+  return writesAny(_a, _b) || writesAny(_b, _a);
+}
+
+//////////////////////////////////////////////////
+void SystemScheduler::RunSegment(WorkStealingPool &_pool,
+    const std::size_t _begin, const std::size_t _end)
+{
+  IGN_PROFILE("SystemScheduler::RunSegment");
+
+  // Number of unfinished dependencies of each system. The last dependency
+  // to finish submits the system.
+  const std::size_t count = _end - _begin;
+  std::unique_ptr<std::atomic<std::size_t>[]> waiting(
+      new std::atomic<std::size_t>[count]);
+  for (std::size_t i = 0; i < count; ++i)
+    waiting[i].store(this->nodes[_begin + i].dependencies);
+
+  WorkStealingPool::TaskGroup group;
+  std::function<void(std::size_t)> runNode = [&](std::size_t _index)
+  {
+    const auto &node = this->nodes[_index];
+    node.run();
+
+    // Dependents are submitted before this task finishes, so the group
+    // can't become empty while there is still work to do.
+    for (const auto dependent : node.dependents)
+    {
+      if (waiting[dependent - _begin].fetch_sub(1,
+          std::memory_order_acq_rel) == 1)
+      {
+        _pool.Submit(group, [&runNode, dependent]{runNode(dependent);});
+      }
+    }
+  };
+
+  for (std::size_t i = _begin; i < _end; ++i)
+  {
+    if (this->nodes[i].dependencies == 0)
+      _pool.Submit(group, [&runNode, i]{runNode(i);});
+  }
+  _pool.Wait(group);
+}
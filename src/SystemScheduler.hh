@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_SYSTEMSCHEDULER_HH_
+#define IGNITION_GAZEBO_SYSTEMSCHEDULER_HH_
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <set>
+#include <vector>
+
+#include <ignition/gazebo/config.hh>
+#include <ignition/gazebo/Export.hh>
+#include <ignition/gazebo/Types.hh>
+
+#include "WorkStealingPool.hh"
+
+namespace ignition
+{
+  namespace gazebo
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+    /// \class SystemScheduler SystemScheduler.hh
+    /// \brief Runs the systems of one phase, such as PreUpdate or Update,
+    /// overlapping the ones which declared the component types they access
+    /// and don't conflict.
+    ///
+    /// The systems are split into segments. A system which didn't declare
+    /// its access is a segment of its own and runs alone on the calling
+    /// thread, after everything before it finished and before anything after
+    /// it starts. Consecutive declared systems form a segment which is run
+    /// as a dependency graph on a worker pool: a system depends on every
+    /// earlier system of the segment which writes a type it reads or writes,
+    /// or reads a type it writes. Conflicting systems therefore keep the
+    /// order in which they were added.
+    class IGNITION_GAZEBO_VISIBLE SystemScheduler
+    {
+      /// \brief Component types accessed by a system.
+      public: struct Access
+      {
+        /// \brief Types which are only read.
+        std::set<ComponentTypeId> reads;
+
+        /// \brief Types which are modified.
+        std::set<ComponentTypeId> writes;
+      };
+
+      /// \brief Add a system after the ones already added.
+      /// \param[in] _run Function which runs the system.
+      /// \param[in] _access Types accessed by the system, or nullopt if it
+      /// didn't declare them.
+      public: void Add(std::function<void()> _run,
+                  std::optional<Access> _access);
+
+      /// \brief Remove all systems.
+      public: void Clear();
+
+      /// \brief Get the number of systems.
+      /// \return Number of systems.
+      public: std::size_t Size() const;
+
+      /// \brief Check whether any two systems may run at the same time.
+      /// \return True if at least one segment can run systems concurrently.
+      public: bool HasConcurrency() const;
+
+      /// \brief Run all the systems once and wait for them to finish.
+      /// \param[in] _pool Pool used to run segments with more than one
+      /// system. If null, all systems run serially in the order in which
+      /// they were added.
+      /// \param[in] _onConcurrent Called with true before a segment starts
+      /// running systems concurrently, and with false once it finished.
+      public: void Run(WorkStealingPool *_pool,
+                  const std::function<void(bool)> &_onConcurrent = {});
+
+      /// \brief Check whether two systems can't run at the same time.
+      /// \param[in] _a Types accessed by the first system.
+      /// \param[in] _b Types accessed by the second system.
+      /// \return True if one of them writes a type the other accesses.
+      public: static bool Conflicts(const Access &_a, const Access &_b);
+
+      /// \brief A system and its place in the dependency graph.
+      private: struct Node
+      {
+        /// \brief Function which runs the system.
+        std::function<void()> run;
+
+        /// \brief Declared access, if any.
+        std::optional<Access> access;
+
+        /// \brief Number of earlier systems of the segment this one waits
+        /// for.
+        std::size_t dependencies{0};
+
+        /// \brief Later systems of the segment which wait for this one.
+        std::vector<std::size_t> dependents;
+      };
+
+      /// \brief Run one segment on the pool.
+      /// \param[in] _pool Worker pool.
+      /// \param[in] _begin Index of the first system of the segment.
+      /// \param[in] _end One past the index of the last system.
+      private: void RunSegment(WorkStealingPool &_pool, std::size_t _begin,
+                  std::size_t _end);
+
+      /// \brief All systems, in the order in which they were added.
+      private: std::vector<Node> nodes;
+
+      /// \brief Index one past the end of each segment.
+      private: std::vector<std::size_t> segmentEnds;
+    };
+    }
+  }
+}
+#endif
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "SystemScheduler.hh"
+#include "WorkStealingPool.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+/// \brief Helper to build an access declaration.
+SystemScheduler::Access makeAccess(std::set<ComponentTypeId> _reads,
+    std::set<ComponentTypeId> _writes)
+{
+  return {std::move(_reads), std::move(_writes)};
+}
+
+//////////////////////////////////////////////////
+TEST(SystemScheduler, Conflicts)
+{
+  EXPECT_FALSE(SystemScheduler::Conflicts(makeAccess({1, 2}, {}),
+      makeAccess({1, 2}, {})));
+  EXPECT_FALSE(SystemScheduler::Conflicts(makeAccess({1}, {2}),
+      makeAccess({1}, {3})));
+  EXPECT_TRUE(SystemScheduler::Conflicts(makeAccess({1}, {2}),
+      makeAccess({2}, {})));
+  EXPECT_TRUE(SystemScheduler::Conflicts(makeAccess({}, {3}),
+      makeAccess({1}, {3})));
+  EXPECT_TRUE(SystemScheduler::Conflicts(makeAccess({3}, {}),
+      makeAccess({}, {3})));
+  EXPECT_FALSE(SystemScheduler::Conflicts(makeAccess({}, {}),
+      makeAccess({}, {})));
+}
+
+//////////////////////////////////////////////////
+TEST(SystemScheduler, HasConcurrency)
+{
+  SystemScheduler scheduler;
+  EXPECT_FALSE(scheduler.HasConcurrency());
+
+  // Undeclared systems never overlap
+  scheduler.Add([]{}, std::nullopt);
+  scheduler.Add([]{}, std::nullopt);
+  EXPECT_FALSE(scheduler.HasConcurrency());
+
+  // A chain of conflicting systems doesn't either
+  scheduler.Add([]{}, makeAccess({}, {1}));
+  scheduler.Add([]{}, makeAccess({1}, {2}));
+  EXPECT_FALSE(scheduler.HasConcurrency());
+
+  // Declared systems separated by an undeclared one don't overlap
+  scheduler.Add([]{}, std::nullopt);
+  scheduler.Add([]{}, makeAccess({}, {3}));
+  EXPECT_FALSE(scheduler.HasConcurrency());
+
+  scheduler.Add([]{}, makeAccess({}, {4}));
+  EXPECT_TRUE(scheduler.HasConcurrency());
+  EXPECT_EQ(7u, scheduler.Size());
+
+  scheduler.Clear();
+  EXPECT_EQ(0u, scheduler.Size());
+  EXPECT_FALSE(scheduler.HasConcurrency());
+}
+
+//////////////////////////////////////////////////
+TEST(SystemScheduler, Order)
+{
+  WorkStealingPool pool(3);
+  SystemScheduler scheduler;
+
+  std::mutex mutex;
+  std::vector<int> order;
+  auto record = [&](int _id)
+  {
+    return [&, _id]
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      order.push_back(_id);
+    };
+  };
+
+  // 0 and 4 are undeclared, 1 writes what 3 reads, 2 is independent
+  scheduler.Add(record(0), std::nullopt);
+  scheduler.Add(record(1), makeAccess({}, {1}));
+  scheduler.Add(record(2), makeAccess({2}, {3}));
+  scheduler.Add(record(3), makeAccess({1}, {4}));
+  scheduler.Add(record(4), std::nullopt);
+
+  int concurrentSegments{0};
+  for (int round = 0; round < 50; ++round)
+  {
+    order.clear();
+    scheduler.Run(&pool, [&](bool _concurrent)
+    {
+      if (_concurrent)
+        ++concurrentSegments;
+    });
+
+    ASSERT_EQ(5u, order.size());
+    EXPECT_EQ(0, order.front());
+    EXPECT_EQ(4, order.back());
+    auto pos = [&](int _id)
+    {
+      return std::find(order.begin(), order.end(), _id) - order.begin();
+    };
+    EXPECT_LT(pos(1), pos(3));
+  }
+  EXPECT_EQ(50, concurrentSegments);
+
+  // Without a pool, everything runs in the order it was added
+  order.clear();
+  scheduler.Run(nullptr, [&](bool)
+  {
+    FAIL() << "Nothing should run concurrently without a pool";
+  });
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 4}), order);
+}
+
+//////////////////////////////////////////////////
+TEST(SystemScheduler, Overlap)
+{
+  WorkStealingPool pool(2);
+  SystemScheduler scheduler;
+
+  // Each system waits until all of them started, which only finishes if
+  // they run at the same time
+  std::atomic<int> started{0};
+  std::set<std::thread::id> ids;
+  std::mutex mutex;
+  for (ComponentTypeId type = 1; type <= 3; ++type)
+  {
+    scheduler.Add([&]
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        ids.insert(std::this_thread::get_id());
+      }
+      started++;
+      while (started < 3)
+        std::this_thread::yield();
+    }, makeAccess({0}, {type}));
+  }
+
+  scheduler.Run(&pool);
+  EXPECT_EQ(3, started.load());
+  EXPECT_EQ(3u, ids.size());
+}
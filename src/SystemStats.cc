@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "SystemStats.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace ignition;
+using namespace gazebo;
+
+//////////////////////////////////////////////////
+SystemStats::SystemStats(std::size_t _window)
+  : window(std::max<std::size_t>(_window, 1u))
+{
+}
+
+//////////////////////////////////////////////////
+std::size_t SystemStats::Add(const std::string &_name, Entity _entity)
+{
+  this->systems.push_back({_name, _entity, {}});
+  return this->systems.size() - 1;
+}
+
+//////////////////////////////////////////////////
+std::size_t SystemStats::Size() const
+{
+  return this->systems.size();
+}
+
+//////////////////////////////////////////////////
+const std::string &SystemStats::Name(std::size_t _system) const
+{
+  return this->systems[_system].name;
+}
+
+//////////////////////////////////////////////////
+Entity SystemStats::SystemEntity(std::size_t _system) const
+{
+  return this->systems[_system].entity;
+}
+
+//////////////////////////////////////////////////
+void SystemStats::Record(std::size_t _system, Phase _phase,
+    std::chrono::steady_clock::duration _duration)
+{
+  auto &series =
+      this->systems[_system].phases[static_cast<std::size_t>(_phase)];
+  if (series.samples.size() < this->window)
+  {
+    if (series.samples.empty())
+      series.samples.reserve(this->window);
+    series.samples.push_back(_duration);
+    return;
+  }
+
+  series.samples[series.next] = _duration;
+  series.next = (series.next + 1) % this->window;
+}
+
+//////////////////////////////////////////////////
+std::optional<SystemStats::Summary> SystemStats::Summarize(
+    std::size_t _system, Phase _phase) const
+{
+  const auto &series =
+      this->systems[_system].phases[static_cast<std::size_t>(_phase)];
+  if (series.samples.empty())
+    return std::nullopt;
+
+  // Nearest-rank percentiles, which are always one of the samples
+  auto sorted = series.samples;
+  auto rank = [&](double _percentile)
+  {
+    const auto index = static_cast<std::size_t>(
+        std::ceil(_percentile * static_cast<double>(sorted.size())));
+    return sorted.begin() + (index > 0 ? index - 1 : 0);
+  };
+
+  Summary summary;
+  summary.samples = sorted.size();
+
+  auto p50 = rank(0.5);
+  std::nth_element(sorted.begin(), p50, sorted.end());
+  summary.p50 = *p50;
+
+  // Everything after the median is at least as large, so only that part
+  // needs to be searched for the higher percentiles.
+  auto p99 = rank(0.99);
+  std::nth_element(p50, p99, sorted.end());
+  summary.p99 = *p99;
+  summary.max = *std::max_element(p99, sorted.end());
+  return summary;
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_SYSTEMSTATS_HH_
+#define IGNITION_GAZEBO_SYSTEMSTATS_HH_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <ignition/gazebo/config.hh>
+#include <ignition/gazebo/Entity.hh>
+#include <ignition/gazebo/Export.hh>
+
+namespace ignition
+{
+  namespace gazebo
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+    /// \class SystemStats SystemStats.hh
+    /// \brief Wall time spent by each system in each update phase, over a
+    /// rolling window of recent iterations.
+    ///
+    /// Each system and phase has its own fixed-size buffer of samples, so
+    /// recording is a single store without locking. Different threads may
+    /// record at the same time as long as they don't record the same system
+    /// and phase, which the simulation runner guarantees since a system runs
+    /// once per phase. Summaries must not be computed while samples are
+    /// being recorded.
+    class IGNITION_GAZEBO_VISIBLE SystemStats
+    {
+      /// \brief Update phases.
+      public: enum class Phase
+      {
+        /// \brief ISystemPreUpdate::PreUpdate
+        kPreUpdate = 0,
+
+        /// \brief ISystemUpdate::Update
+        kUpdate = 1,
+
+        /// \brief ISystemPostUpdate::PostUpdate
+        kPostUpdate = 2,
+      };
+
+      /// \brief Number of phases.
+      public: static constexpr std::size_t kPhaseCount{3};
+
+      /// \brief Percentiles of the samples of one system in one phase.
+      public: struct Summary
+      {
+        /// \brief Median duration.
+        std::chrono::steady_clock::duration p50{0};
+
+        /// \brief 99th percentile duration.
+        std::chrono::steady_clock::duration p99{0};
+
+        /// \brief Longest duration.
+        std::chrono::steady_clock::duration max{0};
+
+        /// \brief Number of samples the summary is based on.
+        std::size_t samples{0};
+      };
+
+      /// \brief Constructor
+      /// \param[in] _window Number of most recent samples kept per system and
+      /// phase.
+      public: explicit SystemStats(std::size_t _window = 1000);
+
+      /// \brief Add a system.
+      /// \param[in] _name Name of the system, such as its plugin name.
+      /// \param[in] _entity Entity the system is attached to.
+      /// \return Index of the system, to be passed to Record.
+      public: std::size_t Add(const std::string &_name, Entity _entity);
+
+      /// \brief Get the number of systems.
+      /// \return Number of systems added.
+      public: std::size_t Size() const;
+
+      /// \brief Get the name of a system.
+      /// \param[in] _system Index of the system.
+      /// \return The name given to Add.
+      public: const std::string &Name(std::size_t _system) const;
+
+      /// \brief Get the entity of a system.
+      /// \param[in] _system Index of the system.
+      /// \return The entity given to Add.
+      public: Entity SystemEntity(std::size_t _system) const;
+
+      /// \brief Record the duration of one call of a system.
+      /// \param[in] _system Index of the system.
+      /// \param[in] _phase Phase the call belongs to.
+      /// \param[in] _duration Wall time of the call.
+      public: void Record(std::size_t _system, Phase _phase,
+                  std::chrono::steady_clock::duration _duration);
+
+      /// \brief Compute the percentiles of a system's recent samples in one
+      /// phase.
+      /// \param[in] _system Index of the system.
+      /// \param[in] _phase Phase.
+      /// \return The summary, or nullopt if nothing was recorded.
+      public: std::optional<Summary> Summarize(std::size_t _system,
+                  Phase _phase) const;
+
+      /// \brief Samples of one system in one phase.
+      private: struct Series
+      {
+        /// \brief Ring buffer of durations, allocated on the first sample.
+        std::vector<std::chrono::steady_clock::duration> samples;
+
+        /// \brief Position of the next sample in the ring buffer.
+        std::size_t next{0};
+      };
+
+      /// \brief A system and its samples.
+      private: struct System
+      {
+        /// \brief Name of the system.
+        std::string name;
+
+        /// \brief Entity the system is attached to.
+        Entity entity{kNullEntity};
+
+        /// \brief Samples for each phase.
+        std::array<Series, kPhaseCount> phases;
+      };
+
+      /// \brief Number of samples kept per series.
+      private: std::size_t window;
+
+      /// \brief All systems, in the order they were added.
+      private: std::vector<System> systems;
+    };
+    }
+  }
+}
+#endif
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+
+#include "SystemStats.hh"
+
+using namespace ignition;
+using namespace gazebo;
+using namespace std::chrono_literals;
+
+//////////////////////////////////////////////////
+TEST(SystemStats, Percentiles)
+{
+  SystemStats stats;
+  EXPECT_EQ(0u, stats.Size());
+
+  const auto first = stats.Add("first", 1);
+  const auto second = stats.Add("second", 2);
+  EXPECT_EQ(2u, stats.Size());
+  EXPECT_EQ("first", stats.Name(first));
+  EXPECT_EQ(2u, stats.SystemEntity(second));
+
+  EXPECT_EQ(std::nullopt,
+      stats.Summarize(first, SystemStats::Phase::kPreUpdate));
+
+  // 1us to 100us, in reverse order
+  for (int i = 100; i >= 1; --i)
+    stats.Record(first, SystemStats::Phase::kPreUpdate, i * 1us);
+
+  auto summary = stats.Summarize(first, SystemStats::Phase::kPreUpdate);
+  ASSERT_TRUE(summary);
+  EXPECT_EQ(100u, summary->samples);
+  EXPECT_EQ(50us, summary->p50);
+  EXPECT_EQ(99us, summary->p99);
+  EXPECT_EQ(100us, summary->max);
+
+  // Phases and systems are independent
+  EXPECT_EQ(std::nullopt,
+      stats.Summarize(first, SystemStats::Phase::kUpdate));
+  EXPECT_EQ(std::nullopt,
+      stats.Summarize(second, SystemStats::Phase::kPreUpdate));
+
+  stats.Record(second, SystemStats::Phase::kPostUpdate, 7us);
+  summary = stats.Summarize(second, SystemStats::Phase::kPostUpdate);
+  ASSERT_TRUE(summary);
+  EXPECT_EQ(1u, summary->samples);
+  EXPECT_EQ(7us, summary->p50);
+  EXPECT_EQ(7us, summary->p99);
+  EXPECT_EQ(7us, summary->max);
+}
+
+//////////////////////////////////////////////////
+TEST(SystemStats, Window)
+{
+  SystemStats stats(10);
+  const auto system = stats.Add("system", kNullEntity);
+
+  // Old samples are dropped once the window is full
+  for (int i = 0; i < 10; ++i)
+    stats.Record(system, SystemStats::Phase::kUpdate, 1ms);
+  for (int i = 1; i <= 10; ++i)
+    stats.Record(system, SystemStats::Phase::kUpdate, i * 1us);
+
+  auto summary = stats.Summarize(system, SystemStats::Phase::kUpdate);
+  ASSERT_TRUE(summary);
+  EXPECT_EQ(10u, summary->samples);
+  EXPECT_EQ(5us, summary->p50);
+  EXPECT_EQ(10us, summary->p99);
+  EXPECT_EQ(10us, summary->max);
+}
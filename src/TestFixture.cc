@@ -15,6 +15,8 @@
  *
 */
 
+#include <optional>
+
 #include "ignition/gazebo/Server.hh"
 #include "ignition/gazebo/ServerConfig.hh"
 
@@ -120,6 +122,9 @@ class ignition::gazebo::TestFixturePrivate
 
   /// \brief Flag to make sure Finalize is only called once
   public: bool finalized{false};
+
+  /// \brief State of the world saved with SaveState, used by Reset.
+  public: std::optional<WorldSnapshot> savedState;
 };
 
 //////////////////////////////////////////////////
@@ -168,6 +173,37 @@ TestFixture &TestFixture::Finalize()
   return *this;
 }
 
+//////////////////////////////////////////////////
+TestFixture &TestFixture::SaveState()
+{
+  if (!this->dataPtr->finalized)
+  {
+    ignerr << "Fixture must be finalized before its state can be saved."
+           << std::endl;
+    return *this;
+  }
+
+  this->dataPtr->savedState = this->dataPtr->server->Snapshot();
+  if (!this->dataPtr->savedState)
+    ignerr << "Failed to save the state of the fixture." << std::endl;
+  return *this;
+}
+
+//////////////////////////////////////////////////
+TestFixture &TestFixture::Reset()
+{
+  if (!this->dataPtr->savedState)
+  {
+    ignerr << "Fixture state must be saved with SaveState before it can be "
+           << "reset." << std::endl;
+    return *this;
+  }
+
+  if (!this->dataPtr->server->Restore(*this->dataPtr->savedState))
+    ignerr << "Failed to reset the fixture." << std::endl;
+  return *this;
+}
+
 //////////////////////////////////////////////////
 TestFixture &TestFixture::OnConfigure(std::function<void(
           const Entity &_entity,
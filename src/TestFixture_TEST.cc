@@ -17,6 +17,9 @@
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <vector>
+
 #include <ignition/common/Console.hh>
 #include <ignition/common/Util.hh>
 
@@ -259,3 +262,64 @@ TEST_F(TestFixtureTest, ChangeCallback)
   // New callback is called
   EXPECT_EQ(expectedIterations, preUpdate2);
 }
+
+/////////////////////////////////////////////////
+TEST_F(TestFixtureTest, Reset)
+{
+  TestFixture testFixture(common::joinPaths(
+      std::string(PROJECT_SOURCE_PATH), "test", "worlds", "shapes.sdf"));
+  ASSERT_NE(nullptr, testFixture.Server());
+
+  bool firstIteration{true};
+  unsigned int episode{0u};
+  Entity spawned{kNullEntity};
+  std::vector<std::chrono::steady_clock::duration> startTimes;
+  testFixture.
+    OnPreUpdate([&](const UpdateInfo &_info, EntityComponentManager &_ecm)
+    {
+      if (!firstIteration)
+        return;
+      firstIteration = false;
+      startTimes.push_back(_info.simTime);
+
+      auto sphere = _ecm.EntityByComponents(components::Name("sphere"));
+      ASSERT_NE(kNullEntity, sphere);
+
+      // Change the world during the first episode
+      if (episode == 0u)
+      {
+        _ecm.Component<components::Name>(sphere)->Data() = "renamed";
+        spawned = _ecm.CreateEntity();
+        _ecm.CreateComponent(spawned, components::Name("spawned"));
+        return;
+      }
+
+      // Entities created during the episode are removed after a reset
+      bool removed{false};
+      _ecm.EachRemoved<components::Name>(
+          [&](const Entity &_entity, const components::Name *) -> bool
+          {
+            removed = removed || _entity == spawned;
+            return true;
+          });
+      EXPECT_TRUE(removed);
+    }).
+    Finalize();
+
+  // Nothing to reset to yet
+  testFixture.Reset();
+
+  testFixture.SaveState();
+  const auto entityCount = testFixture.Server()->EntityCount();
+  testFixture.Server()->Run(true, 10, false);
+  EXPECT_EQ(*entityCount + 1, *testFixture.Server()->EntityCount());
+
+  testFixture.Reset();
+  episode = 1u;
+  firstIteration = true;
+  testFixture.Server()->Run(true, 10, false);
+
+  EXPECT_EQ(entityCount, testFixture.Server()->EntityCount());
+  ASSERT_EQ(2u, startTimes.size());
+  EXPECT_EQ(startTimes[0], startTimes[1]);
+}
@@ -63,28 +63,13 @@ inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
 math::Pose3d worldPose(const Entity &_entity,
     const EntityComponentManager &_ecm)
 {
-  auto poseComp = _ecm.Component<components::Pose>(_entity);
-  if (nullptr == poseComp)
+  math::Pose3d pose;
+  if (!_ecm.CachedWorldPose(_entity, pose))
   {
     ignwarn << "Trying to get world pose from entity [" << _entity
             << "], which doesn't have a pose component" << std::endl;
     return math::Pose3d();
   }
-
-  // work out pose in world frame
-  math::Pose3d pose = poseComp->Data();
-  auto p = _ecm.Component<components::ParentEntity>(_entity);
-  while (p)
-  {
-    // get pose of parent entity
-    auto parentPose = _ecm.Component<components::Pose>(p->Data());
-    if (!parentPose)
-      break;
-    // transform pose
-    pose = pose + parentPose->Data();
-    // keep going up the tree
-    p = _ecm.Component<components::ParentEntity>(p->Data());
-  }
   return pose;
 }
 
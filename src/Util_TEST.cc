@@ -30,6 +30,7 @@
 #include "ignition/gazebo/components/Name.hh"
 #include "ignition/gazebo/components/ParentEntity.hh"
 #include "ignition/gazebo/components/ParticleEmitter.hh"
+#include "ignition/gazebo/components/Pose.hh"
 #include "ignition/gazebo/components/Sensor.hh"
 #include "ignition/gazebo/components/Visual.hh"
 #include "ignition/gazebo/components/World.hh"
@@ -716,3 +717,27 @@ TEST_F(UtilTest, EnableComponent)
   EXPECT_FALSE(enableComponent<components::Name>(ecm, entity1, false));
   EXPECT_EQ(nullptr, ecm.Component<components::Name>(entity1));
 }
+
+/////////////////////////////////////////////////
+TEST_F(UtilTest, WorldPose)
+{
+  EntityComponentManager ecm;
+
+  auto model = ecm.CreateEntity();
+  ecm.CreateComponent(model, components::Pose(math::Pose3d(1, 0, 0, 0, 0, 0)));
+  auto link = ecm.CreateEntity();
+  ecm.SetParentEntity(link, model);
+  ecm.CreateComponent(link, components::ParentEntity(model));
+  ecm.CreateComponent(link, components::Pose(math::Pose3d(0, 1, 0, 0, 0, 0)));
+
+  EXPECT_EQ(math::Pose3d(1, 1, 0, 0, 0, 0), worldPose(link, ecm));
+  EXPECT_EQ(math::Pose3d::Zero, worldPose(ecm.CreateEntity(), ecm));
+
+  // Poses written without SetChanged, as some systems do, are seen
+  ecm.Component<components::Pose>(model)->Data().Pos().X(2);
+  EXPECT_EQ(math::Pose3d(2, 1, 0, 0, 0, 0), worldPose(link, ecm));
+
+  ecm.SetComponentData<components::Pose>(link,
+      math::Pose3d(0, 3, 0, 0, 0, 0));
+  EXPECT_EQ(math::Pose3d(2, 3, 0, 0, 0, 0), worldPose(link, ecm));
+}
@@ -0,0 +1,363 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "WorkStealingPool.hh"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <ignition/common/Profiler.hh>
+
+using namespace ignition::gazebo;
+
+namespace
+{
+  /// \brief Index used by threads that are not workers of a pool.
+  constexpr std::size_t kNoWorker = std::numeric_limits<std::size_t>::max();
+
+  /// \brief Pool that the current thread works for, if any.
+  thread_local const WorkStealingPoolPrivate *tlPool{nullptr};
+
+  /// \brief Index of the current thread in tlPool.
+  thread_local std::size_t tlWorker{kNoWorker};
+}
+
+class ignition::gazebo::WorkStealingPoolPrivate
+{
+  /// \brief A queued task.
+  public: struct Task
+  {
+    /// \brief Function to execute.
+    std::function<void()> fn;
+
+    /// \brief Group that the task belongs to.
+    WorkStealingPool::TaskGroup *group{nullptr};
+  };
+
+  /// \brief Task queue of a single worker.
+  public: struct Queue
+  {
+    /// \brief Protects tasks.
+    std::mutex mutex;
+
+    /// \brief The owner takes from the back, thieves from the front.
+    std::deque<Task> tasks;
+  };
+
+  /// \brief Main loop of a worker thread.
+  /// \param[in] _index Index of the worker.
+  public: void WorkerLoop(std::size_t _index);
+
+  /// \brief Take a task, from the given worker's queue first and then from
+  /// the other queues, and execute it.
+  /// \param[in] _index Index of the calling worker, or kNoWorker.
+  /// \param[in] _group Only take tasks of this group, or any task if null.
+  /// \return True if a task was executed.
+  public: bool RunOne(std::size_t _index,
+              WorkStealingPool::TaskGroup *_group = nullptr);
+
+  /// \brief Take a task from a queue.
+  /// \param[in] _queue Queue index.
+  /// \param[in] _back True to take from the back.
+  /// \param[in] _group Only take tasks of this group, or any task if null.
+  /// \param[out] _task The task.
+  /// \return True if a task was taken.
+  public: bool Take(std::size_t _queue, bool _back,
+              WorkStealingPool::TaskGroup *_group, Task &_task);
+
+  /// \brief One queue per worker, or a single one if there are no workers.
+  public: std::vector<std::unique_ptr<Queue>> queues;
+
+  /// \brief Worker threads.
+  public: std::vector<std::thread> workers;
+
+  /// \brief Number of tasks in all queues.
+  public: std::atomic<std::size_t> queued{0};
+
+  /// \brief Number of threads blocked in Wait.
+  public: std::atomic<std::size_t> waiters{0};
+
+  /// \brief Used to pick a queue when submitting from outside the pool.
+  public: std::atomic<std::size_t> nextQueue{0};
+
+  /// \brief Set to stop the workers.
+  public: bool stop{false};
+
+  /// \brief Protects stop and pairs with the condition variables.
+  public: std::mutex sleepMutex;
+
+  /// \brief Wakes up idle workers.
+  public: std::condition_variable workCv;
+
+  /// \brief Wakes up threads in Wait.
+  public: std::condition_variable doneCv;
+};
+
+//////////////////////////////////////////////////
+void WorkStealingPoolPrivate::WorkerLoop(std::size_t _index)
+{
+  IGN_PROFILE_THREAD_NAME("WorkStealingPool");
+  tlPool = this;
+  tlWorker = _index;
+
+  while (true)
+  {
+    if (this->RunOne(_index))
+      continue;
+
+    std::unique_lock<std::mutex> lock(this->sleepMutex);
+    this->workCv.wait(lock, [this]
+    {
+      return this->stop || this->queued > 0;
+    });
+    if (this->stop)
+      break;
+  }
+}
+
+//////////////////////////////////////////////////
+bool WorkStealingPoolPrivate::Take(std::size_t _queue, bool _back,
+    WorkStealingPool::TaskGroup *_group, Task &_task)
+{
+  auto &queue = *this->queues[_queue];
+  std::lock_guard<std::mutex> lock(queue.mutex);
+  if (queue.tasks.empty())
+    return false;
+
+  if (nullptr == _group)
+  {
+    if (_back)
+    {
+      _task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    }
+    else
+    {
+      _task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+  }
+  else
+  {
+    auto matches = [_group](const Task &_t) {return _t.group == _group;};
+    auto it = queue.tasks.end();
+    if (_back)
+    {
+      auto rit = std::find_if(queue.tasks.rbegin(), queue.tasks.rend(),
+          matches);
+      if (rit != queue.tasks.rend())
+        it = std::prev(rit.base());
+    }
+    else
+    {
+      it = std::find_if(queue.tasks.begin(), queue.tasks.end(), matches);
+    }
+    if (it == queue.tasks.end())
+      return false;
+
+    _task = std::move(*it);
+    queue.tasks.erase(it);
+  }
+  --_task.group->queued;
+  --this->queued;
+  return true;
+}
+
+//////////////////////////////////////////////////
+bool WorkStealingPoolPrivate::RunOne(std::size_t _index,
+    WorkStealingPool::TaskGroup *_group)
+{
+  if ((nullptr == _group ? this->queued : _group->queued) == 0)
+    return false;
+
+  Task task;
+  bool found{false};
+  const std::size_t count = this->queues.size();
+
+  // Own queue first, most recent task first since its data is likely still
+  // in cache
+  if (_index != kNoWorker)
+    found = this->Take(_index, true, _group, task);
+
+  // Then steal the oldest task of the other queues
+  const std::size_t start = _index == kNoWorker ? 0 : _index + 1;
+  for (std::size_t i = 0; !found && i < count; ++i)
+  {
+    const std::size_t victim = (start + i) % count;
+    if (victim != _index)
+      found = this->Take(victim, false, _group, task);
+  }
+
+  if (!found)
+    return false;
+
+  // Exceptions are kept for Wait, since the group must be finished anyway
+  try
+  {
+    task.fn();
+  }
+  catch (...)
+  {
+    std::lock_guard<std::mutex> lock(task.group->errorMutex);
+    if (!task.group->error)
+      task.group->error = std::current_exception();
+  }
+
+  // Don't touch the group after the decrement, the waiting thread may
+  // destroy it right away
+  if (--task.group->pending == 0)
+  {
+    std::lock_guard<std::mutex> lock(this->sleepMutex);
+    this->doneCv.notify_all();
+  }
+  return true;
+}
+
+//////////////////////////////////////////////////
+WorkStealingPool::WorkStealingPool(unsigned int _workerCount)
+  : dataPtr(std::make_unique<WorkStealingPoolPrivate>())
+{
+  const std::size_t queueCount = std::max(1u, _workerCount);
+  for (std::size_t i = 0; i < queueCount; ++i)
+  {
+    this->dataPtr->queues.push_back(
+        std::make_unique<WorkStealingPoolPrivate::Queue>());
+  }
+
+  for (std::size_t i = 0; i < _workerCount; ++i)
+  {
+    this->dataPtr->workers.emplace_back(
+        &WorkStealingPoolPrivate::WorkerLoop, this->dataPtr.get(), i);
+  }
+}
+
+//////////////////////////////////////////////////
+WorkStealingPool::~WorkStealingPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->sleepMutex);
+    this->dataPtr->stop = true;
+  }
+  this->dataPtr->workCv.notify_all();
+
+  for (auto &worker : this->dataPtr->workers)
+    worker.join();
+}
+
+//////////////////////////////////////////////////
+unsigned int WorkStealingPool::WorkerCount() const
+{
+  return static_cast<unsigned int>(this->dataPtr->workers.size());
+}
+
+//////////////////////////////////////////////////
+void WorkStealingPool::Submit(TaskGroup &_group, std::function<void()> _task)
+{
+  ++_group.pending;
+  ++_group.queued;
+
+  // Tasks submitted by a worker go to its own queue, others are spread
+  // round-robin
+  std::size_t queue;
+  if (tlPool == this->dataPtr.get())
+  {
+    queue = tlWorker;
+  }
+  else
+  {
+    queue = this->dataPtr->nextQueue++ % this->dataPtr->queues.size();
+  }
+
+  {
+    auto &q = *this->dataPtr->queues[queue];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    q.tasks.push_back({std::move(_task), &_group});
+  }
+  ++this->dataPtr->queued;
+
+  {
+    std::lock_guard<std::mutex> lock(this->dataPtr->sleepMutex);
+  }
+  this->dataPtr->workCv.notify_one();
+  if (this->dataPtr->waiters > 0)
+    this->dataPtr->doneCv.notify_all();
+}
+
+//////////////////////////////////////////////////
+void WorkStealingPool::Wait(TaskGroup &_group)
+{
+  const std::size_t index =
+      tlPool == this->dataPtr.get() ? tlWorker : kNoWorker;
+
+  // Only the group's own tasks are run, others may take much longer
+  ++this->dataPtr->waiters;
+  while (_group.pending > 0)
+  {
+    if (this->dataPtr->RunOne(index, &_group))
+      continue;
+
+    std::unique_lock<std::mutex> lock(this->dataPtr->sleepMutex);
+    this->dataPtr->doneCv.wait(lock, [&]
+    {
+      return _group.pending == 0 || _group.queued > 0;
+    });
+  }
+  --this->dataPtr->waiters;
+
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock(_group.errorMutex);
+    std::swap(error, _group.error);
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
+//////////////////////////////////////////////////
+void WorkStealingPool::ParallelFor(std::size_t _count,
+    const std::function<void(std::size_t)> &_fn)
+{
+  if (_count == 0)
+    return;
+
+  // Nothing to gain from the queues
+  if (_count == 1 || this->dataPtr->workers.empty())
+  {
+    for (std::size_t i = 0; i < _count; ++i)
+      _fn(i);
+    return;
+  }
+
+  TaskGroup group;
+  for (std::size_t i = 0; i < _count; ++i)
+    this->Submit(group, [&_fn, i]{_fn(i);});
+  this->Wait(group);
+}
+
+//////////////////////////////////////////////////
+unsigned int WorkStealingPool::DefaultWorkerCount()
+{
+  const unsigned int hardware = std::thread::hardware_concurrency();
+  return hardware > 1 ? hardware - 1 : 0;
+}
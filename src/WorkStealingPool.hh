@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef IGNITION_GAZEBO_WORKSTEALINGPOOL_HH_
+#define IGNITION_GAZEBO_WORKSTEALINGPOOL_HH_
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include <ignition/gazebo/config.hh>
+#include <ignition/gazebo/Export.hh>
+
+namespace ignition
+{
+  namespace gazebo
+  {
+    // Inline bracket to help doxygen filtering.
+    inline namespace IGNITION_GAZEBO_VERSION_NAMESPACE {
+    // Forward declarations.
+    class WorkStealingPoolPrivate;
+
+    /// \class WorkStealingPool WorkStealingPool.hh
+    /// \brief A persistent pool of worker threads with one task queue per
+    /// worker. Workers take tasks from the back of their own queue and steal
+    /// from the front of the other queues when theirs is empty.
+    ///
+    /// Tasks are grouped in a TaskGroup, which the submitting thread can
+    /// Wait on. A waiting thread executes the queued tasks of that group
+    /// itself instead of blocking, so a pool without workers still makes
+    /// progress, and tasks may submit and wait on other tasks without
+    /// deadlocking. It doesn't execute tasks of other groups, which could
+    /// take much longer than the ones it waits for.
+    class IGNITION_GAZEBO_VISIBLE WorkStealingPool
+    {
+      /// \brief A set of tasks that can be waited on.
+      public: class TaskGroup
+      {
+        /// \brief Number of tasks submitted but not finished yet.
+        private: std::atomic<std::size_t> pending{0};
+
+        /// \brief Number of tasks submitted but not started yet.
+        private: std::atomic<std::size_t> queued{0};
+
+        /// \brief First exception thrown by a task of the group, rethrown
+        /// by Wait.
+        private: std::exception_ptr error;
+
+        /// \brief Protects error.
+        private: std::mutex errorMutex;
+
+        friend class WorkStealingPool;
+        friend class WorkStealingPoolPrivate;
+      };
+
+      /// \brief Constructor
+      /// \param[in] _workerCount Number of worker threads to spawn. The
+      /// thread calling Wait also executes tasks, so zero is valid.
+      public: explicit WorkStealingPool(unsigned int _workerCount);
+
+      /// \brief Destructor. Tasks that haven't started are discarded.
+      public: ~WorkStealingPool();
+
+      /// \brief Get the number of worker threads.
+      /// \return Number of workers.
+      public: unsigned int WorkerCount() const;
+
+      /// \brief Queue a task.
+      /// \param[in] _group Group that the task belongs to. It must outlive
+      /// the task.
+      /// \param[in] _task Task to execute.
+      public: void Submit(TaskGroup &_group, std::function<void()> _task);
+
+      /// \brief Block until all the tasks in a group are done, executing
+      /// the group's queued tasks in the meantime. If tasks of the group
+      /// threw, the first exception is rethrown once all of them are done.
+      /// \param[in] _group Group to wait for.
+      public: void Wait(TaskGroup &_group);
+
+      /// \brief Call _fn for every index in [0, _count), in parallel, and
+      /// wait for all the calls to finish. If calls threw, the first
+      /// exception is rethrown once all of them are done.
+      /// \param[in] _count Number of indices.
+      /// \param[in] _fn Function to call for each index.
+      public: void ParallelFor(std::size_t _count,
+                  const std::function<void(std::size_t)> &_fn);
+
+      /// \brief Get a worker count suitable for the current machine, which
+      /// is one less than the hardware concurrency since the thread that
+      /// submits work helps executing it.
+      /// \return Default worker count.
+      public: static unsigned int DefaultWorkerCount();
+
+      /// \brief Private data pointer.
+      private: std::unique_ptr<WorkStealingPoolPrivate> dataPtr;
+    };
+    }
+  }
+}
+#endif
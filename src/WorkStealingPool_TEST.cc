@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "WorkStealingPool.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+//////////////////////////////////////////////////
+void parallelForTest(unsigned int _workerCount)
+{
+  WorkStealingPool pool(_workerCount);
+  EXPECT_EQ(_workerCount, pool.WorkerCount());
+
+  for (std::size_t count : {0u, 1u, 7u, 1000u})
+  {
+    std::vector<std::atomic<int>> visits(count);
+    pool.ParallelFor(count, [&](std::size_t _i)
+    {
+      visits[_i]++;
+    });
+
+    for (const auto &v : visits)
+      EXPECT_EQ(1, v.load());
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(WorkStealingPool, ParallelFor)
+{
+  parallelForTest(0);
+  parallelForTest(1);
+  parallelForTest(4);
+}
+
+//////////////////////////////////////////////////
+TEST(WorkStealingPool, SubmitWait)
+{
+  WorkStealingPool pool(3);
+
+  // Reuse the pool for several rounds
+  for (int round = 0; round < 10; ++round)
+  {
+    WorkStealingPool::TaskGroup group;
+    std::atomic<int> sum{0};
+    for (int i = 1; i <= 100; ++i)
+      pool.Submit(group, [&sum, i]{sum += i;});
+    pool.Wait(group);
+    EXPECT_EQ(5050, sum.load());
+  }
+}
+
+//////////////////////////////////////////////////
+TEST(WorkStealingPool, Nested)
+{
+  // Tasks that submit and wait on other tasks, with fewer workers than
+  // waiting tasks, must not deadlock
+  WorkStealingPool pool(2);
+
+  std::atomic<int> count{0};
+  pool.ParallelFor(8, [&](std::size_t)
+  {
+    pool.ParallelFor(8, [&](std::size_t)
+    {
+      count++;
+    });
+  });
+  EXPECT_EQ(64, count.load());
+}
+
+//////////////////////////////////////////////////
+TEST(WorkStealingPool, WaitRunsOwnGroup)
+{
+  // Without workers, only waiting runs tasks
+  WorkStealingPool pool(0);
+
+  WorkStealingPool::TaskGroup other;
+  std::atomic<bool> otherRan{false};
+  pool.Submit(other, [&]{otherRan = true;});
+
+  WorkStealingPool::TaskGroup group;
+  std::atomic<int> count{0};
+  for (int i = 0; i < 3; ++i)
+    pool.Submit(group, [&]{count++;});
+  pool.Wait(group);
+  EXPECT_EQ(3, count.load());
+  EXPECT_FALSE(otherRan);
+
+  pool.ParallelFor(4, [&](std::size_t){count++;});
+  EXPECT_EQ(7, count.load());
+  EXPECT_FALSE(otherRan);
+
+  pool.Wait(other);
+  EXPECT_TRUE(otherRan);
+}
+
+//////////////////////////////////////////////////
+TEST(WorkStealingPool, UsesWorkers)
+{
+  WorkStealingPool pool(2);
+
+  std::mutex mutex;
+  std::set<std::thread::id> ids;
+  std::atomic<int> started{0};
+  pool.ParallelFor(3, [&](std::size_t)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ids.insert(std::this_thread::get_id());
+    }
+
+    // Hold every thread until all 3 tasks run, so they can't all be
+    // executed by the same thread
+    started++;
+    while (started < 3)
+      std::this_thread::yield();
+  });
+  EXPECT_EQ(3u, ids.size());
+}
+
+//////////////////////////////////////////////////
+TEST(WorkStealingPool, Exceptions)
+{
+  for (unsigned int workers : {0u, 2u})
+  {
+    WorkStealingPool pool(workers);
+
+    // The other tasks of the group still run, and Wait rethrows
+    WorkStealingPool::TaskGroup group;
+    std::atomic<int> count{0};
+    for (int i = 0; i < 10; ++i)
+    {
+      pool.Submit(group, [&count, i]
+      {
+        count++;
+        if (i % 3 == 0)
+          throw std::runtime_error("task failed");
+      });
+    }
+    EXPECT_THROW(pool.Wait(group), std::runtime_error);
+    EXPECT_EQ(10, count.load());
+
+    // The group and the pool can be used again
+    pool.Submit(group, [&count]{count++;});
+    EXPECT_NO_THROW(pool.Wait(group));
+    EXPECT_EQ(11, count.load());
+
+    EXPECT_THROW(pool.ParallelFor(5, [](std::size_t _i)
+    {
+      if (_i == 4)
+        throw std::out_of_range("index");
+    }), std::out_of_range);
+  }
+}
@@ -439,6 +439,11 @@ void Buoyancy::PreUpdate(const ignition::gazebo::UpdateInfo &_info,
           const components::Volume *_volume,
           const components::CenterOfVolume *_centerOfVolume) -> bool
     {
+      // Copy the values out before enabling components, since adding a
+      // component moves this entity's data and invalidates the pointers.
+      const double volume = _volume->Data();
+      const math::Vector3d centerOfVolume = _centerOfVolume->Data();
+
       auto newPose = enableComponent<components::Inertial>(_ecm, _entity);
       newPose |= enableComponent<components::WorldPose>(_ecm, _entity);
 
@@ -456,11 +461,11 @@ void Buoyancy::PreUpdate(const ignition::gazebo::UpdateInfo &_info,
       {
         buoyancy =
         -this->dataPtr->UniformFluidDensity(linkWorldPose) *
-        _volume->Data() * gravity->Data();
+        volume * gravity->Data();
 
         // Convert the center of volume to the world frame
         math::Vector3d offsetWorld = linkWorldPose.Rot().RotateVector(
-            _centerOfVolume->Data());
+            centerOfVolume);
         // Compute the torque that should be applied due to buoyancy and
         // the center of volume.
         math::Vector3d torque = offsetWorld.Cross(buoyancy);
@@ -22,9 +22,11 @@
 
 #include <string>
 #include <fstream>
+#include <chrono>
 #include <ctime>
 #include <set>
 #include <list>
+#include <mutex>
 
 #include <ignition/common/Console.hh>
 #include <ignition/common/Filesystem.hh>
@@ -128,6 +130,13 @@ class ignition::gazebo::systems::LogRecordPrivate
   /// header should be the most accurate.
   public: std::unique_ptr<transport::NetworkClock> clock;
 
+  /// \brief Simulation time set on the clock by the latest PreUpdate.
+  public: std::chrono::steady_clock::duration clockTime{0};
+
+  /// \brief Protects the clock, since a pipelined PostUpdate runs at the
+  /// same time as the next PreUpdate.
+  public: std::mutex clockMutex;
+
   /// \brief Name of this world
   public: std::string worldName{""};
 
@@ -642,6 +651,9 @@ void LogRecord::PreUpdate(const UpdateInfo &_info,
   // Safe guard to prevent seg faults if recorder could not be started
   if (!this->dataPtr->instStarted)
     return;
+
+  std::lock_guard<std::mutex> lock(this->dataPtr->clockMutex);
+  this->dataPtr->clockTime = _info.simTime;
   this->dataPtr->clock->SetTime(_info.simTime);
 }
 
@@ -699,18 +711,37 @@ void LogRecord::PostUpdate(const UpdateInfo &_info,
   msgs::SerializedStateMap stateMsg;
   _ecm.ChangedState(stateMsg);
   if (!stateMsg.entities().empty())
+  {
+    // A pipelined PostUpdate runs after the next PreUpdate moved the clock,
+    // so the state is stamped with the time it was captured at
+    std::lock_guard<std::mutex> lock(this->dataPtr->clockMutex);
+    const bool lagging = this->dataPtr->clockTime != _info.simTime;
+    if (lagging)
+      this->dataPtr->clock->SetTime(_info.simTime);
     this->dataPtr->statePub.Publish(stateMsg);
+    if (lagging)
+      this->dataPtr->clock->SetTime(this->dataPtr->clockTime);
+  }
 
   // If there are new models loaded, save meshes and textures
   if (this->dataPtr->RecordResources() && _ecm.HasNewEntities())
     this->dataPtr->LogModelResources(_ecm);
 }
 
+//////////////////////////////////////////////////
+bool LogRecord::PostUpdateLagTolerated() const
+{
+  // The clock that stamps the recorded messages is moved back to the
+  // captured state's time while publishing it, see PostUpdate
+  return true;
+}
+
 IGNITION_ADD_PLUGIN(ignition::gazebo::systems::LogRecord,
                     ignition::gazebo::System,
                     LogRecord::ISystemConfigure,
                     LogRecord::ISystemPreUpdate,
-                    LogRecord::ISystemPostUpdate)
+                    LogRecord::ISystemPostUpdate,
+                    LogRecord::ISystemPostUpdateLag)
 
 IGNITION_ADD_PLUGIN_ALIAS(ignition::gazebo::systems::LogRecord,
                           "ignition::gazebo::systems::LogRecord")
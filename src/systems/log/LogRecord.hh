@@ -39,7 +39,8 @@ namespace systems
     public System,
     public ISystemConfigure,
     public ISystemPreUpdate,
-    public ISystemPostUpdate
+    public ISystemPostUpdate,
+    public ISystemPostUpdateLag
   {
     /// \brief Constructor
     public: explicit LogRecord();
@@ -61,6 +62,9 @@ namespace systems
     public: void PostUpdate(const UpdateInfo &_info,
                             const EntityComponentManager &_ecm) final;
 
+    /// Documentation inherited
+    public: bool PostUpdateLagTolerated() const final;
+
     /// \brief Private data pointer.
     private: std::unique_ptr<LogRecordPrivate> dataPtr;
   };
@@ -232,6 +232,14 @@ void OdometryPublisher::PostUpdate(const UpdateInfo &_info,
   this->dataPtr->UpdateOdometry(_info, _ecm);
 }
 
+//////////////////////////////////////////////////
+bool OdometryPublisher::PostUpdateLagTolerated() const
+{
+  // Odometry is computed and stamped from the captured state alone; the
+  // PreUpdate only makes sure the pose component exists
+  return true;
+}
+
 //////////////////////////////////////////////////
 void OdometryPublisherPrivate::UpdateOdometry(
     const ignition::gazebo::UpdateInfo &_info,
@@ -363,7 +371,8 @@ IGNITION_ADD_PLUGIN(OdometryPublisher,
                     ignition::gazebo::System,
                     OdometryPublisher::ISystemConfigure,
                     OdometryPublisher::ISystemPreUpdate,
-                    OdometryPublisher::ISystemPostUpdate)
+                    OdometryPublisher::ISystemPostUpdate,
+                    OdometryPublisher::ISystemPostUpdateLag)
 
 IGNITION_ADD_PLUGIN_ALIAS(OdometryPublisher,
                           "ignition::gazebo::systems::OdometryPublisher")
@@ -60,7 +60,8 @@ namespace systems
       : public System,
         public ISystemConfigure,
         public ISystemPreUpdate,
-        public ISystemPostUpdate
+        public ISystemPostUpdate,
+        public ISystemPostUpdateLag
   {
     /// \brief Constructor
     public: OdometryPublisher();
@@ -84,6 +85,9 @@ namespace systems
                 const UpdateInfo &_info,
                 const EntityComponentManager &_ecm) override;
 
+    // Documentation inherited
+    public: bool PostUpdateLagTolerated() const override;
+
     /// \brief Private data pointer
     private: std::unique_ptr<OdometryPublisherPrivate> dataPtr;
   };
@@ -30,6 +30,7 @@
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <ignition/common/HeightmapData.hh>
@@ -223,6 +224,13 @@ class ignition::gazebo::systems::PhysicsPrivate
   /// \param[in] _ecm Mutable reference to ECM.
   public: void UpdatePhysics(EntityComponentManager &_ecm);
 
+  /// \brief Bring the physics engine back in line with the ECM after the
+  /// world was restored to a snapshot. Top level models are moved to their
+  /// poses, with the velocities their links had, and joints are set to
+  /// their positions and velocities.
+  /// \param[in] _ecm Mutable reference to ECM.
+  public: void Reset(EntityComponentManager &_ecm);
+
   /// \brief Step the simulation for each world
   /// \param[in] _dt Duration
   /// \returns Output data from the physics engine (this currently contains
@@ -852,6 +860,15 @@ void Physics::Update(const UpdateInfo &_info, EntityComponentManager &_ecm)
   }
 }
 
+//////////////////////////////////////////////////
+void Physics::Reset(const UpdateInfo &, EntityComponentManager &_ecm)
+{
+  IGN_PROFILE("Physics::Reset");
+
+  if (this->dataPtr->engine)
+    this->dataPtr->Reset(_ecm);
+}
+
 //////////////////////////////////////////////////
 void PhysicsPrivate::CreatePhysicsEntities(const EntityComponentManager &_ecm)
 {
@@ -953,16 +970,16 @@ void PhysicsPrivate::CreateWorldEntities(const EntityComponentManager &_ecm)
 void PhysicsPrivate::CreateModelEntities(const EntityComponentManager &_ecm)
 {
   _ecm.EachNew<components::Model, components::Name, components::Pose,
-            components::ParentEntity>(
+            components::ParentEntity, Without<components::Recreate>,
+            Optional<components::Static>, Optional<components::SelfCollide>>(
       [&](const Entity &_entity,
           const components::Model *,
           const components::Name *_name,
           const components::Pose *_pose,
-          const components::ParentEntity *_parent)->bool
+          const components::ParentEntity *_parent,
+          const components::Static *_staticComp,
+          const components::SelfCollide *_selfCollideComp)->bool
       {
-        if (_ecm.EntityHasComponentType(_entity, components::Recreate::typeId))
-          return true;
-
         // Check if model already exists
         if (this->entityModelMap.HasEntity(_entity))
         {
@@ -977,16 +994,14 @@ void PhysicsPrivate::CreateModelEntities(const EntityComponentManager &_ecm)
         sdf::Model model;
         model.SetName(_name->Data());
         model.SetRawPose(_pose->Data());
-        auto staticComp = _ecm.Component<components::Static>(_entity);
-        if (staticComp && staticComp->Data())
+        if (_staticComp && _staticComp->Data())
         {
-          model.SetStatic(staticComp->Data());
+          model.SetStatic(_staticComp->Data());
           this->staticEntities.insert(_entity);
         }
-        auto selfCollideComp = _ecm.Component<components::SelfCollide>(_entity);
-        if (selfCollideComp && selfCollideComp ->Data())
+        if (_selfCollideComp && _selfCollideComp->Data())
         {
-          model.SetSelfCollide(selfCollideComp->Data());
+          model.SetSelfCollide(_selfCollideComp->Data());
         }
 
         // check if parent is a world
@@ -1687,6 +1702,86 @@ void PhysicsPrivate::RemovePhysicsEntities(const EntityComponentManager &_ecm)
       });
 }
 
+//////////////////////////////////////////////////
+void PhysicsPrivate::Reset(EntityComponentManager &_ecm)
+{
+  IGN_PROFILE("PhysicsPrivate::Reset");
+
+  _ecm.Each<components::Model, components::Pose>(
+      [&](const Entity &_entity, const components::Model *,
+          const components::Pose *_pose)
+      {
+        auto modelPtrPhys = this->entityModelMap.Get(_entity);
+        if (nullptr == modelPtrPhys ||
+            _entity != this->topLevelModelMap[_entity] ||
+            this->staticEntities.find(_entity) != this->staticEntities.end())
+        {
+          return true;
+        }
+
+        auto freeGroup = modelPtrPhys->FindFreeGroup();
+        if (!freeGroup)
+          return true;
+
+        const auto linkEntity =
+            this->entityLinkMap.Get(freeGroup->RootLink());
+        if (linkEntity == kNullEntity)
+          return true;
+
+        math::Pose3d linkPose =
+            this->RelativePose(_entity, linkEntity, _ecm);
+        freeGroup->SetWorldPose(math::eigen3::convert(_pose->Data() *
+                                linkPose));
+
+        // The engine would otherwise keep the velocities from before the
+        // restore. Links whose velocities aren't tracked come to rest.
+        this->entityFreeGroupMap.AddEntity(_entity, freeGroup);
+        auto velFeature = this->entityFreeGroupMap
+            .EntityCast<WorldVelocityCommandFeatureList>(_entity);
+        if (!velFeature)
+          return true;
+
+        auto linearVel =
+            _ecm.Component<components::WorldLinearVelocity>(linkEntity);
+        auto angularVel =
+            _ecm.Component<components::WorldAngularVelocity>(linkEntity);
+        velFeature->SetWorldLinearVelocity(math::eigen3::convert(
+            linearVel ? linearVel->Data() : math::Vector3d::Zero));
+        velFeature->SetWorldAngularVelocity(math::eigen3::convert(
+            angularVel ? angularVel->Data() : math::Vector3d::Zero));
+
+        return true;
+      });
+
+  // Joints are reset through the reset components on the next update.
+  // Collect them first, since creating components while iterating isn't
+  // allowed.
+  std::vector<std::pair<Entity, std::vector<double>>> positions;
+  _ecm.Each<components::Joint, components::JointPosition>(
+      [&](const Entity &_entity, const components::Joint *,
+          const components::JointPosition *_position)
+      {
+        if (this->entityJointMap.HasEntity(_entity))
+          positions.emplace_back(_entity, _position->Data());
+        return true;
+      });
+
+  std::vector<std::pair<Entity, std::vector<double>>> velocities;
+  _ecm.Each<components::Joint, components::JointVelocity>(
+      [&](const Entity &_entity, const components::Joint *,
+          const components::JointVelocity *_velocity)
+      {
+        if (this->entityJointMap.HasEntity(_entity))
+          velocities.emplace_back(_entity, _velocity->Data());
+        return true;
+      });
+
+  for (const auto &[entity, position] : positions)
+    _ecm.SetComponentData<components::JointPositionReset>(entity, position);
+  for (const auto &[entity, velocity] : velocities)
+    _ecm.SetComponentData<components::JointVelocityReset>(entity, velocity);
+}
+
 //////////////////////////////////////////////////
 void PhysicsPrivate::UpdatePhysics(EntityComponentManager &_ecm)
 {
@@ -3384,6 +3479,7 @@ void PhysicsPrivate::DisableContactSurfaceCustomization(const Entity &_world)
 IGNITION_ADD_PLUGIN(Physics,
                     ignition::gazebo::System,
                     Physics::ISystemConfigure,
-                    Physics::ISystemUpdate)
+                    Physics::ISystemUpdate,
+                    Physics::ISystemReset)
 
 IGNITION_ADD_PLUGIN_ALIAS(Physics, "ignition::gazebo::systems::Physics")
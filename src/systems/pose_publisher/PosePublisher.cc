@@ -350,6 +350,13 @@ void PosePublisher::PostUpdate(const UpdateInfo &_info,
   }
 }
 
+//////////////////////////////////////////////////
+bool PosePublisher::PostUpdateLagTolerated() const
+{
+  // Poses are stamped with the simulation time they were captured at
+  return true;
+}
+
 //////////////////////////////////////////////////
 void PosePublisherPrivate::InitializeEntitiesToPublish(
     const EntityComponentManager &_ecm)
@@ -552,7 +559,8 @@ void PosePublisherPrivate::PublishPoses(
 IGNITION_ADD_PLUGIN(PosePublisher,
                     System,
                     PosePublisher::ISystemConfigure,
-                    PosePublisher::ISystemPostUpdate)
+                    PosePublisher::ISystemPostUpdate,
+                    PosePublisher::ISystemPostUpdateLag)
 
 IGNITION_ADD_PLUGIN_ALIAS(PosePublisher,
                           "ignition::gazebo::systems::PosePublisher")
@@ -65,7 +65,8 @@ namespace systems
   class PosePublisher
       : public System,
         public ISystemConfigure,
-        public ISystemPostUpdate
+        public ISystemPostUpdate,
+        public ISystemPostUpdateLag
   {
     /// \brief Constructor
     public: PosePublisher();
@@ -84,6 +85,9 @@ namespace systems
                 const UpdateInfo &_info,
                 const EntityComponentManager &_ecm) override;
 
+    // Documentation inherited
+    public: bool PostUpdateLagTolerated() const override;
+
     /// \brief Private data pointer
     private: std::unique_ptr<PosePublisherPrivate> dataPtr;
   };
@@ -201,6 +201,10 @@ class ignition::gazebo::systems::SceneBroadcasterPrivate
   public: std::chrono::time_point<std::chrono::system_clock>
       lastStatePubTime{std::chrono::system_clock::now()};
 
+  /// \brief ECM change tick when the state message was last filled, used to
+  /// include changes from iterations skipped by the throttling.
+  public: uint64_t lastStateTick{0};
+
   /// \brief Period to publish state while paused and running. The key for
   /// the map is used to store the publish period when paused and not
   /// paused. The not-paused (a.ka. running) period has a key=false and a
@@ -315,14 +319,20 @@ void SceneBroadcaster::PostUpdate(const UpdateInfo &_info,
     if (changeEvent || this->dataPtr->stateServiceRequest)
     {
       _manager.State(*this->dataPtr->stepMsg.mutable_state(), {}, {}, true);
+      this->dataPtr->lastStateTick = _manager.ChangeTick();
     }
-    // Otherwise publish just periodic change components when running
+    // Otherwise publish just the components changed since the last message
+    // when running
     else if (!_info.paused)
     {
       IGN_PROFILE("SceneBroadcast::PostUpdate UpdateState");
-      auto periodicComponents = _manager.ComponentTypesWithPeriodicChanges();
-      _manager.State(*this->dataPtr->stepMsg.mutable_state(),
-          {}, periodicComponents);
+      if (!_manager.ChangedStateSince(this->dataPtr->lastStateTick,
+          *this->dataPtr->stepMsg.mutable_state()))
+      {
+        this->dataPtr->stepMsg.mutable_state()->Clear();
+        _manager.State(*this->dataPtr->stepMsg.mutable_state(), {}, {}, true);
+      }
+      this->dataPtr->lastStateTick = _manager.ChangeTick();
     }
 
     // Full state on demand
@@ -354,6 +364,14 @@ void SceneBroadcaster::PostUpdate(const UpdateInfo &_info,
   }
 }
 
+//////////////////////////////////////////////////
+bool SceneBroadcaster::PostUpdateLagTolerated() const
+{
+  // Messages are stamped with the simulation time of the state they carry,
+  // and the services only read state under their own mutexes
+  return true;
+}
+
 //////////////////////////////////////////////////
 void SceneBroadcasterPrivate::PoseUpdate(const UpdateInfo &_info,
     const EntityComponentManager &_manager)
@@ -990,7 +1008,8 @@ void SceneBroadcasterPrivate::RemoveFromGraph(const Entity _entity,
 IGNITION_ADD_PLUGIN(SceneBroadcaster,
                     ignition::gazebo::System,
                     SceneBroadcaster::ISystemConfigure,
-                    SceneBroadcaster::ISystemPostUpdate)
+                    SceneBroadcaster::ISystemPostUpdate,
+                    SceneBroadcaster::ISystemPostUpdateLag)
 
 // Add plugin alias so that we can refer to the plugin without the version
 // namespace
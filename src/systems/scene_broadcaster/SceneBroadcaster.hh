@@ -40,7 +40,8 @@ namespace systems
   class SceneBroadcaster:
     public System,
     public ISystemConfigure,
-    public ISystemPostUpdate
+    public ISystemPostUpdate,
+    public ISystemPostUpdateLag
   {
     /// \brief Constructor
     public: SceneBroadcaster();
@@ -58,6 +59,9 @@ namespace systems
     public: void PostUpdate(const UpdateInfo &_info,
                 const EntityComponentManager &_ecm) final;
 
+    // Documentation inherited
+    public: bool PostUpdateLagTolerated() const final;
+
     /// \brief Private data pointer
     private: std::unique_ptr<SceneBroadcasterPrivate> dataPtr;
   };
@@ -547,6 +547,9 @@ void Sensors::PostUpdate(const UpdateInfo &_info,
     if (!activeSensors.empty() ||
         this->dataPtr->renderUtil.PendingSensors() > 0)
     {
+      // Wait for the previous frame, so the scene isn't updated while it's
+      // being rendered. This holds a PostUpdate thread, see
+      // ISystemPostUpdate.
       std::unique_lock<std::mutex> lock(this->dataPtr->renderMutex);
       this->dataPtr->renderCv.wait(lock, [this] {
         return !this->dataPtr->running || !this->dataPtr->updateAvailable; });
@@ -564,6 +567,14 @@ void Sensors::PostUpdate(const UpdateInfo &_info,
   }
 }
 
+//////////////////////////////////////////////////
+bool Sensors::PostUpdateLagTolerated() const
+{
+  // Sensors render the scene at the time it was captured at. Update only
+  // goes through the render utility, which is synchronized.
+  return true;
+}
+
 //////////////////////////////////////////////////
 std::string Sensors::CreateSensor(const Entity &_entity,
     const sdf::Sensor &_sdf, const std::string &_parentName)
@@ -697,7 +708,8 @@ std::string Sensors::CreateSensor(const Entity &_entity,
 IGNITION_ADD_PLUGIN(Sensors, System,
   Sensors::ISystemConfigure,
   Sensors::ISystemUpdate,
-  Sensors::ISystemPostUpdate
+  Sensors::ISystemPostUpdate,
+  Sensors::ISystemPostUpdateLag
 )
 
 IGNITION_ADD_PLUGIN_ALIAS(Sensors, "ignition::gazebo::systems::Sensors")
@@ -54,7 +54,8 @@ namespace systems
     public System,
     public ISystemConfigure,
     public ISystemUpdate,
-    public ISystemPostUpdate
+    public ISystemPostUpdate,
+    public ISystemPostUpdateLag
   {
     /// \brief Constructor
     public: explicit Sensors();
@@ -76,6 +77,9 @@ namespace systems
     public: void PostUpdate(const UpdateInfo &_info,
                             const EntityComponentManager &_ecm) final;
 
+    // Documentation inherited
+    public: bool PostUpdateLagTolerated() const final;
+
     /// \brief Create a rendering sensor from sdf
     /// \param[in] _entity Entity of the sensor
     /// \param[in] _sdf SDF description of the sensor
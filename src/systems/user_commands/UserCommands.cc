@@ -982,6 +982,8 @@ bool CreateCommand::Execute()
         auto pose = gazebo::convert<math::Pose3d>(createMsg->pose());
         this->iface->ecm->SetComponentData<components::Pose>(clonedEntity,
             pose);
+        this->iface->ecm->SetChanged(clonedEntity, components::Pose::typeId,
+            ComponentState::OneTimeChange);
       }
       return true;
     }
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "ignition/gazebo/Entity.hh"
+#include "ignition/gazebo/EntityComponentManager.hh"
+
+#include "ignition/gazebo/components/LinearVelocity.hh"
+#include "ignition/gazebo/components/Link.hh"
+#include "ignition/gazebo/components/Name.hh"
+#include "ignition/gazebo/components/Pose.hh"
+#include "ignition/gazebo/components/Static.hh"
+
+using namespace ignition;
+using namespace gazebo;
+using namespace components;
+
+/// \brief Entities spread over a few archetypes, with views that the new
+/// component affects, so each creation has to update them.
+class CreateComponentsFixture: public benchmark::Fixture
+{
+  protected: void Populate(int _entityCount)
+  {
+    this->mgr = std::make_unique<EntityComponentManager>();
+    this->entities = this->mgr->CreateEntities(_entityCount);
+    for (int i = 0; i < _entityCount; ++i)
+    {
+      const Entity entity = this->entities[i];
+      this->mgr->CreateComponents(entity, Link(), components::Name("link"),
+          Pose());
+      if (i % 2 == 0)
+        this->mgr->CreateComponent(entity, LinearVelocity());
+      if (i % 3 == 0)
+        this->mgr->CreateComponent(entity, Static());
+    }
+
+    this->mgr->Each<Link, Pose>(
+        [](const Entity &, const Link *, const Pose *) {return true;});
+    this->mgr->Each<Link, WorldPose>(
+        [](const Entity &, const Link *, const WorldPose *) {return true;});
+    this->mgr->Each<Pose, LinearVelocity>(
+        [](const Entity &, const Pose *, const LinearVelocity *)
+        {return true;});
+  }
+
+  /// \brief Check that all entities got the component.
+  /// \param[in] _st Benchmark state, which is skipped with an error if not.
+  protected: void Check(benchmark::State &_st)
+  {
+    int matched = 0;
+    this->mgr->Each<Link, WorldPose>(
+        [&](const Entity &, const Link *, const WorldPose *)
+        {
+          ++matched;
+          return true;
+        });
+    if (matched != static_cast<int>(this->entities.size()))
+      _st.SkipWithError("Failed to create components on all entities");
+  }
+
+  protected: std::unique_ptr<EntityComponentManager> mgr;
+
+  protected: std::vector<Entity> entities;
+};
+
+BENCHMARK_DEFINE_F(CreateComponentsFixture, CreateComponentEach)
+(benchmark::State &_st)
+{
+  for (auto _ : _st)
+  {
+    _st.PauseTiming();
+    this->Populate(_st.range(0));
+    _st.ResumeTiming();
+
+    for (const Entity entity : this->entities)
+      this->mgr->CreateComponent(entity, WorldPose());
+
+    _st.PauseTiming();
+    this->Check(_st);
+    _st.ResumeTiming();
+  }
+}
+
+BENCHMARK_DEFINE_F(CreateComponentsFixture, CreateComponentsBatch)
+(benchmark::State &_st)
+{
+  for (auto _ : _st)
+  {
+    _st.PauseTiming();
+    this->Populate(_st.range(0));
+    _st.ResumeTiming();
+
+    this->mgr->CreateComponents(this->entities, WorldPose());
+
+    _st.PauseTiming();
+    this->Check(_st);
+    _st.ResumeTiming();
+  }
+}
+
+BENCHMARK_REGISTER_F(CreateComponentsFixture, CreateComponentEach)
+  ->Arg(100)
+  ->Arg(1000)
+  ->Arg(10000)
+  ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(CreateComponentsFixture, CreateComponentsBatch)
+  ->Arg(100)
+  ->Arg(1000)
+  ->Arg(10000)
+  ->Unit(benchmark::kMillisecond);
+
+// OSX needs the semicolon, Ubuntu complains that there's an extra ';'
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+BENCHMARK_MAIN();
+#pragma GCC diagnostic pop
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <memory>
+#include <tuple>
+
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Vector3.hh>
+
+#include "ignition/gazebo/Entity.hh"
+#include "ignition/gazebo/EntityComponentManager.hh"
+
+#include "ignition/gazebo/components/AngularVelocity.hh"
+#include "ignition/gazebo/components/LinearVelocity.hh"
+#include "ignition/gazebo/components/Pose.hh"
+
+using namespace ignition;
+using namespace gazebo;
+using namespace components;
+
+constexpr const int kEachIterations {10};
+
+/// \brief Time step used to integrate the velocities.
+constexpr const double kDt {0.001};
+
+/// \brief Per-entity workload, heavy enough for the threading overhead to
+/// be amortized: integrate the velocities into the pose a few times.
+/// \param[in,out] _pose Pose to update.
+/// \param[in] _lin Linear velocity.
+/// \param[in] _ang Angular velocity.
+static void integrate(math::Pose3d &_pose, const math::Vector3d &_lin,
+    const math::Vector3d &_ang)
+{
+  for (int i = 0; i < 10; ++i)
+  {
+    _pose.Pos() += _pose.Rot().RotateVector(_lin) * kDt;
+    math::Quaterniond delta(_ang * kDt);
+    _pose.Rot() = _pose.Rot() * delta;
+    _pose.Rot().Normalize();
+  }
+}
+
+class EachParallelFixture: public benchmark::Fixture
+{
+  protected: void SetUp(const ::benchmark::State &_state) override
+  {
+    mgr = std::make_unique<EntityComponentManager>();
+    this->Populate(_state.range(0));
+  }
+
+  protected: void Populate(int _entityCount)
+  {
+    for (int i = 0; i < _entityCount; ++i)
+    {
+      Entity entity = mgr->CreateEntity();
+      mgr->CreateComponent(entity, Pose());
+      mgr->CreateComponent(entity,
+          LinearVelocity(math::Vector3d(1, 0, 0)));
+      mgr->CreateComponent(entity,
+          AngularVelocity(math::Vector3d(0, 0, 0.1)));
+    }
+  }
+
+  std::unique_ptr<EntityComponentManager> mgr;
+};
+
+BENCHMARK_DEFINE_F(EachParallelFixture, Each)
+(benchmark::State &_st)
+{
+  for (auto _ : _st)
+  {
+    for (int eachIter = 0; eachIter < kEachIterations; ++eachIter)
+    {
+      mgr->Each<Pose, LinearVelocity, AngularVelocity>(
+          [&](const Entity &, Pose *_pose, LinearVelocity *_lin,
+              AngularVelocity *_ang)->bool
+          {
+            integrate(_pose->Data(), _lin->Data(), _ang->Data());
+            return true;
+          });
+    }
+  }
+}
+
+BENCHMARK_DEFINE_F(EachParallelFixture, EachParallel)
+(benchmark::State &_st)
+{
+  for (auto _ : _st)
+  {
+    for (int eachIter = 0; eachIter < kEachIterations; ++eachIter)
+    {
+      mgr->EachParallel<Pose, LinearVelocity, AngularVelocity>(
+          [&](const Entity &, Pose *_pose, LinearVelocity *_lin,
+              AngularVelocity *_ang)
+          {
+            integrate(_pose->Data(), _lin->Data(), _ang->Data());
+          });
+    }
+  }
+}
+
+BENCHMARK_DEFINE_F(EachParallelFixture, ForEachChunk)
+(benchmark::State &_st)
+{
+  for (auto _ : _st)
+  {
+    for (int eachIter = 0; eachIter < kEachIterations; ++eachIter)
+    {
+      mgr->ForEachChunk<Pose, LinearVelocity, AngularVelocity>(
+          [&](const std::tuple<Entity, Pose *, LinearVelocity *,
+                               AngularVelocity *> *_chunk,
+              std::size_t _count)
+          {
+            for (std::size_t i = 0; i < _count; ++i)
+            {
+              integrate(std::get<1>(_chunk[i])->Data(),
+                        std::get<2>(_chunk[i])->Data(),
+                        std::get<3>(_chunk[i])->Data());
+            }
+          });
+    }
+  }
+}
+
+BENCHMARK_REGISTER_F(EachParallelFixture, Each)
+  ->Arg(100)
+  ->Arg(1000)
+  ->Arg(10000)
+  ->Arg(100000)
+  ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(EachParallelFixture, EachParallel)
+  ->Arg(100)
+  ->Arg(1000)
+  ->Arg(10000)
+  ->Arg(100000)
+  ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_REGISTER_F(EachParallelFixture, ForEachChunk)
+  ->Arg(100)
+  ->Arg(1000)
+  ->Arg(10000)
+  ->Arg(100000)
+  ->Unit(benchmark::kMillisecond);
+
+// OSX needs the semicolon, Ubuntu complains that there's an extra ';'
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+BENCHMARK_MAIN();
+#pragma GCC diagnostic pop
@@ -18,6 +18,7 @@
 #include <benchmark/benchmark.h>
 
 #include <memory>
+#include <vector>
 
 #include "ignition/gazebo/Entity.hh"
 #include "ignition/gazebo/EntityComponentManager.hh"
@@ -130,6 +131,103 @@ void BM_Serialize5Component(benchmark::State &_st)
   _st.counters["num_components"] = 5;
 }
 
+/// \brief Create entities with 5 components each.
+/// \param[in] _mgr Manager to populate.
+/// \param[in] _entityCount Number of entities.
+void populate5Component(EntityComponentManager &_mgr, int64_t _entityCount)
+{
+  for (int ii = 0; ii < _entityCount; ++ii)
+  {
+    auto e = _mgr.CreateEntity();
+    _mgr.CreateComponent(e, IntComponent(ii));
+    _mgr.CreateComponent(e, UIntComponent(ii));
+    _mgr.CreateComponent(e, DoubleComponent(ii));
+    _mgr.CreateComponent(e, StringComponent("foobar"));
+    _mgr.CreateComponent(e, BoolComponent(ii%2));
+  }
+}
+
+// NOLINTNEXTLINE
+void BM_SerializeMap5Component(benchmark::State &_st)
+{
+  size_t serializedSize = 0;
+  auto entityCount = _st.range(0);
+
+  // The same ECM is serialized over and over, as the scene broadcaster and
+  // the log recorder do
+  auto mgr = std::make_unique<EntityComponentManager>();
+  populate5Component(*mgr, entityCount);
+
+  for (auto _: _st)
+  {
+    msgs::SerializedStateMap stateMsg;
+    mgr->State(stateMsg, {}, {}, true);
+#if GOOGLE_PROTOBUF_VERSION >= 3004000
+    serializedSize = stateMsg.ByteSizeLong();
+#else
+    serializedSize = stateMsg.ByteSize();
+#endif
+  }
+  _st.counters["serialized_size"] = serializedSize;
+  _st.counters["num_entities"] = entityCount;
+  _st.counters["num_components"] = 5;
+}
+
+// NOLINTNEXTLINE
+void BM_SerializeBinary5Component(benchmark::State &_st)
+{
+  auto entityCount = _st.range(0);
+  auto mgr = std::make_unique<EntityComponentManager>();
+  populate5Component(*mgr, entityCount);
+
+  std::vector<char> buffer;
+  for (auto _: _st)
+  {
+    mgr->BinaryState(buffer);
+  }
+  _st.counters["serialized_size"] = buffer.size();
+  _st.counters["num_entities"] = entityCount;
+  _st.counters["num_components"] = 5;
+}
+
+// NOLINTNEXTLINE
+void BM_DeserializeMap5Component(benchmark::State &_st)
+{
+  auto entityCount = _st.range(0);
+  auto mgr = std::make_unique<EntityComponentManager>();
+  populate5Component(*mgr, entityCount);
+
+  msgs::SerializedStateMap stateMsg;
+  mgr->State(stateMsg, {}, {}, true);
+
+  // Updates the components of an existing ECM, as a GUI client does
+  for (auto _: _st)
+  {
+    mgr->SetState(stateMsg);
+  }
+  _st.counters["num_entities"] = entityCount;
+  _st.counters["num_components"] = 5;
+}
+
+// NOLINTNEXTLINE
+void BM_DeserializeBinary5Component(benchmark::State &_st)
+{
+  auto entityCount = _st.range(0);
+  auto mgr = std::make_unique<EntityComponentManager>();
+  populate5Component(*mgr, entityCount);
+
+  std::vector<char> buffer;
+  mgr->BinaryState(buffer);
+  BinaryStateView view(buffer.data(), buffer.size());
+
+  for (auto _: _st)
+  {
+    mgr->SetBinaryState(view);
+  }
+  _st.counters["num_entities"] = entityCount;
+  _st.counters["num_components"] = 5;
+}
+
 // NOLINTNEXTLINE
 BENCHMARK(BM_Serialize1Component)
   ->Arg(10)
@@ -148,6 +246,34 @@ BENCHMARK(BM_Serialize5Component)
   ->Arg(1000)
   ->Unit(benchmark::kMillisecond);
 
+// NOLINTNEXTLINE
+BENCHMARK(BM_SerializeMap5Component)
+  ->Arg(1000)
+  ->Arg(10000)
+  ->Arg(100000)
+  ->Unit(benchmark::kMillisecond);
+
+// NOLINTNEXTLINE
+BENCHMARK(BM_SerializeBinary5Component)
+  ->Arg(1000)
+  ->Arg(10000)
+  ->Arg(100000)
+  ->Unit(benchmark::kMillisecond);
+
+// NOLINTNEXTLINE
+BENCHMARK(BM_DeserializeMap5Component)
+  ->Arg(1000)
+  ->Arg(10000)
+  ->Arg(100000)
+  ->Unit(benchmark::kMillisecond);
+
+// NOLINTNEXTLINE
+BENCHMARK(BM_DeserializeBinary5Component)
+  ->Arg(1000)
+  ->Arg(10000)
+  ->Arg(100000)
+  ->Unit(benchmark::kMillisecond);
+
 // OSX needs the semicolon, Ubuntu complains that there's an extra ';'
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpedantic"
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2022 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <string>
+
+#include <ignition/common/Console.hh>
+
+#include "ignition/gazebo/Entity.hh"
+#include "ignition/gazebo/EntityComponentManager.hh"
+#include "ignition/gazebo/Server.hh"
+#include "ignition/gazebo/ServerConfig.hh"
+#include "ignition/gazebo/System.hh"
+
+#include "ignition/gazebo/components/Name.hh"
+
+using namespace ignition;
+using namespace gazebo;
+
+/// \brief Number of entities the systems iterate over.
+constexpr const int kEntityCount {100};
+
+/// \brief PostUpdate system with a small read-only workload, like a sensor
+/// or a publisher reading a few components. It tolerates lag, so it's
+/// pipelined when that's enabled.
+class ReadingSystem
+  : public System,
+    public ISystemPostUpdate,
+    public ISystemPostUpdateLag
+{
+  // Documentation inherited
+  public: bool PostUpdateLagTolerated() const override
+  {
+    return true;
+  }
+
+  // Documentation inherited
+  public: void PostUpdate(const UpdateInfo &,
+              const EntityComponentManager &_ecm) override
+  {
+    std::size_t length{0};
+    _ecm.Each<components::Name>(
+        [&](const Entity &, const components::Name *_name) -> bool
+        {
+          length += _name->Data().size();
+          return true;
+        });
+    benchmark::DoNotOptimize(length);
+  }
+};
+
+/// \brief System which creates the entities read by the other systems in
+/// its first PreUpdate.
+class PopulatingSystem : public System, public ISystemPreUpdate
+{
+  // Documentation inherited
+  public: void PreUpdate(const UpdateInfo &,
+              EntityComponentManager &_ecm) override
+  {
+    for (; this->created < kEntityCount; ++this->created)
+    {
+      _ecm.CreateComponent(_ecm.CreateEntity(),
+          components::Name("entity_" + std::to_string(this->created)));
+    }
+  }
+
+  /// \brief Number of entities created so far.
+  private: int created{0};
+};
+
+/// \brief Measures the duration of a simulation step for a number of
+/// PostUpdate systems, given as the first argument, and a number of system
+/// worker threads, given as the second argument. A negative worker count
+/// uses the default, which is based on the hardware. PostUpdate is pipelined
+/// if the third argument is not zero.
+static void PostUpdateStep(benchmark::State &_st)
+{
+  common::Console::SetVerbosity(0);
+
+  ServerConfig config;
+  config.SetSdfString(R"(
+      <?xml version="1.0" ?>
+      <sdf version="1.6">
+        <world name="default">
+        </world>
+      </sdf>)");
+  if (_st.range(1) >= 0)
+    config.SetSystemWorkerCount(static_cast<unsigned int>(_st.range(1)));
+  config.SetPipelinedPostUpdate(_st.range(2) != 0);
+
+  Server server(config);
+  server.AddSystem(std::make_shared<PopulatingSystem>());
+  for (int i = 0; i < _st.range(0); ++i)
+    server.AddSystem(std::make_shared<ReadingSystem>());
+
+  // Load the systems and create the entities before timing
+  server.RunOnce(false);
+
+  for (auto _ : _st)
+  {
+    server.RunOnce(false);
+  }
+}
+
+/// \brief Step latency versus system count, with the default number of
+/// workers, with and without pipelining, and with all systems on the
+/// simulation thread.
+/// \param[in] _b Benchmark to configure.
+static void SystemCounts(benchmark::internal::Benchmark *_b)
+{
+  for (const int systems : {1, 8, 32, 64, 128})
+  {
+    _b->Args({systems, -1, 0});
+    _b->Args({systems, -1, 1});
+    _b->Args({systems, 0, 0});
+  }
+}
+
+BENCHMARK(PostUpdateStep)
+  ->Apply(SystemCounts)
+  ->Unit(benchmark::kMicrosecond);
+
+// OSX needs the semicolon, Ubuntu complains that there's an extra ';'
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+BENCHMARK_MAIN();
+#pragma GCC diagnostic pop
@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <cmath>
 #include <string>
 #include <vector>
 
@@ -42,6 +43,7 @@
 #include "ignition/gazebo/Util.hh"
 #include "ignition/gazebo/test_config.hh"  // NOLINT(build/include)
 
+#include "ignition/gazebo/components/AngularVelocity.hh"
 #include "ignition/gazebo/components/AxisAlignedBox.hh"
 #include "ignition/gazebo/components/CanonicalLink.hh"
 #include "ignition/gazebo/components/Collision.hh"
@@ -183,6 +185,81 @@ TEST_F(PhysicsSystemFixture, FallingObject)
   EXPECT_NEAR(spherePoses.back().Pos().Z(), zStopped, 5e-2);
 }
 
+/////////////////////////////////////////////////
+// Restoring a snapshot of a falling object should also reset the physics
+// engine, so the object falls along the same trajectory again.
+TEST_F(PhysicsSystemFixture, RestoreSnapshot)
+{
+  ignition::gazebo::ServerConfig serverConfig;
+  serverConfig.SetSdfFile(std::string(PROJECT_SOURCE_PATH) +
+    "/test/worlds/falling.sdf");
+
+  gazebo::Server server(serverConfig);
+  server.SetUpdatePeriod(1us);
+
+  const std::string linkName = "sphere_link";
+  math::Pose3d linkPose;
+
+  test::Relay testSystem;
+  testSystem.OnPreUpdate(
+    [&](const gazebo::UpdateInfo &, gazebo::EntityComponentManager &_ecm)
+    {
+      // Track the link velocities, so that they're part of the snapshot
+      _ecm.Each<components::Link, components::Name>(
+        [&](const gazebo::Entity &_entity, const components::Link *,
+        const components::Name *_name)->bool
+        {
+          if (_name->Data() != linkName)
+            return true;
+          if (!_ecm.Component<components::WorldLinearVelocity>(_entity))
+          {
+            _ecm.CreateComponent(_entity,
+                components::WorldLinearVelocity());
+          }
+          if (!_ecm.Component<components::WorldAngularVelocity>(_entity))
+          {
+            _ecm.CreateComponent(_entity,
+                components::WorldAngularVelocity());
+          }
+          return true;
+        });
+    });
+  testSystem.OnPostUpdate(
+    [&](const gazebo::UpdateInfo &,
+    const gazebo::EntityComponentManager &_ecm)
+    {
+      _ecm.Each<components::Link, components::Name>(
+        [&](const gazebo::Entity &_entity, const components::Link *,
+        const components::Name *_name)->bool
+        {
+          if (_name->Data() == linkName)
+            linkPose = gazebo::worldPose(_entity, _ecm);
+          return true;
+        });
+    });
+  server.AddSystem(testSystem.systemPtr);
+
+  // Take the snapshot while the sphere is falling
+  server.Run(true, 200, false);
+  auto snapshot = server.Snapshot();
+  ASSERT_TRUE(snapshot.has_value());
+
+  server.Run(true, 100, false);
+  const math::Pose3d expectedPose = linkPose;
+  EXPECT_LT(expectedPose.Pos().Z(), 6.7);
+
+  // Let the sphere land, then go back in time
+  server.Run(true, 2000, false);
+  EXPECT_GT(std::abs(linkPose.Pos().Z() - expectedPose.Pos().Z()), 1.0);
+
+  ASSERT_TRUE(server.Restore(*snapshot));
+  server.Run(true, 100, false);
+
+  // Without resetting the engine, the sphere would either stay on the
+  // ground, or fall from the restored pose starting at rest
+  EXPECT_NEAR(expectedPose.Pos().Z(), linkPose.Pos().Z(), 1e-3);
+}
+
 /////////////////////////////////////////////////
 // This tests whether links with fixed joints keep their relative transforms
 // after physics. For that to work properly, the canonical link implementation